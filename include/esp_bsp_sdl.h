@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include "esp_bsp_sdl_surface.h"
 #include "esp_err.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_ops.h"
@@ -18,15 +19,25 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Placement policy for frame and transfer buffers
+ */
+typedef enum {
+    ESP_BSP_SDL_PLACEMENT_AUTO = 0,     /*!< PSRAM with internal bounce if PSRAM is enabled, internal otherwise */
+    ESP_BSP_SDL_PLACEMENT_INTERNAL,     /*!< Full-frame transfers from internal DMA memory */
+    ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE, /*!< Frames in PSRAM, sent through band-sized internal DMA buffers */
+} esp_bsp_sdl_placement_t;
+
 /**
  * @brief Display configuration structure for SDL abstraction
  */
 typedef struct {
-    int width;              /*!< Display width in pixels */
-    int height;             /*!< Display height in pixels */
-    int pixel_format;       /*!< SDL pixel format */
-    size_t max_transfer_sz; /*!< Maximum transfer size for display operations */
-    bool has_touch;         /*!< Whether the display has touch capability */
+    int width;                         /*!< Display width in pixels */
+    int height;                        /*!< Display height in pixels */
+    int pixel_format;                  /*!< SDL pixel format */
+    size_t max_transfer_sz;            /*!< Maximum transfer size for display operations */
+    bool has_touch;                    /*!< Whether the display has touch capability */
+    esp_bsp_sdl_placement_t placement; /*!< Placement policy in effect, never AUTO */
 } esp_bsp_sdl_display_config_t;
 
 /**
@@ -38,8 +49,78 @@ typedef struct {
     int y;        /*!< Touch Y coordinate */
 } esp_bsp_sdl_touch_info_t;
 
+/**
+ * @brief Logical display orientation (clockwise rotation of the native panel image)
+ */
+typedef enum {
+    ESP_BSP_SDL_ORIENTATION_0 = 0, /*!< Native panel orientation */
+    ESP_BSP_SDL_ORIENTATION_90,    /*!< Rotated 90 degrees clockwise */
+    ESP_BSP_SDL_ORIENTATION_180,   /*!< Rotated 180 degrees */
+    ESP_BSP_SDL_ORIENTATION_270,   /*!< Rotated 270 degrees clockwise */
+} esp_bsp_sdl_orientation_t;
+
+/**
+ * @brief Panel controller gamma curves (MIPI-DBI PGAMCTRL 0xE0 / NGAMCTRL 0xE1)
+ */
+typedef struct {
+    uint8_t positive[16]; /*!< Positive polarity gamma parameters */
+    uint8_t negative[16]; /*!< Negative polarity gamma parameters */
+    uint8_t length;       /*!< Valid bytes per curve: 15 on ILI9341/ILI9342, 14 on ST7789 */
+} esp_bsp_sdl_panel_gamma_t;
+
+/**
+ * @brief MIPI-DBI panel description (SPI/I80 controllers addressed with CASET/RASET/RAMWR)
+ *
+ * Boards describe the native orientation. Rotating moves the visible area to other controller RAM
+ * unless it is centred, the gaps of the other orientations are derived from the RAM size.
+ */
+typedef struct {
+    int x_gap;        /*!< Column offset of the visible area in controller RAM */
+    int y_gap;        /*!< Row offset of the visible area in controller RAM */
+    int ram_width;    /*!< Controller RAM columns, 0 to keep the gaps in every orientation */
+    int ram_height;   /*!< Controller RAM rows */
+    int scroll_lines; /*!< Controller RAM rows for vertical scrolling (VSCRDEF), 0 without it */
+    bool mirror_x;    /*!< Native orientation mirrors columns (MADCTL MX) */
+    bool mirror_y;    /*!< Native orientation mirrors rows (MADCTL MY), scrolling runs reversed */
+} esp_bsp_sdl_dbi_info_t;
+
+/**
+ * @brief Flush statistics
+ */
+typedef struct {
+    uint32_t draws;         /*!< esp_bsp_sdl_draw_bitmap() calls */
+    uint32_t caset_sent;    /*!< Column address commands sent */
+    uint32_t caset_elided;  /*!< Column address commands skipped, window unchanged */
+    uint32_t raset_sent;    /*!< Row address commands sent */
+    uint32_t raset_elided;  /*!< Row address commands skipped, window unchanged */
+    uint32_t ramwrc_writes; /*!< Writes continued with RAMWRC, no address commands at all */
+    uint64_t pixel_bytes;   /*!< Pixel bytes sent to the panel */
+    uint32_t frames;        /*!< esp_bsp_sdl_flush_frame() calls */
+    uint32_t tiles_checked; /*!< Tiles compared in auto-dirty mode */
+    uint32_t tiles_dirty;   /*!< Tiles found changed in auto-dirty mode */
+    uint64_t skipped_bytes; /*!< Pixel bytes not sent because they were unchanged */
+    uint64_t diff_time_us;  /*!< Time spent detecting changes */
+    uint64_t flush_time_us; /*!< Total time spent in esp_bsp_sdl_flush_frame() */
+    uint64_t bounced_bytes; /*!< Pixel bytes staged through internal bounce buffers */
+    uint32_t scrolls;       /*!< esp_bsp_sdl_scroll() calls */
+    uint32_t scroll_lines;  /*!< Lines scrolled, sum of the scroll distances */
+    uint64_t scroll_bytes;  /*!< Command and pixel bytes esp_bsp_sdl_scroll() sent to the panel */
+    uint64_t scroll_moved;  /*!< Frame buffer bytes moved by frame buffer scrolling */
+} esp_bsp_sdl_flush_stats_t;
+
+/**
+ * @brief Automatic dirty region detection for esp_bsp_sdl_flush_frame()
+ */
+typedef enum {
+    ESP_BSP_SDL_DIRTY_OFF = 0,   /*!< Every frame is sent completely */
+    ESP_BSP_SDL_DIRTY_SHADOW,    /*!< Compare against a shadow copy of the last flushed frame */
+    ESP_BSP_SDL_DIRTY_TILE_HASH, /*!< Compare 32-bit tile signatures, a few KB instead of a full frame */
+} esp_bsp_sdl_dirty_mode_t;
+
 /**
  * @brief Board interface function pointer structure (for internal use)
+ *
+ * Optional members may be left NULL by boards that do not support them.
  */
 typedef struct {
     esp_err_t (*init)(esp_bsp_sdl_display_config_t *config,
@@ -52,6 +133,16 @@ typedef struct {
     esp_err_t (*touch_read)(esp_bsp_sdl_touch_info_t *touch_info);
     const char *(*get_name)(void);
     esp_err_t (*deinit)(void);
+    /* Optional: rotate in the panel controller (MADCTL) or panel driver, no per-frame cost */
+    esp_err_t (*set_orientation)(esp_bsp_sdl_orientation_t orientation);
+    /* Optional: native frame buffer, used for software rotation on DPI panels */
+    esp_err_t (*get_frame_buffer)(void **frame_buffer);
+    /* Optional: controller gamma curves, non-NULL if the controller accepts PGAMCTRL/NGAMCTRL */
+    const esp_bsp_sdl_panel_gamma_t *panel_gamma;
+    /* Optional: set for MIPI-DBI panels, enables the address window cache in esp_bsp_sdl_draw_bitmap() */
+    const esp_bsp_sdl_dbi_info_t *dbi;
+    /* Optional: called by the flush functions once a frame has reached the panel */
+    void (*frame_presented)(void);
     const char *board_name;
 } esp_bsp_sdl_board_interface_t;
 
@@ -107,6 +198,175 @@ esp_err_t esp_bsp_sdl_touch_init(void);
  */
 esp_err_t esp_bsp_sdl_touch_read(esp_bsp_sdl_touch_info_t *touch_info);
 
+/**
+ * @brief Set the logical display orientation
+ *
+ * SPI and RGB panels are rotated by the panel controller or driver (esp_lcd_panel_swap_xy /
+ * esp_lcd_panel_mirror), which costs nothing per frame. DPI panels fall back to a software
+ * rotation blit in esp_bsp_sdl_draw_bitmap(). Touch coordinates returned by
+ * esp_bsp_sdl_touch_read() follow the selected orientation.
+ *
+ * @param orientation New orientation
+ * @param[in,out] config Display configuration to update with the rotated width/height (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if the board cannot rotate, error code otherwise
+ */
+esp_err_t esp_bsp_sdl_set_orientation(esp_bsp_sdl_orientation_t orientation, esp_bsp_sdl_display_config_t *config);
+
+/**
+ * @brief Get the current logical display orientation
+ *
+ * @return Current orientation
+ */
+esp_bsp_sdl_orientation_t esp_bsp_sdl_get_orientation(void);
+
+/**
+ * @brief Draw a bitmap in logical (oriented) display coordinates
+ *
+ * Same semantics as esp_lcd_panel_draw_bitmap() (end coordinates are exclusive), but honours
+ * the orientation selected with esp_bsp_sdl_set_orientation().
+ *
+ * On MIPI-DBI panels (ESP-Box-3, M5Stack CoreS3, M5 Atom S3) the current address window is
+ * cached: CASET/RASET are only sent when they change, and a band starting where the previous
+ * one ended is appended with RAMWRC without any address command. Call
+ * esp_bsp_sdl_invalidate_window() after drawing with esp_lcd_panel_draw_bitmap() directly.
+ *
+ * @param x_start Start column
+ * @param y_start Start row
+ * @param x_end End column (exclusive)
+ * @param y_end End row (exclusive)
+ * @param color_data RGB565 pixel data
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t esp_bsp_sdl_draw_bitmap(int x_start, int y_start, int x_end, int y_end, const void *color_data);
+
+/**
+ * @brief Select automatic dirty region detection
+ *
+ * In ESP_BSP_SDL_DIRTY_SHADOW mode a copy of the last flushed frame is kept (PSRAM when
+ * available) and esp_bsp_sdl_flush_frame() compares 16x16 tiles word by word with early exit;
+ * only tile rows containing changes are sent, trimmed to the changed columns.
+ * ESP_BSP_SDL_DIRTY_TILE_HASH keeps only a 32-bit signature per 16x16 tile (1.2 KB for 320x240)
+ * for boards without room for a shadow frame, at the cost of hashing every pixel and a
+ * negligible chance of missing a change on a hash collision. Only available
+ * on MIPI-DBI panels, where bus time dominates; frame-buffer panels (RGB/DPI) return
+ * ESP_ERR_NOT_SUPPORTED.
+ *
+ * @param mode Dirty detection mode
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if buffers cannot be allocated, error code otherwise
+ */
+esp_err_t esp_bsp_sdl_set_dirty_mode(esp_bsp_sdl_dirty_mode_t mode);
+
+/**
+ * @brief Present a full frame
+ *
+ * The frame covers the whole display in logical coordinates (see esp_bsp_sdl_set_orientation())
+ * as RGB565 pixels in panel byte order. With a dirty mode selected only changed regions are
+ * sent. The call returns once the panel has consumed all data, so the frame can be reused.
+ *
+ * @param frame Frame pixels, width * height values
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t esp_bsp_sdl_flush_frame(const uint16_t *frame);
+
+/**
+ * @brief Select the placement policy of esp_bsp_sdl_flush_frame()
+ *
+ * The default comes from menuconfig and also sizes max_transfer_sz at init: full frames with
+ * ESP_BSP_SDL_PLACEMENT_INTERNAL, ESP_BSP_SDL_FLUSH_BAND_ROWS rows with
+ * ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE, which keeps the SPI driver from allocating a full-frame
+ * internal DMA buffer. With ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE, frames that are not DMA-capable
+ * are copied band by band into internal DMA buffers and sent while the next band is copied.
+ * Switching at runtime lets the flush statistics be compared per policy; the transfer size set
+ * at init is kept. Frame-buffer panels (RGB/DPI) copy into their own frame buffer and are not
+ * affected.
+ *
+ * @param placement Placement policy, ESP_BSP_SDL_PLACEMENT_AUTO for the menuconfig default
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an unknown policy
+ */
+esp_err_t esp_bsp_sdl_set_placement(esp_bsp_sdl_placement_t placement);
+
+/**
+ * @brief Get the placement policy in effect, never ESP_BSP_SDL_PLACEMENT_AUTO
+ */
+esp_bsp_sdl_placement_t esp_bsp_sdl_get_placement(void);
+
+/**
+ * @brief Rows of the bands rendered by esp_bsp_sdl_flush_bands()
+ */
+#define ESP_BSP_SDL_FLUSH_BAND_ROWS 16
+
+/**
+ * @brief Band render callback of esp_bsp_sdl_flush_bands()
+ *
+ * @param band Band to fill completely, full display width and up to ESP_BSP_SDL_FLUSH_BAND_ROWS rows
+ * @param y First display row of the band
+ * @param user_ctx User context
+ * @return ESP_OK to send the band, error code to stop the flush
+ */
+typedef esp_err_t (*esp_bsp_sdl_band_render_cb_t)(esp_bsp_sdl_surface_t *band, int y, void *user_ctx);
+
+/**
+ * @brief Present a frame rendered band by band, without a full frame buffer
+ *
+ * Each band is rendered into an internal DMA buffer and sent while the next one is rendered.
+ * The call returns once the panel has consumed all data.
+ *
+ * @param render Band render callback
+ * @param user_ctx Context for the callback
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if band buffers cannot be allocated, error code otherwise
+ */
+esp_err_t esp_bsp_sdl_flush_bands(esp_bsp_sdl_band_render_cb_t render, void *user_ctx);
+
+/**
+ * @brief Forget the cached panel address window
+ *
+ * Needed after anything other than esp_bsp_sdl_draw_bitmap() changed CASET/RASET, e.g. a direct
+ * esp_lcd_panel_draw_bitmap() call.
+ */
+void esp_bsp_sdl_invalidate_window(void);
+
+/**
+ * @brief Get flush statistics
+ *
+ * @param[out] stats Statistics to fill
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if stats is NULL
+ */
+esp_err_t esp_bsp_sdl_get_flush_stats(esp_bsp_sdl_flush_stats_t *stats);
+
+/**
+ * @brief Reset flush statistics
+ */
+void esp_bsp_sdl_reset_flush_stats(void);
+
+/**
+ * @brief Register a color transfer completion callback next to the flush engine
+ *
+ * On MIPI-DBI panels the flush functions install their own on_color_trans_done callback on the
+ * panel IO handle. esp_lcd cannot report a callback installed earlier, which would be replaced
+ * silently, so register application callbacks here instead of with
+ * esp_lcd_panel_io_register_event_callbacks(). The callback runs after the engine's own, in the
+ * same (ISR) context, and is left installed on the panel IO by esp_bsp_sdl_deinit().
+ *
+ * @param cb Callback, NULL to remove it
+ * @param user_ctx Context passed to cb
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE before esp_bsp_sdl_init(), error code otherwise
+ */
+esp_err_t esp_bsp_sdl_set_trans_done_callback(esp_lcd_panel_io_color_trans_done_cb_t cb, void *user_ctx);
+
+/**
+ * @brief Program gamma curves into the panel controller
+ *
+ * Color correction done by the controller costs nothing per pixel. Only supported on boards whose
+ * controller exposes PGAMCTRL/NGAMCTRL (ILI9342 on ESP-Box-3 and M5Stack CoreS3) and on the
+ * virtual board, which records the curves. With CONFIG_SDL_BSP_PANEL_GAMMA enabled the board
+ * default curves are loaded by esp_bsp_sdl_init().
+ *
+ * @param gamma Gamma curves, NULL to load the board default curves
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if the controller has no gamma registers,
+ *         ESP_ERR_INVALID_ARG for a length of 0 or more than 16
+ */
+esp_err_t esp_bsp_sdl_load_panel_gamma(const esp_bsp_sdl_panel_gamma_t *gamma);
+
 /**
  * @brief Get the selected board name (for debugging/logging)
  *
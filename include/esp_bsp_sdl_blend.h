@@ -0,0 +1,85 @@
+/**
+ * @file esp_bsp_sdl_blend.h
+ * @brief Alpha blending kernels onto RGB565 surfaces
+ *
+ * All kernels work on native-endian RGB565 rows and use 5-bit alpha, (alpha + 4) >> 3 in the
+ * range 0..32, so 0 leaves the destination and 255 replaces it. Every implementation of a
+ * kernel produces bit-identical results; the fastest one for the target is selected at init.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_bsp_sdl_surface.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Kernel implementations
+ */
+typedef enum {
+    ESP_BSP_SDL_BLEND_IMPL_AUTO,   /*!< Fastest implementation for the target */
+    ESP_BSP_SDL_BLEND_IMPL_SCALAR, /*!< One color channel at a time (reference) */
+    ESP_BSP_SDL_BLEND_IMPL_SWAR,   /*!< All three channels of a pixel in one 32-bit word */
+} esp_bsp_sdl_blend_impl_t;
+
+/**
+ * @brief Row kernels, count pixels each
+ */
+typedef struct {
+    /** Straight ARGB8888 (alpha in bits 31..24) over RGB565 */
+    void (*argb8888_over)(uint16_t *dst, const uint32_t *src, int count);
+    /** Premultiplied ARGB8888 over RGB565 */
+    void (*argb8888_premul_over)(uint16_t *dst, const uint32_t *src, int count);
+    /** RGB565 with a separate 8-bit alpha plane over RGB565 */
+    void (*rgb565_a8_over)(uint16_t *dst, const uint16_t *src, const uint8_t *alpha, int count);
+    /** Premultiplied RGB565 with a separate 8-bit alpha plane over RGB565 */
+    void (*rgb565_a8_premul_over)(uint16_t *dst, const uint16_t *src, const uint8_t *alpha, int count);
+    /** RGB565 with one alpha for the whole row over RGB565 */
+    void (*rgb565_const_over)(uint16_t *dst, const uint16_t *src, uint8_t alpha, int count);
+    /** One RGB565 color with 8-bit coverage per pixel over RGB565 (anti-aliased text and shapes) */
+    void (*color_a8_over)(uint16_t *dst, uint16_t color, const uint8_t *alpha, int count);
+} esp_bsp_sdl_blend_kernels_t;
+
+/**
+ * @brief Select the kernel implementation
+ *
+ * Not required before use; the kernels default to ESP_BSP_SDL_BLEND_IMPL_AUTO.
+ *
+ * @param impl Implementation
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an unknown implementation
+ */
+esp_err_t esp_bsp_sdl_blend_select(esp_bsp_sdl_blend_impl_t impl);
+
+/**
+ * @brief Get the kernels of an implementation
+ *
+ * @param impl Implementation, ESP_BSP_SDL_BLEND_IMPL_AUTO for the selected one
+ * @return Kernel table, NULL for an unknown implementation
+ */
+const esp_bsp_sdl_blend_kernels_t *esp_bsp_sdl_blend_get_kernels(esp_bsp_sdl_blend_impl_t impl);
+
+/**
+ * @brief Blend an RGB565 surface with constant alpha onto another surface
+ *
+ * @param dst Destination surface
+ * @param dst_x Destination column
+ * @param dst_y Destination row
+ * @param src Source surface
+ * @param src_rect Source rectangle, NULL for the whole surface (clipped to both surfaces)
+ * @param alpha Opacity of the source, 0..255
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid surfaces
+ */
+esp_err_t esp_bsp_sdl_blend_surface(esp_bsp_sdl_surface_t *dst,
+                                    int dst_x,
+                                    int dst_y,
+                                    const esp_bsp_sdl_surface_t *src,
+                                    const esp_bsp_sdl_rect_t *src_rect,
+                                    uint8_t alpha);
+
+#ifdef __cplusplus
+}
+#endif
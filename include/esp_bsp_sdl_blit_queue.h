@@ -0,0 +1,122 @@
+/**
+ * @file esp_bsp_sdl_blit_queue.h
+ * @brief Sprite blit queue with sorted, band-batched execution
+ *
+ * Sprites are queued for a frame, sorted by z order and source texture, binned per band of
+ * ESP_BSP_SDL_FLUSH_BAND_ROWS rows and then drawn band by band. Each band is touched once while
+ * it is hot in cache, and consecutive sprites mostly read the same texture. The queue can render
+ * into a frame buffer or straight into the band buffers of esp_bsp_sdl_flush_bands().
+ *
+ * Band sizes are counted on push and the sort is a stable radix sort, so the overhead is linear
+ * in the sprite count. Banding pays off when the target does not fit the data cache, such as a
+ * PSRAM frame buffer; a target that stays in cache draws faster with direct blits
+ * (test/host/bench_blit_queue.c compares both).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include "esp_bsp_sdl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_bsp_sdl_blit_queue_t *esp_bsp_sdl_blit_queue_handle_t;
+
+/**
+ * @brief Blit queue configuration
+ */
+typedef struct {
+    int width;              /*!< Target width in pixels */
+    int height;             /*!< Target height in pixels */
+    size_t max_sprites;     /*!< Sprites per frame, 0 for default (512) */
+    size_t max_bin_entries; /*!< Sprite references over all bands, 0 for 4 * max_sprites */
+} esp_bsp_sdl_blit_queue_config_t;
+
+/**
+ * @brief Sprite draw command
+ *
+ * Sprites are drawn in ascending z. Sprites with the same z are grouped by texture, so
+ * overlapping sprites that must keep their order need different z values.
+ */
+typedef struct {
+    const esp_bsp_sdl_surface_t *texture; /*!< Source texture, valid until the queue is executed */
+    esp_bsp_sdl_rect_t src;               /*!< Source rectangle in the texture */
+    int dst_x;                            /*!< Destination column */
+    int dst_y;                            /*!< Destination row */
+    int z;                                /*!< Draw order */
+    uint8_t alpha;                        /*!< 255 copies, lower values blend (native-endian RGB565) */
+} esp_bsp_sdl_sprite_t;
+
+/**
+ * @brief Counters of the last execution
+ */
+typedef struct {
+    uint32_t sprites;          /*!< Sprites drawn */
+    uint32_t bands;            /*!< Bands with at least one sprite */
+    uint32_t texture_switches; /*!< Consecutive draws from different textures */
+    uint64_t render_time_us;   /*!< Time spent drawing sprites */
+} esp_bsp_sdl_blit_queue_stats_t;
+
+/**
+ * @brief Create a blit queue
+ *
+ * @param config Configuration
+ * @param[out] ret_queue Created queue
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if buffers cannot be allocated
+ */
+esp_err_t esp_bsp_sdl_blit_queue_create(const esp_bsp_sdl_blit_queue_config_t *config,
+                                        esp_bsp_sdl_blit_queue_handle_t *ret_queue);
+
+/**
+ * @brief Delete a blit queue
+ */
+void esp_bsp_sdl_blit_queue_delete(esp_bsp_sdl_blit_queue_handle_t queue);
+
+/**
+ * @brief Queue a sprite
+ *
+ * @return ESP_OK on success (also for sprites outside the target), ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t esp_bsp_sdl_blit_queue_push(esp_bsp_sdl_blit_queue_handle_t queue, const esp_bsp_sdl_sprite_t *sprite);
+
+/**
+ * @brief Drop all queued sprites
+ */
+void esp_bsp_sdl_blit_queue_clear(esp_bsp_sdl_blit_queue_handle_t queue);
+
+/**
+ * @brief Draw all queued sprites into a surface, then clear the queue
+ *
+ * @param queue Blit queue
+ * @param target Target surface, at least width x height of the configuration
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the target is too small, ESP_ERR_NO_MEM if the queued
+ *         sprites need more than max_bin_entries band references
+ */
+esp_err_t esp_bsp_sdl_blit_queue_render(esp_bsp_sdl_blit_queue_handle_t queue, esp_bsp_sdl_surface_t *target);
+
+/**
+ * @brief Present the queued sprites on the display through esp_bsp_sdl_flush_bands(), then clear the queue
+ *
+ * Every band starts from the background (or the clear color) and gets its sprites drawn on top,
+ * so no full frame buffer is needed.
+ *
+ * @param queue Blit queue, configured with the logical display size
+ * @param background Full-screen background, NULL to use clear_color
+ * @param clear_color Background color when background is NULL
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the queue does not match the display, error code otherwise
+ */
+esp_err_t esp_bsp_sdl_blit_queue_flush(esp_bsp_sdl_blit_queue_handle_t queue,
+                                       const esp_bsp_sdl_surface_t *background,
+                                       uint16_t clear_color);
+
+/**
+ * @brief Get counters of the last execution
+ */
+esp_err_t esp_bsp_sdl_blit_queue_get_stats(esp_bsp_sdl_blit_queue_handle_t queue,
+                                           esp_bsp_sdl_blit_queue_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,194 @@
+/**
+ * @file esp_bsp_sdl_capture.h
+ * @brief Frame capture of presented frames into a replayable container
+ *
+ * While a capture runs, every frame presented with esp_bsp_sdl_flush_frame() or
+ * esp_bsp_sdl_flush_bands() (or every Nth) is written to a FILE together with its flush frame
+ * number, timestamp and per-frame flush counters, so stutter sessions can be replayed offline and
+ * hitches lined up with the flush statistics.
+ *
+ * Container layout, little-endian, written strictly sequentially (works on stdout or a UART):
+ *
+ *     esp_bsp_sdl_capture_file_header_t
+ *     per captured frame:
+ *         esp_bsp_sdl_capture_frame_header_t
+ *         esp_bsp_sdl_capture_chunk_t + payload, repeated, whole rows top to bottom
+ *         esp_bsp_sdl_capture_chunk_t (END) + esp_bsp_sdl_capture_frame_stats_t
+ *     esp_bsp_sdl_capture_index_entry_t per captured frame
+ *     esp_bsp_sdl_capture_trailer_t
+ *
+ * RAW chunks hold the pixels as passed to the flush functions. DELTA chunks hold (skip, copy)
+ * uint16_t pairs, each followed by copy pixels, against the same rows of the previous captured
+ * frame; rows without a chunk are unchanged. Key frames contain RAW chunks only. A capture cut
+ * short has no index; the frame records can still be read one after the other. The reader in
+ * test/host/test_capture.c decodes the container and serves as its reference.
+ *
+ * Frames that never pass through the flush functions, e.g. the memory of an offscreen panel drawn
+ * with esp_lcd_panel_draw_bitmap(), are captured with esp_bsp_sdl_capture_surface().
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_bsp_sdl_surface.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_BSP_SDL_CAPTURE_VERSION 1 /*!< Container version */
+
+#define ESP_BSP_SDL_CAPTURE_FLAG_DELTA 0x1 /*!< File header: DELTA chunks may occur */
+#define ESP_BSP_SDL_CAPTURE_FLAG_KEY   0x1 /*!< Frame header/index: frame contains RAW chunks only */
+
+/**
+ * @brief Chunk types
+ */
+typedef enum {
+    ESP_BSP_SDL_CAPTURE_CHUNK_RAW = 0, /*!< rows x width pixels */
+    ESP_BSP_SDL_CAPTURE_CHUNK_DELTA,   /*!< (skip, copy) runs against the previous captured frame */
+    ESP_BSP_SDL_CAPTURE_CHUNK_END,     /*!< End of frame, esp_bsp_sdl_capture_frame_stats_t */
+} esp_bsp_sdl_capture_chunk_type_t;
+
+/**
+ * @brief Container header
+ */
+typedef struct {
+    char magic[4];      /*!< "SDLC" */
+    uint16_t version;   /*!< ESP_BSP_SDL_CAPTURE_VERSION */
+    uint16_t flags;     /*!< ESP_BSP_SDL_CAPTURE_FLAG_DELTA */
+    uint32_t every_nth; /*!< Capture interval in presented frames */
+    uint32_t reserved;  /*!< Zero */
+    int64_t start_us;   /*!< esp_timer time at esp_bsp_sdl_capture_start() */
+} esp_bsp_sdl_capture_file_header_t;
+
+/**
+ * @brief Frame record header
+ */
+typedef struct {
+    char magic[4];        /*!< "FRME" */
+    uint32_t seq;         /*!< Flush frame number, esp_bsp_sdl_flush_stats_t::frames before this frame */
+    int64_t timestamp_us; /*!< esp_timer time at the start of the flush */
+    uint16_t width;       /*!< Frame width (logical orientation) */
+    uint16_t height;      /*!< Frame height */
+    uint32_t flags;       /*!< ESP_BSP_SDL_CAPTURE_FLAG_KEY */
+} esp_bsp_sdl_capture_frame_header_t;
+
+/**
+ * @brief Chunk header
+ */
+typedef struct {
+    uint8_t type;       /*!< esp_bsp_sdl_capture_chunk_type_t */
+    uint8_t reserved;   /*!< Zero */
+    uint16_t first_row; /*!< First row covered */
+    uint16_t rows;      /*!< Rows covered */
+    uint16_t reserved2; /*!< Zero */
+    uint32_t size;      /*!< Payload bytes following the header */
+} esp_bsp_sdl_capture_chunk_t;
+
+/**
+ * @brief Per-frame flush counters, payload of the END chunk
+ */
+typedef struct {
+    uint32_t flush_time_us; /*!< Time spent in the flush call, capture excluded */
+    uint32_t draws;         /*!< esp_bsp_sdl_draw_bitmap() calls */
+    uint32_t tiles_dirty;   /*!< Tiles found changed in auto-dirty mode */
+    uint32_t reserved;      /*!< Zero */
+    uint64_t pixel_bytes;   /*!< Pixel bytes sent to the panel */
+} esp_bsp_sdl_capture_frame_stats_t;
+
+/**
+ * @brief Index entry, one per captured frame
+ */
+typedef struct {
+    uint32_t seq;         /*!< Flush frame number */
+    uint32_t flags;       /*!< ESP_BSP_SDL_CAPTURE_FLAG_KEY */
+    int64_t timestamp_us; /*!< esp_timer time at the start of the flush */
+    uint64_t offset;      /*!< Byte offset of the frame record header */
+} esp_bsp_sdl_capture_index_entry_t;
+
+/**
+ * @brief Container trailer, the last bytes of a completed capture
+ */
+typedef struct {
+    char magic[4];         /*!< "SDLX" */
+    uint32_t count;        /*!< Index entries */
+    uint64_t index_offset; /*!< Byte offset of the first index entry */
+} esp_bsp_sdl_capture_trailer_t;
+
+/**
+ * @brief Capture configuration
+ */
+typedef struct {
+    FILE *out;             /*!< Output stream (file on SD, host file system, stdout), owned by the caller */
+    uint32_t every_nth;    /*!< Capture every Nth presented frame, 0 or 1 for every frame */
+    bool delta;            /*!< Encode frames against the previous captured frame */
+    uint32_t key_interval; /*!< Captured frames between key frames in delta mode, 0 for the first frame only */
+    bool manual;           /*!< Only capture frames passed to esp_bsp_sdl_capture_surface(), not the flush functions */
+} esp_bsp_sdl_capture_config_t;
+
+/**
+ * @brief Capture counters
+ */
+typedef struct {
+    uint32_t frames_seen;     /*!< Frames presented while capturing */
+    uint32_t frames_written;  /*!< Frames written */
+    uint32_t key_frames;      /*!< Frames written as key frames */
+    uint64_t raw_bytes;       /*!< Pixel bytes of the written frames */
+    uint64_t written_bytes;   /*!< Bytes written, headers included */
+    uint64_t capture_time_us; /*!< Time spent encoding and writing */
+    uint32_t write_errors;    /*!< Failed writes, the capture stops at the first one */
+} esp_bsp_sdl_capture_summary_t;
+
+/**
+ * @brief Start capturing presented frames
+ *
+ * Writes the container header. In delta mode the previous frame is kept in PSRAM when available.
+ * Call from the task that flushes.
+ *
+ * @param config Configuration
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG without an output stream, ESP_ERR_INVALID_STATE if a
+ *         capture is running, ESP_FAIL if the header cannot be written
+ */
+esp_err_t esp_bsp_sdl_capture_start(const esp_bsp_sdl_capture_config_t *config);
+
+/**
+ * @brief Stop capturing, write the index and the trailer and flush the stream
+ *
+ * The stream stays open. Counters stay available until the next start.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no capture is running, ESP_FAIL if a write failed
+ */
+esp_err_t esp_bsp_sdl_capture_stop(void);
+
+/**
+ * @brief Capture a frame that was not presented through the flush functions
+ *
+ * The frame record gets the number of esp_bsp_sdl_capture_surface() calls as sequence number and
+ * the flush counters accumulated since the previous call. every_nth applies as for presented frames.
+ * Call from one task only; use a manual capture when the flush functions run in another task.
+ *
+ * @param frame RGB565 frame, stride in pixels
+ * @return ESP_OK on success or when the frame is skipped, ESP_ERR_INVALID_ARG without a frame,
+ *         ESP_ERR_INVALID_STATE if no capture is running, ESP_FAIL if a write failed
+ */
+esp_err_t esp_bsp_sdl_capture_surface(const esp_bsp_sdl_surface_t *frame);
+
+/**
+ * @brief Check whether a capture is running
+ */
+bool esp_bsp_sdl_capture_is_active(void);
+
+/**
+ * @brief Get capture counters
+ *
+ * @param[out] summary Counters to fill
+ */
+void esp_bsp_sdl_capture_get_summary(esp_bsp_sdl_capture_summary_t *summary);
+
+#ifdef __cplusplus
+}
+#endif
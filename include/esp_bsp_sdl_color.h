@@ -0,0 +1,76 @@
+/**
+ * @file esp_bsp_sdl_color.h
+ * @brief Color correction applied in the RGB888 to RGB565 conversion
+ *
+ * A color profile (3x3 matrix + per-channel gamma) is turned into lookup tables once, so the
+ * per-pixel cost of correction is a handful of table lookups and additions, no float math.
+ * No board ships a profile: the application passes one measured for its panel, or none.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Color profile of a panel
+ *
+ * Each output channel is computed as gamma[c](sum_k(matrix[c][k] * in[k])) on 0..255 values.
+ * Matrix coefficients are limited to [-2, 2].
+ */
+typedef struct {
+    float matrix[3][3]; /*!< Row-major RGB mixing matrix, identity for no correction */
+    float gamma[3];     /*!< Per-channel exponent applied after the matrix, 1.0 for none */
+} esp_bsp_sdl_color_profile_t;
+
+/**
+ * @brief Precomputed conversion tables built from a color profile
+ */
+typedef struct {
+    int16_t matrix[3][3][256]; /*!< matrix[c][k][v] = matrix coefficient * v, 6 fractional bits */
+    uint16_t out[3][256];      /*!< Gamma-corrected value already shifted into its RGB565 position */
+    bool identity_matrix;      /*!< Skip the matrix stage */
+} esp_bsp_sdl_color_lut_t;
+
+/**
+ * @brief Identity profile (no correction)
+ */
+extern const esp_bsp_sdl_color_profile_t esp_bsp_sdl_color_profile_identity;
+
+/**
+ * @brief Build conversion tables from a color profile
+ *
+ * @param profile Color profile, NULL for identity
+ * @param[out] lut Tables to fill
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on NULL lut or out-of-range coefficients
+ */
+esp_err_t esp_bsp_sdl_color_lut_build(const esp_bsp_sdl_color_profile_t *profile, esp_bsp_sdl_color_lut_t *lut);
+
+/**
+ * @brief Convert packed RGB888 pixels to RGB565 with color correction
+ *
+ * With an identity matrix the result matches a float evaluation of the profile exactly. Otherwise
+ * the matrix result is rounded to 8 bits before the gamma stage; each channel then stays within
+ * 1 LSB of the float result for gamma 0.6 and above, steeper curves below 0.6 magnify the rounding.
+ *
+ * @param lut Tables from esp_bsp_sdl_color_lut_build()
+ * @param src Source pixels, 3 bytes per pixel in R, G, B order
+ * @param[out] dst Destination RGB565 pixels
+ * @param pixels Number of pixels
+ * @param swap_bytes Emit big-endian RGB565 (as expected by SPI panels)
+ */
+void esp_bsp_sdl_color_convert_rgb888_to_rgb565(const esp_bsp_sdl_color_lut_t *lut,
+                                                const uint8_t *src,
+                                                uint16_t *dst,
+                                                size_t pixels,
+                                                bool swap_bytes);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,164 @@
+/**
+ * @file esp_bsp_sdl_compositor.h
+ * @brief Layer compositor with per-layer dirty tracking and a cached composition of lower layers
+ *
+ * UIs are often a static background, a semi-static widget layer and a small layer of moving
+ * sprites. The compositor holds up to ESP_BSP_SDL_COMPOSITOR_MAX_LAYERS layers, each an RGB565
+ * surface with a position and opaque, constant alpha or per-pixel alpha (A8 plane) coverage.
+ * Changes are tracked per layer and 16x16 tile. The bottom cached_layers are composed into a
+ * cache frame that is only rebuilt where one of them changed; a flush composes the dirty tiles
+ * from the cache and the layers above it and sends nothing else.
+ *
+ * Layer pixels belong to the application. After drawing into a layer, report the changed area
+ * with esp_bsp_sdl_compositor_invalidate().
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_bsp_sdl_surface.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum number of layers, the dirty map holds one bit per layer and tile
+ */
+#define ESP_BSP_SDL_COMPOSITOR_MAX_LAYERS 8
+
+/**
+ * @brief Edge length of the dirty tiles in pixels, ESP_BSP_SDL_FLUSH_BAND_ROWS
+ */
+#define ESP_BSP_SDL_COMPOSITOR_TILE 16
+
+typedef struct esp_bsp_sdl_compositor_t *esp_bsp_sdl_compositor_handle_t;
+
+/**
+ * @brief Compositor configuration
+ */
+typedef struct {
+    int width;            /*!< Output width in pixels */
+    int height;           /*!< Output height in pixels */
+    int layers;           /*!< Number of layers, 1 to ESP_BSP_SDL_COMPOSITOR_MAX_LAYERS */
+    int cached_layers;    /*!< Bottom layers composed into the cache frame, 0 for no cache */
+    uint16_t clear_color; /*!< Color below layer 0 */
+} esp_bsp_sdl_compositor_config_t;
+
+/**
+ * @brief Layer description
+ */
+typedef struct {
+    esp_bsp_sdl_surface_t surface; /*!< Layer pixels, NULL pixels for an empty layer */
+    const uint8_t *alpha;          /*!< Per-pixel alpha with the stride of the surface, NULL for none */
+    int x;                         /*!< Output column of the surface */
+    int y;                         /*!< Output row of the surface */
+    uint8_t opacity;               /*!< Constant alpha of layers without alpha plane, 255 copies */
+    bool visible;                  /*!< Hidden layers are skipped */
+} esp_bsp_sdl_layer_t;
+
+/**
+ * @brief Composition counters, accumulated until esp_bsp_sdl_compositor_reset_stats()
+ */
+typedef struct {
+    uint32_t frames;          /*!< Flushes and renders */
+    uint32_t tiles_dirty;     /*!< Tiles with at least one changed layer */
+    uint32_t tiles_composed;  /*!< Tiles composed, clean tiles between dirty ones of a tile row included */
+    uint32_t cache_rebuilds;  /*!< Tiles of the cache frame composed again */
+    uint64_t read_bytes;      /*!< Layer, alpha plane and cache bytes read while composing */
+    uint64_t full_bytes;      /*!< Bytes a full composition of every layer would have read for the same frames */
+    uint64_t compose_time_us; /*!< Time spent composing */
+} esp_bsp_sdl_compositor_stats_t;
+
+/**
+ * @brief Create a compositor with all layers empty
+ *
+ * The cache frame is allocated in PSRAM when available. The first flush or render composes the
+ * whole output.
+ *
+ * @param config Configuration
+ * @param[out] ret_compositor Created compositor
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid configuration, ESP_ERR_NO_MEM if memory is short
+ */
+esp_err_t esp_bsp_sdl_compositor_create(const esp_bsp_sdl_compositor_config_t *config,
+                                        esp_bsp_sdl_compositor_handle_t *ret_compositor);
+
+/**
+ * @brief Delete a compositor
+ */
+void esp_bsp_sdl_compositor_delete(esp_bsp_sdl_compositor_handle_t compositor);
+
+/**
+ * @brief Set the pixels, position and coverage of a layer
+ *
+ * Marks the areas covered by the layer before and after the change as dirty.
+ *
+ * @param compositor Compositor
+ * @param index Layer index, 0 is the bottom layer
+ * @param layer Layer description, copied
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid arguments
+ */
+esp_err_t esp_bsp_sdl_compositor_set_layer(esp_bsp_sdl_compositor_handle_t compositor,
+                                           int index,
+                                           const esp_bsp_sdl_layer_t *layer);
+
+/**
+ * @brief Move a layer
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an invalid index
+ */
+esp_err_t esp_bsp_sdl_compositor_move_layer(esp_bsp_sdl_compositor_handle_t compositor, int index, int x, int y);
+
+/**
+ * @brief Report changed pixels of a layer
+ *
+ * @param compositor Compositor
+ * @param index Layer index
+ * @param rect Changed area in layer coordinates, NULL for the whole layer
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an invalid index
+ */
+esp_err_t esp_bsp_sdl_compositor_invalidate(esp_bsp_sdl_compositor_handle_t compositor,
+                                            int index,
+                                            const esp_bsp_sdl_rect_t *rect);
+
+/**
+ * @brief Compose the dirty tiles into a surface
+ *
+ * The target is expected to hold the previous composition, e.g. a DPI frame buffer. Use either
+ * this or esp_bsp_sdl_compositor_flush() with one compositor, both consume the dirty tiles.
+ *
+ * @param compositor Compositor
+ * @param target Target surface, at least the configured size
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the target is too small
+ */
+esp_err_t esp_bsp_sdl_compositor_render(esp_bsp_sdl_compositor_handle_t compositor, esp_bsp_sdl_surface_t *target);
+
+/**
+ * @brief Present the dirty tiles on the display
+ *
+ * Each tile row sends one area from the first to the last dirty tile, composed straight into the
+ * internal band buffers of the flush engine: no output frame buffer is needed. Partial frames are
+ * not recorded by esp_bsp_sdl_capture_start().
+ *
+ * @param compositor Compositor configured with the logical display size
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the size does not match the display, error code
+ *         otherwise (the whole output is composed again on the next call)
+ */
+esp_err_t esp_bsp_sdl_compositor_flush(esp_bsp_sdl_compositor_handle_t compositor);
+
+/**
+ * @brief Get composition counters
+ */
+esp_err_t esp_bsp_sdl_compositor_get_stats(esp_bsp_sdl_compositor_handle_t compositor,
+                                           esp_bsp_sdl_compositor_stats_t *stats);
+
+/**
+ * @brief Reset composition counters
+ */
+void esp_bsp_sdl_compositor_reset_stats(esp_bsp_sdl_compositor_handle_t compositor);
+
+#ifdef __cplusplus
+}
+#endif
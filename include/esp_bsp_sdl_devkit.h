@@ -0,0 +1,66 @@
+/**
+ * @file esp_bsp_sdl_devkit.h
+ * @brief Headless DevKit board: offscreen panel with frame export
+ *
+ * The DevKit board has no display. It draws into an offscreen virtual panel (frame in PSRAM when
+ * available) that accepts the same esp_lcd commands as a real controller, so SDL workloads run
+ * and can be profiled on display-less devkits. Changed frames are exported from a low-priority
+ * task, or from esp_bsp_sdl_devkit_export_frame() in the minimal-footprint profile, in the
+ * esp_bsp_sdl_capture.h container, delta-compressed against the previous exported frame, to a
+ * stream such as a VFS UART, USB-Serial-JTAG, a file or a socket opened with fdopen().
+ * The frame memory can also be read back with esp_bsp_sdl_virtual_panel_get_frame().
+ *
+ * Only available when the DevKit board is selected in menuconfig.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start exporting frames to a stream
+ *
+ * The stream must pass bytes unchanged (LF line endings on VFS UARTs) and must not carry log
+ * output. Frames are exported at most every CONFIG_SDL_BSP_DEVKIT_EXPORT_INTERVAL_MS, and only
+ * when the panel was drawn to since the previous export. The export task never reads the panel
+ * memory while it is drawn to: at the end of esp_bsp_sdl_flush_frame(), esp_bsp_sdl_flush_bands()
+ * and esp_bsp_sdl_flush_rects(), and in esp_bsp_sdl_devkit_export_frame(), the presenting task
+ * copies the frame into one of two snapshots (PSRAM when available) and the task encodes the
+ * other one. The minimal-footprint profile runs no export task and needs no snapshots; frames are
+ * exported from esp_bsp_sdl_devkit_export_frame() only. Call from the presenting task.
+ *
+ * @param out Output stream, owned by the caller
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG without a stream, ESP_ERR_INVALID_STATE before
+ *         esp_bsp_sdl_init() or while an export or capture runs, ESP_ERR_NO_MEM if the task or the
+ *         snapshots cannot be allocated, ESP_FAIL if the container header cannot be written
+ */
+esp_err_t esp_bsp_sdl_devkit_export_start(FILE *out);
+
+/**
+ * @brief Stop exporting, write the container index and flush the stream
+ *
+ * Frames drawn since the last frame boundary are exported first. Call from the presenting task.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no export runs, ESP_FAIL if a write failed
+ */
+esp_err_t esp_bsp_sdl_devkit_export_stop(void);
+
+/**
+ * @brief Export the current frame now if the panel was drawn to since the previous export
+ *
+ * Call after presenting a frame with esp_bsp_sdl_draw_bitmap() or esp_lcd_panel_draw_bitmap(); the
+ * flush functions mark frame boundaries on their own. With the export task this copies the frame
+ * and wakes the task; in the minimal-footprint profile the frame is written from the calling task.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no export runs, ESP_FAIL if a write failed
+ */
+esp_err_t esp_bsp_sdl_devkit_export_frame(void);
+
+#ifdef __cplusplus
+}
+#endif
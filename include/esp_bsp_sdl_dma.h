@@ -0,0 +1,79 @@
+/**
+ * @file esp_bsp_sdl_dma.h
+ * @brief Frame buffer fill and copy offloaded to GDMA
+ *
+ * Large regions are moved by the async memcpy driver while the CPU keeps rendering. Small
+ * regions, regions that do not meet the DMA alignment rules and targets without GDMA use
+ * memset/memcpy instead. Only one operation is in flight; starting another waits for it.
+ */
+
+#pragma once
+
+#include "esp_bsp_sdl_surface.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Completion callback
+ *
+ * Runs in interrupt context when the operation was offloaded, and in the calling task before
+ * esp_bsp_sdl_fill()/esp_bsp_sdl_copy() return when the CPU did the work.
+ *
+ * @param user_ctx User context passed to the operation
+ */
+typedef void (*esp_bsp_sdl_dma_done_cb_t)(void *user_ctx);
+
+/**
+ * @brief Fill a rectangle of a surface with a color
+ *
+ * @param dst Destination surface
+ * @param rect Rectangle to fill, NULL for the whole surface (clipped to the surface)
+ * @param color RGB565 color, in the byte order of the surface
+ * @param done_cb Completion callback, may be NULL
+ * @param user_ctx Context for the callback
+ * @return ESP_OK once the operation is started (or done), error otherwise
+ */
+esp_err_t esp_bsp_sdl_fill(esp_bsp_sdl_surface_t *dst,
+                           const esp_bsp_sdl_rect_t *rect,
+                           uint16_t color,
+                           esp_bsp_sdl_dma_done_cb_t done_cb,
+                           void *user_ctx);
+
+/**
+ * @brief Copy a rectangle between surfaces
+ *
+ * Source and destination must not overlap.
+ *
+ * @param dst Destination surface
+ * @param dst_x Destination column
+ * @param dst_y Destination row
+ * @param src Source surface
+ * @param src_rect Source rectangle, NULL for the whole surface (clipped to both surfaces)
+ * @param done_cb Completion callback, may be NULL
+ * @param user_ctx Context for the callback
+ * @return ESP_OK once the operation is started (or done), error otherwise
+ */
+esp_err_t esp_bsp_sdl_copy(esp_bsp_sdl_surface_t *dst,
+                           int dst_x,
+                           int dst_y,
+                           const esp_bsp_sdl_surface_t *src,
+                           const esp_bsp_sdl_rect_t *src_rect,
+                           esp_bsp_sdl_dma_done_cb_t done_cb,
+                           void *user_ctx);
+
+/**
+ * @brief Wait until the operation in flight is finished
+ *
+ * Call before the CPU touches memory of an offloaded fill or copy.
+ *
+ * @param timeout_ms Timeout in milliseconds, -1 to wait forever
+ * @return ESP_OK when idle, ESP_ERR_TIMEOUT otherwise
+ */
+esp_err_t esp_bsp_sdl_dma_wait(int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
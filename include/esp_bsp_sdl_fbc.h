@@ -0,0 +1,127 @@
+/**
+ * @file esp_bsp_sdl_fbc.h
+ * @brief Lossless tile-compressed frame buffer
+ *
+ * The frame is kept as 16x16 tiles, each stored as a constant color (header only, no PSRAM
+ * access), run-length encoded rows or raw pixels, whichever reads less. Every tile keeps a full
+ * raw-sized slot, so the store is as large as an uncompressed frame; the saving is in reads only.
+ *
+ * On SPI/I80 panels esp_bsp_sdl_fbc_flush() decompresses tile rows into the internal band
+ * buffers, so flat UI content costs a fraction of the PSRAM reads of an uncompressed frame
+ * buffer. RGB/DPI boards copy the bands into the driver's PSRAM frame buffer, which scanout
+ * reads uncompressed: there the flush is an extra decode pass that saves no bandwidth. Only a
+ * panel created without a frame buffer, filling its bounce buffers from esp_bsp_sdl_fbc_read()
+ * in on_bounce_empty, reads compressed at scanout; none of the boards here does that.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_bsp_sdl_surface.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Tile edge length in pixels
+ */
+#define ESP_BSP_SDL_FBC_TILE 16
+
+typedef struct esp_bsp_sdl_fbc_t *esp_bsp_sdl_fbc_handle_t;
+
+/**
+ * @brief Compression counters
+ */
+typedef struct {
+    uint32_t tiles_const; /*!< Tiles currently stored as a constant color */
+    uint32_t tiles_rle;   /*!< Tiles currently stored run-length encoded */
+    uint32_t tiles_raw;   /*!< Tiles currently stored as raw pixels */
+    uint64_t bytes_read;  /*!< Compressed bytes read from the tile store while decoding */
+    uint64_t bytes_raw;   /*!< Bytes an uncompressed frame buffer would have read for the same pixels */
+} esp_bsp_sdl_fbc_stats_t;
+
+/**
+ * @brief Create a compressed frame buffer, initially filled with black
+ *
+ * The tile store is allocated in PSRAM when available.
+ *
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @param[out] ret_fbc Created frame buffer
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if memory is short
+ */
+esp_err_t esp_bsp_sdl_fbc_create(int width, int height, esp_bsp_sdl_fbc_handle_t *ret_fbc);
+
+/**
+ * @brief Delete a compressed frame buffer
+ */
+void esp_bsp_sdl_fbc_delete(esp_bsp_sdl_fbc_handle_t fbc);
+
+/**
+ * @brief Store pixels into the frame buffer
+ *
+ * Tiles completely covered are encoded straight from src; partially covered tiles are
+ * decoded, merged and encoded again. Passing tile-aligned internal buffers (e.g. rendered
+ * tile by tile) avoids any uncompressed PSRAM traffic.
+ *
+ * @param fbc Frame buffer
+ * @param src Source pixels
+ * @param x Destination column of the source
+ * @param y Destination row of the source
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid arguments
+ */
+esp_err_t esp_bsp_sdl_fbc_write(esp_bsp_sdl_fbc_handle_t fbc, const esp_bsp_sdl_surface_t *src, int x, int y);
+
+/**
+ * @brief Fill a rectangle with a color
+ *
+ * Tiles completely covered become constant tiles without touching the tile store.
+ *
+ * @param fbc Frame buffer
+ * @param rect Rectangle, NULL for the whole frame
+ * @param color Fill color
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on invalid arguments
+ */
+esp_err_t esp_bsp_sdl_fbc_fill(esp_bsp_sdl_fbc_handle_t fbc, const esp_bsp_sdl_rect_t *rect, uint16_t color);
+
+/**
+ * @brief Decode a linear pixel range (row-major, frame width per row)
+ *
+ * Matches the RGB panel bounce buffer callback (on_bounce_empty of a panel created with
+ * flags.no_fb), which asks for len_px pixels at pos_px.
+ *
+ * @param fbc Frame buffer
+ * @param pos_px First pixel, y * width + x
+ * @param len_px Pixels to decode
+ * @param[out] dst Destination
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the range exceeds the frame
+ */
+esp_err_t esp_bsp_sdl_fbc_read(esp_bsp_sdl_fbc_handle_t fbc, size_t pos_px, size_t len_px, uint16_t *dst);
+
+/**
+ * @brief Present the frame through esp_bsp_sdl_flush_bands()
+ *
+ * Reads less PSRAM than an uncompressed frame only on band-flushed (SPI/I80) panels, see the
+ * file description.
+ *
+ * @param fbc Frame buffer with the logical display size
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the size does not match the display, error code otherwise
+ */
+esp_err_t esp_bsp_sdl_fbc_flush(esp_bsp_sdl_fbc_handle_t fbc);
+
+/**
+ * @brief Get compression counters
+ */
+esp_err_t esp_bsp_sdl_fbc_get_stats(esp_bsp_sdl_fbc_handle_t fbc, esp_bsp_sdl_fbc_stats_t *stats);
+
+/**
+ * @brief Reset the read counters (bytes_read, bytes_raw)
+ */
+void esp_bsp_sdl_fbc_reset_stats(esp_bsp_sdl_fbc_handle_t fbc);
+
+#ifdef __cplusplus
+}
+#endif
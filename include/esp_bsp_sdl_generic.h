@@ -0,0 +1,84 @@
+/**
+ * @file esp_bsp_sdl_generic.h
+ * @brief Generic SPI panel board built from a declarative panel descriptor
+ *
+ * Boards without an official BSP (ESP32-C3-LCDkit, ESP32-C6 DevKit with an external display,
+ * custom products) describe their panel here: controller, SPI host and pins, clock, color order
+ * and offsets. The board creates the SPI bus, the esp_lcd panel IO and the panel itself and
+ * registers as a MIPI-DBI panel, so the window cache, auto-dirty flush and MADCTL rotation work
+ * as on the BSP boards. The defaults come from menuconfig; call esp_bsp_sdl_generic_set_panel()
+ * before esp_bsp_sdl_init() to describe the panel in code instead.
+ *
+ * Only available when a generic panel board is selected in menuconfig.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_lcd_touch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Panel controllers known to the generic board
+ */
+typedef enum {
+    ESP_BSP_SDL_PANEL_ST7789 = 0, /*!< ST7789, driver built into esp_lcd */
+    ESP_BSP_SDL_PANEL_ILI9341,    /*!< ILI9341, espressif/esp_lcd_ili9341 */
+    ESP_BSP_SDL_PANEL_GC9A01,     /*!< GC9A01, espressif/esp_lcd_gc9a01 */
+    ESP_BSP_SDL_PANEL_MAX,
+} esp_bsp_sdl_panel_controller_t;
+
+/**
+ * @brief Panel descriptor
+ */
+typedef struct {
+    esp_bsp_sdl_panel_controller_t controller; /*!< Panel controller */
+    int width;                                 /*!< Visible width in pixels */
+    int height;                                /*!< Visible height in pixels */
+    int spi_host;                              /*!< SPI host (spi_host_device_t), SPI2_HOST or SPI3_HOST */
+    uint32_t pclk_hz;                          /*!< SPI clock */
+    int pin_sclk;                              /*!< SPI clock pin */
+    int pin_mosi;                              /*!< SPI data pin */
+    int pin_cs;                                /*!< Chip select pin, -1 if tied low */
+    int pin_dc;                                /*!< Data/command pin */
+    int pin_rst;                               /*!< Reset pin, -1 for software reset */
+    int pin_backlight;                         /*!< Backlight pin, -1 if always on */
+    bool backlight_on_level;                   /*!< Backlight pin level that turns the backlight on */
+    bool bgr;                                  /*!< Panel expects BGR element order */
+    bool invert_color;                         /*!< Invert colors (most IPS panels) */
+    bool mirror_x;                             /*!< Mirror X in the native orientation */
+    bool mirror_y;                             /*!< Mirror Y in the native orientation */
+    int x_gap;                                 /*!< Column offset of the visible area in controller RAM */
+    int y_gap;                                 /*!< Row offset of the visible area in controller RAM */
+    esp_lcd_touch_handle_t touch;              /*!< Touch controller created by the application, NULL for none */
+} esp_bsp_sdl_generic_panel_t;
+
+/**
+ * @brief Get the panel descriptor selected in menuconfig
+ *
+ * @param[out] panel Descriptor to fill
+ */
+void esp_bsp_sdl_generic_get_default(esp_bsp_sdl_generic_panel_t *panel);
+
+/**
+ * @brief Describe the panel to create on esp_bsp_sdl_init()
+ *
+ * The descriptor is copied. The touch handle stays owned by the application; touch coordinates
+ * are expected in native panel orientation. ST7789 is always available, ILI9341 and GC9A01 only
+ * when selected as the controller in menuconfig, which adds their driver component.
+ *
+ * @param panel Panel descriptor
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an invalid descriptor or SPI host,
+ *         ESP_ERR_NOT_SUPPORTED if the controller driver is not part of the build,
+ *         ESP_ERR_INVALID_STATE after esp_bsp_sdl_init()
+ */
+esp_err_t esp_bsp_sdl_generic_set_panel(const esp_bsp_sdl_generic_panel_t *panel);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,136 @@
+/**
+ * @file esp_bsp_sdl_glyph_cache.h
+ * @brief Glyph atlas cache and text rendering onto RGB565 surfaces
+ *
+ * Glyphs are rasterized once through a user callback (e.g. SDL_ttf or FreeType rendering into
+ * 8-bit coverage), quantized to 4 bits per pixel and kept in a fixed-slot atlas in PSRAM with an
+ * LRU hash index. Drawing walks the non-empty span of each glyph row and writes RGB565 directly:
+ * full coverage is stored, partial coverage is blended, empty pixels are skipped.
+ * One cache holds one font face at one size.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_bsp_sdl_surface.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_bsp_sdl_glyph_cache_t *esp_bsp_sdl_glyph_cache_handle_t;
+
+/**
+ * @brief Glyph metrics, relative to the pen position on the baseline
+ */
+typedef struct {
+    int width;     /*!< Bitmap width */
+    int height;    /*!< Bitmap height */
+    int bearing_x; /*!< Pen position to left edge of the bitmap */
+    int bearing_y; /*!< Baseline to top edge of the bitmap, positive upwards */
+    int advance;   /*!< Pen advance after the glyph */
+} esp_bsp_sdl_glyph_metrics_t;
+
+/**
+ * @brief Rasterize callback, called once per glyph that is not cached
+ *
+ * Glyphs the font does not have are cached as missing too, the callback is not asked again until
+ * they are evicted.
+ *
+ * @param codepoint Unicode code point
+ * @param[out] metrics Glyph metrics; width/height must not exceed the configured maximum
+ * @param[out] coverage 8-bit coverage, metrics->width bytes per row
+ * @param coverage_size Bytes available at coverage, max_glyph_width * max_glyph_height
+ * @param user_ctx User context
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the font has no such glyph, ESP_ERR_INVALID_SIZE
+ *         if the glyph does not fit (nothing written to coverage)
+ */
+typedef esp_err_t (*esp_bsp_sdl_glyph_rasterize_cb_t)(uint32_t codepoint,
+                                                      esp_bsp_sdl_glyph_metrics_t *metrics,
+                                                      uint8_t *coverage,
+                                                      size_t coverage_size,
+                                                      void *user_ctx);
+
+/**
+ * @brief Glyph cache configuration
+ */
+typedef struct {
+    int max_glyph_width;                        /*!< Largest glyph bitmap width (up to 255) */
+    int max_glyph_height;                       /*!< Largest glyph bitmap height (up to 255) */
+    int capacity;                               /*!< Cached glyphs */
+    esp_bsp_sdl_glyph_rasterize_cb_t rasterize; /*!< Rasterize callback */
+    void *user_ctx;                             /*!< Context for the callback */
+} esp_bsp_sdl_glyph_cache_config_t;
+
+/**
+ * @brief Cache counters
+ */
+typedef struct {
+    uint32_t hits;              /*!< Glyph lookups served from the atlas, missing glyphs included */
+    uint32_t misses;            /*!< Glyphs rasterized or found missing by the callback */
+    uint32_t evictions;         /*!< Glyphs and missing entries dropped to make room */
+    uint64_t rasterize_time_us; /*!< Time spent in the rasterize callback */
+} esp_bsp_sdl_glyph_cache_stats_t;
+
+/**
+ * @brief Create a glyph cache
+ *
+ * The atlas takes capacity * (2 + ceil(max_glyph_width / 2)) * max_glyph_height bytes, in PSRAM
+ * when available: two span bytes and the 4bpp pixels for every row of a slot.
+ *
+ * @param config Configuration
+ * @param[out] ret_cache Created cache
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad configuration, ESP_ERR_NO_MEM if memory is short
+ */
+esp_err_t esp_bsp_sdl_glyph_cache_create(const esp_bsp_sdl_glyph_cache_config_t *config,
+                                         esp_bsp_sdl_glyph_cache_handle_t *ret_cache);
+
+/**
+ * @brief Delete a glyph cache
+ */
+void esp_bsp_sdl_glyph_cache_delete(esp_bsp_sdl_glyph_cache_handle_t cache);
+
+/**
+ * @brief Drop all cached glyphs
+ */
+void esp_bsp_sdl_glyph_cache_clear(esp_bsp_sdl_glyph_cache_handle_t cache);
+
+/**
+ * @brief Draw UTF-8 text
+ *
+ * Missing glyphs are skipped, malformed UTF-8 is looked up as U+FFFD. Pixels are written in
+ * native-endian RGB565.
+ *
+ * @param cache Glyph cache
+ * @param dst Destination surface
+ * @param x Pen column
+ * @param y Baseline row
+ * @param text UTF-8 text
+ * @param color Text color
+ * @param[out] advance Total pen advance (may be NULL)
+ * @return ESP_OK on success, error code of the rasterize callback otherwise
+ */
+esp_err_t esp_bsp_sdl_text_draw(esp_bsp_sdl_glyph_cache_handle_t cache,
+                                esp_bsp_sdl_surface_t *dst,
+                                int x,
+                                int y,
+                                const char *text,
+                                uint16_t color,
+                                int *advance);
+
+/**
+ * @brief Measure the pen advance of UTF-8 text, rasterizing missing glyphs
+ */
+esp_err_t esp_bsp_sdl_text_measure(esp_bsp_sdl_glyph_cache_handle_t cache, const char *text, int *advance);
+
+/**
+ * @brief Get cache counters
+ */
+esp_err_t esp_bsp_sdl_glyph_cache_get_stats(esp_bsp_sdl_glyph_cache_handle_t cache,
+                                            esp_bsp_sdl_glyph_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
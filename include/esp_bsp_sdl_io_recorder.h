@@ -0,0 +1,140 @@
+/**
+ * @file esp_bsp_sdl_io_recorder.h
+ * @brief Command-stream recorder for LCD panel IO
+ *
+ * Hooks tx_param/tx_color/rx_param of an existing esp_lcd_panel_io_handle_t and logs every
+ * command, its parameter bytes, transfer size and timing into a ring buffer. The text export
+ * (one line per transfer) can be diffed between boards, and the summary points out redundant
+ * CASET/RASET writes and oversized color transfers.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_BSP_SDL_IO_REC_MAX_PARAM 16 /*!< Parameter bytes kept per entry */
+
+/**
+ * @brief Kind of recorded transfer
+ */
+typedef enum {
+    ESP_BSP_SDL_IO_REC_TX_PARAM = 0, /*!< Command with parameters */
+    ESP_BSP_SDL_IO_REC_TX_COLOR,     /*!< Command with color data */
+    ESP_BSP_SDL_IO_REC_RX_PARAM,     /*!< Parameter read */
+} esp_bsp_sdl_io_rec_kind_t;
+
+/**
+ * @brief Recorded transfer
+ */
+typedef struct {
+    int64_t timestamp_us;                        /*!< esp_timer time when the call started */
+    uint32_t duration_us;                        /*!< Time spent in the call (queueing time for async color) */
+    int32_t cmd;                                 /*!< LCD command */
+    uint32_t size;                               /*!< Parameter or color size in bytes */
+    uint8_t kind;                                /*!< esp_bsp_sdl_io_rec_kind_t */
+    uint8_t param_len;                           /*!< Parameter bytes stored in param */
+    uint8_t param[ESP_BSP_SDL_IO_REC_MAX_PARAM]; /*!< First parameter bytes (tx_param only) */
+} esp_bsp_sdl_io_rec_entry_t;
+
+/**
+ * @brief Recorder summary
+ */
+typedef struct {
+    uint32_t entries;            /*!< Entries currently held in the ring buffer */
+    uint32_t dropped;            /*!< Entries overwritten because the ring buffer was full */
+    uint32_t redundant_caset;    /*!< CASET writes repeating the previous CASET parameters */
+    uint32_t redundant_raset;    /*!< RASET writes repeating the previous RASET parameters */
+    uint32_t oversized_color;    /*!< Color transfers larger than the configured threshold */
+    uint64_t color_bytes;        /*!< Total color bytes */
+    uint64_t param_bytes;        /*!< Total parameter bytes */
+} esp_bsp_sdl_io_rec_summary_t;
+
+/**
+ * @brief Start recording an IO handle
+ *
+ * Only one IO handle can be recorded at a time.
+ *
+ * @param io Panel IO handle to hook
+ * @param capacity Ring buffer size in entries
+ * @param oversized_threshold Color transfers larger than this many bytes are counted as oversized (0 to disable)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already recording, ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t esp_bsp_sdl_io_recorder_start(esp_lcd_panel_io_handle_t io, size_t capacity, size_t oversized_threshold);
+
+/**
+ * @brief Stop recording and restore the original IO functions
+ *
+ * Recorded entries stay available until esp_bsp_sdl_io_recorder_free().
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not recording
+ */
+esp_err_t esp_bsp_sdl_io_recorder_stop(void);
+
+/**
+ * @brief Drop recorded entries and reset the summary
+ */
+void esp_bsp_sdl_io_recorder_clear(void);
+
+/**
+ * @brief Stop recording (if needed) and release the ring buffer
+ */
+void esp_bsp_sdl_io_recorder_free(void);
+
+/**
+ * @brief Get a recorded entry, oldest first
+ *
+ * @param index Entry index, 0 is the oldest entry held
+ * @param[out] entry Entry copy
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if index is out of range
+ */
+esp_err_t esp_bsp_sdl_io_recorder_get_entry(size_t index, esp_bsp_sdl_io_rec_entry_t *entry);
+
+/**
+ * @brief Get the recorder summary
+ *
+ * @param[out] summary Summary to fill
+ */
+void esp_bsp_sdl_io_recorder_get_summary(esp_bsp_sdl_io_rec_summary_t *summary);
+
+/**
+ * @brief Export recorded entries as text
+ *
+ * One line per entry: "<time_us> <duration_us> <kind> 0x<cmd> <size> [param bytes]", followed by
+ * summary lines starting with '#'. Without timing the lines only depend on the command stream,
+ * which makes exports from different boards directly diffable.
+ *
+ * @param out Output stream (stdout, a file on SD, ...)
+ * @param with_timing Include timestamp and duration columns
+ * @return ESP_OK on success
+ */
+esp_err_t esp_bsp_sdl_io_recorder_dump(FILE *out, bool with_timing);
+
+/**
+ * @brief Record the panel init sequence
+ *
+ * Starts recording (if not already) and re-runs esp_lcd_panel_reset() + esp_lcd_panel_init() +
+ * esp_lcd_panel_disp_on_off(true). BSP tweaks applied after init (mirroring, color inversion,
+ * gap, gamma curves) are reset by this and must be re-applied, e.g. with esp_bsp_sdl_set_orientation()
+ * and esp_bsp_sdl_load_panel_gamma(). The
+ * cached address window, the scroll area and the auto-dirty history are dropped, so the next flush
+ * sends a complete frame.
+ *
+ * @param panel Panel handle
+ * @param io Panel IO handle of the panel
+ * @param capacity Ring buffer size in entries if recording is not started yet
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t esp_bsp_sdl_io_recorder_capture_init(esp_lcd_panel_handle_t panel,
+                                               esp_lcd_panel_io_handle_t io,
+                                               size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file esp_bsp_sdl_mem.h
+ * @brief Heap and PSRAM accounting per subsystem
+ *
+ * Buffers of the flush engine, the rendering helpers and the debug tools are allocated through
+ * esp_bsp_sdl_mem_malloc() and friends, which book every block by subsystem and by the memory it
+ * landed in (internal DMA-capable, other internal, PSRAM). What the BSP allocates in
+ * bsp_display_new() and the touch driver cannot be hooked; it is measured as the drop of free heap
+ * around the board init and touch init calls (allocations of other tasks in that window are
+ * included).
+ *
+ * With the minimal-footprint profile (CONFIG_SDL_BSP_MIN_FOOTPRINT) everything held, measured
+ * subsystems included, is capped to CONFIG_SDL_BSP_MEM_BUDGET: allocations that would exceed it
+ * fail as if the heap were exhausted. Static data of the component is not booked;
+ * `idf.py size-components` reports it per archive.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Subsystems memory is booked to
+ */
+typedef enum {
+    ESP_BSP_SDL_MEM_PANEL = 0, /*!< Board display init: panel, IO, BSP frame and transfer buffers (measured) */
+    ESP_BSP_SDL_MEM_TOUCH,     /*!< Board touch init (measured), touch mock and its script */
+    ESP_BSP_SDL_MEM_FLUSH,     /*!< Flush engine: band buffers, shadow frame, tile hashes, DMA fill pattern */
+    ESP_BSP_SDL_MEM_RENDER,    /*!< Rendering helpers: compressed frame buffer, tiler, glyph atlas, compositor */
+    ESP_BSP_SDL_MEM_TOOLS,     /*!< Debug tools: frame capture, IO recorder */
+    ESP_BSP_SDL_MEM_SUBSYS_MAX,
+} esp_bsp_sdl_mem_subsys_t;
+
+/**
+ * @brief Memory classes
+ */
+typedef enum {
+    ESP_BSP_SDL_MEM_INTERNAL_DMA = 0, /*!< Internal, DMA-capable */
+    ESP_BSP_SDL_MEM_INTERNAL,         /*!< Internal, not DMA-capable */
+    ESP_BSP_SDL_MEM_PSRAM,            /*!< External PSRAM */
+    ESP_BSP_SDL_MEM_CLASS_MAX,
+} esp_bsp_sdl_mem_class_t;
+
+/**
+ * @brief Accounting snapshot
+ */
+typedef struct {
+    size_t current[ESP_BSP_SDL_MEM_SUBSYS_MAX][ESP_BSP_SDL_MEM_CLASS_MAX]; /*!< Bytes held now */
+    size_t peak[ESP_BSP_SDL_MEM_SUBSYS_MAX][ESP_BSP_SDL_MEM_CLASS_MAX];    /*!< High-water mark */
+    size_t total_peak[ESP_BSP_SDL_MEM_CLASS_MAX];    /*!< High-water mark of all subsystems together */
+    size_t heap_free[ESP_BSP_SDL_MEM_CLASS_MAX];     /*!< Free heap now, internal includes DMA-capable */
+    size_t heap_min_free[ESP_BSP_SDL_MEM_CLASS_MAX]; /*!< Lowest free heap since boot, same classes */
+    size_t held;                                     /*!< Bytes held now by all subsystems in all classes */
+    size_t budget;                                   /*!< CONFIG_SDL_BSP_MEM_BUDGET, 0 without a budget */
+    uint32_t budget_denied;                          /*!< Allocations refused for exceeding the budget */
+} esp_bsp_sdl_mem_snapshot_t;
+
+/**
+ * @brief heap_caps_malloc() booked to a subsystem
+ */
+void *esp_bsp_sdl_mem_malloc(esp_bsp_sdl_mem_subsys_t subsys, size_t size, uint32_t caps);
+
+/**
+ * @brief heap_caps_calloc() booked to a subsystem
+ */
+void *esp_bsp_sdl_mem_calloc(esp_bsp_sdl_mem_subsys_t subsys, size_t n, size_t size, uint32_t caps);
+
+/**
+ * @brief heap_caps_aligned_alloc() booked to a subsystem
+ */
+void *esp_bsp_sdl_mem_aligned_alloc(esp_bsp_sdl_mem_subsys_t subsys, size_t alignment, size_t size, uint32_t caps);
+
+/**
+ * @brief heap_caps_realloc() booked to a subsystem, NULL ptr allocates
+ */
+void *esp_bsp_sdl_mem_realloc(esp_bsp_sdl_mem_subsys_t subsys, void *ptr, size_t size, uint32_t caps);
+
+/**
+ * @brief Free a block allocated with esp_bsp_sdl_mem_*alloc() for the same subsystem (NULL is ignored)
+ */
+void esp_bsp_sdl_mem_free(esp_bsp_sdl_mem_subsys_t subsys, void *ptr);
+
+/**
+ * @brief Get the current accounting
+ *
+ * @param[out] snapshot Snapshot to fill
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if snapshot is NULL
+ */
+esp_err_t esp_bsp_sdl_mem_get_snapshot(esp_bsp_sdl_mem_snapshot_t *snapshot);
+
+/**
+ * @brief Reset high-water marks to the current values
+ */
+void esp_bsp_sdl_mem_reset_peaks(void);
+
+/**
+ * @brief Log current bytes and high-water marks per subsystem and class, the free heap and the budget
+ */
+void esp_bsp_sdl_mem_log(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,59 @@
+/**
+ * @file esp_bsp_sdl_scroll.h
+ * @brief Vertical scrolling that sends only the newly exposed lines
+ *
+ * Terminals and lists that move their content by a few lines would otherwise resend the whole
+ * frame. On MIPI-DBI panels whose controller scrolls (ILI9341/ILI9342, ST7789, GC9A01, ...), the
+ * scroll area is defined with VSCRDEF and moved with VSCRSADD, a 3-byte command; only the exposed
+ * lines are sent. While scrolled, esp_bsp_sdl_draw_bitmap() and the flush functions keep working in
+ * logical coordinates: rows of the scroll area are addressed where the controller shows them.
+ * On DPI/RGB panels the scan-out cannot be offset through esp_lcd, so the area is moved inside the
+ * frame buffer (no bus traffic, but CPU and PSRAM bandwidth) and the exposed lines are drawn.
+ *
+ * Controller scrolling works in the native and the 180 degree orientation, frame buffer scrolling
+ * in the native orientation only. Changing the orientation resets the scroll area.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Define the rows moved by esp_bsp_sdl_scroll()
+ *
+ * Fixed rows above and below the area (status bars, soft keys) stay in place. The area is the
+ * whole display until this is called. Defining an area resets the scroll offset, after which the
+ * area shows its content unscrolled: redraw it.
+ *
+ * @param top_fixed Fixed rows at the top
+ * @param bottom_fixed Fixed rows at the bottom
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if no row is left to scroll, ESP_ERR_INVALID_STATE
+ *         before esp_bsp_sdl_init(), ESP_ERR_NOT_SUPPORTED if the panel cannot scroll in the current
+ *         orientation
+ */
+esp_err_t esp_bsp_sdl_scroll_set_area(int top_fixed, int bottom_fixed);
+
+/**
+ * @brief Scroll the area and draw the exposed lines
+ *
+ * Positive lines move the content up and expose lines at the bottom of the area, negative lines
+ * move it down and expose lines at the top. The exposed lines are sent before returning, the
+ * buffer can be reused right away. The auto-dirty history of esp_bsp_sdl_flush_frame() is dropped,
+ * its next flush sends every tile.
+ *
+ * @param lines Lines to scroll, at most the height of the area either way
+ * @param exposed Pixels of the exposed lines, |lines| full-width rows, top to bottom
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for a bad distance or missing pixels,
+ *         ESP_ERR_INVALID_STATE before esp_bsp_sdl_init(), ESP_ERR_NOT_SUPPORTED if the panel
+ *         cannot scroll in the current orientation, error code from esp_lcd otherwise
+ */
+esp_err_t esp_bsp_sdl_scroll(int lines, const uint16_t *exposed);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file esp_bsp_sdl_surface.h
+ * @brief Pixel surface and rectangle types shared by the rendering helpers
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Rectangle in pixels
+ */
+typedef struct {
+    int x; /*!< Left column */
+    int y; /*!< Top row */
+    int w; /*!< Width */
+    int h; /*!< Height */
+} esp_bsp_sdl_rect_t;
+
+/**
+ * @brief RGB565 pixel surface
+ */
+typedef struct {
+    uint16_t *pixels; /*!< First pixel */
+    int width;        /*!< Width in pixels */
+    int height;       /*!< Height in pixels */
+    int stride;       /*!< Distance between rows in pixels */
+} esp_bsp_sdl_surface_t;
+
+/**
+ * @brief Intersect two rectangles
+ *
+ * @param a First rectangle
+ * @param b Second rectangle
+ * @param[out] out Intersection (may alias a or b)
+ * @return true if the intersection is not empty
+ */
+static inline bool esp_bsp_sdl_rect_intersect(const esp_bsp_sdl_rect_t *a,
+                                              const esp_bsp_sdl_rect_t *b,
+                                              esp_bsp_sdl_rect_t *out)
+{
+    const int x0 = a->x > b->x ? a->x : b->x;
+    const int y0 = a->y > b->y ? a->y : b->y;
+    const int x1 = (a->x + a->w) < (b->x + b->w) ? (a->x + a->w) : (b->x + b->w);
+    const int y1 = (a->y + a->h) < (b->y + b->h) ? (a->y + a->h) : (b->y + b->h);
+    if(x1 <= x0 || y1 <= y0) {
+        return false;
+    }
+    out->x = x0;
+    out->y = y0;
+    out->w = x1 - x0;
+    out->h = y1 - y0;
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
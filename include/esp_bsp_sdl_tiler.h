@@ -0,0 +1,112 @@
+/**
+ * @file esp_bsp_sdl_tiler.h
+ * @brief Tile-based deferred renderer for SDL-style 2D primitives
+ *
+ * Draw commands are recorded and binned per screen tile. At render time each tile is rasterized
+ * in an internal SRAM buffer and written to the target frame buffer exactly once, so overdraw
+ * costs SRAM bandwidth instead of PSRAM bandwidth. Tiles without commands are not touched.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include "esp_bsp_sdl_surface.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct esp_bsp_sdl_tiler_t *esp_bsp_sdl_tiler_handle_t;
+
+/**
+ * @brief Tiler configuration
+ */
+typedef struct {
+    int width;              /*!< Target width in pixels */
+    int height;             /*!< Target height in pixels */
+    int tile_width;         /*!< Tile width, 0 for default (64) */
+    int tile_height;        /*!< Tile height, 0 for default (32) */
+    size_t max_commands;    /*!< Commands per frame, 0 for default (256) */
+    size_t max_bin_entries; /*!< Command references over all tiles, 0 for 8 * max_commands */
+    bool clear;             /*!< Start every touched tile with clear_color instead of reading the target */
+    uint16_t clear_color;   /*!< Clear color when clear is set */
+    bool cache_writeback;   /*!< Write back the CPU cache after each tile (target scanned out by DMA) */
+} esp_bsp_sdl_tiler_config_t;
+
+/**
+ * @brief Traffic counters of the last esp_bsp_sdl_tiler_render()
+ */
+typedef struct {
+    uint32_t commands;       /*!< Commands rendered */
+    uint32_t tiles_touched;  /*!< Tiles with at least one command */
+    uint64_t target_read;    /*!< Bytes read from the target (tile loads when clear is not set) */
+    uint64_t target_written; /*!< Bytes written to the target */
+    uint64_t direct_written; /*!< Bytes an immediate-mode renderer would have written to the target */
+} esp_bsp_sdl_tiler_stats_t;
+
+/**
+ * @brief Create a tiler
+ *
+ * @param config Configuration
+ * @param[out] ret_tiler Created tiler
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if buffers cannot be allocated
+ */
+esp_err_t esp_bsp_sdl_tiler_create(const esp_bsp_sdl_tiler_config_t *config, esp_bsp_sdl_tiler_handle_t *ret_tiler);
+
+/**
+ * @brief Delete a tiler
+ */
+void esp_bsp_sdl_tiler_delete(esp_bsp_sdl_tiler_handle_t tiler);
+
+/**
+ * @brief Record a solid rectangle fill
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the command or bin storage is full (render first)
+ */
+esp_err_t esp_bsp_sdl_tiler_fill_rect(esp_bsp_sdl_tiler_handle_t tiler, const esp_bsp_sdl_rect_t *rect, uint16_t color);
+
+/**
+ * @brief Record an opaque texture blit
+ *
+ * The texture must stay valid until esp_bsp_sdl_tiler_render() returns.
+ *
+ * @param tiler Tiler
+ * @param texture Source texture
+ * @param src Source rectangle, NULL for the whole texture
+ * @param dst_x Destination column
+ * @param dst_y Destination row
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the command or bin storage is full (render first)
+ */
+esp_err_t esp_bsp_sdl_tiler_blit(esp_bsp_sdl_tiler_handle_t tiler,
+                                 const esp_bsp_sdl_surface_t *texture,
+                                 const esp_bsp_sdl_rect_t *src,
+                                 int dst_x,
+                                 int dst_y);
+
+/**
+ * @brief Record a one pixel wide line (end points included)
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the command or bin storage is full (render first)
+ */
+esp_err_t esp_bsp_sdl_tiler_line(esp_bsp_sdl_tiler_handle_t tiler, int x0, int y0, int x1, int y1, uint16_t color);
+
+/**
+ * @brief Rasterize all recorded commands into the target and start a new frame
+ *
+ * @param tiler Tiler
+ * @param target Target surface, at least width x height of the configuration
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the target is too small
+ */
+esp_err_t esp_bsp_sdl_tiler_render(esp_bsp_sdl_tiler_handle_t tiler, esp_bsp_sdl_surface_t *target);
+
+/**
+ * @brief Get traffic counters of the last render
+ *
+ * Comparing target_read + target_written with direct_written shows the PSRAM traffic saved.
+ */
+esp_err_t esp_bsp_sdl_tiler_get_stats(esp_bsp_sdl_tiler_handle_t tiler, esp_bsp_sdl_tiler_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,149 @@
+/**
+ * @file esp_bsp_sdl_touch_mock.h
+ * @brief Scripted esp_lcd_touch controller
+ *
+ * The mock implements the esp_lcd_touch driver interface, so esp_lcd_touch_read_data() and
+ * esp_lcd_touch_get_coordinates() (including the software swap/mirror of esp_lcd_touch) run
+ * exactly as with a GT911 or FT5x06. Contacts come from a timed script of multi-touch frames
+ * instead of I2C registers, and every read costs a configurable bus latency. With the manual
+ * clock, time only moves when the caller advances it, which makes latency measurements
+ * deterministic. Contacts can also be injected at run time, e.g. from mouse input of a preview
+ * of the virtual panel.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_lcd_touch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Contacts reported by the mock at once (clamped to CONFIG_ESP_LCD_TOUCH_MAX_POINTS)
+ */
+#define ESP_BSP_SDL_TOUCH_MOCK_MAX_POINTS 5
+
+/**
+ * @brief One step of a touch script
+ */
+typedef struct {
+    uint32_t time_ms; /*!< Script time at which these contacts become current */
+    uint8_t points;   /*!< Contacts, 0 for released */
+    struct {
+        uint16_t x;        /*!< Controller X coordinate */
+        uint16_t y;        /*!< Controller Y coordinate */
+        uint16_t strength; /*!< Contact strength */
+        uint8_t track_id;  /*!< Contact tracking id */
+    } coords[ESP_BSP_SDL_TOUCH_MOCK_MAX_POINTS];
+} esp_bsp_sdl_touch_mock_frame_t;
+
+/**
+ * @brief Mock configuration
+ */
+typedef struct {
+    uint16_t x_max;                               /*!< Controller X resolution */
+    uint16_t y_max;                               /*!< Controller Y resolution */
+    bool swap_xy;                                 /*!< Software swap applied by esp_lcd_touch */
+    bool mirror_x;                                /*!< Software X mirror applied by esp_lcd_touch */
+    bool mirror_y;                                /*!< Software Y mirror applied by esp_lcd_touch */
+    const esp_bsp_sdl_touch_mock_frame_t *script; /*!< Frames sorted by time, copied (may be NULL) */
+    size_t script_len;                            /*!< Frames in script */
+    uint32_t loop_period_ms;                      /*!< Replay the script with this period, 0 to play it once */
+    uint32_t i2c_latency_us;                      /*!< Bus time of one read_data() call */
+    bool manual_clock;                            /*!< Time only advances with esp_bsp_sdl_touch_mock_advance() */
+} esp_bsp_sdl_touch_mock_config_t;
+
+/**
+ * @brief Polling and latency counters
+ */
+typedef struct {
+    uint32_t reads;          /*!< read_data() calls */
+    uint64_t read_time_us;   /*!< Time spent in read_data(), bus latency included */
+    uint32_t events;         /*!< Script frames picked up by a read */
+    uint32_t missed_events;  /*!< Script frames replaced by a later frame before any read picked them up */
+    uint64_t latency_us;     /*!< Sum of the delays between a frame becoming current and its first read */
+    uint32_t max_latency_us; /*!< Longest of these delays */
+} esp_bsp_sdl_touch_mock_stats_t;
+
+/**
+ * @brief Create a mock touch controller
+ *
+ * The script clock starts at creation; esp_bsp_sdl_touch_mock_restart() starts it again.
+ *
+ * @param config Configuration
+ * @param[out] ret_touch Touch handle, released with esp_lcd_touch_del()
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad configuration, ESP_ERR_NO_MEM if memory is short
+ */
+esp_err_t esp_bsp_sdl_touch_mock_new(const esp_bsp_sdl_touch_mock_config_t *config, esp_lcd_touch_handle_t *ret_touch);
+
+/**
+ * @brief Check whether a touch handle is a mock
+ */
+bool esp_bsp_sdl_is_touch_mock(esp_lcd_touch_handle_t touch);
+
+/**
+ * @brief Replace the script and restart the script clock
+ *
+ * @param touch Mock touch handle
+ * @param script Frames sorted by time, copied (may be NULL)
+ * @param script_len Frames in script
+ * @param loop_period_ms Replay period, 0 to play the script once
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if touch is not a mock, the script is unsorted or ends
+ *         outside the loop period
+ */
+esp_err_t esp_bsp_sdl_touch_mock_load_script(esp_lcd_touch_handle_t touch,
+                                             const esp_bsp_sdl_touch_mock_frame_t *script,
+                                             size_t script_len,
+                                             uint32_t loop_period_ms);
+
+/**
+ * @brief Inject contacts, overriding the script
+ *
+ * The injected contacts are reported by every read until the next injection. A frame with zero
+ * points reports a release. Passing NULL hands control back to the script. An injection counts as
+ * an event for the latency counters, and as missed if it is replaced before a read picked it up.
+ * Safe to call from another task than the one reading the touch.
+ *
+ * @param touch Mock touch handle
+ * @param contacts Contacts to report, time_ms is ignored (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if touch is not a mock
+ */
+esp_err_t esp_bsp_sdl_touch_mock_inject(esp_lcd_touch_handle_t touch, const esp_bsp_sdl_touch_mock_frame_t *contacts);
+
+/**
+ * @brief Start the script from the beginning and reset the counters
+ */
+esp_err_t esp_bsp_sdl_touch_mock_restart(esp_lcd_touch_handle_t touch);
+
+/**
+ * @brief Advance the manual clock
+ *
+ * @param touch Mock touch handle created with manual_clock
+ * @param delta_us Time to advance
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the mock uses esp_timer time
+ */
+esp_err_t esp_bsp_sdl_touch_mock_advance(esp_lcd_touch_handle_t touch, uint32_t delta_us);
+
+/**
+ * @brief Get polling and latency counters
+ */
+esp_err_t esp_bsp_sdl_touch_mock_get_stats(esp_lcd_touch_handle_t touch, esp_bsp_sdl_touch_mock_stats_t *stats);
+
+/**
+ * @brief Touch controller of the virtual board, created by esp_bsp_sdl_touch_init()
+ *
+ * Only available with CONFIG_SDL_BSP_VIRTUAL. The mock starts without a script; load one with
+ * esp_bsp_sdl_touch_mock_load_script().
+ *
+ * @return Mock touch handle, NULL before esp_bsp_sdl_touch_init()
+ */
+esp_lcd_touch_handle_t esp_bsp_sdl_virtual_get_touch(void);
+
+#ifdef __cplusplus
+}
+#endif
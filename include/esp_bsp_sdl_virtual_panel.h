@@ -0,0 +1,224 @@
+/**
+ * @file esp_bsp_sdl_virtual_panel.h
+ * @brief RAM-backed stand-in for a MIPI-DBI panel and frame comparison helpers
+ *
+ * The virtual panel provides an esp_lcd_panel_io_handle_t that interprets the command stream of
+ * an ILI9341/ST7789 class controller (CASET, RASET, RAMWR, RAMWRC, MADCTL, VSCRDEF, VSCRSADD,
+ * PGAMCTRL/NGAMCTRL, ...)
+ * into a frame buffer in RAM, and an esp_lcd_panel_handle_t on top of it that behaves like the
+ * esp_lcd vendor drivers. Everything above esp_lcd (window cache, flush engine, orientation,
+ * scrolling, touch mapping) runs unchanged, and the resulting frame can be compared against a
+ * reference image.
+ *
+ * An optional bus timing model (SPI, i80, MIPI-DSI) makes color transfers take as long as on the
+ * real bus and complete asynchronously from an esp_timer callback, with the esp_lcd transaction
+ * queue semantics: pixels are read from the caller's buffer only when the transfer completes, and
+ * commands wait for queued color transfers first.
+ *
+ * A frame listener sees every completed color transfer together with the frame memory itself,
+ * which lets a preview or capture consumer pick up changed areas without an extra frame copy.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_surface.h"
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Simulated bus
+ */
+typedef enum {
+    ESP_BSP_SDL_VIRTUAL_BUS_INSTANT = 0, /*!< Transfers complete within the call */
+    ESP_BSP_SDL_VIRTUAL_BUS_SPI,         /*!< SPI, data_lines 1 (standard), 2, 4 or 8 at clock_hz */
+    ESP_BSP_SDL_VIRTUAL_BUS_I80,         /*!< Intel 8080 parallel, data_lines 8 or 16 at clock_hz */
+    ESP_BSP_SDL_VIRTUAL_BUS_DSI,         /*!< MIPI-DSI, data_lines lanes at lane_mbps */
+} esp_bsp_sdl_virtual_bus_type_t;
+
+/**
+ * @brief Bus timing model
+ */
+typedef struct {
+    esp_bsp_sdl_virtual_bus_type_t type; /*!< Bus type */
+    uint32_t clock_hz;                   /*!< SPI/i80 clock */
+    uint32_t lane_mbps;                  /*!< DSI lane bit rate */
+    uint8_t data_lines;                  /*!< SPI/i80 data lines, DSI lanes */
+    uint8_t queue_depth;                 /*!< Color transfers in flight before tx_color blocks, 0 for 10 */
+    uint16_t command_overhead_us;        /*!< Fixed cost of every command (driver, CS and D/C handling) */
+    uint16_t transfer_overhead_us;       /*!< Fixed cost of every color transfer (queueing, DMA setup) */
+} esp_bsp_sdl_virtual_bus_timing_t;
+
+/**
+ * @brief Bus timing profiles of the supported boards
+ */
+typedef enum {
+    ESP_BSP_SDL_VIRTUAL_PROFILE_INSTANT = 0,          /*!< No timing model */
+    ESP_BSP_SDL_VIRTUAL_PROFILE_ESP_BOX_3,            /*!< SPI 40 MHz */
+    ESP_BSP_SDL_VIRTUAL_PROFILE_M5STACK_CORE_S3,      /*!< SPI 40 MHz */
+    ESP_BSP_SDL_VIRTUAL_PROFILE_M5_ATOM_S3,           /*!< SPI 40 MHz */
+    ESP_BSP_SDL_VIRTUAL_PROFILE_ESP32_P4_FUNCTION_EV, /*!< MIPI-DSI, 2 lanes at 1000 Mbps */
+    ESP_BSP_SDL_VIRTUAL_PROFILE_ESP32_S3_LCD_EV,      /*!< 16-bit RGB at 16 MHz, modelled as i80 */
+    ESP_BSP_SDL_VIRTUAL_PROFILE_M5STACK_TAB5,         /*!< MIPI-DSI, 2 lanes at 730 Mbps */
+} esp_bsp_sdl_virtual_profile_t;
+
+/**
+ * @brief Virtual panel configuration
+ */
+typedef struct {
+    int width;                            /*!< Visible width in native orientation */
+    int height;                           /*!< Visible height in native orientation */
+    int x_gap;                            /*!< Column offset of the visible area in controller RAM */
+    int y_gap;                            /*!< Row offset of the visible area in controller RAM */
+    int ram_width;                        /*!< Controller RAM columns, 0 for x_gap + width */
+    int ram_height;                       /*!< Controller RAM rows, 0 for y_gap + height */
+    esp_bsp_sdl_virtual_bus_timing_t bus; /*!< Bus timing model, zero for instant transfers */
+} esp_bsp_sdl_virtual_panel_config_t;
+
+/**
+ * @brief Virtual panel counters
+ */
+typedef struct {
+    uint32_t commands;       /*!< Commands with parameters (tx_param) */
+    uint32_t color_writes;   /*!< Color transfers (tx_color) */
+    uint64_t param_bytes;    /*!< Parameter bytes received */
+    uint64_t color_bytes;    /*!< Color bytes received */
+    uint64_t dropped_pixels; /*!< Pixels written outside the visible area or the RAM */
+    uint64_t bus_time_us;    /*!< Simulated bus time of all commands and transfers */
+    uint32_t queue_waits;    /*!< tx_color calls that blocked on a full transaction queue */
+} esp_bsp_sdl_virtual_panel_stats_t;
+
+/**
+ * @brief Result of a frame comparison
+ */
+typedef struct {
+    uint32_t mismatched;       /*!< Pixels with a channel difference above the tolerance */
+    int max_delta;             /*!< Largest channel difference, in RGB565 channel steps */
+    esp_bsp_sdl_rect_t bounds; /*!< Bounding box of the mismatched pixels, empty if none */
+} esp_bsp_sdl_frame_diff_t;
+
+/**
+ * @brief Frame listener, called after each color transfer has been written to the frame memory
+ *
+ * The frame holds what the panel shows: a vertical scroll (VSCRSADD) rotates the rows of the scroll
+ * area and is reported like a transfer covering the area.
+ *
+ * Runs in the context that completes the transfer: the caller of tx_color for instant transfers,
+ * the esp_timer task with a bus timing model. The next transfer is not applied before the listener
+ * returns, so it may read the area directly from the frame, but it should not block.
+ *
+ * @param frame Whole frame in native orientation, the panel's own memory
+ * @param area Bounding box of the pixels written by the transfer, never empty
+ * @param user_ctx User context passed to esp_bsp_sdl_virtual_panel_set_listener()
+ */
+typedef void (*esp_bsp_sdl_virtual_panel_listener_t)(const esp_bsp_sdl_surface_t *frame,
+                                                     const esp_bsp_sdl_rect_t *area,
+                                                     void *user_ctx);
+
+/**
+ * @brief Create a virtual panel
+ *
+ * The controller RAM is allocated in PSRAM when available and starts black. MADCTL mirrors
+ * across the whole RAM, so rotating moves a visible area that is not centred to other RAM, like
+ * on the real controller. Gaps of the panel handle start at zero, like the esp_lcd vendor
+ * drivers; call esp_lcd_panel_set_gap() with the configured gap to draw through the panel handle.
+ *
+ * @param config Configuration
+ * @param[out] ret_io Panel IO handle, interprets the command stream
+ * @param[out] ret_panel Panel handle, sends commands through ret_io
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad configuration, ESP_ERR_NO_MEM if memory is short
+ */
+esp_err_t esp_bsp_sdl_virtual_panel_new(const esp_bsp_sdl_virtual_panel_config_t *config,
+                                        esp_lcd_panel_io_handle_t *ret_io,
+                                        esp_lcd_panel_handle_t *ret_panel);
+
+/**
+ * @brief Get the bus timing model of a board
+ *
+ * @param profile Board profile
+ * @param[out] timing Timing model
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an unknown profile
+ */
+esp_err_t esp_bsp_sdl_virtual_bus_get_profile(esp_bsp_sdl_virtual_profile_t profile,
+                                              esp_bsp_sdl_virtual_bus_timing_t *timing);
+
+/**
+ * @brief Check whether a panel handle is a virtual panel
+ */
+bool esp_bsp_sdl_is_virtual_panel(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Get the frame buffer of a virtual panel
+ *
+ * Pixels are stored as received, i.e. in the byte order the caller sent to the panel. The frame
+ * is the visible area of the controller RAM, its stride is the RAM width. The surface stays valid
+ * until the panel IO handle is deleted. With a bus timing model this waits for the queued color
+ * transfers first.
+ *
+ * @param panel Virtual panel handle
+ * @param[out] frame Visible area in native orientation
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if panel is not a virtual panel
+ */
+esp_err_t esp_bsp_sdl_virtual_panel_get_frame(esp_lcd_panel_handle_t panel, esp_bsp_sdl_surface_t *frame);
+
+/**
+ * @brief Get virtual panel counters
+ */
+esp_err_t esp_bsp_sdl_virtual_panel_get_stats(esp_lcd_panel_handle_t panel, esp_bsp_sdl_virtual_panel_stats_t *stats);
+
+/**
+ * @brief Get the gamma curves last written with PGAMCTRL/NGAMCTRL
+ *
+ * The curves are only recorded, frames hold the pixels as sent. length is that of the last write,
+ * 0 after a reset until curves are written.
+ *
+ * @param panel Virtual panel handle
+ * @param[out] gamma Curves
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if panel is not a virtual panel
+ */
+esp_err_t esp_bsp_sdl_virtual_panel_get_gamma(esp_lcd_panel_handle_t panel, esp_bsp_sdl_panel_gamma_t *gamma);
+
+/**
+ * @brief Reset virtual panel counters
+ */
+void esp_bsp_sdl_virtual_panel_reset_stats(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Set the frame listener
+ *
+ * @param panel Virtual panel handle
+ * @param listener Listener, NULL to remove it
+ * @param user_ctx User context passed to the listener
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if panel is not a virtual panel
+ */
+esp_err_t esp_bsp_sdl_virtual_panel_set_listener(esp_lcd_panel_handle_t panel,
+                                                 esp_bsp_sdl_virtual_panel_listener_t listener,
+                                                 void *user_ctx);
+
+/**
+ * @brief Compare an RGB565 frame against a reference image
+ *
+ * Both surfaces must hold native-endian RGB565 of the same size. A pixel mismatches when any
+ * of its red, green or blue values differs by more than tolerance steps of that channel.
+ *
+ * @param frame Frame to check
+ * @param reference Reference image
+ * @param tolerance Allowed difference per channel, 0 for an exact match
+ * @param[out] diff Comparison details (may be NULL)
+ * @return ESP_OK if all pixels match, ESP_FAIL on a mismatch, ESP_ERR_INVALID_SIZE if the sizes differ
+ */
+esp_err_t esp_bsp_sdl_frame_compare(const esp_bsp_sdl_surface_t *frame,
+                                    const esp_bsp_sdl_surface_t *reference,
+                                    int tolerance,
+                                    esp_bsp_sdl_frame_diff_t *diff);
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,6 +12,7 @@
 // Include ESP32-P4 Function EV Board BSP headers - only when this board is selected
 #include "bsp/display.h"
 #include "bsp/esp32_p4_function_ev_board.h"
+#include "esp_lcd_mipi_dsi.h"
 
 // Forward declarations for touch support to avoid including problematic headers
 // The managed BSP component doesn't have esp_lcd_touch dependency, so we include it directly
@@ -225,6 +226,15 @@ static esp_err_t esp32_p4_function_ev_touch_read(esp_bsp_sdl_touch_info_t *touch
 #endif
 }
 
+static esp_err_t esp32_p4_function_ev_get_frame_buffer(void **frame_buffer)
+{
+    // DPI panels have no MADCTL, the common layer rotates in software directly into this buffer
+    if(!s_panel_handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return esp_lcd_dpi_panel_get_frame_buffer(s_panel_handle, 1, frame_buffer);
+}
+
 static const char *esp32_p4_function_ev_get_name(void)
 {
     return "ESP32-P4 Function EV Board";
@@ -261,4 +271,5 @@ const esp_bsp_sdl_board_interface_t esp_bsp_sdl_esp32_p4_function_ev_interface =
     .touch_read = esp32_p4_function_ev_touch_read,
     .get_name = esp32_p4_function_ev_get_name,
     .deinit = esp32_p4_function_ev_deinit,
+    .get_frame_buffer = esp32_p4_function_ev_get_frame_buffer,
     .board_name = "ESP32-P4 Function EV Board"};
\ No newline at end of file
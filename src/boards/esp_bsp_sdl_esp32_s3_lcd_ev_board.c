@@ -6,6 +6,7 @@
  */
 
 #include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_priv.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
@@ -21,6 +22,10 @@
 // SDL pixel format constants - using direct values to avoid SDL dependency
 #define SDL_PIXELFORMAT_RGB565 0x15151002u
 
+// Mirror state applied by bsp_display_new(), orientation changes are relative to it
+#define BSP_SDL_PANEL_MIRROR_X false
+#define BSP_SDL_PANEL_MIRROR_Y false
+
 static const char *TAG = "esp_bsp_sdl_esp32_s3_lcd_ev_board";
 static esp_lcd_panel_handle_t s_panel_handle = NULL;
 static esp_lcd_panel_io_handle_t s_panel_io_handle = NULL;
@@ -175,6 +180,15 @@ static esp_err_t esp32_s3_lcd_ev_board_touch_read(esp_bsp_sdl_touch_info_t *touc
 #endif
 }
 
+static esp_err_t esp32_s3_lcd_ev_board_set_orientation(esp_bsp_sdl_orientation_t orientation)
+{
+    // The esp_lcd RGB driver rotates while copying into its frame buffer
+    return esp_bsp_sdl_panel_apply_orientation(s_panel_handle,
+                                                orientation,
+                                                BSP_SDL_PANEL_MIRROR_X,
+                                                BSP_SDL_PANEL_MIRROR_Y);
+}
+
 static const char *esp32_s3_lcd_ev_board_get_name(void)
 {
     return "ESP32-S3-LCD-EV-Board";
@@ -212,4 +226,5 @@ const esp_bsp_sdl_board_interface_t esp_bsp_sdl_esp32_s3_lcd_ev_board_interface
     .touch_read = esp32_s3_lcd_ev_board_touch_read,
     .get_name = esp32_s3_lcd_ev_board_get_name,
     .deinit = esp32_s3_lcd_ev_board_deinit,
+    .set_orientation = esp32_s3_lcd_ev_board_set_orientation,
     .board_name = "ESP32-S3-LCD-EV-Board"};
\ No newline at end of file
@@ -4,6 +4,7 @@
  */
 
 #include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_priv.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
@@ -20,6 +21,28 @@
 // SDL pixel format constants - using direct values to avoid SDL dependency
 #define SDL_PIXELFORMAT_RGB565 0x15151002u
 
+// Mirror state applied by bsp_display_new(), orientation changes are relative to it
+#define BSP_SDL_PANEL_MIRROR_X true
+#define BSP_SDL_PANEL_MIRROR_Y true
+
+// ILI9342 gamma curves, loaded into PGAMCTRL/NGAMCTRL by esp_bsp_sdl_load_panel_gamma()
+static const esp_bsp_sdl_panel_gamma_t s_panel_gamma = {
+    .positive = {0x0F, 0x31, 0x2B, 0x0C, 0x0E, 0x08, 0x4E, 0xF1, 0x37, 0x07, 0x10, 0x03, 0x0E, 0x09, 0x00},
+    .negative = {0x00, 0x0E, 0x14, 0x03, 0x11, 0x07, 0x31, 0xC1, 0x48, 0x08, 0x0F, 0x0C, 0x31, 0x36, 0x0F},
+    .length = 15,
+};
+
+// SPI MIPI-DBI panel, visible area starts at controller RAM origin
+static const esp_bsp_sdl_dbi_info_t s_dbi_info = {
+    .x_gap = 0,
+    .y_gap = 0,
+    .ram_width = 320, // ILI9342, 320x240 RAM
+    .ram_height = 240,
+    .scroll_lines = 240,
+    .mirror_x = BSP_SDL_PANEL_MIRROR_X,
+    .mirror_y = BSP_SDL_PANEL_MIRROR_Y,
+};
+
 static const char *TAG = "esp_bsp_sdl_esp_box_3";
 static esp_lcd_panel_handle_t s_panel_handle = NULL;
 static esp_lcd_panel_io_handle_t s_panel_io_handle = NULL;
@@ -38,7 +61,7 @@ static esp_err_t esp_box_3_init(esp_bsp_sdl_display_config_t *config,
     config->width = 320;   // ESP-BOX-3 specific resolution
     config->height = 240;  // ESP-BOX-3 specific resolution
     config->pixel_format = SDL_PIXELFORMAT_RGB565;
-    config->max_transfer_sz = (320 * 240) * sizeof(uint16_t);
+    config->max_transfer_sz = esp_bsp_sdl_priv_transfer_size(config->width, config->height);
     config->has_touch = BSP_CAPS_TOUCH == 1;
 
     // Initialize BSP display
@@ -124,6 +147,15 @@ static esp_err_t esp_box_3_touch_read(esp_bsp_sdl_touch_info_t *touch_info)
 #endif
 }
 
+static esp_err_t esp_box_3_set_orientation(esp_bsp_sdl_orientation_t orientation)
+{
+    // Rotation is done by the panel controller (MADCTL), no per-frame cost
+    return esp_bsp_sdl_panel_apply_orientation(s_panel_handle,
+                                                orientation,
+                                                BSP_SDL_PANEL_MIRROR_X,
+                                                BSP_SDL_PANEL_MIRROR_Y);
+}
+
 static const char *esp_box_3_get_name(void)
 {
     return "ESP-Box-3";
@@ -155,4 +187,7 @@ const esp_bsp_sdl_board_interface_t esp_bsp_sdl_esp_box_3_interface = {.init = e
                                                                        .touch_read = esp_box_3_touch_read,
                                                                        .get_name = esp_box_3_get_name,
                                                                        .deinit = esp_box_3_deinit,
+                                                                       .set_orientation = esp_box_3_set_orientation,
+                                                                       .dbi = &s_dbi_info,
+                                                                       .panel_gamma = &s_panel_gamma,
                                                                        .board_name = "ESP32-S3-BOX-3"};
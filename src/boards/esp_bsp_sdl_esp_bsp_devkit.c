@@ -1,135 +1,447 @@
 /**
  * @file esp_bsp_sdl_esp_bsp_devkit.c
- * @brief ESP BSP DevKit specific implementation for ESP-BSP SDL abstraction layer
- * Uses esp_bsp_devkit for basic DevKit support (LEDs, buttons, no display)
- * Note: This creates a virtual display for SDL since DevKit BSP has no display
+ * @brief Headless DevKit board for the ESP-BSP SDL abstraction layer
+ * Draws into an offscreen virtual panel and exports changed frames in the capture container
+ * format, so SDL workloads run and can be profiled on devkits without a display.
  */
 
-#include "esp_bsp_devkit.h"
+#include <string.h>
 #include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_capture.h"
+#include "esp_bsp_sdl_devkit.h"
+#include "esp_bsp_sdl_mem.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_bsp_sdl_virtual_panel.h"
 #include "esp_err.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 #include "sdkconfig.h"
 
 // SDL pixel format constants - using direct values to avoid SDL dependency
 #define SDL_PIXELFORMAT_RGB565 0x15151002u
 
-// Virtual display dimensions for DevKit (no physical display)
-#define VIRTUAL_DISPLAY_WIDTH 240
-#define VIRTUAL_DISPLAY_HEIGHT 320
+#define EXPORT_TASK_STACK 4096
+#define SNAPSHOTS         2
 
-static const char *TAG = "esp_bsp_sdl_esp_bsp_devkit";
+// The minimal-footprint profile runs no export task, frames go out from esp_bsp_sdl_devkit_export_frame()
+#if CONFIG_SDL_BSP_MIN_FOOTPRINT
+#    define EXPORT_TASK false
+#else
+#    define EXPORT_TASK true
+#endif
+
+#if CONFIG_SDL_BSP_DEVKIT_EXPORT_DELTA
+#    define EXPORT_DELTA true
+#else
+#    define EXPORT_DELTA false
+#endif
+
+// Offscreen MIPI-DBI panel, no gap
+static const esp_bsp_sdl_dbi_info_t s_dbi_info = {
+    .x_gap = 0,
+    .y_gap = 0,
+    .ram_width = CONFIG_SDL_BSP_DEVKIT_WIDTH,
+    .ram_height = CONFIG_SDL_BSP_DEVKIT_HEIGHT,
+    .scroll_lines = CONFIG_SDL_BSP_DEVKIT_HEIGHT,
+};
+
+static const char *TAG = "esp_bsp_sdl_devkit";
+static esp_lcd_panel_handle_t s_panel_handle = NULL;
+static esp_lcd_panel_io_handle_t s_panel_io_handle = NULL;
+static FILE *s_export_file = NULL; // Opened from CONFIG_SDL_BSP_DEVKIT_EXPORT_PATH
+static bool s_exporting = false;
+static TaskHandle_t s_export_task = NULL;
+static SemaphoreHandle_t s_export_done = NULL;
+static volatile bool s_export_stop = false;
+static volatile bool s_export_failed = false;
+static volatile bool s_dirty = false; // Panel drawn to since the last snapshot or export
+
+// Frames copied at frame boundaries for the export task, which encodes one while the other is refilled
+static uint16_t *s_snapshot[SNAPSHOTS];
+static SemaphoreHandle_t s_snapshot_lock = NULL; // Guards the indices, never held while copying or encoding
+static int s_snapshot_ready = -1;                // Complete snapshot waiting for the export task
+static int s_snapshot_encoding = -1;             // Snapshot the export task is encoding
+
+static void on_frame_written(const esp_bsp_sdl_surface_t *frame, const esp_bsp_sdl_rect_t *area, void *user_ctx)
+{
+    s_dirty = true;
+}
 
-esp_err_t esp_bsp_sdl_board_init(esp_bsp_sdl_display_config_t *config,
-                                 esp_lcd_panel_handle_t *panel_handle,
-                                 esp_lcd_panel_io_handle_t *panel_io_handle)
+static esp_err_t export_dirty_frame(void)
 {
-    ESP_LOGI(TAG, "Initializing ESP BSP DevKit (LEDs/Buttons, No Display)");
+    if(!s_dirty) {
+        return ESP_OK;
+    }
+    s_dirty = false;
 
-    if(!config || !panel_handle || !panel_io_handle) {
+    esp_bsp_sdl_surface_t frame;
+    esp_err_t ret = esp_bsp_sdl_virtual_panel_get_frame(s_panel_handle, &frame);
+    if(ret == ESP_OK) {
+        ret = esp_bsp_sdl_capture_surface(&frame);
+    }
+    return ret;
+}
+
+// Runs in the presenting task at a frame boundary, so the panel memory holds one whole frame. The copy
+// goes to the snapshot the export task is not encoding, the presenting task never waits for the stream.
+static void take_snapshot(void)
+{
+    if(!s_dirty || s_export_failed) {
+        return;
+    }
+    esp_bsp_sdl_surface_t frame;
+    if(esp_bsp_sdl_virtual_panel_get_frame(s_panel_handle, &frame) != ESP_OK) {
+        return;
+    }
+    s_dirty = false;
+
+    xSemaphoreTake(s_snapshot_lock, portMAX_DELAY);
+    const int target = s_snapshot_encoding == 0 ? 1 : 0;
+    if(s_snapshot_ready == target) {
+        s_snapshot_ready = -1; // Replaced by a newer frame before it was exported
+    }
+    xSemaphoreGive(s_snapshot_lock);
+
+    for(int y = 0; y < frame.height; y++) {
+        memcpy(s_snapshot[target] + (size_t) y * frame.width,
+               frame.pixels + (size_t) y * frame.stride,
+               frame.width * sizeof(uint16_t));
+    }
+
+    xSemaphoreTake(s_snapshot_lock, portMAX_DELAY);
+    s_snapshot_ready = target;
+    xSemaphoreGive(s_snapshot_lock);
+    xTaskNotifyGive(s_export_task);
+}
+
+static esp_err_t export_snapshot(void)
+{
+    xSemaphoreTake(s_snapshot_lock, portMAX_DELAY);
+    s_snapshot_encoding = s_snapshot_ready;
+    s_snapshot_ready = -1;
+    xSemaphoreGive(s_snapshot_lock);
+    if(s_snapshot_encoding < 0) {
+        return ESP_OK;
+    }
+
+    const esp_bsp_sdl_surface_t frame = {
+        .pixels = s_snapshot[s_snapshot_encoding],
+        .width = CONFIG_SDL_BSP_DEVKIT_WIDTH,
+        .height = CONFIG_SDL_BSP_DEVKIT_HEIGHT,
+        .stride = CONFIG_SDL_BSP_DEVKIT_WIDTH,
+    };
+    const esp_err_t ret = esp_bsp_sdl_capture_surface(&frame);
+
+    xSemaphoreTake(s_snapshot_lock, portMAX_DELAY);
+    s_snapshot_encoding = -1;
+    xSemaphoreGive(s_snapshot_lock);
+    return ret;
+}
+
+// Exits only after esp_bsp_sdl_devkit_export_stop() asked it to, so s_export_task stays a valid handle to
+// notify until then, also after a failed write
+static void export_task(void *arg)
+{
+    for(;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if(!s_export_failed && export_snapshot() != ESP_OK) {
+            ESP_LOGE(TAG, "Frame export failed, export stopped");
+            s_export_failed = true;
+        }
+        if(s_export_stop) {
+            break;
+        }
+        if(!s_export_failed) {
+            // At most one export per interval, newer frames replace the waiting snapshot meanwhile
+            vTaskDelay(pdMS_TO_TICKS(CONFIG_SDL_BSP_DEVKIT_EXPORT_INTERVAL_MS));
+        }
+    }
+    xSemaphoreGive(s_export_done);
+    vTaskDelete(NULL);
+}
+
+static void free_snapshots(void)
+{
+    for(int i = 0; i < SNAPSHOTS; i++) {
+        esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_TOOLS, s_snapshot[i]);
+        s_snapshot[i] = NULL;
+    }
+    s_snapshot_ready = -1;
+    s_snapshot_encoding = -1;
+}
+
+static esp_err_t alloc_snapshots(void)
+{
+    const size_t frame_size = (size_t) CONFIG_SDL_BSP_DEVKIT_WIDTH * CONFIG_SDL_BSP_DEVKIT_HEIGHT * sizeof(uint16_t);
+    for(int i = 0; i < SNAPSHOTS; i++) {
+        s_snapshot[i] = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_TOOLS, frame_size, MALLOC_CAP_SPIRAM);
+        if(!s_snapshot[i]) {
+            s_snapshot[i] = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_TOOLS, frame_size, MALLOC_CAP_DEFAULT);
+        }
+        if(!s_snapshot[i]) {
+            free_snapshots();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_devkit_export_start(FILE *out)
+{
+    if(!out) {
         return ESP_ERR_INVALID_ARG;
     }
+    if(!s_panel_handle || s_exporting) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if(EXPORT_TASK && !s_export_done) {
+        s_export_done = xSemaphoreCreateBinary();
+        if(!s_export_done) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if(EXPORT_TASK && !s_snapshot_lock) {
+        s_snapshot_lock = xSemaphoreCreateMutex();
+        if(!s_snapshot_lock) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if(EXPORT_TASK && alloc_snapshots() != ESP_OK) {
+        ESP_LOGE(TAG, "No memory for the export snapshots");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Manual capture: the export task is the only writer, whatever task flushes
+    const esp_bsp_sdl_capture_config_t capture_config = {
+        .out = out,
+        .every_nth = 1,
+        .delta = EXPORT_DELTA,
+        .key_interval = CONFIG_SDL_BSP_DEVKIT_EXPORT_KEY_INTERVAL,
+        .manual = true,
+    };
+    esp_err_t ret = esp_bsp_sdl_capture_start(&capture_config);
+    if(ret != ESP_OK) {
+        free_snapshots();
+        return ret;
+    }
 
-    esp_err_t ret = ESP_OK;
+    s_export_stop = false;
+    s_export_failed = false;
+    s_dirty = true;
+    if(!EXPORT_TASK) {
+        s_exporting = true;
+        ESP_LOGI(TAG, "Frame export started, on esp_bsp_sdl_devkit_export_frame()");
+        return ESP_OK;
+    }
 
-    // DevKit BSP has no display - create virtual display configuration for SDL
-    config->width = VIRTUAL_DISPLAY_WIDTH;
-    config->height = VIRTUAL_DISPLAY_HEIGHT;
-    config->pixel_format = SDL_PIXELFORMAT_RGB565;
-    config->max_transfer_sz = (config->width * config->height) * sizeof(uint16_t);
-    config->has_touch = false;  // DevKit BSP doesn't support touch
+    if(xTaskCreate(export_task, "sdl_export", EXPORT_TASK_STACK, NULL, tskIDLE_PRIORITY + 1, &s_export_task) !=
+       pdPASS) {
+        s_export_task = NULL;
+        esp_bsp_sdl_capture_stop();
+        free_snapshots();
+        return ESP_ERR_NO_MEM;
+    }
+    s_exporting = true;
 
-    ESP_LOGI(TAG, "Virtual display configured: %dx%d (no physical display)", config->width, config->height);
+    ESP_LOGI(TAG, "Frame export started, every %d ms", CONFIG_SDL_BSP_DEVKIT_EXPORT_INTERVAL_MS);
+    return ESP_OK;
+}
 
-    // Initialize DevKit BSP features (LEDs, buttons, file systems)
-    ESP_LOGI(TAG, "Initializing DevKit BSP features...");
+esp_err_t esp_bsp_sdl_devkit_export_frame(void)
+{
+    if(!s_exporting) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if(s_export_task) {
+        if(s_export_failed) {
+            return ESP_FAIL;
+        }
+        take_snapshot();
+        return ESP_OK;
+    }
+    return export_dirty_frame();
+}
 
-    // Initialize LEDs if configured
-#ifdef CONFIG_BSP_DEVKIT_LED_ENABLED
-    ret = bsp_leds_init();
-    if(ret == ESP_OK) {
-        ESP_LOGI(TAG, "LEDs initialized successfully");
-    } else {
-        ESP_LOGW(TAG, "LED initialization failed: %s", esp_err_to_name(ret));
+esp_err_t esp_bsp_sdl_devkit_export_stop(void)
+{
+    if(!s_exporting) {
+        return ESP_ERR_INVALID_STATE;
     }
-#endif
+    if(s_export_task) {
+        // The last presented frame goes out before the index, unless a write already failed
+        take_snapshot();
+        s_export_stop = true;
+        xTaskNotifyGive(s_export_task);
+        // The task has ended once it gives s_export_done
+        xSemaphoreTake(s_export_done, portMAX_DELAY);
+        s_export_task = NULL;
+        free_snapshots();
+    }
+    s_exporting = false;
+    return esp_bsp_sdl_capture_stop();
+}
 
-    // Initialize buttons if configured
-#ifdef CONFIG_BSP_DEVKIT_BUTTON_ENABLED
-    ret = bsp_iot_button_create();
-    if(ret == ESP_OK) {
-        ESP_LOGI(TAG, "Buttons initialized successfully");
-    } else {
-        ESP_LOGW(TAG, "Button initialization failed: %s", esp_err_to_name(ret));
+static void devkit_frame_presented(void)
+{
+    if(s_exporting && s_export_task) {
+        take_snapshot();
     }
-#endif
+}
 
-    // Initialize file systems if configured
-#ifdef CONFIG_BSP_DEVKIT_SPIFFS_ENABLED
-    ret = bsp_spiffs_mount();
-    if(ret == ESP_OK) {
-        ESP_LOGI(TAG, "SPIFFS mounted successfully");
-    } else {
-        ESP_LOGW(TAG, "SPIFFS mount failed: %s", esp_err_to_name(ret));
+static esp_err_t devkit_init(esp_bsp_sdl_display_config_t *config,
+                             esp_lcd_panel_handle_t *panel_handle,
+                             esp_lcd_panel_io_handle_t *panel_io_handle)
+{
+    ESP_LOGI(TAG, "Initializing DevKit offscreen panel");
+
+    if(!config || !panel_handle || !panel_io_handle) {
+        return ESP_ERR_INVALID_ARG;
     }
-#endif
 
-#ifdef CONFIG_BSP_DEVKIT_USD_ENABLED
-    // Note: uSD card initialization would be done here if configured
-    ESP_LOGI(TAG, "uSD card support configured (mount on demand)");
-#endif
+    config->width = CONFIG_SDL_BSP_DEVKIT_WIDTH;
+    config->height = CONFIG_SDL_BSP_DEVKIT_HEIGHT;
+    config->pixel_format = SDL_PIXELFORMAT_RGB565;
+    config->max_transfer_sz = esp_bsp_sdl_priv_transfer_size(config->width, config->height);
+    config->has_touch = false;
 
-    // No physical display handles for DevKit
-    *panel_handle = NULL;
-    *panel_io_handle = NULL;
+    const esp_bsp_sdl_virtual_panel_config_t panel_config = {
+        .width = config->width,
+        .height = config->height,
+    };
+    esp_err_t ret = esp_bsp_sdl_virtual_panel_new(&panel_config, &s_panel_io_handle, &s_panel_handle);
+    if(ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create offscreen panel: %s", esp_err_to_name(ret));
+        return ret;
+    }
 
-    ESP_LOGI(TAG, "ESP BSP DevKit initialized (virtual display: %dx%d)", config->width, config->height);
+    // Same bring-up as the BSPs: reset, init, display on
+    ret = esp_lcd_panel_reset(s_panel_handle);
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_init(s_panel_handle);
+    }
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_disp_on_off(s_panel_handle, true);
+    }
+    if(ret == ESP_OK) {
+        ret = esp_bsp_sdl_virtual_panel_set_listener(s_panel_handle, on_frame_written, NULL);
+    }
+    if(ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize offscreen panel: %s", esp_err_to_name(ret));
+        esp_lcd_panel_del(s_panel_handle);
+        esp_lcd_panel_io_del(s_panel_io_handle);
+        s_panel_handle = NULL;
+        s_panel_io_handle = NULL;
+        return ret;
+    }
+
+    *panel_handle = s_panel_handle;
+    *panel_io_handle = s_panel_io_handle;
 
+    // A missing export device leaves the board headless, frames stay readable on the device
+    const char *path = CONFIG_SDL_BSP_DEVKIT_EXPORT_PATH;
+    if(path[0]) {
+        s_export_file = fopen(path, "wb");
+        if(!s_export_file) {
+            ESP_LOGW(TAG, "Cannot open %s, frames are not exported", path);
+        } else if(esp_bsp_sdl_devkit_export_start(s_export_file) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to start frame export to %s", path);
+            fclose(s_export_file);
+            s_export_file = NULL;
+        }
+    }
+
+    ESP_LOGI(TAG, "DevKit offscreen panel initialized: %dx%d", config->width, config->height);
     return ESP_OK;
 }
 
-esp_err_t esp_bsp_sdl_board_backlight_on(void)
+static esp_err_t devkit_backlight_on(void)
 {
-    ESP_LOGW(TAG, "DevKit has no backlight - ignoring backlight_on request");
-    return ESP_OK;  // Return success since this is expected for DevKit
+    ESP_LOGD(TAG, "Offscreen panel: backlight on");
+    return ESP_OK;
 }
 
-int esp_bsp_sdl_board_backlight_off(void)
+static esp_err_t devkit_backlight_off(void)
 {
-    ESP_LOGW(TAG, "DevKit has no backlight - ignoring backlight_off request");
-    return ESP_OK;  // Return success since this is expected for DevKit
+    ESP_LOGD(TAG, "Offscreen panel: backlight off");
+    return ESP_OK;
 }
 
-esp_err_t esp_bsp_sdl_board_display_on_off(bool enable)
+static esp_err_t devkit_display_on_off(bool enable)
 {
-    ESP_LOGD(TAG, "%s virtual display (no physical display on DevKit)", enable ? "Enabling" : "Disabling");
-    return ESP_OK;  // Always succeed for virtual display
+    if(s_panel_handle) {
+        return esp_lcd_panel_disp_on_off(s_panel_handle, enable);
+    }
+    return ESP_ERR_INVALID_STATE;
 }
 
-esp_err_t esp_bsp_sdl_board_touch_init(void)
+static esp_err_t devkit_touch_init(void)
 {
     ESP_LOGI(TAG, "DevKit has no touch interface");
     return ESP_ERR_NOT_SUPPORTED;
 }
 
-esp_err_t esp_bsp_sdl_board_touch_read(esp_bsp_sdl_touch_info_t *touch_info)
+static esp_err_t devkit_touch_read(esp_bsp_sdl_touch_info_t *touch_info)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static esp_err_t devkit_set_orientation(esp_bsp_sdl_orientation_t orientation)
 {
-    return ESP_ERR_NOT_SUPPORTED;  // DevKit has no touch
+    // MADCTL is interpreted by the offscreen panel, exported frames stay in native orientation
+    return esp_bsp_sdl_panel_apply_orientation(s_panel_handle, orientation, false, false);
 }
 
-const char *esp_bsp_sdl_board_get_name(void)
+static const char *devkit_get_name(void)
 {
-    return "ESP BSP DevKit (LEDs/Buttons)";
+    return "DevKit (offscreen)";
 }
 
-esp_err_t esp_bsp_sdl_board_deinit(void)
+static esp_err_t devkit_deinit(void)
 {
-    ESP_LOGI(TAG, "Deinitializing ESP BSP DevKit");
+    ESP_LOGI(TAG, "Deinitializing DevKit offscreen panel");
 
-    // Clean up DevKit BSP resources if needed
-#ifdef CONFIG_BSP_DEVKIT_SPIFFS_ENABLED
-    bsp_spiffs_unmount();
-#endif
+    if(s_exporting) {
+        esp_bsp_sdl_devkit_export_stop();
+    }
+    if(s_export_file) {
+        fclose(s_export_file);
+        s_export_file = NULL;
+    }
+    if(s_export_done) {
+        vSemaphoreDelete(s_export_done);
+        s_export_done = NULL;
+    }
+    if(s_snapshot_lock) {
+        vSemaphoreDelete(s_snapshot_lock);
+        s_snapshot_lock = NULL;
+    }
+
+    if(s_panel_handle) {
+        esp_lcd_panel_del(s_panel_handle);
+        s_panel_handle = NULL;
+    }
+
+    if(s_panel_io_handle) {
+        esp_lcd_panel_io_del(s_panel_io_handle);
+        s_panel_io_handle = NULL;
+    }
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+// DevKit board interface
+const esp_bsp_sdl_board_interface_t esp_bsp_sdl_devkit_interface = {.init = devkit_init,
+                                                                    .backlight_on = devkit_backlight_on,
+                                                                    .backlight_off = devkit_backlight_off,
+                                                                    .display_on_off = devkit_display_on_off,
+                                                                    .touch_init = devkit_touch_init,
+                                                                    .touch_read = devkit_touch_read,
+                                                                    .get_name = devkit_get_name,
+                                                                    .deinit = devkit_deinit,
+                                                                    .set_orientation = devkit_set_orientation,
+                                                                    .dbi = &s_dbi_info,
+                                                                    .frame_presented = devkit_frame_presented,
+                                                                    .board_name = "DevKit (offscreen)"};
@@ -1,113 +1,322 @@
 /**
  * @file esp_bsp_sdl_esp_bsp_generic.c
- * @brief ESP BSP Generic specific implementation for ESP-BSP SDL abstraction layer
- * Uses esp_bsp_generic for configurable DevKit + Display support
- * Supports any ESP32 DevKit with custom display/touch configuration via menuconfig
+ * @brief Generic SPI panel board for the ESP-BSP SDL abstraction layer
+ * Builds the SPI bus, panel IO and esp_lcd panel from a declarative descriptor
+ * (esp_bsp_sdl_generic.h), used for the ESP32-C3-LCDkit, the ESP32-C6 DevKit and custom panels.
  */
 
-#include "esp_bsp_generic.h"
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
 #include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_generic.h"
+#include "esp_bsp_sdl_priv.h"
 #include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_vendor.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
 
+#if CONFIG_SDL_BSP_GENERIC_ILI9341
+#    include "esp_lcd_ili9341.h"
+#endif
+#if CONFIG_SDL_BSP_GENERIC_GC9A01
+#    include "esp_lcd_gc9a01.h"
+#endif
+
 // SDL pixel format constants - using direct values to avoid SDL dependency
 #define SDL_PIXELFORMAT_RGB565 0x15151002u
 
-static const char *TAG = "esp_bsp_sdl_esp_bsp_generic";
+#if CONFIG_SDL_BSP_ESP32_C3_LCDKIT
+#    define GENERIC_BOARD_NAME "ESP32-C3-LCDkit"
+#elif CONFIG_SDL_BSP_ESP32_C6_DEVKIT
+#    define GENERIC_BOARD_NAME "ESP32-C6 DevKit"
+#else
+#    define GENERIC_BOARD_NAME "Generic SPI panel"
+#endif
+
+#if CONFIG_SDL_BSP_GENERIC_ILI9341
+#    define GENERIC_CONTROLLER ESP_BSP_SDL_PANEL_ILI9341
+#elif CONFIG_SDL_BSP_GENERIC_GC9A01
+#    define GENERIC_CONTROLLER ESP_BSP_SDL_PANEL_GC9A01
+#else
+#    define GENERIC_CONTROLLER ESP_BSP_SDL_PANEL_ST7789
+#endif
+
+typedef esp_err_t (*panel_new_fn_t)(const esp_lcd_panel_io_handle_t io,
+                                    const esp_lcd_panel_dev_config_t *panel_dev_config,
+                                    esp_lcd_panel_handle_t *ret_panel);
+
+// Controller driver table. ST7789 is part of esp_lcd; ILI9341 and GC9A01 are managed components and
+// only the one selected in menuconfig is built, the other keeps its name but has no constructor.
+typedef struct {
+    const char *name;
+    panel_new_fn_t new_panel;
+    int spi_mode;
+    int ram_width;  // Controller RAM columns
+    int ram_height; // Controller RAM rows, also the VSCRDEF lines
+} panel_driver_t;
+
+static const panel_driver_t s_drivers[ESP_BSP_SDL_PANEL_MAX] = {
+    [ESP_BSP_SDL_PANEL_ST7789] = {.name = "ST7789",
+                                  .new_panel = esp_lcd_new_panel_st7789,
+                                  .spi_mode = 0,
+                                  .ram_width = 240,
+                                  .ram_height = 320},
+#if CONFIG_SDL_BSP_GENERIC_ILI9341
+    [ESP_BSP_SDL_PANEL_ILI9341] = {.name = "ILI9341",
+                                   .new_panel = esp_lcd_new_panel_ili9341,
+                                   .spi_mode = 0,
+                                   .ram_width = 240,
+                                   .ram_height = 320},
+#else
+    [ESP_BSP_SDL_PANEL_ILI9341] = {.name = "ILI9341"},
+#endif
+#if CONFIG_SDL_BSP_GENERIC_GC9A01
+    [ESP_BSP_SDL_PANEL_GC9A01] = {.name = "GC9A01",
+                                  .new_panel = esp_lcd_new_panel_gc9a01,
+                                  .spi_mode = 0,
+                                  .ram_width = 240,
+                                  .ram_height = 240},
+#else
+    [ESP_BSP_SDL_PANEL_GC9A01] = {.name = "GC9A01"},
+#endif
+};
+
+static const char *TAG = "esp_bsp_sdl_generic";
+static esp_bsp_sdl_generic_panel_t s_desc;
+static bool s_desc_valid = false;
+static esp_bsp_sdl_dbi_info_t s_dbi_info; // Gap and mirroring taken from the descriptor at init
+static bool s_bus_initialized = false;
 static esp_lcd_panel_handle_t s_panel_handle = NULL;
 static esp_lcd_panel_io_handle_t s_panel_io_handle = NULL;
 
-esp_err_t esp_bsp_sdl_board_init(esp_bsp_sdl_display_config_t *config,
-                                 esp_lcd_panel_handle_t *panel_handle,
-                                 esp_lcd_panel_io_handle_t *panel_io_handle)
+void esp_bsp_sdl_generic_get_default(esp_bsp_sdl_generic_panel_t *panel)
 {
-    ESP_LOGI(TAG, "Initializing ESP BSP Generic (Configurable DevKit)");
+    if(!panel) {
+        return;
+    }
+    *panel = (esp_bsp_sdl_generic_panel_t) {
+        .controller = GENERIC_CONTROLLER,
+        .width = CONFIG_SDL_BSP_GENERIC_WIDTH,
+        .height = CONFIG_SDL_BSP_GENERIC_HEIGHT,
+        .spi_host = CONFIG_SDL_BSP_GENERIC_SPI_HOST,
+        .pclk_hz = CONFIG_SDL_BSP_GENERIC_PCLK_HZ,
+        .pin_sclk = CONFIG_SDL_BSP_GENERIC_PIN_SCLK,
+        .pin_mosi = CONFIG_SDL_BSP_GENERIC_PIN_MOSI,
+        .pin_cs = CONFIG_SDL_BSP_GENERIC_PIN_CS,
+        .pin_dc = CONFIG_SDL_BSP_GENERIC_PIN_DC,
+        .pin_rst = CONFIG_SDL_BSP_GENERIC_PIN_RST,
+        .pin_backlight = CONFIG_SDL_BSP_GENERIC_PIN_BACKLIGHT,
+        .backlight_on_level = CONFIG_SDL_BSP_GENERIC_BACKLIGHT_ON_LEVEL,
+#if CONFIG_SDL_BSP_GENERIC_BGR
+        .bgr = true,
+#endif
+#if CONFIG_SDL_BSP_GENERIC_INVERT_COLOR
+        .invert_color = true,
+#endif
+#if CONFIG_SDL_BSP_GENERIC_MIRROR_X
+        .mirror_x = true,
+#endif
+#if CONFIG_SDL_BSP_GENERIC_MIRROR_Y
+        .mirror_y = true,
+#endif
+        .x_gap = CONFIG_SDL_BSP_GENERIC_X_GAP,
+        .y_gap = CONFIG_SDL_BSP_GENERIC_Y_GAP,
+    };
+}
 
+esp_err_t esp_bsp_sdl_generic_set_panel(const esp_bsp_sdl_generic_panel_t *panel)
+{
+    if(!panel || panel->controller >= ESP_BSP_SDL_PANEL_MAX || panel->width <= 0 || panel->height <= 0 ||
+       panel->pin_sclk < 0 || panel->pin_mosi < 0 || panel->pin_dc < 0 || panel->pclk_hz == 0 ||
+       panel->spi_host <= SPI1_HOST || panel->spi_host >= SPI_HOST_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(!s_drivers[panel->controller].new_panel) {
+        ESP_LOGE(TAG, "%s driver is not part of the build", s_drivers[panel->controller].name);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if(s_panel_handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_desc = *panel;
+    s_desc_valid = true;
+    return ESP_OK;
+}
+
+static esp_err_t set_backlight(bool on)
+{
+    if(s_desc.pin_backlight < 0) {
+        return ESP_OK;
+    }
+    return gpio_set_level(s_desc.pin_backlight, on == s_desc.backlight_on_level);
+}
+
+// Undo whatever generic_init() got to, in reverse order
+static void release(void)
+{
+    if(s_panel_handle) {
+        esp_lcd_panel_del(s_panel_handle);
+        s_panel_handle = NULL;
+    }
+    if(s_panel_io_handle) {
+        esp_lcd_panel_io_del(s_panel_io_handle);
+        s_panel_io_handle = NULL;
+    }
+    if(s_bus_initialized) {
+        spi_bus_free(s_desc.spi_host);
+        s_bus_initialized = false;
+    }
+    if(s_desc.pin_backlight >= 0) {
+        gpio_reset_pin(s_desc.pin_backlight);
+    }
+}
+
+static esp_err_t generic_init(esp_bsp_sdl_display_config_t *config,
+                              esp_lcd_panel_handle_t *panel_handle,
+                              esp_lcd_panel_io_handle_t *panel_io_handle)
+{
     if(!config || !panel_handle || !panel_io_handle) {
         return ESP_ERR_INVALID_ARG;
     }
+    if(!s_desc_valid) {
+        esp_bsp_sdl_generic_get_default(&s_desc);
+        s_desc_valid = true;
+    }
 
-    esp_err_t ret = ESP_OK;
+    const panel_driver_t *driver = &s_drivers[s_desc.controller];
+    ESP_LOGI(TAG,
+             "Initializing %s panel %dx%d on SPI host %d",
+             driver->name,
+             s_desc.width,
+             s_desc.height,
+             s_desc.spi_host);
+    if(!driver->new_panel) {
+        ESP_LOGE(TAG, "%s driver is not part of the build, select the controller in menuconfig", driver->name);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
 
-    // Step 1: Get display configuration from BSP Generic
-    // The actual resolution and settings are configured via menuconfig
-#ifdef CONFIG_BSP_GENERIC_DISPLAY_ENABLED
-    // Read configuration from BSP Generic settings
-    config->width = CONFIG_BSP_GENERIC_DISPLAY_WIDTH;
-    config->height = CONFIG_BSP_GENERIC_DISPLAY_HEIGHT;
+    config->width = s_desc.width;
+    config->height = s_desc.height;
     config->pixel_format = SDL_PIXELFORMAT_RGB565;
-    config->max_transfer_sz = (config->width * config->height) * sizeof(uint16_t);
-    config->has_touch = CONFIG_BSP_GENERIC_TOUCH_ENABLED;
+    config->max_transfer_sz = esp_bsp_sdl_priv_transfer_size(config->width, config->height);
+    config->has_touch = s_desc.touch != NULL;
 
-    ESP_LOGI(TAG,
-             "Display configured: %dx%d, Touch: %s",
-             config->width,
-             config->height,
-             config->has_touch ? "enabled" : "disabled");
-
-    // Step 2: Initialize BSP Generic display
-    ESP_LOGI(TAG, "Initializing display via BSP Generic...");
-    ret = bsp_display_new(NULL, &s_panel_handle, &s_panel_io_handle);
+    esp_err_t ret = ESP_OK;
+
+    // Backlight stays off until the panel shows something
+    if(s_desc.pin_backlight >= 0) {
+        const gpio_config_t bl_config = {
+            .pin_bit_mask = 1ULL << s_desc.pin_backlight,
+            .mode = GPIO_MODE_OUTPUT,
+        };
+        ret = gpio_config(&bl_config);
+        if(ret == ESP_OK) {
+            ret = set_backlight(false);
+        }
+        if(ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to configure backlight pin: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+
+    const spi_bus_config_t bus_config = {
+        .sclk_io_num = s_desc.pin_sclk,
+        .mosi_io_num = s_desc.pin_mosi,
+        .miso_io_num = -1,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = config->max_transfer_sz,
+    };
+    ret = spi_bus_initialize(s_desc.spi_host, &bus_config, SPI_DMA_CH_AUTO);
+    if(ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize SPI bus: %s", esp_err_to_name(ret));
+        release();
+        return ret;
+    }
+    s_bus_initialized = true;
+
+    const esp_lcd_panel_io_spi_config_t io_config = {
+        .cs_gpio_num = s_desc.pin_cs,
+        .dc_gpio_num = s_desc.pin_dc,
+        .spi_mode = driver->spi_mode,
+        .pclk_hz = s_desc.pclk_hz,
+        .trans_queue_depth = 10,
+        .lcd_cmd_bits = 8,
+        .lcd_param_bits = 8,
+    };
+    ret = esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t) s_desc.spi_host, &io_config, &s_panel_io_handle);
     if(ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize BSP Generic display: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to create panel IO: %s", esp_err_to_name(ret));
+        release();
         return ret;
     }
 
-    // Step 3: Turn on the display
-    ESP_LOGI(TAG, "Enabling display...");
-    ret = esp_lcd_panel_disp_on_off(s_panel_handle, true);
+    const esp_lcd_panel_dev_config_t panel_config = {
+        .reset_gpio_num = s_desc.pin_rst,
+        .rgb_ele_order = s_desc.bgr ? LCD_RGB_ELEMENT_ORDER_BGR : LCD_RGB_ELEMENT_ORDER_RGB,
+        .bits_per_pixel = 16,
+    };
+    ret = driver->new_panel(s_panel_io_handle, &panel_config, &s_panel_handle);
     if(ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to turn on display: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to create %s panel: %s", driver->name, esp_err_to_name(ret));
+        release();
         return ret;
     }
 
-    // Step 4: Initialize backlight if available
-    ESP_LOGI(TAG, "Initializing backlight control...");
-    ret = bsp_display_brightness_init();
+    ret = esp_lcd_panel_reset(s_panel_handle);
     if(ret == ESP_OK) {
-        ret = bsp_display_backlight_on();
-        if(ret != ESP_OK) {
-            ESP_LOGW(TAG, "Backlight control failed: %s", esp_err_to_name(ret));
-        }
-    } else {
-        ESP_LOGI(TAG, "No backlight control configured");
+        ret = esp_lcd_panel_init(s_panel_handle);
+    }
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_invert_color(s_panel_handle, s_desc.invert_color);
+    }
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_set_gap(s_panel_handle, s_desc.x_gap, s_desc.y_gap);
+    }
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_mirror(s_panel_handle, s_desc.mirror_x, s_desc.mirror_y);
+    }
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_disp_on_off(s_panel_handle, true);
+    }
+    if(ret == ESP_OK) {
+        ret = set_backlight(true);
+    }
+    if(ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize %s panel: %s", driver->name, esp_err_to_name(ret));
+        release();
+        return ret;
     }
 
+    s_dbi_info.x_gap = s_desc.x_gap;
+    s_dbi_info.y_gap = s_desc.y_gap;
+    s_dbi_info.ram_width = driver->ram_width;
+    s_dbi_info.ram_height = driver->ram_height;
+    s_dbi_info.scroll_lines = driver->ram_height;
+    s_dbi_info.mirror_x = s_desc.mirror_x;
+    s_dbi_info.mirror_y = s_desc.mirror_y;
+
     *panel_handle = s_panel_handle;
     *panel_io_handle = s_panel_io_handle;
 
-#else
-    // No display configured - this is unusual for SDL applications but supported
-    ESP_LOGW(TAG, "No display configured in BSP Generic - SDL will use virtual display");
-    config->width = 240;  // Default fallback size
-    config->height = 320;
-    config->pixel_format = SDL_PIXELFORMAT_RGB565;
-    config->max_transfer_sz = (config->width * config->height) * sizeof(uint16_t);
-    config->has_touch = false;
-
-    *panel_handle = NULL;
-    *panel_io_handle = NULL;
-#endif
-
-    ESP_LOGI(TAG, "ESP BSP Generic initialized: %dx%d", config->width, config->height);
-
+    ESP_LOGI(TAG, "%s initialized: %dx%d", GENERIC_BOARD_NAME, config->width, config->height);
     return ESP_OK;
 }
 
-esp_err_t esp_bsp_sdl_board_backlight_on(void)
+static esp_err_t generic_backlight_on(void)
 {
-    ESP_LOGI(TAG, "Turning backlight on");
-    return bsp_display_backlight_on();
+    ESP_LOGD(TAG, "Turning on backlight");
+    return set_backlight(true);
 }
 
-int esp_bsp_sdl_board_backlight_off(void)
+static esp_err_t generic_backlight_off(void)
 {
-    ESP_LOGI(TAG, "Turning backlight off");
-    return bsp_display_backlight_off();
+    ESP_LOGD(TAG, "Turning off backlight");
+    return set_backlight(false);
 }
 
-esp_err_t esp_bsp_sdl_board_display_on_off(bool enable)
+static esp_err_t generic_display_on_off(bool enable)
 {
     ESP_LOGD(TAG, "%s display", enable ? "Enabling" : "Disabling");
     if(s_panel_handle) {
@@ -116,60 +325,72 @@ esp_err_t esp_bsp_sdl_board_display_on_off(bool enable)
     return ESP_ERR_INVALID_STATE;
 }
 
-esp_err_t esp_bsp_sdl_board_touch_init(void)
+static esp_err_t generic_touch_init(void)
 {
-#ifdef CONFIG_BSP_GENERIC_TOUCH_ENABLED
-    ESP_LOGI(TAG, "Initializing touch interface");
-
-    esp_err_t ret = bsp_touch_new(NULL, NULL);
-    if(ret == ESP_OK) {
-        ESP_LOGI(TAG, "Touch interface initialized successfully");
-        return ESP_OK;
-    } else {
-        ESP_LOGW(TAG, "Touch initialization failed: %s", esp_err_to_name(ret));
-        return ret;
+    if(!s_desc.touch) {
+        ESP_LOGW(TAG, "No touch controller in the panel descriptor");
+        return ESP_ERR_NOT_SUPPORTED;
     }
-#else
-    ESP_LOGI(TAG, "Touch not configured in BSP Generic");
-    return ESP_ERR_NOT_SUPPORTED;
-#endif
+    // Created by the application, nothing to bring up
+    return ESP_OK;
 }
 
-esp_err_t esp_bsp_sdl_board_touch_read(esp_bsp_sdl_touch_info_t *touch_info)
+static esp_err_t generic_touch_read(esp_bsp_sdl_touch_info_t *touch_info)
 {
-#ifdef CONFIG_BSP_GENERIC_TOUCH_ENABLED
     if(!touch_info) {
         return ESP_ERR_INVALID_ARG;
     }
+    if(!s_desc.touch) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
 
-    // TODO: Implement touch reading for BSP Generic
-    // This would need to be implemented based on the actual touch driver configured
-    touch_info->pressed = false;
-    touch_info->x = 0;
-    touch_info->y = 0;
+    uint16_t touch_x[1] = {0};
+    uint16_t touch_y[1] = {0};
+    uint8_t touch_cnt = 0;
 
-    return ESP_ERR_NOT_SUPPORTED;  // Not yet implemented
-#else
-    return ESP_ERR_NOT_SUPPORTED;
-#endif
+    esp_err_t ret = esp_lcd_touch_read_data(s_desc.touch);
+    if(ret != ESP_OK) {
+        return ret;
+    }
+
+    bool touched = esp_lcd_touch_get_coordinates(s_desc.touch, touch_x, touch_y, NULL, &touch_cnt, 1);
+
+    touch_info->pressed = touched && (touch_cnt > 0);
+    touch_info->x = touch_info->pressed ? (int) touch_x[0] : 0;
+    touch_info->y = touch_info->pressed ? (int) touch_y[0] : 0;
+
+    return ESP_OK;
 }
 
-const char *esp_bsp_sdl_board_get_name(void)
+static esp_err_t generic_set_orientation(esp_bsp_sdl_orientation_t orientation)
 {
-    return "ESP BSP Generic (Configurable)";
+    // Rotation is done by the panel controller (MADCTL), no per-frame cost
+    return esp_bsp_sdl_panel_apply_orientation(s_panel_handle, orientation, s_desc.mirror_x, s_desc.mirror_y);
 }
 
-esp_err_t esp_bsp_sdl_board_deinit(void)
+static const char *generic_get_name(void)
 {
-    ESP_LOGI(TAG, "Deinitializing ESP BSP Generic");
-
-    if(s_panel_handle) {
-        s_panel_handle = NULL;
-    }
+    return GENERIC_BOARD_NAME;
+}
 
-    if(s_panel_io_handle) {
-        s_panel_io_handle = NULL;
-    }
+static esp_err_t generic_deinit(void)
+{
+    ESP_LOGI(TAG, "Deinitializing %s", GENERIC_BOARD_NAME);
 
+    // The touch controller belongs to the application
+    release();
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+// Generic SPI panel board interface
+const esp_bsp_sdl_board_interface_t esp_bsp_sdl_generic_interface = {.init = generic_init,
+                                                                     .backlight_on = generic_backlight_on,
+                                                                     .backlight_off = generic_backlight_off,
+                                                                     .display_on_off = generic_display_on_off,
+                                                                     .touch_init = generic_touch_init,
+                                                                     .touch_read = generic_touch_read,
+                                                                     .get_name = generic_get_name,
+                                                                     .deinit = generic_deinit,
+                                                                     .set_orientation = generic_set_orientation,
+                                                                     .dbi = &s_dbi_info,
+                                                                     .board_name = GENERIC_BOARD_NAME};
@@ -5,6 +5,7 @@
  */
 
 #include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_priv.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
@@ -18,6 +19,21 @@
 // SDL pixel format constants - using direct values to avoid SDL dependency
 #define SDL_PIXELFORMAT_RGB565 0x15151002u
 
+// Mirror state applied by bsp_display_new(), orientation changes are relative to it
+#define BSP_SDL_PANEL_MIRROR_X false
+#define BSP_SDL_PANEL_MIRROR_Y false
+
+// SPI MIPI-DBI panel, gap matches bsp_display_new()
+static const esp_bsp_sdl_dbi_info_t s_dbi_info = {
+    .x_gap = 0,
+    .y_gap = 32,
+    .ram_width = 128, // GC9107, 128x160 RAM
+    .ram_height = 160,
+    .scroll_lines = 160,
+    .mirror_x = BSP_SDL_PANEL_MIRROR_X,
+    .mirror_y = BSP_SDL_PANEL_MIRROR_Y,
+};
+
 static const char *TAG = "esp_bsp_sdl_m5_atom_s3";
 static esp_lcd_panel_handle_t s_panel_handle = NULL;
 static esp_lcd_panel_io_handle_t s_panel_io_handle = NULL;
@@ -38,7 +54,7 @@ static esp_err_t m5_atom_s3_init(esp_bsp_sdl_display_config_t *config,
     config->width = 128;   // M5 Atom S3 specific resolution
     config->height = 128;  // M5 Atom S3 specific resolution
     config->pixel_format = SDL_PIXELFORMAT_RGB565;
-    config->max_transfer_sz = (128 * 128) * sizeof(uint16_t);
+    config->max_transfer_sz = esp_bsp_sdl_priv_transfer_size(config->width, config->height);
     config->has_touch = BSP_CAPS_TOUCH == 1;
 
     // Step 2: Initialize backlight PWM control FIRST (M5 Atom S3 requires this)
@@ -140,6 +156,15 @@ static esp_err_t m5_atom_s3_touch_read(esp_bsp_sdl_touch_info_t *touch_info)
 #endif
 }
 
+static esp_err_t m5_atom_s3_set_orientation(esp_bsp_sdl_orientation_t orientation)
+{
+    // Rotation is done by the panel controller (MADCTL), no per-frame cost
+    return esp_bsp_sdl_panel_apply_orientation(s_panel_handle,
+                                                orientation,
+                                                BSP_SDL_PANEL_MIRROR_X,
+                                                BSP_SDL_PANEL_MIRROR_Y);
+}
+
 static const char *m5_atom_s3_get_name(void)
 {
     return "M5 Atom S3";
@@ -170,4 +195,6 @@ const esp_bsp_sdl_board_interface_t esp_bsp_sdl_m5_atom_s3_interface = {.init =
                                                                         .touch_read = m5_atom_s3_touch_read,
                                                                         .get_name = m5_atom_s3_get_name,
                                                                         .deinit = m5_atom_s3_deinit,
+                                                                        .set_orientation = m5_atom_s3_set_orientation,
+                                                                        .dbi = &s_dbi_info,
                                                                         .board_name = "M5 Atom S3"};
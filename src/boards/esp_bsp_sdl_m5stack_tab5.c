@@ -232,6 +232,10 @@ static esp_err_t m5stack_tab5_deinit(void)
 }
 
 // M5Stack Tab5 board interface
+// No get_frame_buffer/set_orientation: the software rotation of DPI panels blits into the frame buffer
+// with the geometry init reports, and this board reports 1280x720 landscape over the 720x1280 portrait
+// panel (touch is remapped above). Until init reports the native geometry, only orientation 0 is
+// supported and vertical scrolling, which moves rows in the frame buffer, is not available.
 const esp_bsp_sdl_board_interface_t esp_bsp_sdl_m5stack_tab5_interface = {.init = m5stack_tab5_init,
                                                                           .backlight_on = m5stack_tab5_backlight_on,
                                                                           .backlight_off = m5stack_tab5_backlight_off,
@@ -0,0 +1,240 @@
+/**
+ * @file esp_bsp_sdl_virtual.c
+ * @brief Virtual board for the ESP-BSP SDL abstraction layer
+ * Renders into a RAM-backed MIPI-DBI panel stand-in, no display hardware or BSP required.
+ * Frames can be read back with esp_bsp_sdl_virtual_panel_get_frame() for reference comparisons,
+ * touch input comes from a scripted mock controller.
+ */
+
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_bsp_sdl_touch_mock.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+// SDL pixel format constants - using direct values to avoid SDL dependency
+#define SDL_PIXELFORMAT_RGB565 0x15151002u
+
+#if CONFIG_SDL_BSP_VIRTUAL_RAM_WIDTH
+#    define VIRTUAL_RAM_WIDTH CONFIG_SDL_BSP_VIRTUAL_RAM_WIDTH
+#else
+#    define VIRTUAL_RAM_WIDTH (CONFIG_SDL_BSP_VIRTUAL_X_GAP + CONFIG_SDL_BSP_VIRTUAL_WIDTH)
+#endif
+#if CONFIG_SDL_BSP_VIRTUAL_RAM_HEIGHT
+#    define VIRTUAL_RAM_HEIGHT CONFIG_SDL_BSP_VIRTUAL_RAM_HEIGHT
+#else
+#    define VIRTUAL_RAM_HEIGHT (CONFIG_SDL_BSP_VIRTUAL_Y_GAP + CONFIG_SDL_BSP_VIRTUAL_HEIGHT)
+#endif
+
+static const esp_bsp_sdl_dbi_info_t s_dbi_info = {
+    .x_gap = CONFIG_SDL_BSP_VIRTUAL_X_GAP,
+    .y_gap = CONFIG_SDL_BSP_VIRTUAL_Y_GAP,
+    .ram_width = VIRTUAL_RAM_WIDTH,
+    .ram_height = VIRTUAL_RAM_HEIGHT,
+    .scroll_lines = VIRTUAL_RAM_HEIGHT,
+};
+
+// ESP-Box-3 ILI9342 curves, so the gamma command stream can be checked without the board
+static const esp_bsp_sdl_panel_gamma_t s_panel_gamma = {
+    .positive = {0x0F, 0x31, 0x2B, 0x0C, 0x0E, 0x08, 0x4E, 0xF1, 0x37, 0x07, 0x10, 0x03, 0x0E, 0x09, 0x00},
+    .negative = {0x00, 0x0E, 0x14, 0x03, 0x11, 0x07, 0x31, 0xC1, 0x48, 0x08, 0x0F, 0x0C, 0x31, 0x36, 0x0F},
+    .length = 15,
+};
+
+// Bus timing model selected in menuconfig
+#if CONFIG_SDL_BSP_VIRTUAL_BUS_ESP_BOX_3
+#    define VIRTUAL_BUS_PROFILE ESP_BSP_SDL_VIRTUAL_PROFILE_ESP_BOX_3
+#elif CONFIG_SDL_BSP_VIRTUAL_BUS_M5STACK_CORE_S3
+#    define VIRTUAL_BUS_PROFILE ESP_BSP_SDL_VIRTUAL_PROFILE_M5STACK_CORE_S3
+#elif CONFIG_SDL_BSP_VIRTUAL_BUS_M5_ATOM_S3
+#    define VIRTUAL_BUS_PROFILE ESP_BSP_SDL_VIRTUAL_PROFILE_M5_ATOM_S3
+#elif CONFIG_SDL_BSP_VIRTUAL_BUS_ESP32_P4_FUNCTION_EV
+#    define VIRTUAL_BUS_PROFILE ESP_BSP_SDL_VIRTUAL_PROFILE_ESP32_P4_FUNCTION_EV
+#elif CONFIG_SDL_BSP_VIRTUAL_BUS_ESP32_S3_LCD_EV_BOARD
+#    define VIRTUAL_BUS_PROFILE ESP_BSP_SDL_VIRTUAL_PROFILE_ESP32_S3_LCD_EV
+#elif CONFIG_SDL_BSP_VIRTUAL_BUS_M5STACK_TAB5
+#    define VIRTUAL_BUS_PROFILE ESP_BSP_SDL_VIRTUAL_PROFILE_M5STACK_TAB5
+#else
+#    define VIRTUAL_BUS_PROFILE ESP_BSP_SDL_VIRTUAL_PROFILE_INSTANT
+#endif
+
+static const char *TAG = "esp_bsp_sdl_virtual";
+static esp_lcd_panel_handle_t s_panel_handle = NULL;
+static esp_lcd_panel_io_handle_t s_panel_io_handle = NULL;
+static esp_lcd_touch_handle_t s_touch_handle = NULL;
+
+static esp_err_t virtual_init(esp_bsp_sdl_display_config_t *config,
+                              esp_lcd_panel_handle_t *panel_handle,
+                              esp_lcd_panel_io_handle_t *panel_io_handle)
+{
+    ESP_LOGI(TAG, "Initializing virtual panel");
+
+    if(!config || !panel_handle || !panel_io_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    config->width = CONFIG_SDL_BSP_VIRTUAL_WIDTH;
+    config->height = CONFIG_SDL_BSP_VIRTUAL_HEIGHT;
+    config->pixel_format = SDL_PIXELFORMAT_RGB565;
+    config->max_transfer_sz = esp_bsp_sdl_priv_transfer_size(config->width, config->height);
+    config->has_touch = true;
+
+    esp_bsp_sdl_virtual_panel_config_t panel_config = {
+        .width = config->width,
+        .height = config->height,
+        .x_gap = s_dbi_info.x_gap,
+        .y_gap = s_dbi_info.y_gap,
+        .ram_width = s_dbi_info.ram_width,
+        .ram_height = s_dbi_info.ram_height,
+    };
+    esp_bsp_sdl_virtual_bus_get_profile(VIRTUAL_BUS_PROFILE, &panel_config.bus);
+    esp_err_t ret = esp_bsp_sdl_virtual_panel_new(&panel_config, &s_panel_io_handle, &s_panel_handle);
+    if(ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create virtual panel: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Same bring-up as the BSPs: reset, init, gap, display on
+    ret = esp_lcd_panel_reset(s_panel_handle);
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_init(s_panel_handle);
+    }
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_set_gap(s_panel_handle, s_dbi_info.x_gap, s_dbi_info.y_gap);
+    }
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_disp_on_off(s_panel_handle, true);
+    }
+    if(ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize virtual panel: %s", esp_err_to_name(ret));
+        esp_lcd_panel_del(s_panel_handle);
+        esp_lcd_panel_io_del(s_panel_io_handle);
+        s_panel_handle = NULL;
+        s_panel_io_handle = NULL;
+        return ret;
+    }
+
+    *panel_handle = s_panel_handle;
+    *panel_io_handle = s_panel_io_handle;
+
+    ESP_LOGI(TAG, "Virtual panel initialized: %dx%d", config->width, config->height);
+    return ESP_OK;
+}
+
+static esp_err_t virtual_backlight_on(void)
+{
+    ESP_LOGD(TAG, "Virtual panel: backlight on");
+    return ESP_OK;
+}
+
+static esp_err_t virtual_backlight_off(void)
+{
+    ESP_LOGD(TAG, "Virtual panel: backlight off");
+    return ESP_OK;
+}
+
+static esp_err_t virtual_display_on_off(bool enable)
+{
+    if(s_panel_handle) {
+        return esp_lcd_panel_disp_on_off(s_panel_handle, enable);
+    }
+    return ESP_ERR_INVALID_STATE;
+}
+
+static esp_err_t virtual_touch_init(void)
+{
+    if(s_touch_handle) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Initializing mock touch controller");
+    const esp_bsp_sdl_touch_mock_config_t touch_cfg = {
+        .x_max = CONFIG_SDL_BSP_VIRTUAL_WIDTH,
+        .y_max = CONFIG_SDL_BSP_VIRTUAL_HEIGHT,
+        .i2c_latency_us = CONFIG_SDL_BSP_VIRTUAL_TOUCH_LATENCY_US,
+    };
+    esp_err_t ret = esp_bsp_sdl_touch_mock_new(&touch_cfg, &s_touch_handle);
+    if(ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create mock touch: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static esp_err_t virtual_touch_read(esp_bsp_sdl_touch_info_t *touch_info)
+{
+    if(!touch_info || !s_touch_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Same esp_lcd_touch sequence as the BSP boards
+    uint16_t touch_x[1] = {0};
+    uint16_t touch_y[1] = {0};
+    uint8_t touch_cnt = 0;
+
+    esp_err_t ret = esp_lcd_touch_read_data(s_touch_handle);
+    if(ret != ESP_OK) {
+        return ret;
+    }
+
+    bool touched = esp_lcd_touch_get_coordinates(s_touch_handle, touch_x, touch_y, NULL, &touch_cnt, 1);
+
+    touch_info->pressed = touched && (touch_cnt > 0);
+    touch_info->x = touch_info->pressed ? (int) touch_x[0] : 0;
+    touch_info->y = touch_info->pressed ? (int) touch_y[0] : 0;
+
+    return ESP_OK;
+}
+
+esp_lcd_touch_handle_t esp_bsp_sdl_virtual_get_touch(void)
+{
+    return s_touch_handle;
+}
+
+static esp_err_t virtual_set_orientation(esp_bsp_sdl_orientation_t orientation)
+{
+    // MADCTL is interpreted by the stand-in exactly like a controller would
+    return esp_bsp_sdl_panel_apply_orientation(s_panel_handle, orientation, false, false);
+}
+
+static const char *virtual_get_name(void)
+{
+    return "Virtual panel";
+}
+
+static esp_err_t virtual_deinit(void)
+{
+    ESP_LOGI(TAG, "Deinitializing virtual panel");
+
+    if(s_touch_handle) {
+        esp_lcd_touch_del(s_touch_handle);
+        s_touch_handle = NULL;
+    }
+
+    if(s_panel_handle) {
+        esp_lcd_panel_del(s_panel_handle);
+        s_panel_handle = NULL;
+    }
+
+    if(s_panel_io_handle) {
+        esp_lcd_panel_io_del(s_panel_io_handle);
+        s_panel_io_handle = NULL;
+    }
+
+    return ESP_OK;
+}
+
+// Virtual board interface
+const esp_bsp_sdl_board_interface_t esp_bsp_sdl_virtual_interface = {.init = virtual_init,
+                                                                     .backlight_on = virtual_backlight_on,
+                                                                     .backlight_off = virtual_backlight_off,
+                                                                     .display_on_off = virtual_display_on_off,
+                                                                     .touch_init = virtual_touch_init,
+                                                                     .touch_read = virtual_touch_read,
+                                                                     .get_name = virtual_get_name,
+                                                                     .deinit = virtual_deinit,
+                                                                     .set_orientation = virtual_set_orientation,
+                                                                     .dbi = &s_dbi_info,
+                                                                     .panel_gamma = &s_panel_gamma,
+                                                                     .board_name = "Virtual panel"};
@@ -0,0 +1,228 @@
+/**
+ * @file esp_bsp_sdl_blend.c
+ * @brief Alpha blending kernels onto RGB565 surfaces
+ */
+
+#include <string.h>
+#include "esp_bsp_sdl_blend.h"
+
+// RGB565 spread over 32 bits as ------GGGGGG-----RRRRR------BBBBB, leaving room for a 5-bit multiply
+#define SPREAD_MASK 0x07E0F81Fu
+// Carry out of the spread 5-bit red/blue and 6-bit green channels after adding two channels
+#define SPREAD_CARRY_RB 0x00010020u
+#define SPREAD_CARRY_G 0x08000000u
+
+static inline unsigned alpha5(unsigned alpha)
+{
+    return (alpha + 4) >> 3;
+}
+
+static inline uint16_t argb8888_to_rgb565(uint32_t c)
+{
+    return ((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F);
+}
+
+/* Scalar: one channel at a time */
+
+static inline uint16_t scalar_over(uint16_t d, uint16_t s, unsigned a)
+{
+    int dr = d >> 11;
+    int dg = (d >> 5) & 0x3F;
+    int db = d & 0x1F;
+    dr += ((int) (s >> 11) - dr) * (int) a >> 5;
+    dg += ((int) ((s >> 5) & 0x3F) - dg) * (int) a >> 5;
+    db += ((int) (s & 0x1F) - db) * (int) a >> 5;
+    return (dr << 11) | (dg << 5) | db;
+}
+
+static inline uint16_t scalar_premul_over(uint16_t d, uint16_t s, unsigned a)
+{
+    const unsigned ia = 32 - a;
+    unsigned r = (s >> 11) + (((d >> 11) * ia) >> 5);
+    unsigned g = ((s >> 5) & 0x3F) + ((((d >> 5) & 0x3F) * ia) >> 5);
+    unsigned b = (s & 0x1F) + (((d & 0x1F) * ia) >> 5);
+    r = r > 0x1F ? 0x1F : r;
+    g = g > 0x3F ? 0x3F : g;
+    b = b > 0x1F ? 0x1F : b;
+    return (r << 11) | (g << 5) | b;
+}
+
+/* SWAR: the three channels of a pixel in one 32-bit word */
+
+static inline uint32_t spread(uint16_t c)
+{
+    return (c | ((uint32_t) c << 16)) & SPREAD_MASK;
+}
+
+static inline uint16_t unspread(uint32_t c)
+{
+    return c | (c >> 16);
+}
+
+static inline uint16_t swar_over(uint16_t d, uint16_t s, unsigned a)
+{
+    uint32_t dw = spread(d);
+    dw += (spread(s) - dw) * a >> 5;
+    return unspread(dw & SPREAD_MASK);
+}
+
+static inline uint16_t swar_premul_over(uint16_t d, uint16_t s, unsigned a)
+{
+    uint32_t sum = spread(s) + (((spread(d) * (32 - a)) >> 5) & SPREAD_MASK);
+    // Saturate: a carry out of a channel turns into all ones in that channel
+    const uint32_t carry_rb = sum & SPREAD_CARRY_RB;
+    const uint32_t carry_g = sum & SPREAD_CARRY_G;
+    sum |= (carry_rb - (carry_rb >> 5)) | (carry_g - (carry_g >> 6));
+    return unspread(sum & SPREAD_MASK);
+}
+
+/* Row kernels, generated for both pixel operators so both stay bit-identical by construction */
+
+#define DEFINE_KERNELS(prefix, over, premul_over)                                                               \
+    static void prefix##_argb8888_over(uint16_t *dst, const uint32_t *src, int count)                           \
+    {                                                                                                           \
+        for(int i = 0; i < count; i++) {                                                                        \
+            const unsigned a = alpha5(src[i] >> 24);                                                            \
+            if(a == 32) {                                                                                       \
+                dst[i] = argb8888_to_rgb565(src[i]);                                                            \
+            } else if(a) {                                                                                      \
+                dst[i] = over(dst[i], argb8888_to_rgb565(src[i]), a);                                           \
+            }                                                                                                   \
+        }                                                                                                       \
+    }                                                                                                           \
+                                                                                                                \
+    static void prefix##_argb8888_premul_over(uint16_t *dst, const uint32_t *src, int count)                    \
+    {                                                                                                           \
+        for(int i = 0; i < count; i++) {                                                                        \
+            const unsigned a = alpha5(src[i] >> 24);                                                            \
+            dst[i] = premul_over(dst[i], argb8888_to_rgb565(src[i]), a);                                        \
+        }                                                                                                       \
+    }                                                                                                           \
+                                                                                                                \
+    static void prefix##_rgb565_a8_over(uint16_t *dst, const uint16_t *src, const uint8_t *alpha, int count)    \
+    {                                                                                                           \
+        for(int i = 0; i < count; i++) {                                                                        \
+            const unsigned a = alpha5(alpha[i]);                                                                \
+            if(a == 32) {                                                                                       \
+                dst[i] = src[i];                                                                                \
+            } else if(a) {                                                                                      \
+                dst[i] = over(dst[i], src[i], a);                                                               \
+            }                                                                                                   \
+        }                                                                                                       \
+    }                                                                                                           \
+                                                                                                                \
+    static void prefix##_rgb565_a8_premul_over(uint16_t *dst,                                                   \
+                                               const uint16_t *src,                                             \
+                                               const uint8_t *alpha,                                            \
+                                               int count)                                                       \
+    {                                                                                                           \
+        for(int i = 0; i < count; i++) {                                                                        \
+            dst[i] = premul_over(dst[i], src[i], alpha5(alpha[i]));                                             \
+        }                                                                                                       \
+    }                                                                                                           \
+                                                                                                                \
+    static void prefix##_rgb565_const_over(uint16_t *dst, const uint16_t *src, uint8_t alpha, int count)        \
+    {                                                                                                           \
+        const unsigned a = alpha5(alpha);                                                                       \
+        if(a == 0) {                                                                                            \
+            return;                                                                                             \
+        }                                                                                                       \
+        if(a == 32) {                                                                                           \
+            memcpy(dst, src, count * sizeof(uint16_t));                                                         \
+            return;                                                                                             \
+        }                                                                                                       \
+        for(int i = 0; i < count; i++) {                                                                        \
+            dst[i] = over(dst[i], src[i], a);                                                                   \
+        }                                                                                                       \
+    }                                                                                                           \
+                                                                                                                \
+    static void prefix##_color_a8_over(uint16_t *dst, uint16_t color, const uint8_t *alpha, int count)          \
+    {                                                                                                           \
+        for(int i = 0; i < count; i++) {                                                                        \
+            const unsigned a = alpha5(alpha[i]);                                                                \
+            if(a == 32) {                                                                                       \
+                dst[i] = color;                                                                                 \
+            } else if(a) {                                                                                      \
+                dst[i] = over(dst[i], color, a);                                                                \
+            }                                                                                                   \
+        }                                                                                                       \
+    }                                                                                                           \
+                                                                                                                \
+    static const esp_bsp_sdl_blend_kernels_t prefix##_kernels = {                                               \
+        .argb8888_over = prefix##_argb8888_over,                                                                \
+        .argb8888_premul_over = prefix##_argb8888_premul_over,                                                  \
+        .rgb565_a8_over = prefix##_rgb565_a8_over,                                                              \
+        .rgb565_a8_premul_over = prefix##_rgb565_a8_premul_over,                                                \
+        .rgb565_const_over = prefix##_rgb565_const_over,                                                        \
+        .color_a8_over = prefix##_color_a8_over,                                                                \
+    };
+
+DEFINE_KERNELS(scalar, scalar_over, scalar_premul_over)
+DEFINE_KERNELS(swar, swar_over, swar_premul_over)
+
+// SWAR does one multiply per pixel instead of three and wins on every supported core
+static const esp_bsp_sdl_blend_kernels_t *s_kernels = &swar_kernels;
+
+const esp_bsp_sdl_blend_kernels_t *esp_bsp_sdl_blend_get_kernels(esp_bsp_sdl_blend_impl_t impl)
+{
+    switch(impl) {
+        case ESP_BSP_SDL_BLEND_IMPL_AUTO:
+            return s_kernels;
+        case ESP_BSP_SDL_BLEND_IMPL_SCALAR:
+            return &scalar_kernels;
+        case ESP_BSP_SDL_BLEND_IMPL_SWAR:
+            return &swar_kernels;
+        default:
+            return NULL;
+    }
+}
+
+esp_err_t esp_bsp_sdl_blend_select(esp_bsp_sdl_blend_impl_t impl)
+{
+    if(impl == ESP_BSP_SDL_BLEND_IMPL_AUTO) {
+        s_kernels = &swar_kernels;
+        return ESP_OK;
+    }
+    const esp_bsp_sdl_blend_kernels_t *kernels = esp_bsp_sdl_blend_get_kernels(impl);
+    if(!kernels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_kernels = kernels;
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_blend_surface(esp_bsp_sdl_surface_t *dst,
+                                    int dst_x,
+                                    int dst_y,
+                                    const esp_bsp_sdl_surface_t *src,
+                                    const esp_bsp_sdl_rect_t *src_rect,
+                                    uint8_t alpha)
+{
+    if(!dst || !dst->pixels || !src || !src->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const esp_bsp_sdl_rect_t src_whole = {0, 0, src->width, src->height};
+    const esp_bsp_sdl_rect_t dst_whole = {0, 0, dst->width, dst->height};
+    const int dx = dst_x - (src_rect ? src_rect->x : 0);
+    const int dy = dst_y - (src_rect ? src_rect->y : 0);
+    esp_bsp_sdl_rect_t area;
+    if(!esp_bsp_sdl_rect_intersect(src_rect ? src_rect : &src_whole, &src_whole, &area)) {
+        return ESP_OK;
+    }
+    area.x += dx;
+    area.y += dy;
+    if(!esp_bsp_sdl_rect_intersect(&area, &dst_whole, &area)) {
+        return ESP_OK;
+    }
+
+    const esp_bsp_sdl_blend_kernels_t *k = s_kernels;
+    for(int row = 0; row < area.h; row++) {
+        const int y = area.y + row;
+        k->rgb565_const_over(dst->pixels + (size_t) y * dst->stride + area.x,
+                             src->pixels + (size_t) (y - dy) * src->stride + (area.x - dx),
+                             alpha,
+                             area.w);
+    }
+    return ESP_OK;
+}
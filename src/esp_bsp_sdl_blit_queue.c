@@ -0,0 +1,396 @@
+/**
+ * @file esp_bsp_sdl_blit_queue.c
+ * @brief Sprite blit queue with sorted, band-batched execution
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl_blend.h"
+#include "esp_bsp_sdl_blit_queue.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define DEFAULT_MAX_SPRITES 512
+#define DEFAULT_BIN_ENTRIES_PER_SPRITE 4
+#define BAND_ROWS ESP_BSP_SDL_FLUSH_BAND_ROWS
+// Sort key bytes: texture address, then z, least significant first
+#define KEY_BYTES (sizeof(uintptr_t) + sizeof(uint32_t))
+
+static const char *TAG = "esp_bsp_sdl_blit_queue";
+
+typedef struct {
+    const uint16_t *texture; // Texture base, the batching key
+    const uint16_t *pixels;  // Texture pixel for dst.x, dst.y
+    int stride;
+    esp_bsp_sdl_rect_t dst; // Clipped to the target
+    int z;
+    uint8_t alpha;
+} queued_sprite_t;
+
+struct esp_bsp_sdl_blit_queue_t {
+    esp_bsp_sdl_blit_queue_config_t config;
+    int bands;
+    queued_sprite_t *sprites; // Submission order
+    queued_sprite_t *sorted;  // Draw order, so band walks read sprites front to back
+    uint32_t *order;          // Radix sort index buffers
+    uint32_t *order_tmp;
+    size_t count;
+    size_t bin_entries;    // Sprite references over all bands, counted on push
+    uint32_t *entries;     // Indices into sorted, grouped by band
+    uint32_t *band_count;  // Sprites per band, counted on push
+    uint32_t *band_start;  // First entry of every band, bands + 1 values
+    uint32_t digit[256];   // Radix histogram
+    const esp_bsp_sdl_surface_t *background; // esp_bsp_sdl_blit_queue_flush() state
+    uint16_t clear_color;
+    esp_bsp_sdl_blit_queue_stats_t stats;
+};
+
+esp_err_t esp_bsp_sdl_blit_queue_create(const esp_bsp_sdl_blit_queue_config_t *config,
+                                        esp_bsp_sdl_blit_queue_handle_t *ret_queue)
+{
+    if(!config || !ret_queue || config->width <= 0 || config->height <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_bsp_sdl_blit_queue_handle_t queue = esp_bsp_sdl_mem_calloc(ESP_BSP_SDL_MEM_RENDER, 1, sizeof(*queue), MALLOC_CAP_DEFAULT);
+    if(!queue) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    queue->config = *config;
+    esp_bsp_sdl_blit_queue_config_t *cfg = &queue->config;
+    if(cfg->max_sprites == 0) {
+        cfg->max_sprites = DEFAULT_MAX_SPRITES;
+    }
+    if(cfg->max_bin_entries == 0) {
+        cfg->max_bin_entries = cfg->max_sprites * DEFAULT_BIN_ENTRIES_PER_SPRITE;
+    }
+    queue->bands = (cfg->height + BAND_ROWS - 1) / BAND_ROWS;
+
+    queue->sprites = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, cfg->max_sprites * sizeof(queued_sprite_t), MALLOC_CAP_DEFAULT);
+    queue->sorted = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, cfg->max_sprites * sizeof(queued_sprite_t), MALLOC_CAP_DEFAULT);
+    queue->order = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, cfg->max_sprites * sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    queue->order_tmp = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, cfg->max_sprites * sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    queue->entries = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, cfg->max_bin_entries * sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    queue->band_count = esp_bsp_sdl_mem_calloc(ESP_BSP_SDL_MEM_RENDER, queue->bands, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    queue->band_start = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, (queue->bands + 1) * sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if(!queue->sprites || !queue->sorted || !queue->order || !queue->order_tmp || !queue->entries || !queue->band_count ||
+       !queue->band_start) {
+        ESP_LOGE(TAG, "Failed to allocate queue for %u sprites", (unsigned) cfg->max_sprites);
+        esp_bsp_sdl_blit_queue_delete(queue);
+        return ESP_ERR_NO_MEM;
+    }
+
+    *ret_queue = queue;
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_blit_queue_delete(esp_bsp_sdl_blit_queue_handle_t queue)
+{
+    if(!queue) {
+        return;
+    }
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, queue->sprites);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, queue->sorted);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, queue->order);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, queue->order_tmp);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, queue->entries);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, queue->band_count);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, queue->band_start);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, queue);
+}
+
+esp_err_t esp_bsp_sdl_blit_queue_push(esp_bsp_sdl_blit_queue_handle_t queue, const esp_bsp_sdl_sprite_t *sprite)
+{
+    if(!queue || !sprite || !sprite->texture || !sprite->texture->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(queue->count >= queue->config.max_sprites) {
+        return ESP_ERR_NO_MEM;
+    }
+    if(sprite->alpha == 0) {
+        return ESP_OK;
+    }
+
+    const esp_bsp_sdl_surface_t *tex = sprite->texture;
+    const esp_bsp_sdl_rect_t tex_rect = {0, 0, tex->width, tex->height};
+    const esp_bsp_sdl_rect_t target = {0, 0, queue->config.width, queue->config.height};
+    const int dx = sprite->dst_x - sprite->src.x;
+    const int dy = sprite->dst_y - sprite->src.y;
+    esp_bsp_sdl_rect_t area;
+    if(!esp_bsp_sdl_rect_intersect(&sprite->src, &tex_rect, &area)) {
+        return ESP_OK;
+    }
+    area.x += dx;
+    area.y += dy;
+    if(!esp_bsp_sdl_rect_intersect(&area, &target, &area)) {
+        return ESP_OK;
+    }
+
+    queued_sprite_t *q = &queue->sprites[queue->count];
+    q->texture = tex->pixels;
+    q->pixels = tex->pixels + (size_t) (area.y - dy) * tex->stride + (area.x - dx);
+    q->stride = tex->stride;
+    q->dst = area;
+    q->z = sprite->z;
+    q->alpha = sprite->alpha;
+    queue->count++;
+
+    // Bin sizes are known before rendering, so binning is a single scatter
+    const int b1 = (area.y + area.h - 1) / BAND_ROWS;
+    for(int b = area.y / BAND_ROWS; b <= b1; b++) {
+        queue->band_count[b]++;
+        queue->bin_entries++;
+    }
+    return ESP_OK;
+}
+
+static void reset_queue(esp_bsp_sdl_blit_queue_handle_t queue)
+{
+    queue->count = 0;
+    queue->bin_entries = 0;
+    memset(queue->band_count, 0, queue->bands * sizeof(uint32_t));
+}
+
+void esp_bsp_sdl_blit_queue_clear(esp_bsp_sdl_blit_queue_handle_t queue)
+{
+    if(queue) {
+        reset_queue(queue);
+    }
+}
+
+static uint8_t key_byte(const queued_sprite_t *s, int byte)
+{
+    if(byte < (int) sizeof(uintptr_t)) {
+        return (uint8_t) ((uintptr_t) s->texture >> (byte * 8));
+    }
+    // Flipping the sign bit orders negative z first
+    const uint32_t z = (uint32_t) s->z ^ 0x80000000u;
+    return (uint8_t) (z >> ((byte - (int) sizeof(uintptr_t)) * 8));
+}
+
+// Stable LSD radix sort of the sprite indices by (z, texture), so submission order breaks ties. Bytes that are
+// the same for every sprite (high address bytes, the upper bytes of small z values) are skipped.
+static void sort_sprites(esp_bsp_sdl_blit_queue_handle_t queue)
+{
+    const size_t n = queue->count;
+    uint32_t *order = queue->order;
+    uint32_t *tmp = queue->order_tmp;
+    uintptr_t texture_and = UINTPTR_MAX;
+    uintptr_t texture_or = 0;
+    uint32_t z_and = UINT32_MAX;
+    uint32_t z_or = 0;
+    for(size_t i = 0; i < n; i++) {
+        order[i] = i;
+        texture_and &= (uintptr_t) queue->sprites[i].texture;
+        texture_or |= (uintptr_t) queue->sprites[i].texture;
+        z_and &= (uint32_t) queue->sprites[i].z;
+        z_or |= (uint32_t) queue->sprites[i].z;
+    }
+
+    for(int byte = 0; byte < (int) KEY_BYTES; byte++) {
+        const int shift = (byte % sizeof(uintptr_t)) * 8;
+        const bool constant = byte < (int) sizeof(uintptr_t)
+                                  ? ((texture_and ^ texture_or) >> shift & 0xFF) == 0
+                                  : ((z_and ^ z_or) >> ((byte - (int) sizeof(uintptr_t)) * 8) & 0xFF) == 0;
+        if(constant) {
+            continue;
+        }
+        memset(queue->digit, 0, sizeof(queue->digit));
+        for(size_t i = 0; i < n; i++) {
+            queue->digit[key_byte(&queue->sprites[i], byte)]++;
+        }
+        uint32_t pos = 0;
+        for(int d = 0; d < 256; d++) {
+            const uint32_t c = queue->digit[d];
+            queue->digit[d] = pos;
+            pos += c;
+        }
+        for(size_t i = 0; i < n; i++) {
+            tmp[queue->digit[key_byte(&queue->sprites[order[i]], byte)]++] = order[i];
+        }
+        uint32_t *swap = order;
+        order = tmp;
+        tmp = swap;
+    }
+
+    for(size_t i = 0; i < n; i++) {
+        queue->sorted[i] = queue->sprites[order[i]];
+    }
+}
+
+// Sort once, then scatter every sprite into the bands it covers; each band keeps the sorted order
+static esp_err_t sort_and_bin(esp_bsp_sdl_blit_queue_handle_t queue)
+{
+    if(queue->bin_entries > queue->config.max_bin_entries) {
+        ESP_LOGE(TAG,
+                 "Out of bin entries, %u needed for %u sprites",
+                 (unsigned) queue->bin_entries,
+                 (unsigned) queue->count);
+        return ESP_ERR_NO_MEM;
+    }
+    if(queue->count == 0) {
+        memset(queue->band_start, 0, (queue->bands + 1) * sizeof(uint32_t));
+        return ESP_OK;
+    }
+    sort_sprites(queue);
+
+    // band_start[b + 1] is the fill position of band b while scattering and its end afterwards
+    queue->band_start[0] = 0;
+    queue->band_start[1] = 0;
+    for(int b = 1; b < queue->bands; b++) {
+        queue->band_start[b + 1] = queue->band_start[b] + queue->band_count[b - 1];
+    }
+    for(size_t i = 0; i < queue->count; i++) {
+        const esp_bsp_sdl_rect_t *dst = &queue->sorted[i].dst;
+        const int b1 = (dst->y + dst->h - 1) / BAND_ROWS;
+        for(int b = dst->y / BAND_ROWS; b <= b1; b++) {
+            queue->entries[queue->band_start[b + 1]++] = i;
+        }
+    }
+    return ESP_OK;
+}
+
+// Draw the sprites of one band; rows points at display row y of a buffer with the given stride
+static void draw_band(esp_bsp_sdl_blit_queue_handle_t queue, int band, uint16_t *rows, int stride, int y, int height)
+{
+    const esp_bsp_sdl_blend_kernels_t *blend = esp_bsp_sdl_blend_get_kernels(ESP_BSP_SDL_BLEND_IMPL_AUTO);
+    const uint32_t *entry = queue->entries + queue->band_start[band];
+    const uint32_t *end = queue->entries + queue->band_start[band + 1];
+    if(entry == end) {
+        return;
+    }
+
+    const uint16_t *last_texture = queue->sorted[*entry].texture;
+    uint32_t switches = 0;
+    uint32_t sprites = 0;
+    for(; entry < end; entry++) {
+        const queued_sprite_t *s = &queue->sorted[*entry];
+        // Binned sprites cover the band, only the rows need clipping
+        const int top = s->dst.y > y ? s->dst.y : y;
+        const int bottom = s->dst.y + s->dst.h < y + height ? s->dst.y + s->dst.h : y + height;
+        const uint16_t *src = s->pixels + (size_t) (top - s->dst.y) * s->stride;
+        uint16_t *dst = rows + (size_t) (top - y) * stride + s->dst.x;
+        const size_t bytes = s->dst.w * sizeof(uint16_t);
+        if(s->alpha == 255) {
+            for(int row = top; row < bottom; row++) {
+                memcpy(dst, src, bytes);
+                dst += stride;
+                src += s->stride;
+            }
+        } else {
+            for(int row = top; row < bottom; row++) {
+                blend->rgb565_const_over(dst, src, s->alpha, s->dst.w);
+                dst += stride;
+                src += s->stride;
+            }
+        }
+
+        switches += s->texture != last_texture;
+        last_texture = s->texture;
+        // A sprite is counted in its first band only
+        sprites += top == s->dst.y;
+    }
+    queue->stats.texture_switches += switches;
+    queue->stats.sprites += sprites;
+    queue->stats.bands++;
+}
+
+static void begin_stats(esp_bsp_sdl_blit_queue_handle_t queue)
+{
+    memset(&queue->stats, 0, sizeof(queue->stats));
+}
+
+esp_err_t esp_bsp_sdl_blit_queue_render(esp_bsp_sdl_blit_queue_handle_t queue, esp_bsp_sdl_surface_t *target)
+{
+    if(!queue || !target || !target->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(target->width < queue->config.width || target->height < queue->config.height) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    begin_stats(queue);
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = sort_and_bin(queue);
+    if(ret == ESP_OK) {
+        for(int b = 0; b < queue->bands; b++) {
+            const int y = b * BAND_ROWS;
+            const int rows = (queue->config.height - y) < BAND_ROWS ? (queue->config.height - y) : BAND_ROWS;
+            draw_band(queue, b, target->pixels + (size_t) y * target->stride, target->stride, y, rows);
+        }
+    }
+    queue->stats.render_time_us = esp_timer_get_time() - start;
+    reset_queue(queue);
+    return ret;
+}
+
+static esp_err_t render_flush_band(esp_bsp_sdl_surface_t *band, int y, void *user_ctx)
+{
+    esp_bsp_sdl_blit_queue_handle_t queue = user_ctx;
+    int64_t start = esp_timer_get_time();
+
+    if(queue->background) {
+        const esp_bsp_sdl_surface_t *bg = queue->background;
+        for(int row = 0; row < band->height; row++) {
+            memcpy(band->pixels + (size_t) row * band->stride,
+                   bg->pixels + (size_t) (y + row) * bg->stride,
+                   band->width * sizeof(uint16_t));
+        }
+    } else {
+        for(int col = 0; col < band->width; col++) {
+            band->pixels[col] = queue->clear_color;
+        }
+        for(int row = 1; row < band->height; row++) {
+            memcpy(band->pixels + (size_t) row * band->stride, band->pixels, band->width * sizeof(uint16_t));
+        }
+    }
+
+    draw_band(queue, y / BAND_ROWS, band->pixels, band->stride, y, band->height);
+    queue->stats.render_time_us += esp_timer_get_time() - start;
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_blit_queue_flush(esp_bsp_sdl_blit_queue_handle_t queue,
+                                       const esp_bsp_sdl_surface_t *background,
+                                       uint16_t clear_color)
+{
+    if(!queue || (background && !background->pixels)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int width;
+    int height;
+    esp_bsp_sdl_priv_get_logical_size(&width, &height);
+    if(width != queue->config.width || height != queue->config.height) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if(background && (background->width < width || background->height < height)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    begin_stats(queue);
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = sort_and_bin(queue);
+    queue->stats.render_time_us = esp_timer_get_time() - start;
+    if(ret == ESP_OK) {
+        queue->background = background;
+        queue->clear_color = clear_color;
+        ret = esp_bsp_sdl_flush_bands(render_flush_band, queue);
+        queue->background = NULL;
+    }
+    reset_queue(queue);
+    return ret;
+}
+
+esp_err_t esp_bsp_sdl_blit_queue_get_stats(esp_bsp_sdl_blit_queue_handle_t queue,
+                                           esp_bsp_sdl_blit_queue_stats_t *stats)
+{
+    if(!queue || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = queue->stats;
+    return ESP_OK;
+}
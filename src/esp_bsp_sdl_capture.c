@@ -0,0 +1,371 @@
+/**
+ * @file esp_bsp_sdl_capture.c
+ * @brief Frame capture of presented frames
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl_capture.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define CHUNK_ROWS ESP_BSP_SDL_FLUSH_BAND_ROWS
+#define RUN_MAX 0xFFFF
+#define INDEX_GROW 64
+
+static const char *TAG = "esp_bsp_sdl_capture";
+
+static FILE *s_out = NULL;
+static esp_bsp_sdl_capture_config_t s_config;
+static esp_bsp_sdl_capture_summary_t s_summary;
+static bool s_failed = false;
+static uint64_t s_offset = 0;
+static esp_bsp_sdl_capture_index_entry_t *s_index = NULL;
+static size_t s_index_count = 0;
+static size_t s_index_capacity = 0;
+static uint16_t *s_prev = NULL;   // Delta mode: previous captured frame
+static bool s_prev_valid = false;
+static uint16_t *s_encode = NULL; // Delta mode: payload of one chunk
+static int s_width = 0;           // Size s_prev and s_encode are allocated for
+static int s_height = 0;
+static bool s_in_frame = false;
+static bool s_key = false;
+static size_t s_frame_bytes = 0; // Pixel bytes of the frame being captured
+static uint32_t s_surface_seq = 0;
+static esp_bsp_sdl_flush_stats_t s_surface_stats; // Flush counters at the previous surface capture
+
+static bool write_bytes(const void *data, size_t size)
+{
+    if(s_failed) {
+        return false;
+    }
+    if(fwrite(data, 1, size, s_out) != size) {
+        ESP_LOGE(TAG, "Write failed after %llu bytes, capture stopped", (unsigned long long) s_offset);
+        s_summary.write_errors++;
+        s_failed = true;
+        return false;
+    }
+    s_offset += size;
+    s_summary.written_bytes += size;
+    return true;
+}
+
+static void free_buffers(void)
+{
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_TOOLS, s_prev);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_TOOLS, s_encode);
+    s_prev = NULL;
+    s_encode = NULL;
+    s_prev_valid = false;
+    s_width = 0;
+    s_height = 0;
+}
+
+// Delta mode buffers for the current frame size, key frames only if they cannot be allocated
+static void alloc_buffers(int width, int height)
+{
+    if(width == s_width && height == s_height) {
+        return;
+    }
+    free_buffers();
+
+    const size_t frame_size = (size_t) width * height * sizeof(uint16_t);
+    s_prev = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_TOOLS, frame_size, MALLOC_CAP_SPIRAM);
+    if(!s_prev) {
+        s_prev = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_TOOLS, frame_size, MALLOC_CAP_DEFAULT);
+    }
+    s_encode = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_TOOLS,
+                                      (size_t) width * CHUNK_ROWS * sizeof(uint16_t),
+                                      MALLOC_CAP_DEFAULT);
+    if(!s_prev || !s_encode) {
+        ESP_LOGW(TAG, "No memory for delta encoding at %dx%d, writing key frames", width, height);
+        free_buffers();
+        return;
+    }
+    s_width = width;
+    s_height = height;
+}
+
+// (skip, copy) runs of src against ref, 0 if the runs would not be smaller than the raw pixels
+static size_t encode_delta(const uint16_t *src, int stride, const uint16_t *ref, int width, int rows, bool *changed)
+{
+    const size_t limit = (size_t) width * rows;
+    uint16_t *out = s_encode;
+    uint16_t *pair = NULL;
+    size_t used = 0;
+
+    *changed = false;
+    for(int y = 0; y < rows; y++) {
+        const uint16_t *s = src + y * stride;
+        const uint16_t *r = ref + y * width;
+        for(int x = 0; x < width; x++) {
+            const bool same = s[x] == r[x];
+            if(!pair || (same ? (pair[1] || pair[0] == RUN_MAX) : pair[1] == RUN_MAX)) {
+                if(used + 2 > limit) {
+                    return 0;
+                }
+                pair = out + used;
+                pair[0] = 0;
+                pair[1] = 0;
+                used += 2;
+            }
+            if(same) {
+                pair[0]++;
+                continue;
+            }
+            if(used + 1 > limit) {
+                return 0;
+            }
+            pair[1]++;
+            out[used++] = s[x];
+            *changed = true;
+        }
+    }
+    return used * sizeof(uint16_t);
+}
+
+static bool write_chunk(esp_bsp_sdl_capture_chunk_type_t type, int first_row, int rows, size_t size)
+{
+    const esp_bsp_sdl_capture_chunk_t chunk = {
+        .type = type,
+        .first_row = first_row,
+        .rows = rows,
+        .size = size,
+    };
+    return write_bytes(&chunk, sizeof(chunk));
+}
+
+esp_err_t esp_bsp_sdl_capture_start(const esp_bsp_sdl_capture_config_t *config)
+{
+    if(!config || !config->out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(s_out) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_config = *config;
+    if(s_config.every_nth == 0) {
+        s_config.every_nth = 1;
+    }
+    memset(&s_summary, 0, sizeof(s_summary));
+    s_out = config->out;
+    s_failed = false;
+    s_offset = 0;
+    s_index_count = 0;
+    s_in_frame = false;
+    s_prev_valid = false;
+    s_surface_seq = 0;
+    esp_bsp_sdl_get_flush_stats(&s_surface_stats);
+
+    const esp_bsp_sdl_capture_file_header_t header = {
+        .magic = {'S', 'D', 'L', 'C'},
+        .version = ESP_BSP_SDL_CAPTURE_VERSION,
+        .flags = config->delta ? ESP_BSP_SDL_CAPTURE_FLAG_DELTA : 0,
+        .every_nth = s_config.every_nth,
+        .start_us = esp_timer_get_time(),
+    };
+    if(!write_bytes(&header, sizeof(header))) {
+        s_out = NULL;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG,
+             "Capture started (every %" PRIu32 " frame(s), %s)",
+             s_config.every_nth,
+             config->delta ? "delta" : "raw");
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_capture_stop(void)
+{
+    if(!s_out) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const esp_bsp_sdl_capture_trailer_t trailer = {
+        .magic = {'S', 'D', 'L', 'X'},
+        .count = s_index_count,
+        .index_offset = s_offset,
+    };
+    if(s_index_count) {
+        write_bytes(s_index, s_index_count * sizeof(*s_index));
+    }
+    write_bytes(&trailer, sizeof(trailer));
+    fflush(s_out);
+
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_TOOLS, s_index);
+    s_index = NULL;
+    s_index_capacity = 0;
+    free_buffers();
+    s_out = NULL;
+
+    ESP_LOGI(TAG,
+             "Capture stopped: %" PRIu32 " of %" PRIu32 " frames, %llu bytes (raw %llu)",
+             s_summary.frames_written,
+             s_summary.frames_seen,
+             (unsigned long long) s_summary.written_bytes,
+             (unsigned long long) s_summary.raw_bytes);
+    return s_failed ? ESP_FAIL : ESP_OK;
+}
+
+bool esp_bsp_sdl_capture_is_active(void)
+{
+    return s_out != NULL;
+}
+
+void esp_bsp_sdl_capture_get_summary(esp_bsp_sdl_capture_summary_t *summary)
+{
+    if(summary) {
+        *summary = s_summary;
+    }
+}
+
+static bool begin_frame(uint32_t seq, int64_t timestamp_us, int width, int height)
+{
+    if(!s_out || s_failed) {
+        return false;
+    }
+    if(s_summary.frames_seen++ % s_config.every_nth) {
+        return false;
+    }
+    const int64_t start = esp_timer_get_time();
+
+    if(s_index_count == s_index_capacity) {
+        const size_t index_size = (s_index_capacity + INDEX_GROW) * sizeof(*s_index);
+        esp_bsp_sdl_capture_index_entry_t *index =
+            esp_bsp_sdl_mem_realloc(ESP_BSP_SDL_MEM_TOOLS, s_index, index_size, MALLOC_CAP_DEFAULT);
+        if(!index) {
+            ESP_LOGW(TAG, "No memory for the frame index, frame %" PRIu32 " not captured", seq);
+            return false;
+        }
+        s_index = index;
+        s_index_capacity += INDEX_GROW;
+    }
+
+    if(s_config.delta) {
+        alloc_buffers(width, height);
+    }
+    s_key = !s_prev || !s_prev_valid ||
+            (s_config.key_interval && s_summary.frames_written % s_config.key_interval == 0);
+
+    const uint32_t flags = s_key ? ESP_BSP_SDL_CAPTURE_FLAG_KEY : 0;
+    s_index[s_index_count++] = (esp_bsp_sdl_capture_index_entry_t) {
+        .seq = seq,
+        .flags = flags,
+        .timestamp_us = timestamp_us,
+        .offset = s_offset,
+    };
+    const esp_bsp_sdl_capture_frame_header_t header = {
+        .magic = {'F', 'R', 'M', 'E'},
+        .seq = seq,
+        .timestamp_us = timestamp_us,
+        .width = width,
+        .height = height,
+        .flags = flags,
+    };
+    s_frame_bytes = (size_t) width * height * sizeof(uint16_t);
+    s_in_frame = write_bytes(&header, sizeof(header));
+    // A frame cut short leaves the reference undefined, start over with a key frame
+    s_prev_valid = false;
+
+    s_summary.capture_time_us += esp_timer_get_time() - start;
+    return s_in_frame;
+}
+
+bool esp_bsp_sdl_capture_begin_frame(uint32_t seq, int64_t timestamp_us, int width, int height)
+{
+    return !s_config.manual && begin_frame(seq, timestamp_us, width, height);
+}
+
+uint32_t esp_bsp_sdl_capture_add_rows(const uint16_t *pixels, int stride, int width, int first_row, int rows)
+{
+    if(!s_in_frame) {
+        return 0;
+    }
+    const int64_t start = esp_timer_get_time();
+
+    for(int y0 = 0; y0 < rows && !s_failed; y0 += CHUNK_ROWS) {
+        const int n = (rows - y0) < CHUNK_ROWS ? (rows - y0) : CHUNK_ROWS;
+        const uint16_t *src = pixels + y0 * stride;
+        uint16_t *ref = s_prev ? s_prev + (size_t) (first_row + y0) * width : NULL;
+
+        size_t delta_size = 0;
+        bool changed = true;
+        if(!s_key) {
+            delta_size = encode_delta(src, stride, ref, width, n, &changed);
+        }
+        if(!changed) {
+            // Rows without a chunk are unchanged
+            continue;
+        }
+        if(delta_size) {
+            write_chunk(ESP_BSP_SDL_CAPTURE_CHUNK_DELTA, first_row + y0, n, delta_size);
+            write_bytes(s_encode, delta_size);
+        } else {
+            write_chunk(ESP_BSP_SDL_CAPTURE_CHUNK_RAW, first_row + y0, n, (size_t) width * n * sizeof(uint16_t));
+            if(stride == width) {
+                write_bytes(src, (size_t) width * n * sizeof(uint16_t));
+            } else {
+                for(int y = 0; y < n; y++) {
+                    write_bytes(src + y * stride, width * sizeof(uint16_t));
+                }
+            }
+        }
+        if(ref) {
+            for(int y = 0; y < n; y++) {
+                memcpy(ref + y * width, src + y * stride, width * sizeof(uint16_t));
+            }
+        }
+    }
+
+    const uint32_t spent = esp_timer_get_time() - start;
+    s_summary.capture_time_us += spent;
+    return spent;
+}
+
+void esp_bsp_sdl_capture_end_frame(const esp_bsp_sdl_flush_stats_t *before, const esp_bsp_sdl_flush_stats_t *after)
+{
+    if(!s_in_frame) {
+        return;
+    }
+    const int64_t start = esp_timer_get_time();
+    s_in_frame = false;
+
+    const esp_bsp_sdl_capture_frame_stats_t frame_stats = {
+        .flush_time_us = after->flush_time_us - before->flush_time_us,
+        .draws = after->draws - before->draws,
+        .tiles_dirty = after->tiles_dirty - before->tiles_dirty,
+        .pixel_bytes = after->pixel_bytes - before->pixel_bytes,
+    };
+    write_chunk(ESP_BSP_SDL_CAPTURE_CHUNK_END, 0, 0, sizeof(frame_stats));
+    if(write_bytes(&frame_stats, sizeof(frame_stats))) {
+        s_prev_valid = s_prev != NULL;
+        s_summary.frames_written++;
+        s_summary.key_frames += s_key;
+        s_summary.raw_bytes += s_frame_bytes;
+    }
+    s_summary.capture_time_us += esp_timer_get_time() - start;
+}
+
+esp_err_t esp_bsp_sdl_capture_surface(const esp_bsp_sdl_surface_t *frame)
+{
+    if(!frame || !frame->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(!s_out) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if(begin_frame(s_surface_seq++, esp_timer_get_time(), frame->width, frame->height)) {
+        esp_bsp_sdl_flush_stats_t stats;
+        esp_bsp_sdl_get_flush_stats(&stats);
+        esp_bsp_sdl_capture_add_rows(frame->pixels, frame->stride, frame->width, 0, frame->height);
+        esp_bsp_sdl_capture_end_frame(&s_surface_stats, &stats);
+        s_surface_stats = stats;
+    }
+    return s_failed ? ESP_FAIL : ESP_OK;
+}
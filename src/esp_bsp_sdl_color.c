@@ -0,0 +1,94 @@
+/**
+ * @file esp_bsp_sdl_color.c
+ * @brief Table-driven color correction for RGB888 to RGB565 conversion
+ */
+
+#include <math.h>
+#include "esp_bsp_sdl_color.h"
+
+#define MATRIX_FRAC_BITS 6
+#define MATRIX_LIMIT 2.0f
+
+const esp_bsp_sdl_color_profile_t esp_bsp_sdl_color_profile_identity = {
+    .matrix = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+    .gamma = {1.0f, 1.0f, 1.0f},
+};
+
+esp_err_t esp_bsp_sdl_color_lut_build(const esp_bsp_sdl_color_profile_t *profile, esp_bsp_sdl_color_lut_t *lut)
+{
+    if(!lut) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(!profile) {
+        profile = &esp_bsp_sdl_color_profile_identity;
+    }
+
+    lut->identity_matrix = true;
+    for(int c = 0; c < 3; c++) {
+        if(profile->gamma[c] <= 0.0f) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        for(int k = 0; k < 3; k++) {
+            const float m = profile->matrix[c][k];
+            if(m < -MATRIX_LIMIT || m > MATRIX_LIMIT) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            if(m != (c == k ? 1.0f : 0.0f)) {
+                lut->identity_matrix = false;
+            }
+            for(int v = 0; v < 256; v++) {
+                lut->matrix[c][k][v] = (int16_t) lroundf(m * v * (1 << MATRIX_FRAC_BITS));
+            }
+        }
+    }
+
+    // Output tables: gamma, quantize to 5/6/5 bits and place into the RGB565 word
+    static const int bits[3] = {5, 6, 5};
+    static const int shift[3] = {11, 5, 0};
+    for(int c = 0; c < 3; c++) {
+        const int max = (1 << bits[c]) - 1;
+        for(int v = 0; v < 256; v++) {
+            const float corrected = powf(v / 255.0f, profile->gamma[c]);
+            lut->out[c][v] = (uint16_t) (lroundf(corrected * max) << shift[c]);
+        }
+    }
+
+    return ESP_OK;
+}
+
+static inline uint8_t clamp_u8(int32_t v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : (uint8_t) v);
+}
+
+void esp_bsp_sdl_color_convert_rgb888_to_rgb565(const esp_bsp_sdl_color_lut_t *lut,
+                                                const uint8_t *src,
+                                                uint16_t *dst,
+                                                size_t pixels,
+                                                bool swap_bytes)
+{
+    const uint16_t *out_r = lut->out[0];
+    const uint16_t *out_g = lut->out[1];
+    const uint16_t *out_b = lut->out[2];
+
+    if(lut->identity_matrix) {
+        for(size_t i = 0; i < pixels; i++, src += 3) {
+            uint16_t px = out_r[src[0]] | out_g[src[1]] | out_b[src[2]];
+            dst[i] = swap_bytes ? (uint16_t) ((px >> 8) | (px << 8)) : px;
+        }
+        return;
+    }
+
+    const int round = 1 << (MATRIX_FRAC_BITS - 1);
+    for(size_t i = 0; i < pixels; i++, src += 3) {
+        const uint8_t r = src[0];
+        const uint8_t g = src[1];
+        const uint8_t b = src[2];
+        const int32_t rr = lut->matrix[0][0][r] + lut->matrix[0][1][g] + lut->matrix[0][2][b] + round;
+        const int32_t gg = lut->matrix[1][0][r] + lut->matrix[1][1][g] + lut->matrix[1][2][b] + round;
+        const int32_t bb = lut->matrix[2][0][r] + lut->matrix[2][1][g] + lut->matrix[2][2][b] + round;
+        uint16_t px = out_r[clamp_u8(rr >> MATRIX_FRAC_BITS)] | out_g[clamp_u8(gg >> MATRIX_FRAC_BITS)] |
+                      out_b[clamp_u8(bb >> MATRIX_FRAC_BITS)];
+        dst[i] = swap_bytes ? (uint16_t) ((px >> 8) | (px << 8)) : px;
+    }
+}
@@ -3,7 +3,11 @@
  * @brief Runtime board selection for ESP-BSP SDL abstraction layer
  */
 
+#include <string.h>
 #include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_cache.h"
+#include "esp_lcd_panel_commands.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
 
@@ -30,8 +34,59 @@ extern const esp_bsp_sdl_board_interface_t esp_bsp_sdl_esp32_s3_lcd_ev_board_int
 #ifdef CONFIG_SDL_BSP_M5STACK_TAB5
 extern const esp_bsp_sdl_board_interface_t esp_bsp_sdl_m5stack_tab5_interface;
 #endif
+#ifdef CONFIG_SDL_BSP_GENERIC_PANEL
+extern const esp_bsp_sdl_board_interface_t esp_bsp_sdl_generic_interface;
+#endif
+#ifdef CONFIG_SDL_BSP_DEVKIT
+extern const esp_bsp_sdl_board_interface_t esp_bsp_sdl_devkit_interface;
+#endif
+#ifdef CONFIG_SDL_BSP_VIRTUAL
+extern const esp_bsp_sdl_board_interface_t esp_bsp_sdl_virtual_interface;
+#endif
 
 static const esp_bsp_sdl_board_interface_t *s_current_board = NULL;
+static esp_lcd_panel_handle_t s_panel_handle = NULL;
+static esp_lcd_panel_io_handle_t s_panel_io_handle = NULL;
+static int s_native_width = 0;
+static int s_native_height = 0;
+static esp_bsp_sdl_orientation_t s_orientation = ESP_BSP_SDL_ORIENTATION_0;
+static bool s_sw_rotation = false;
+static esp_bsp_sdl_dbi_info_t s_dbi; // Board MIPI-DBI description in the current orientation
+static esp_bsp_sdl_window_t s_window;
+static esp_bsp_sdl_flush_stats_t s_flush_stats;
+
+// Current display size in logical (oriented) coordinates
+static void get_logical_size(int *width, int *height)
+{
+    const bool swap = esp_bsp_sdl_orientation_swaps_axes(s_orientation);
+    *width = swap ? s_native_height : s_native_width;
+    *height = swap ? s_native_width : s_native_height;
+}
+
+const esp_bsp_sdl_board_interface_t *esp_bsp_sdl_priv_get_board(void)
+{
+    return s_current_board;
+}
+
+const esp_bsp_sdl_dbi_info_t *esp_bsp_sdl_priv_get_dbi(void)
+{
+    return s_current_board && s_current_board->dbi ? &s_dbi : NULL;
+}
+
+esp_lcd_panel_io_handle_t esp_bsp_sdl_priv_get_io(void)
+{
+    return s_panel_io_handle;
+}
+
+void esp_bsp_sdl_priv_get_logical_size(int *width, int *height)
+{
+    get_logical_size(width, height);
+}
+
+esp_bsp_sdl_flush_stats_t *esp_bsp_sdl_priv_get_stats(void)
+{
+    return &s_flush_stats;
+}
 
 // Runtime board detection based on Kconfig
 static const esp_bsp_sdl_board_interface_t *detect_board(void)
@@ -54,6 +109,15 @@ static const esp_bsp_sdl_board_interface_t *detect_board(void)
 #elif CONFIG_SDL_BSP_M5STACK_TAB5
     ESP_LOGI(TAG, "Detected board: M5Stack Tab5");
     return &esp_bsp_sdl_m5stack_tab5_interface;
+#elif CONFIG_SDL_BSP_GENERIC_PANEL
+    ESP_LOGI(TAG, "Detected board: %s", esp_bsp_sdl_generic_interface.board_name);
+    return &esp_bsp_sdl_generic_interface;
+#elif CONFIG_SDL_BSP_DEVKIT
+    ESP_LOGI(TAG, "Detected board: DevKit (offscreen)");
+    return &esp_bsp_sdl_devkit_interface;
+#elif CONFIG_SDL_BSP_VIRTUAL
+    ESP_LOGI(TAG, "Detected board: Virtual panel");
+    return &esp_bsp_sdl_virtual_interface;
 #else
     ESP_LOGE(TAG, "No board configuration detected!");
     return NULL;
@@ -75,7 +139,265 @@ esp_err_t esp_bsp_sdl_init(esp_bsp_sdl_display_config_t *config,
 
     ESP_LOGI(TAG, "Selected board: %s", s_current_board->board_name);
 
-    return s_current_board->init(config, panel_handle, panel_io_handle);
+    esp_bsp_sdl_mem_mark_t mark;
+    esp_bsp_sdl_mem_measure_begin(&mark);
+    esp_err_t ret = s_current_board->init(config, panel_handle, panel_io_handle);
+    if(ret != ESP_OK) {
+        return ret;
+    }
+    esp_bsp_sdl_mem_measure_end(ESP_BSP_SDL_MEM_PANEL, &mark);
+    config->placement = esp_bsp_sdl_get_placement();
+    ESP_LOGI(TAG,
+             "Display init done, max_transfer_sz %u, %s placement",
+             (unsigned) config->max_transfer_sz,
+             config->placement == ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE ? "PSRAM with internal bounce" : "internal");
+    esp_bsp_sdl_mem_log();
+
+    // Remember the native geometry, orientation changes are applied relative to it
+    s_panel_handle = *panel_handle;
+    s_panel_io_handle = *panel_io_handle;
+    s_native_width = config->width;
+    s_native_height = config->height;
+    s_orientation = ESP_BSP_SDL_ORIENTATION_0;
+    s_sw_rotation = false;
+    if(s_current_board->dbi) {
+        esp_bsp_sdl_dbi_orient(s_current_board->dbi, s_native_width, s_native_height, s_orientation, &s_dbi);
+    }
+    s_window.valid = false;
+
+#ifdef CONFIG_SDL_BSP_PANEL_GAMMA
+    if(s_current_board->panel_gamma) {
+        ret = esp_bsp_sdl_load_panel_gamma(NULL);
+        if(ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to load panel gamma: %s", esp_err_to_name(ret));
+        }
+    }
+#endif
+
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_invalidate_window(void)
+{
+    s_window.valid = false;
+}
+
+esp_err_t esp_bsp_sdl_get_flush_stats(esp_bsp_sdl_flush_stats_t *stats)
+{
+    if(!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = s_flush_stats;
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_reset_flush_stats(void)
+{
+    memset(&s_flush_stats, 0, sizeof(s_flush_stats));
+}
+
+esp_err_t esp_bsp_sdl_load_panel_gamma(const esp_bsp_sdl_panel_gamma_t *gamma)
+{
+    if(!s_current_board || !s_panel_io_handle) {
+        ESP_LOGE(TAG, "Board not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if(!s_current_board->panel_gamma) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if(!gamma) {
+        gamma = s_current_board->panel_gamma;
+    }
+    if(gamma->length == 0 || gamma->length > sizeof(gamma->positive)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = esp_lcd_panel_io_tx_param(s_panel_io_handle, LCD_CMD_PGAMCTRL, gamma->positive, gamma->length);
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_io_tx_param(s_panel_io_handle, LCD_CMD_NGAMCTRL, gamma->negative, gamma->length);
+    }
+    return ret;
+}
+
+esp_err_t esp_bsp_sdl_set_orientation(esp_bsp_sdl_orientation_t orientation, esp_bsp_sdl_display_config_t *config)
+{
+    if(orientation < ESP_BSP_SDL_ORIENTATION_0 || orientation > ESP_BSP_SDL_ORIENTATION_270) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(!s_current_board) {
+        ESP_LOGE(TAG, "Board not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Controller scrolling follows the scan direction, which the new orientation may reverse
+    esp_bsp_sdl_scroll_deinit();
+
+    bool sw_rotation = false;
+    if(s_current_board->set_orientation) {
+        // Controller-side rotation (MADCTL) or panel driver rotation, no per-frame cost
+        esp_err_t ret = s_current_board->set_orientation(orientation);
+        if(ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set panel orientation: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        if(s_current_board->dbi) {
+            // esp_lcd does not move the gaps with MADCTL, a visible area off the RAM centre needs others
+            esp_bsp_sdl_dbi_orient(s_current_board->dbi, s_native_width, s_native_height, orientation, &s_dbi);
+            if(s_dbi.ram_width > 0) {
+                ret = esp_lcd_panel_set_gap(s_panel_handle, s_dbi.x_gap, s_dbi.y_gap);
+                if(ret != ESP_OK) {
+                    ESP_LOGE(TAG, "Failed to set panel gap: %s", esp_err_to_name(ret));
+                    return ret;
+                }
+            }
+        }
+    } else if(s_current_board->get_frame_buffer) {
+        // DPI panels scan out a frame buffer, rotate while blitting into it
+        sw_rotation = orientation != ESP_BSP_SDL_ORIENTATION_0;
+    } else if(orientation != ESP_BSP_SDL_ORIENTATION_0) {
+        ESP_LOGW(TAG, "Orientation change not supported on %s", s_current_board->board_name);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    s_orientation = orientation;
+    s_sw_rotation = sw_rotation;
+    s_window.valid = false;
+
+    if(config) {
+        get_logical_size(&config->width, &config->height);
+    }
+
+    ESP_LOGI(TAG,
+             "Orientation set to %d degrees (%s rotation)",
+             (int) orientation * 90,
+             s_sw_rotation ? "software" : "panel");
+    return ESP_OK;
+}
+
+esp_bsp_sdl_orientation_t esp_bsp_sdl_get_orientation(void)
+{
+    return s_orientation;
+}
+
+// MIPI-DBI draw of logical rows at controller rows, through the address window cache when enabled
+static esp_err_t draw_dbi(int height, int x_start, int y_start, int x_end, int y_end, const void *color_data)
+{
+#ifdef CONFIG_SDL_BSP_WINDOW_CACHE
+    if(s_panel_io_handle) {
+        return esp_bsp_sdl_window_draw(s_panel_io_handle,
+                                       &s_dbi,
+                                       &s_window,
+                                       &s_flush_stats,
+                                       height,
+                                       x_start,
+                                       y_start,
+                                       x_end,
+                                       y_end,
+                                       color_data);
+    }
+#endif
+    return esp_lcd_panel_draw_bitmap(s_panel_handle, x_start, y_start, x_end, y_end, color_data);
+}
+
+esp_err_t esp_bsp_sdl_draw_bitmap(int x_start, int y_start, int x_end, int y_end, const void *color_data)
+{
+    int transfers;
+    esp_err_t ret = esp_bsp_sdl_priv_draw_bitmap(x_start, y_start, x_end, y_end, color_data, &transfers);
+    esp_bsp_sdl_flush_track(transfers);
+    return ret;
+}
+
+esp_err_t esp_bsp_sdl_priv_draw_bitmap(int x_start,
+                                       int y_start,
+                                       int x_end,
+                                       int y_end,
+                                       const void *color_data,
+                                       int *transfers)
+{
+    *transfers = 0;
+    if(!s_current_board || !s_panel_handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int width;
+    int height;
+    get_logical_size(&width, &height);
+    if(!color_data || x_start < 0 || y_start < 0 || x_end > width || y_end > height || x_start >= x_end ||
+       y_start >= y_end) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_flush_stats.draws++;
+    s_flush_stats.pixel_bytes += (uint64_t) (x_end - x_start) * (y_end - y_start) * sizeof(uint16_t);
+
+    if(!s_sw_rotation && s_current_board->dbi) {
+        // A scrolled controller shows the scroll area rotated, rows wrapping around are addressed separately
+        esp_bsp_sdl_row_span_t spans[ESP_BSP_SDL_SCROLL_MAX_SPANS];
+        const int count = esp_bsp_sdl_scroll_map_rows(y_start, y_end, spans);
+        const size_t row_bytes = (size_t) (x_end - x_start) * sizeof(uint16_t);
+        esp_err_t ret = ESP_OK;
+        for(int i = 0; i < count && ret == ESP_OK; i++) {
+            ret = draw_dbi(height,
+                           x_start,
+                           spans[i].panel_y,
+                           x_end,
+                           spans[i].panel_y + spans[i].y_end - spans[i].y_start,
+                           (const uint8_t *) color_data + (spans[i].y_start - y_start) * row_bytes);
+            if(ret == ESP_OK) {
+                (*transfers)++;
+            }
+        }
+        return ret;
+    }
+
+    if(!s_sw_rotation) {
+        esp_err_t ret = esp_lcd_panel_draw_bitmap(s_panel_handle, x_start, y_start, x_end, y_end, color_data);
+        *transfers = ret == ESP_OK ? 1 : 0;
+        return ret;
+    }
+
+    void *fb = NULL;
+    esp_err_t ret = s_current_board->get_frame_buffer(&fb);
+    if(ret != ESP_OK || !fb) {
+        return ret != ESP_OK ? ret : ESP_ERR_INVALID_STATE;
+    }
+
+    esp_bsp_sdl_rotate_blit_rgb565(fb,
+                                   s_native_width,
+                                   s_native_height,
+                                   s_orientation,
+                                   x_start,
+                                   y_start,
+                                   x_end,
+                                   y_end,
+                                   color_data);
+
+    // Write back the touched native rows so the DPI controller scans out the new pixels
+    int row_start;
+    int row_end;
+    switch(s_orientation) {
+        case ESP_BSP_SDL_ORIENTATION_90:
+            row_start = x_start;
+            row_end = x_end;
+            break;
+        case ESP_BSP_SDL_ORIENTATION_180:
+            row_start = s_native_height - y_end;
+            row_end = s_native_height - y_start;
+            break;
+        default:
+            row_start = s_native_height - x_end;
+            row_end = s_native_height - x_start;
+            break;
+    }
+    uint16_t *rows = (uint16_t *) fb + row_start * s_native_width;
+    esp_cache_msync(rows,
+                    (row_end - row_start) * s_native_width * sizeof(uint16_t),
+                    ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+
+    return ESP_OK;
 }
 
 esp_err_t esp_bsp_sdl_backlight_on(void)
@@ -111,7 +433,14 @@ esp_err_t esp_bsp_sdl_touch_init(void)
         ESP_LOGE(TAG, "Board not initialized");
         return ESP_ERR_INVALID_STATE;
     }
-    return s_current_board->touch_init();
+
+    esp_bsp_sdl_mem_mark_t mark;
+    esp_bsp_sdl_mem_measure_begin(&mark);
+    esp_err_t ret = s_current_board->touch_init();
+    if(ret == ESP_OK) {
+        esp_bsp_sdl_mem_measure_end(ESP_BSP_SDL_MEM_TOUCH, &mark);
+    }
+    return ret;
 }
 
 esp_err_t esp_bsp_sdl_touch_read(esp_bsp_sdl_touch_info_t *touch_info)
@@ -125,7 +454,31 @@ esp_err_t esp_bsp_sdl_touch_read(esp_bsp_sdl_touch_info_t *touch_info)
         return ESP_ERR_INVALID_STATE;
     }
 
-    return s_current_board->touch_read(touch_info);
+    esp_err_t ret = s_current_board->touch_read(touch_info);
+    if(ret != ESP_OK || !touch_info->pressed || s_orientation == ESP_BSP_SDL_ORIENTATION_0) {
+        return ret;
+    }
+
+    // Map native panel coordinates into the logical orientation
+    const int nx = touch_info->x;
+    const int ny = touch_info->y;
+    switch(s_orientation) {
+        case ESP_BSP_SDL_ORIENTATION_90:
+            touch_info->x = ny;
+            touch_info->y = s_native_width - 1 - nx;
+            break;
+        case ESP_BSP_SDL_ORIENTATION_180:
+            touch_info->x = s_native_width - 1 - nx;
+            touch_info->y = s_native_height - 1 - ny;
+            break;
+        case ESP_BSP_SDL_ORIENTATION_270:
+            touch_info->x = s_native_height - 1 - ny;
+            touch_info->y = nx;
+            break;
+        default:
+            break;
+    }
+    return ESP_OK;
 }
 
 const char *esp_bsp_sdl_get_board_name(void)
@@ -144,7 +497,19 @@ esp_err_t esp_bsp_sdl_deinit(void)
         return ESP_OK;
     }
 
+    // High-water marks of the session
+    esp_bsp_sdl_mem_log();
+    esp_bsp_sdl_scroll_deinit();
+    esp_bsp_sdl_flush_deinit();
+    esp_bsp_sdl_dma_deinit();
+
     esp_err_t ret = s_current_board->deinit();
+    esp_bsp_sdl_mem_release(ESP_BSP_SDL_MEM_PANEL);
+    esp_bsp_sdl_mem_release(ESP_BSP_SDL_MEM_TOUCH);
     s_current_board = NULL;
+    s_panel_handle = NULL;
+    s_panel_io_handle = NULL;
+    s_orientation = ESP_BSP_SDL_ORIENTATION_0;
+    s_sw_rotation = false;
     return ret;
 }
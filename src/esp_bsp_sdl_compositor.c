@@ -0,0 +1,388 @@
+/**
+ * @file esp_bsp_sdl_compositor.c
+ * @brief Layer compositor with per-layer dirty tracking and a cached composition of lower layers
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl_blend.h"
+#include "esp_bsp_sdl_compositor.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define TILE ESP_BSP_SDL_COMPOSITOR_TILE // A tile row fills one band buffer of the flush engine
+
+static const char *TAG = "esp_bsp_sdl_compositor";
+
+struct esp_bsp_sdl_compositor_t {
+    esp_bsp_sdl_compositor_config_t config;
+    int tiles_x;
+    int tiles_y;
+    uint8_t all_layers;  // Dirty bits of every layer
+    uint8_t cached_mask; // Dirty bits of the layers in the cache frame
+    esp_bsp_sdl_layer_t layers[ESP_BSP_SDL_COMPOSITOR_MAX_LAYERS];
+    uint8_t *dirty;            // Per tile, one bit per changed layer
+    uint16_t *cache;           // Bottom cached_layers composed, output size, NULL without cache
+    esp_bsp_sdl_rect_t *rects; // One area per tile row
+    esp_bsp_sdl_compositor_stats_t stats;
+};
+
+esp_err_t esp_bsp_sdl_compositor_create(const esp_bsp_sdl_compositor_config_t *config,
+                                        esp_bsp_sdl_compositor_handle_t *ret_compositor)
+{
+    if(!config || !ret_compositor || config->width <= 0 || config->height <= 0 || config->layers < 1 ||
+       config->layers > ESP_BSP_SDL_COMPOSITOR_MAX_LAYERS || config->cached_layers < 0 ||
+       config->cached_layers > config->layers) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_bsp_sdl_compositor_handle_t comp = esp_bsp_sdl_mem_calloc(ESP_BSP_SDL_MEM_RENDER, 1, sizeof(*comp), MALLOC_CAP_DEFAULT);
+    if(!comp) {
+        return ESP_ERR_NO_MEM;
+    }
+    comp->config = *config;
+    comp->tiles_x = (config->width + TILE - 1) / TILE;
+    comp->tiles_y = (config->height + TILE - 1) / TILE;
+    comp->all_layers = (uint8_t) ((1u << config->layers) - 1);
+    comp->cached_mask = (uint8_t) ((1u << config->cached_layers) - 1);
+    const size_t tiles = (size_t) comp->tiles_x * comp->tiles_y;
+
+    // The dirty map is scanned every frame, keep it in internal RAM
+    comp->dirty = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, tiles, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    comp->rects = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER,
+                                         comp->tiles_y * sizeof(esp_bsp_sdl_rect_t),
+                                         MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    bool ok = comp->dirty && comp->rects;
+    if(ok && config->cached_layers > 0) {
+        const size_t frame_size = (size_t) config->width * config->height * sizeof(uint16_t);
+        comp->cache = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, frame_size, MALLOC_CAP_SPIRAM);
+        if(!comp->cache) {
+            comp->cache = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, frame_size, MALLOC_CAP_DEFAULT);
+        }
+        ok = comp->cache != NULL;
+    }
+    if(!ok) {
+        ESP_LOGE(TAG, "Failed to allocate compositor for %dx%d", config->width, config->height);
+        esp_bsp_sdl_compositor_delete(comp);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Neither the cache nor the output hold anything yet
+    memset(comp->dirty, comp->all_layers, tiles);
+    *ret_compositor = comp;
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_compositor_delete(esp_bsp_sdl_compositor_handle_t compositor)
+{
+    if(!compositor) {
+        return;
+    }
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, compositor->dirty);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, compositor->rects);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, compositor->cache);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, compositor);
+}
+
+// Output area of a layer that contributes pixels, false if it contributes none
+static bool layer_area(esp_bsp_sdl_compositor_handle_t comp, const esp_bsp_sdl_layer_t *layer, esp_bsp_sdl_rect_t *area)
+{
+    if(!layer->visible || !layer->surface.pixels || (!layer->alpha && layer->opacity == 0)) {
+        return false;
+    }
+    const esp_bsp_sdl_rect_t output = {0, 0, comp->config.width, comp->config.height};
+    const esp_bsp_sdl_rect_t rect = {layer->x, layer->y, layer->surface.width, layer->surface.height};
+    return esp_bsp_sdl_rect_intersect(&rect, &output, area);
+}
+
+static void mark_area(esp_bsp_sdl_compositor_handle_t comp, int index, const esp_bsp_sdl_rect_t *area)
+{
+    const int tx0 = area->x / TILE;
+    const int tx1 = (area->x + area->w - 1) / TILE;
+    const int ty0 = area->y / TILE;
+    const int ty1 = (area->y + area->h - 1) / TILE;
+    for(int ty = ty0; ty <= ty1; ty++) {
+        uint8_t *row = comp->dirty + (size_t) ty * comp->tiles_x;
+        for(int tx = tx0; tx <= tx1; tx++) {
+            row[tx] |= 1u << index;
+        }
+    }
+}
+
+static void mark_layer(esp_bsp_sdl_compositor_handle_t comp, int index)
+{
+    esp_bsp_sdl_rect_t area;
+    if(layer_area(comp, &comp->layers[index], &area)) {
+        mark_area(comp, index, &area);
+    }
+}
+
+esp_err_t esp_bsp_sdl_compositor_set_layer(esp_bsp_sdl_compositor_handle_t compositor,
+                                           int index,
+                                           const esp_bsp_sdl_layer_t *layer)
+{
+    if(!compositor || !layer || index < 0 || index >= compositor->config.layers) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const esp_bsp_sdl_surface_t *s = &layer->surface;
+    if(s->pixels && (s->width <= 0 || s->height <= 0 || s->stride < s->width)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    mark_layer(compositor, index);
+    compositor->layers[index] = *layer;
+    mark_layer(compositor, index);
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_compositor_move_layer(esp_bsp_sdl_compositor_handle_t compositor, int index, int x, int y)
+{
+    if(!compositor || index < 0 || index >= compositor->config.layers) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_bsp_sdl_layer_t *layer = &compositor->layers[index];
+    if(layer->x == x && layer->y == y) {
+        return ESP_OK;
+    }
+
+    mark_layer(compositor, index);
+    layer->x = x;
+    layer->y = y;
+    mark_layer(compositor, index);
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_compositor_invalidate(esp_bsp_sdl_compositor_handle_t compositor,
+                                            int index,
+                                            const esp_bsp_sdl_rect_t *rect)
+{
+    if(!compositor || index < 0 || index >= compositor->config.layers) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const esp_bsp_sdl_layer_t *layer = &compositor->layers[index];
+    esp_bsp_sdl_rect_t area;
+    if(!layer_area(compositor, layer, &area)) {
+        return ESP_OK;
+    }
+    if(rect) {
+        const esp_bsp_sdl_rect_t changed = {rect->x + layer->x, rect->y + layer->y, rect->w, rect->h};
+        if(!esp_bsp_sdl_rect_intersect(&changed, &area, &area)) {
+            return ESP_OK;
+        }
+    }
+    mark_area(compositor, index, &area);
+    return ESP_OK;
+}
+
+static void fill_area(uint16_t *dst, int stride, int width, int height, uint16_t color)
+{
+    for(int x = 0; x < width; x++) {
+        dst[x] = color;
+    }
+    for(int y = 1; y < height; y++) {
+        memcpy(dst + (size_t) y * stride, dst, width * sizeof(uint16_t));
+    }
+}
+
+// Draw the part of a layer inside area over dst, which holds the output pixel area->x, area->y
+static void blend_layer(esp_bsp_sdl_compositor_handle_t comp,
+                        const esp_bsp_sdl_layer_t *layer,
+                        const esp_bsp_sdl_rect_t *area,
+                        uint16_t *dst,
+                        int dst_stride)
+{
+    esp_bsp_sdl_rect_t part;
+    if(!layer_area(comp, layer, &part) || !esp_bsp_sdl_rect_intersect(&part, area, &part)) {
+        return;
+    }
+
+    const esp_bsp_sdl_blend_kernels_t *blend = esp_bsp_sdl_blend_get_kernels(ESP_BSP_SDL_BLEND_IMPL_AUTO);
+    const int stride = layer->surface.stride;
+    const size_t offset = (size_t) (part.y - layer->y) * stride + (part.x - layer->x);
+    const uint16_t *src = layer->surface.pixels + offset;
+    const uint8_t *alpha = layer->alpha ? layer->alpha + offset : NULL;
+    dst += (size_t) (part.y - area->y) * dst_stride + (part.x - area->x);
+
+    for(int row = 0; row < part.h; row++) {
+        if(alpha) {
+            blend->rgb565_a8_over(dst, src, alpha, part.w);
+            alpha += stride;
+        } else if(layer->opacity == 255) {
+            memcpy(dst, src, part.w * sizeof(uint16_t));
+        } else {
+            blend->rgb565_const_over(dst, src, layer->opacity, part.w);
+        }
+        dst += dst_stride;
+        src += stride;
+    }
+    comp->stats.read_bytes += (uint64_t) part.w * part.h * (sizeof(uint16_t) + (layer->alpha ? 1 : 0));
+}
+
+// Compose the cached layers of one tile into the cache frame
+static void rebuild_cache_tile(esp_bsp_sdl_compositor_handle_t comp, int tx, int ty)
+{
+    const int width = comp->config.width;
+    const esp_bsp_sdl_rect_t output = {0, 0, width, comp->config.height};
+    const esp_bsp_sdl_rect_t tile = {tx * TILE, ty * TILE, TILE, TILE};
+    esp_bsp_sdl_rect_t area;
+    if(!esp_bsp_sdl_rect_intersect(&tile, &output, &area)) {
+        return;
+    }
+
+    uint16_t *dst = comp->cache + (size_t) area.y * width + area.x;
+    fill_area(dst, width, area.w, area.h, comp->config.clear_color);
+    for(int i = 0; i < comp->config.cached_layers; i++) {
+        blend_layer(comp, &comp->layers[i], &area, dst, width);
+    }
+    comp->stats.cache_rebuilds++;
+}
+
+// Compose an area of one tile row into dst; rebuilds cache tiles whose cached layers changed
+static void compose_area(esp_bsp_sdl_compositor_handle_t comp,
+                         const esp_bsp_sdl_rect_t *area,
+                         uint16_t *dst,
+                         int stride)
+{
+    int64_t start = esp_timer_get_time();
+    const int ty = area->y / TILE;
+    const uint8_t *dirty = comp->dirty + (size_t) ty * comp->tiles_x;
+    int first_layer = 0;
+
+    if(comp->cache) {
+        for(int tx = area->x / TILE; tx <= (area->x + area->w - 1) / TILE; tx++) {
+            if(dirty[tx] & comp->cached_mask) {
+                rebuild_cache_tile(comp, tx, ty);
+            }
+        }
+        const int width = comp->config.width;
+        const uint16_t *src = comp->cache + (size_t) area->y * width + area->x;
+        for(int row = 0; row < area->h; row++) {
+            memcpy(dst + (size_t) row * stride, src + (size_t) row * width, area->w * sizeof(uint16_t));
+        }
+        comp->stats.read_bytes += (uint64_t) area->w * area->h * sizeof(uint16_t);
+        first_layer = comp->config.cached_layers;
+    } else {
+        fill_area(dst, stride, area->w, area->h, comp->config.clear_color);
+    }
+
+    for(int i = first_layer; i < comp->config.layers; i++) {
+        blend_layer(comp, &comp->layers[i], area, dst, stride);
+    }
+    comp->stats.compose_time_us += esp_timer_get_time() - start;
+}
+
+// One area per tile row from the first to the last dirty tile, returns the number of areas
+static int collect_areas(esp_bsp_sdl_compositor_handle_t comp)
+{
+    const int width = comp->config.width;
+    const int height = comp->config.height;
+    int count = 0;
+
+    for(int ty = 0; ty < comp->tiles_y; ty++) {
+        const uint8_t *dirty = comp->dirty + (size_t) ty * comp->tiles_x;
+        int first = -1;
+        int last = -1;
+        for(int tx = 0; tx < comp->tiles_x; tx++) {
+            if(dirty[tx]) {
+                comp->stats.tiles_dirty++;
+                last = tx;
+                if(first < 0) {
+                    first = tx;
+                }
+            }
+        }
+        if(first < 0) {
+            continue;
+        }
+
+        const int x0 = first * TILE;
+        const int x1 = (last + 1) * TILE < width ? (last + 1) * TILE : width;
+        const int y0 = ty * TILE;
+        comp->rects[count++] = (esp_bsp_sdl_rect_t) {x0, y0, x1 - x0, (height - y0) < TILE ? (height - y0) : TILE};
+        comp->stats.tiles_composed += last - first + 1;
+    }
+
+    // What composing every layer over the whole output would read instead
+    for(int i = 0; i < comp->config.layers; i++) {
+        const esp_bsp_sdl_layer_t *layer = &comp->layers[i];
+        esp_bsp_sdl_rect_t area;
+        if(layer_area(comp, layer, &area)) {
+            comp->stats.full_bytes += (uint64_t) area.w * area.h * (sizeof(uint16_t) + (layer->alpha ? 1 : 0));
+        }
+    }
+    comp->stats.frames++;
+    return count;
+}
+
+static void clear_dirty(esp_bsp_sdl_compositor_handle_t comp, esp_err_t ret)
+{
+    // After a failure the output is unknown, compose it again from scratch
+    memset(comp->dirty, ret == ESP_OK ? 0 : comp->all_layers, (size_t) comp->tiles_x * comp->tiles_y);
+}
+
+esp_err_t esp_bsp_sdl_compositor_render(esp_bsp_sdl_compositor_handle_t compositor, esp_bsp_sdl_surface_t *target)
+{
+    if(!compositor || !target || !target->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(target->width < compositor->config.width || target->height < compositor->config.height) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const int count = collect_areas(compositor);
+    for(int i = 0; i < count; i++) {
+        const esp_bsp_sdl_rect_t *area = &compositor->rects[i];
+        compose_area(compositor,
+                     area,
+                     target->pixels + (size_t) area->y * target->stride + area->x,
+                     target->stride);
+    }
+    clear_dirty(compositor, ESP_OK);
+    return ESP_OK;
+}
+
+static esp_err_t render_flush_area(esp_bsp_sdl_surface_t *band, const esp_bsp_sdl_rect_t *rect, void *user_ctx)
+{
+    compose_area(user_ctx, rect, band->pixels, band->stride);
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_compositor_flush(esp_bsp_sdl_compositor_handle_t compositor)
+{
+    if(!compositor) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int width;
+    int height;
+    esp_bsp_sdl_priv_get_logical_size(&width, &height);
+    if(width != compositor->config.width || height != compositor->config.height) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const int count = collect_areas(compositor);
+    esp_err_t ret = esp_bsp_sdl_flush_rects(compositor->rects, count, render_flush_area, compositor);
+    if(ret != ESP_OK) {
+        ESP_LOGW(TAG, "Flush failed, recomposing everything next time: %s", esp_err_to_name(ret));
+    }
+    clear_dirty(compositor, ret);
+    return ret;
+}
+
+esp_err_t esp_bsp_sdl_compositor_get_stats(esp_bsp_sdl_compositor_handle_t compositor,
+                                           esp_bsp_sdl_compositor_stats_t *stats)
+{
+    if(!compositor || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = compositor->stats;
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_compositor_reset_stats(esp_bsp_sdl_compositor_handle_t compositor)
+{
+    if(compositor) {
+        memset(&compositor->stats, 0, sizeof(compositor->stats));
+    }
+}
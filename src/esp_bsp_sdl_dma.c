@@ -0,0 +1,385 @@
+/**
+ * @file esp_bsp_sdl_dma.c
+ * @brief Frame buffer fill and copy offloaded to GDMA
+ */
+
+#include <string.h>
+#include "esp_bsp_sdl_dma.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#if CONFIG_SDL_BSP_DMA_COPY
+#include "esp_async_memcpy.h"
+#include "esp_cache.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#endif
+
+static const char *TAG = "esp_bsp_sdl_dma";
+
+// Describes one fill or copy as a set of equally sized chunks and an optional shorter last one
+typedef struct {
+    uint8_t *dst;
+    const uint8_t *src; // NULL for a fill
+    size_t dst_step;    // Bytes between chunks
+    size_t src_step;
+    size_t chunk;       // Bytes per chunk
+    int count;          // Chunks
+    size_t tail;        // Bytes of the last chunk after count full ones, 0 for none
+} dma_op_t;
+
+static bool clip_rect(const esp_bsp_sdl_surface_t *surface, const esp_bsp_sdl_rect_t *rect, esp_bsp_sdl_rect_t *out)
+{
+    const esp_bsp_sdl_rect_t whole = {0, 0, surface->width, surface->height};
+    return esp_bsp_sdl_rect_intersect(rect ? rect : &whole, &whole, out);
+}
+
+static void cpu_fill(uint16_t *dst, int stride, int w, int h, uint16_t color)
+{
+    const size_t row_bytes = w * sizeof(uint16_t);
+    if((color >> 8) == (color & 0xFF)) {
+        for(int row = 0; row < h; row++) {
+            memset(dst + (size_t) row * stride, color & 0xFF, row_bytes);
+        }
+        return;
+    }
+    for(int col = 0; col < w; col++) {
+        dst[col] = color;
+    }
+    for(int row = 1; row < h; row++) {
+        memcpy(dst + (size_t) row * stride, dst, row_bytes);
+    }
+}
+
+static void cpu_copy(const dma_op_t *op)
+{
+    for(int i = 0; i < op->count; i++) {
+        memcpy(op->dst + i * op->dst_step, op->src + i * op->src_step, op->chunk);
+    }
+}
+
+#if CONFIG_SDL_BSP_DMA_COPY
+
+#define DMA_BACKLOG 8
+#define FILL_PATTERN_BYTES 4096
+
+static async_memcpy_handle_t s_mcp = NULL;
+static SemaphoreHandle_t s_slots = NULL; // Free backlog slots, given back on each chunk completion
+static SemaphoreHandle_t s_idle = NULL;  // Held while an operation is in flight
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static int s_outstanding = 0;            // Chunks queued and not completed
+static bool s_submitting = false;        // Chunks of the current operation are still being queued
+static esp_bsp_sdl_dma_done_cb_t s_done_cb = NULL;
+static void *s_done_ctx = NULL;
+static uint16_t *s_pattern = NULL;       // Fill source in DMA-capable internal RAM
+static uint16_t s_pattern_color = 0;
+static bool s_pattern_valid = false;
+static size_t s_align_internal = 4;
+static size_t s_align_external = 4;
+static bool s_unavailable = false;
+
+static esp_err_t dma_init(void)
+{
+    if(s_mcp) {
+        return ESP_OK;
+    }
+    if(s_unavailable) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    size_t align = 0;
+    if(esp_cache_get_alignment(MALLOC_CAP_DMA, &align) == ESP_OK && align > s_align_internal) {
+        s_align_internal = align;
+    }
+    if(esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &align) == ESP_OK && align > s_align_external) {
+        s_align_external = align;
+    }
+
+    s_slots = xSemaphoreCreateCounting(DMA_BACKLOG, DMA_BACKLOG);
+    s_idle = xSemaphoreCreateBinary();
+    s_pattern = esp_bsp_sdl_mem_aligned_alloc(ESP_BSP_SDL_MEM_FLUSH,
+                                              s_align_internal,
+                                              FILL_PATTERN_BYTES,
+                                              MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    async_memcpy_config_t config = ASYNC_MEMCPY_DEFAULT_CONFIG();
+    config.backlog = DMA_BACKLOG;
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if(s_slots && s_idle && s_pattern) {
+        ret = esp_async_memcpy_install(&config, &s_mcp);
+    }
+    if(ret != ESP_OK) {
+        ESP_LOGW(TAG, "Async memcpy unavailable (%s), using CPU copies", esp_err_to_name(ret));
+        esp_bsp_sdl_dma_deinit();
+        s_unavailable = true;
+        return ret;
+    }
+
+    xSemaphoreGive(s_idle);
+    s_pattern_valid = false;
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_dma_deinit(void)
+{
+    if(s_mcp) {
+        esp_bsp_sdl_dma_wait(-1);
+        esp_async_memcpy_uninstall(s_mcp);
+        s_mcp = NULL;
+    }
+    if(s_slots) {
+        vSemaphoreDelete(s_slots);
+        s_slots = NULL;
+    }
+    if(s_idle) {
+        vSemaphoreDelete(s_idle);
+        s_idle = NULL;
+    }
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_FLUSH, s_pattern);
+    s_pattern = NULL;
+    s_pattern_valid = false;
+    s_unavailable = false;
+}
+
+static bool aligned_for_dma(const void *addr, size_t step, size_t chunk, size_t tail)
+{
+    if(!esp_ptr_external_ram(addr) && !esp_ptr_dma_capable(addr)) {
+        return false;
+    }
+    const size_t align = esp_ptr_external_ram(addr) ? s_align_external : s_align_internal;
+    return ((uintptr_t) addr % align) == 0 && step % align == 0 && chunk % align == 0 && tail % align == 0;
+}
+
+// Called once after the last chunk is done: report and release the engine
+static void finish(BaseType_t *need_yield)
+{
+    if(s_done_cb) {
+        s_done_cb(s_done_ctx);
+    }
+    if(need_yield) {
+        xSemaphoreGiveFromISR(s_idle, need_yield);
+    } else {
+        xSemaphoreGive(s_idle);
+    }
+}
+
+static bool on_chunk_done(async_memcpy_handle_t mcp, async_memcpy_event_t *event, void *cb_args)
+{
+    BaseType_t need_yield = pdFALSE;
+    xSemaphoreGiveFromISR(s_slots, &need_yield);
+    portENTER_CRITICAL_ISR(&s_lock);
+    const bool done = --s_outstanding == 0 && !s_submitting;
+    portEXIT_CRITICAL_ISR(&s_lock);
+    if(done) {
+        finish(&need_yield);
+    }
+    return need_yield == pdTRUE;
+}
+
+// PSRAM sits behind the cache: write back the source and drop destination lines around the transfer
+static void sync_external(const void *addr, size_t size, int flags)
+{
+    if(esp_ptr_external_ram(addr)) {
+        esp_cache_msync((void *) addr, size, flags);
+    }
+}
+
+// Queue every chunk; a chunk the driver refuses is copied by the CPU so the operation always completes
+static void dma_run(const dma_op_t *op, esp_bsp_sdl_dma_done_cb_t done_cb, void *user_ctx)
+{
+    s_done_cb = done_cb;
+    s_done_ctx = user_ctx;
+    s_submitting = true;
+
+    const int chunks = op->count + (op->tail ? 1 : 0);
+    for(int i = 0; i < chunks; i++) {
+        uint8_t *dst = op->dst + i * op->dst_step;
+        const uint8_t *src = op->src ? op->src + i * op->src_step : (const uint8_t *) s_pattern;
+        const size_t size = i < op->count ? op->chunk : op->tail;
+
+        sync_external(src, size, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+        sync_external(dst, size, ESP_CACHE_MSYNC_FLAG_DIR_M2C);
+
+        xSemaphoreTake(s_slots, portMAX_DELAY);
+        portENTER_CRITICAL(&s_lock);
+        s_outstanding++;
+        portEXIT_CRITICAL(&s_lock);
+
+        if(esp_async_memcpy(s_mcp, dst, (void *) src, size, on_chunk_done, NULL) != ESP_OK) {
+            portENTER_CRITICAL(&s_lock);
+            s_outstanding--;
+            portEXIT_CRITICAL(&s_lock);
+            xSemaphoreGive(s_slots);
+            memcpy(dst, src, size);
+        }
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_submitting = false;
+    const bool done = s_outstanding == 0;
+    portEXIT_CRITICAL(&s_lock);
+    if(done) {
+        finish(NULL);
+    }
+}
+
+// Claim the engine for an operation of total bytes, false if the CPU should do it
+static bool dma_begin(size_t total)
+{
+    if(total < CONFIG_SDL_BSP_DMA_MIN_BYTES || dma_init() != ESP_OK) {
+        return false;
+    }
+    xSemaphoreTake(s_idle, portMAX_DELAY);
+    return true;
+}
+
+static void dma_end_unused(void)
+{
+    xSemaphoreGive(s_idle);
+}
+
+esp_err_t esp_bsp_sdl_dma_wait(int timeout_ms)
+{
+    if(!s_idle) {
+        return ESP_OK;
+    }
+    const TickType_t ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    if(xSemaphoreTake(s_idle, ticks) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    xSemaphoreGive(s_idle);
+    return ESP_OK;
+}
+
+#else
+
+void esp_bsp_sdl_dma_deinit(void)
+{
+}
+
+esp_err_t esp_bsp_sdl_dma_wait(int timeout_ms)
+{
+    return ESP_OK;
+}
+
+#endif // CONFIG_SDL_BSP_DMA_COPY
+
+esp_err_t esp_bsp_sdl_fill(esp_bsp_sdl_surface_t *dst,
+                           const esp_bsp_sdl_rect_t *rect,
+                           uint16_t color,
+                           esp_bsp_sdl_dma_done_cb_t done_cb,
+                           void *user_ctx)
+{
+    if(!dst || !dst->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_bsp_sdl_rect_t area;
+    if(!clip_rect(dst, rect, &area)) {
+        if(done_cb) {
+            done_cb(user_ctx);
+        }
+        return ESP_OK;
+    }
+    uint16_t *base = dst->pixels + (size_t) area.y * dst->stride + area.x;
+
+#if CONFIG_SDL_BSP_DMA_COPY
+    const size_t total = (size_t) area.w * area.h * sizeof(uint16_t);
+    if(dma_begin(total)) {
+        // Whole rows are one contiguous block cut into pattern-sized chunks and a remainder, otherwise
+        // one chunk per row
+        dma_op_t op = {.dst = (uint8_t *) base};
+        if(area.w == dst->stride) {
+            op.chunk = FILL_PATTERN_BYTES;
+            op.count = total / FILL_PATTERN_BYTES;
+            op.tail = total % FILL_PATTERN_BYTES;
+            op.dst_step = op.chunk;
+        } else {
+            op.chunk = area.w * sizeof(uint16_t);
+            op.count = area.h;
+            op.dst_step = dst->stride * sizeof(uint16_t);
+        }
+
+        if(op.chunk <= FILL_PATTERN_BYTES && aligned_for_dma(op.dst, op.dst_step, op.chunk, op.tail)) {
+            if(!s_pattern_valid || s_pattern_color != color) {
+                for(int i = 0; i < FILL_PATTERN_BYTES / (int) sizeof(uint16_t); i++) {
+                    s_pattern[i] = color;
+                }
+                s_pattern_color = color;
+                s_pattern_valid = true;
+            }
+            dma_run(&op, done_cb, user_ctx);
+            return ESP_OK;
+        }
+        dma_end_unused();
+    }
+#endif
+
+    esp_bsp_sdl_dma_wait(-1);
+    cpu_fill(base, dst->stride, area.w, area.h, color);
+    if(done_cb) {
+        done_cb(user_ctx);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_copy(esp_bsp_sdl_surface_t *dst,
+                           int dst_x,
+                           int dst_y,
+                           const esp_bsp_sdl_surface_t *src,
+                           const esp_bsp_sdl_rect_t *src_rect,
+                           esp_bsp_sdl_dma_done_cb_t done_cb,
+                           void *user_ctx)
+{
+    if(!dst || !dst->pixels || !src || !src->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Clip against the source, then move to the destination and clip again
+    esp_bsp_sdl_rect_t area;
+    const int dx = dst_x - (src_rect ? src_rect->x : 0);
+    const int dy = dst_y - (src_rect ? src_rect->y : 0);
+    bool visible = clip_rect(src, src_rect, &area);
+    if(visible) {
+        area.x += dx;
+        area.y += dy;
+        visible = clip_rect(dst, &area, &area);
+    }
+    if(!visible) {
+        if(done_cb) {
+            done_cb(user_ctx);
+        }
+        return ESP_OK;
+    }
+
+    dma_op_t op = {
+        .dst = (uint8_t *) (dst->pixels + (size_t) area.y * dst->stride + area.x),
+        .src = (const uint8_t *) (src->pixels + (size_t) (area.y - dy) * src->stride + (area.x - dx)),
+    };
+    if(area.w == dst->stride && area.w == src->stride) {
+        op.chunk = (size_t) area.w * area.h * sizeof(uint16_t);
+        op.count = 1;
+    } else {
+        op.chunk = area.w * sizeof(uint16_t);
+        op.count = area.h;
+        op.dst_step = dst->stride * sizeof(uint16_t);
+        op.src_step = src->stride * sizeof(uint16_t);
+    }
+
+#if CONFIG_SDL_BSP_DMA_COPY
+    if(dma_begin(op.chunk * op.count)) {
+        if(aligned_for_dma(op.dst, op.dst_step, op.chunk, 0) && aligned_for_dma(op.src, op.src_step, op.chunk, 0)) {
+            dma_run(&op, done_cb, user_ctx);
+            return ESP_OK;
+        }
+        dma_end_unused();
+    }
+#endif
+
+    esp_bsp_sdl_dma_wait(-1);
+    cpu_copy(&op);
+    if(done_cb) {
+        done_cb(user_ctx);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,373 @@
+/**
+ * @file esp_bsp_sdl_fbc.c
+ * @brief Lossless tile-compressed frame buffer
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_fbc.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#define TILE ESP_BSP_SDL_FBC_TILE
+#define SLOT_BYTES (TILE * TILE * sizeof(uint16_t))
+// RLE slot: first run index of every row (TILE + 1 bytes, padded), then runs as color | length << 16
+#define RLE_HEADER 20
+#define RLE_MAX_RUNS ((SLOT_BYTES - RLE_HEADER) / sizeof(uint32_t))
+
+static const char *TAG = "esp_bsp_sdl_fbc";
+
+typedef enum {
+    TILE_CONST,
+    TILE_RLE,
+    TILE_RAW,
+} tile_type_t;
+
+typedef struct {
+    uint8_t type;
+    uint16_t color; // TILE_CONST
+} tile_info_t;
+
+struct esp_bsp_sdl_fbc_t {
+    int width;
+    int height;
+    int tiles_x;
+    int tiles_y;
+    tile_info_t *tiles;
+    uint8_t *store; // One slot of SLOT_BYTES per tile, PSRAM when available
+    uint16_t merge[TILE * TILE];
+    uint32_t runs[RLE_MAX_RUNS];
+    esp_bsp_sdl_fbc_stats_t stats;
+};
+
+esp_err_t esp_bsp_sdl_fbc_create(int width, int height, esp_bsp_sdl_fbc_handle_t *ret_fbc)
+{
+    if(width <= 0 || height <= 0 || !ret_fbc) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_bsp_sdl_fbc_handle_t fbc = esp_bsp_sdl_mem_calloc(ESP_BSP_SDL_MEM_RENDER, 1, sizeof(*fbc), MALLOC_CAP_DEFAULT);
+    if(!fbc) {
+        return ESP_ERR_NO_MEM;
+    }
+    fbc->width = width;
+    fbc->height = height;
+    fbc->tiles_x = (width + TILE - 1) / TILE;
+    fbc->tiles_y = (height + TILE - 1) / TILE;
+    const size_t tiles = (size_t) fbc->tiles_x * fbc->tiles_y;
+
+    // Headers are read for every tile of every frame, keep them in internal RAM
+    fbc->tiles = esp_bsp_sdl_mem_calloc(ESP_BSP_SDL_MEM_RENDER,
+                                        tiles,
+                                        sizeof(tile_info_t),
+                                        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    fbc->store = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, tiles * SLOT_BYTES, MALLOC_CAP_SPIRAM);
+    if(!fbc->store) {
+        fbc->store = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, tiles * SLOT_BYTES, MALLOC_CAP_DEFAULT);
+    }
+    if(!fbc->tiles || !fbc->store) {
+        ESP_LOGE(TAG, "Failed to allocate compressed frame buffer for %dx%d", width, height);
+        esp_bsp_sdl_fbc_delete(fbc);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // calloc left every tile TILE_CONST black
+    *ret_fbc = fbc;
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_fbc_delete(esp_bsp_sdl_fbc_handle_t fbc)
+{
+    if(!fbc) {
+        return;
+    }
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, fbc->tiles);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, fbc->store);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, fbc);
+}
+
+static inline uint8_t *tile_slot(esp_bsp_sdl_fbc_handle_t fbc, int tile)
+{
+    return fbc->store + (size_t) tile * SLOT_BYTES;
+}
+
+// Decode columns x0..x1 of row r of a tile
+static void decode_tile_row(esp_bsp_sdl_fbc_handle_t fbc, int tile, int r, int x0, int x1, uint16_t *dst)
+{
+    const tile_info_t *info = &fbc->tiles[tile];
+    const int n = x1 - x0;
+    fbc->stats.bytes_raw += n * sizeof(uint16_t);
+
+    if(info->type == TILE_CONST) {
+        for(int i = 0; i < n; i++) {
+            dst[i] = info->color;
+        }
+        return;
+    }
+
+    const uint8_t *slot = tile_slot(fbc, tile);
+    if(info->type == TILE_RAW) {
+        memcpy(dst, slot + (r * TILE + x0) * sizeof(uint16_t), n * sizeof(uint16_t));
+        fbc->stats.bytes_read += n * sizeof(uint16_t);
+        return;
+    }
+
+    const uint32_t *runs = (const uint32_t *) (slot + RLE_HEADER);
+    const int last = slot[r + 1];
+    int i = slot[r];
+    int x = 0;
+    fbc->stats.bytes_read += 2;
+    for(; i < last && x < x1; i++) {
+        const uint32_t run = runs[i];
+        const int end = x + (run >> 16);
+        for(int p = x > x0 ? x : x0; p < end && p < x1; p++) {
+            dst[p - x0] = run & 0xFFFF;
+        }
+        x = end;
+    }
+    fbc->stats.bytes_read += (i - slot[r]) * sizeof(uint32_t);
+}
+
+static void encode_tile(esp_bsp_sdl_fbc_handle_t fbc, int tile, const uint16_t *px, int stride, int w, int h)
+{
+    tile_info_t *info = &fbc->tiles[tile];
+
+    const uint16_t first = px[0];
+    bool constant = true;
+    for(int y = 0; y < h && constant; y++) {
+        for(int x = 0; x < w; x++) {
+            if(px[y * stride + x] != first) {
+                constant = false;
+                break;
+            }
+        }
+    }
+    if(constant) {
+        info->type = TILE_CONST;
+        info->color = first;
+        return;
+    }
+
+    // Run-length encode row by row, give up as soon as raw reads less. RLE must read at most three
+    // quarters of the raw pixels (row starts and runs) to be worth the run walk; partial tiles at
+    // the frame edges have fewer raw pixels to beat.
+    const size_t worth_bytes = (size_t) w * h * sizeof(uint16_t) * 3 / 4;
+    uint8_t row_start[RLE_HEADER] = {0};
+    size_t count = 0;
+    bool rle = true;
+    for(int y = 0; y < h && rle; y++) {
+        const uint16_t *row = px + y * stride;
+        row_start[y] = count;
+        for(int x = 0; x < w;) {
+            int len = 1;
+            while(x + len < w && row[x + len] == row[x]) {
+                len++;
+            }
+            if(count == RLE_MAX_RUNS || 2 * h + (count + 1) * sizeof(uint32_t) > worth_bytes) {
+                rle = false;
+                break;
+            }
+            fbc->runs[count++] = row[x] | ((uint32_t) len << 16);
+            x += len;
+        }
+    }
+
+    uint8_t *slot = tile_slot(fbc, tile);
+    if(rle) {
+        row_start[h] = count;
+        memcpy(slot, row_start, RLE_HEADER);
+        memcpy(slot + RLE_HEADER, fbc->runs, count * sizeof(uint32_t));
+        info->type = TILE_RLE;
+        return;
+    }
+
+    for(int y = 0; y < h; y++) {
+        memcpy(slot + y * TILE * sizeof(uint16_t), px + y * stride, w * sizeof(uint16_t));
+    }
+    info->type = TILE_RAW;
+}
+
+static void tile_rect(esp_bsp_sdl_fbc_handle_t fbc, int tx, int ty, esp_bsp_sdl_rect_t *rect)
+{
+    rect->x = tx * TILE;
+    rect->y = ty * TILE;
+    rect->w = (fbc->width - rect->x) < TILE ? (fbc->width - rect->x) : TILE;
+    rect->h = (fbc->height - rect->y) < TILE ? (fbc->height - rect->y) : TILE;
+}
+
+// Decode a whole tile into the merge buffer
+static void decode_tile(esp_bsp_sdl_fbc_handle_t fbc, int tile, const esp_bsp_sdl_rect_t *rect)
+{
+    for(int r = 0; r < rect->h; r++) {
+        decode_tile_row(fbc, tile, r, 0, rect->w, fbc->merge + r * TILE);
+    }
+}
+
+esp_err_t esp_bsp_sdl_fbc_write(esp_bsp_sdl_fbc_handle_t fbc, const esp_bsp_sdl_surface_t *src, int x, int y)
+{
+    if(!fbc || !src || !src->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const esp_bsp_sdl_rect_t frame = {0, 0, fbc->width, fbc->height};
+    esp_bsp_sdl_rect_t area = {x, y, src->width, src->height};
+    if(!esp_bsp_sdl_rect_intersect(&area, &frame, &area)) {
+        return ESP_OK;
+    }
+
+    for(int ty = area.y / TILE; ty <= (area.y + area.h - 1) / TILE; ty++) {
+        for(int tx = area.x / TILE; tx <= (area.x + area.w - 1) / TILE; tx++) {
+            const int tile = ty * fbc->tiles_x + tx;
+            esp_bsp_sdl_rect_t trect;
+            esp_bsp_sdl_rect_t part;
+            tile_rect(fbc, tx, ty, &trect);
+            if(!esp_bsp_sdl_rect_intersect(&trect, &area, &part)) {
+                continue;
+            }
+            const uint16_t *from = src->pixels + (size_t) (part.y - y) * src->stride + (part.x - x);
+
+            if(part.w == trect.w && part.h == trect.h) {
+                encode_tile(fbc, tile, from, src->stride, trect.w, trect.h);
+                continue;
+            }
+            decode_tile(fbc, tile, &trect);
+            for(int r = 0; r < part.h; r++) {
+                memcpy(fbc->merge + (part.y - trect.y + r) * TILE + (part.x - trect.x),
+                       from + (size_t) r * src->stride,
+                       part.w * sizeof(uint16_t));
+            }
+            encode_tile(fbc, tile, fbc->merge, TILE, trect.w, trect.h);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_fbc_fill(esp_bsp_sdl_fbc_handle_t fbc, const esp_bsp_sdl_rect_t *rect, uint16_t color)
+{
+    if(!fbc) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const esp_bsp_sdl_rect_t frame = {0, 0, fbc->width, fbc->height};
+    esp_bsp_sdl_rect_t area;
+    if(!esp_bsp_sdl_rect_intersect(rect ? rect : &frame, &frame, &area)) {
+        return ESP_OK;
+    }
+
+    for(int ty = area.y / TILE; ty <= (area.y + area.h - 1) / TILE; ty++) {
+        for(int tx = area.x / TILE; tx <= (area.x + area.w - 1) / TILE; tx++) {
+            const int tile = ty * fbc->tiles_x + tx;
+            esp_bsp_sdl_rect_t trect;
+            esp_bsp_sdl_rect_t part;
+            tile_rect(fbc, tx, ty, &trect);
+            if(!esp_bsp_sdl_rect_intersect(&trect, &area, &part)) {
+                continue;
+            }
+
+            if(part.w == trect.w && part.h == trect.h) {
+                fbc->tiles[tile].type = TILE_CONST;
+                fbc->tiles[tile].color = color;
+                continue;
+            }
+            decode_tile(fbc, tile, &trect);
+            for(int r = 0; r < part.h; r++) {
+                uint16_t *row = fbc->merge + (part.y - trect.y + r) * TILE + (part.x - trect.x);
+                for(int i = 0; i < part.w; i++) {
+                    row[i] = color;
+                }
+            }
+            encode_tile(fbc, tile, fbc->merge, TILE, trect.w, trect.h);
+        }
+    }
+    return ESP_OK;
+}
+
+// Decode columns x0..x1 of frame row y
+static void decode_row(esp_bsp_sdl_fbc_handle_t fbc, int y, int x0, int x1, uint16_t *dst)
+{
+    const int ty = y / TILE;
+    const int r = y % TILE;
+    while(x0 < x1) {
+        const int tx = x0 / TILE;
+        const int tile_end = (tx + 1) * TILE < x1 ? (tx + 1) * TILE : x1;
+        decode_tile_row(fbc, ty * fbc->tiles_x + tx, r, x0 - tx * TILE, tile_end - tx * TILE, dst);
+        dst += tile_end - x0;
+        x0 = tile_end;
+    }
+}
+
+esp_err_t esp_bsp_sdl_fbc_read(esp_bsp_sdl_fbc_handle_t fbc, size_t pos_px, size_t len_px, uint16_t *dst)
+{
+    if(!fbc || !dst || pos_px + len_px > (size_t) fbc->width * fbc->height) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    while(len_px) {
+        const int y = pos_px / fbc->width;
+        const int x = pos_px % fbc->width;
+        const size_t n = (size_t) (fbc->width - x) < len_px ? (size_t) (fbc->width - x) : len_px;
+        decode_row(fbc, y, x, x + n, dst);
+        dst += n;
+        pos_px += n;
+        len_px -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t render_band(esp_bsp_sdl_surface_t *band, int y, void *user_ctx)
+{
+    esp_bsp_sdl_fbc_handle_t fbc = user_ctx;
+    for(int r = 0; r < band->height; r++) {
+        decode_row(fbc, y + r, 0, band->width, band->pixels + (size_t) r * band->stride);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_fbc_flush(esp_bsp_sdl_fbc_handle_t fbc)
+{
+    if(!fbc) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int width;
+    int height;
+    esp_bsp_sdl_priv_get_logical_size(&width, &height);
+    if(width != fbc->width || height != fbc->height) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return esp_bsp_sdl_flush_bands(render_band, fbc);
+}
+
+esp_err_t esp_bsp_sdl_fbc_get_stats(esp_bsp_sdl_fbc_handle_t fbc, esp_bsp_sdl_fbc_stats_t *stats)
+{
+    if(!fbc || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = fbc->stats;
+    stats->tiles_const = 0;
+    stats->tiles_rle = 0;
+    stats->tiles_raw = 0;
+    const size_t tiles = (size_t) fbc->tiles_x * fbc->tiles_y;
+    for(size_t i = 0; i < tiles; i++) {
+        switch(fbc->tiles[i].type) {
+            case TILE_CONST:
+                stats->tiles_const++;
+                break;
+            case TILE_RLE:
+                stats->tiles_rle++;
+                break;
+            default:
+                stats->tiles_raw++;
+                break;
+        }
+    }
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_fbc_reset_stats(esp_bsp_sdl_fbc_handle_t fbc)
+{
+    if(fbc) {
+        fbc->stats.bytes_read = 0;
+        fbc->stats.bytes_raw = 0;
+    }
+}
@@ -0,0 +1,688 @@
+/**
+ * @file esp_bsp_sdl_flush.c
+ * @brief Full-frame flush with automatic dirty region detection
+ */
+
+#include <string.h>
+#include "esp_bsp_sdl_priv.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_memory_utils.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+
+#define TILE_SIZE ESP_BSP_SDL_FLUSH_BAND_ROWS // A tile row fills one band buffer
+
+// One band buffer in the minimal-footprint profile: no copy/transfer overlap, half the memory
+#if CONFIG_SDL_BSP_MIN_FOOTPRINT
+#    define BAND_BUFFERS 1
+#else
+#    define BAND_BUFFERS 2
+#endif
+
+// Completions the semaphore can hold: every span of a draw into each band buffer, plus one
+#define TRANS_DONE_MAX (BAND_BUFFERS * ESP_BSP_SDL_SCROLL_MAX_SPANS + 1)
+
+// Placement policy selected in menuconfig, AUTO resolved
+#if CONFIG_SDL_BSP_PLACEMENT_INTERNAL
+#    define DEFAULT_PLACEMENT ESP_BSP_SDL_PLACEMENT_INTERNAL
+#elif CONFIG_SDL_BSP_PLACEMENT_PSRAM_BOUNCE || CONFIG_SPIRAM
+#    define DEFAULT_PLACEMENT ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE
+#else
+#    define DEFAULT_PLACEMENT ESP_BSP_SDL_PLACEMENT_INTERNAL
+#endif
+
+static const char *TAG = "esp_bsp_sdl_flush";
+
+static esp_bsp_sdl_dirty_mode_t s_mode = ESP_BSP_SDL_DIRTY_OFF;
+static esp_bsp_sdl_placement_t s_placement = DEFAULT_PLACEMENT;
+static int s_width = 0;
+static int s_height = 0;
+static esp_bsp_sdl_dirty_mode_t s_alloc_mode = ESP_BSP_SDL_DIRTY_OFF;
+static uint16_t *s_shadow = NULL;     // ESP_BSP_SDL_DIRTY_SHADOW: last flushed frame
+static uint32_t *s_tile_hash = NULL; // ESP_BSP_SDL_DIRTY_TILE_HASH: signature per tile of the last flushed frame
+static bool s_history_valid = false;
+static uint16_t *s_band[BAND_BUFFERS] = {NULL};
+static int s_band_width = 0;
+static int s_band_index = 0;
+static SemaphoreHandle_t s_trans_done = NULL;
+static int s_pending = 0;  // Color transfers queued by us and not yet completed
+static int s_last_transfers = 0; // Color transfers of the most recent draw, more than one on a scrolled panel
+
+// Application callback registered with esp_bsp_sdl_set_trans_done_callback(), called after ours
+static volatile esp_lcd_panel_io_color_trans_done_cb_t s_chained_cb = NULL;
+static void *volatile s_chained_ctx = NULL;
+
+static bool on_color_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    BaseType_t need_yield = pdFALSE;
+    xSemaphoreGiveFromISR(s_trans_done, &need_yield);
+    bool yield = need_yield == pdTRUE;
+    esp_lcd_panel_io_color_trans_done_cb_t chained = s_chained_cb;
+    if(chained) {
+        yield |= chained(panel_io, edata, s_chained_ctx);
+    }
+    return yield;
+}
+
+// Transfers complete in order, so waiting for completions down to max_pending frees the oldest buffers
+static void wait_pending(int max_pending)
+{
+    while(s_pending > max_pending) {
+        xSemaphoreTake(s_trans_done, portMAX_DELAY);
+        s_pending--;
+    }
+}
+
+// Completion tracking for MIPI-DBI panels, where color transfers are queued asynchronously
+static esp_err_t ensure_trans_done(esp_lcd_panel_io_handle_t io)
+{
+    if(s_trans_done) {
+        return ESP_OK;
+    }
+
+    s_trans_done = xSemaphoreCreateCounting(TRANS_DONE_MAX, 0);
+    if(!s_trans_done) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = on_color_trans_done,
+    };
+    esp_err_t ret = esp_lcd_panel_io_register_event_callbacks(io, &cbs, NULL);
+    if(ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register transfer callback: %s", esp_err_to_name(ret));
+        vSemaphoreDelete(s_trans_done);
+        s_trans_done = NULL;
+    }
+    return ret;
+}
+
+// Wait until the next band buffer is free: only the transfers of the most recent draw may still run
+static uint16_t *next_band(void)
+{
+    wait_pending(BAND_BUFFERS > 1 ? s_last_transfers : 0);
+    uint16_t *band = s_band[s_band_index];
+    s_band_index = (s_band_index + 1) % BAND_BUFFERS;
+    return band;
+}
+
+// Draw and count the queued transfers, also on failure: each one still reports its completion
+static esp_err_t queue_draw(int x0, int y0, int x1, int y1, const void *data)
+{
+    int transfers = 0;
+    esp_err_t ret = esp_bsp_sdl_priv_draw_bitmap(x0, y0, x1, y1, data, &transfers);
+    if(s_trans_done) {
+        s_pending += transfers;
+    }
+    s_last_transfers = transfers;
+    return ret;
+}
+
+static void free_bands(void)
+{
+    wait_pending(0);
+    for(int i = 0; i < BAND_BUFFERS; i++) {
+        esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_FLUSH, s_band[i]);
+        s_band[i] = NULL;
+    }
+    s_band_width = 0;
+}
+
+static esp_err_t alloc_bands(int width)
+{
+    if(s_band_width == width) {
+        return ESP_OK;
+    }
+    free_bands();
+    for(int i = 0; i < BAND_BUFFERS; i++) {
+        s_band[i] = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_FLUSH,
+                                           width * TILE_SIZE * sizeof(uint16_t),
+                                           MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if(!s_band[i]) {
+            free_bands();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    s_band_width = width;
+    return ESP_OK;
+}
+
+static void free_buffers(void)
+{
+    free_bands();
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_FLUSH, s_shadow);
+    s_shadow = NULL;
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_FLUSH, s_tile_hash);
+    s_tile_hash = NULL;
+    s_history_valid = false;
+    s_width = 0;
+    s_height = 0;
+    s_alloc_mode = ESP_BSP_SDL_DIRTY_OFF;
+}
+
+static esp_err_t alloc_buffers(int width, int height, esp_bsp_sdl_dirty_mode_t mode)
+{
+    if(s_alloc_mode == mode && s_width == width && s_height == height) {
+        return ESP_OK;
+    }
+    free_buffers();
+
+    bool ok;
+    if(mode == ESP_BSP_SDL_DIRTY_SHADOW) {
+        const size_t frame_size = (size_t) width * height * sizeof(uint16_t);
+        s_shadow = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_FLUSH, frame_size, MALLOC_CAP_SPIRAM);
+        if(!s_shadow) {
+            s_shadow = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_FLUSH, frame_size, MALLOC_CAP_DEFAULT);
+        }
+        ok = s_shadow != NULL;
+    } else {
+        const size_t tiles = (size_t) ((width + TILE_SIZE - 1) / TILE_SIZE) * ((height + TILE_SIZE - 1) / TILE_SIZE);
+        s_tile_hash = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_FLUSH, tiles * sizeof(uint32_t), MALLOC_CAP_INTERNAL);
+        ok = s_tile_hash != NULL;
+    }
+
+    if(!ok || alloc_bands(width) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate auto-dirty buffers for %dx%d", width, height);
+        free_buffers();
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_width = width;
+    s_height = height;
+    s_alloc_mode = mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_set_dirty_mode(esp_bsp_sdl_dirty_mode_t mode)
+{
+    const esp_bsp_sdl_board_interface_t *board = esp_bsp_sdl_priv_get_board();
+    esp_lcd_panel_io_handle_t io = esp_bsp_sdl_priv_get_io();
+    if(!board || !io) {
+        ESP_LOGE(TAG, "Board not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if(mode == ESP_BSP_SDL_DIRTY_OFF) {
+        free_buffers();
+        s_mode = mode;
+        return ESP_OK;
+    }
+
+    if(mode != ESP_BSP_SDL_DIRTY_SHADOW && mode != ESP_BSP_SDL_DIRTY_TILE_HASH) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(!board->dbi) {
+        ESP_LOGW(TAG, "Auto-dirty mode needs a MIPI-DBI panel");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    esp_err_t ret = ensure_trans_done(io);
+    if(ret != ESP_OK) {
+        return ret;
+    }
+
+    int width;
+    int height;
+    esp_bsp_sdl_priv_get_logical_size(&width, &height);
+    ret = alloc_buffers(width, height, mode);
+    if(ret != ESP_OK) {
+        return ret;
+    }
+
+    s_mode = mode;
+    s_history_valid = false;
+    return ESP_OK;
+}
+
+// Word-wise compare of one tile, early exit on the first difference
+static bool tile_changed(const uint16_t *frame, const uint16_t *shadow, int stride, int width, int rows)
+{
+    for(int y = 0; y < rows; y++) {
+        const uint16_t *a = frame + y * stride;
+        const uint16_t *b = shadow + y * stride;
+        if((((uintptr_t) a | (uintptr_t) b) & 3) == 0) {
+            const uint32_t *wa = (const uint32_t *) a;
+            const uint32_t *wb = (const uint32_t *) b;
+            int x = 0;
+            for(; x < width / 2; x++) {
+                if(wa[x] != wb[x]) {
+                    return true;
+                }
+            }
+            if((width & 1) && a[width - 1] != b[width - 1]) {
+                return true;
+            }
+        } else if(memcmp(a, b, width * sizeof(uint16_t)) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 32-bit signature of one tile, every pixel contributes (no early exit possible)
+static uint32_t tile_hash(const uint16_t *frame, int stride, int width, int rows)
+{
+    uint32_t h = 0x811C9DC5u;
+    for(int y = 0; y < rows; y++) {
+        const uint16_t *p = frame + y * stride;
+        int x = 0;
+        for(; x + 1 < width; x += 2) {
+            h = (h ^ (p[x] | ((uint32_t) p[x + 1] << 16))) * 0x01000193u;
+            h ^= h >> 15;
+        }
+        if(x < width) {
+            h = (h ^ p[x]) * 0x01000193u;
+        }
+    }
+    return h;
+}
+
+// Copy a rectangle into the next band buffer (updating the shadow) and send it
+static esp_err_t send_rect(const uint16_t *frame, int stride, int x0, int y0, int x1, int y1)
+{
+    const int w = x1 - x0;
+    uint16_t *band = next_band();
+
+    for(int y = y0; y < y1; y++) {
+        const uint16_t *src = frame + y * stride + x0;
+        memcpy(band + (y - y0) * w, src, w * sizeof(uint16_t));
+        if(s_shadow) {
+            memcpy(s_shadow + y * stride + x0, src, w * sizeof(uint16_t));
+        }
+    }
+
+    return queue_draw(x0, y0, x1, y1, band);
+}
+
+static esp_err_t flush_tiles(const uint16_t *frame, esp_bsp_sdl_flush_stats_t *stats)
+{
+    esp_err_t ret = ESP_OK;
+    const int tiles_x = (s_width + TILE_SIZE - 1) / TILE_SIZE;
+    uint32_t *hash = s_tile_hash;
+
+    for(int y0 = 0; y0 < s_height && ret == ESP_OK; y0 += TILE_SIZE) {
+        const int rows = (s_height - y0) < TILE_SIZE ? (s_height - y0) : TILE_SIZE;
+        int first = -1;
+        int last = -1;
+
+        int64_t start = esp_timer_get_time();
+        for(int tx = 0; tx < tiles_x; tx++) {
+            const int x = tx * TILE_SIZE;
+            const int w = (s_width - x) < TILE_SIZE ? (s_width - x) : TILE_SIZE;
+            const size_t offset = (size_t) y0 * s_width + x;
+            bool dirty;
+            if(s_mode == ESP_BSP_SDL_DIRTY_TILE_HASH) {
+                // Hashes are refreshed even without history, they seed the next comparison
+                const uint32_t h = tile_hash(frame + offset, s_width, w, rows);
+                dirty = !s_history_valid || h != *hash;
+                *hash++ = h;
+            } else {
+                dirty = !s_history_valid || tile_changed(frame + offset, s_shadow + offset, s_width, w, rows);
+            }
+            stats->tiles_checked++;
+            if(dirty) {
+                stats->tiles_dirty++;
+                last = tx;
+                if(first < 0) {
+                    first = tx;
+                }
+            }
+        }
+        stats->diff_time_us += esp_timer_get_time() - start;
+
+        if(first < 0) {
+            stats->skipped_bytes += (uint64_t) s_width * rows * sizeof(uint16_t);
+            continue;
+        }
+
+        const int x0 = first * TILE_SIZE;
+        const int x1 = (last + 1) * TILE_SIZE < s_width ? (last + 1) * TILE_SIZE : s_width;
+        stats->skipped_bytes += (uint64_t) (s_width - (x1 - x0)) * rows * sizeof(uint16_t);
+        ret = send_rect(frame, s_width, x0, y0, x1, y0 + rows);
+    }
+
+    wait_pending(0);
+    s_history_valid = ret == ESP_OK;
+    return ret;
+}
+
+// Whole frame through the band buffers, so the panel IO never transfers from PSRAM
+static esp_err_t flush_bounced(const uint16_t *frame, int width, int height, esp_bsp_sdl_flush_stats_t *stats)
+{
+    esp_err_t ret = alloc_bands(width);
+    for(int y0 = 0; y0 < height && ret == ESP_OK; y0 += TILE_SIZE) {
+        const int rows = (height - y0) < TILE_SIZE ? (height - y0) : TILE_SIZE;
+        ret = send_rect(frame, width, 0, y0, width, y0 + rows);
+        if(ret == ESP_OK) {
+            stats->bounced_bytes += (uint64_t) width * rows * sizeof(uint16_t);
+        }
+    }
+    wait_pending(0);
+    return ret;
+}
+
+esp_err_t esp_bsp_sdl_flush_frame(const uint16_t *frame)
+{
+    if(!frame) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(!esp_bsp_sdl_priv_get_board() || !esp_bsp_sdl_priv_get_io()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int width;
+    int height;
+    esp_bsp_sdl_priv_get_logical_size(&width, &height);
+
+    const esp_bsp_sdl_board_interface_t *board = esp_bsp_sdl_priv_get_board();
+    esp_bsp_sdl_flush_stats_t *stats = esp_bsp_sdl_priv_get_stats();
+    const esp_bsp_sdl_flush_stats_t before = *stats;
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = ESP_OK;
+
+    if(board->dbi) {
+        ret = ensure_trans_done(esp_bsp_sdl_priv_get_io());
+        if(ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    if(s_mode == ESP_BSP_SDL_DIRTY_OFF && board->dbi && s_placement == ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE &&
+       !esp_ptr_dma_capable(frame)) {
+        ret = flush_bounced(frame, width, height, stats);
+    } else if(s_mode == ESP_BSP_SDL_DIRTY_OFF) {
+        ret = queue_draw(0, 0, width, height, frame);
+        wait_pending(0);
+    } else {
+        // Orientation changed since the mode was selected
+        ret = alloc_buffers(width, height, s_mode);
+        if(ret == ESP_OK) {
+            ret = flush_tiles(frame, stats);
+        }
+    }
+
+    stats->frames++;
+    stats->flush_time_us += esp_timer_get_time() - start;
+
+    // Captured after the flush, the encoding does not delay the panel
+    if(esp_bsp_sdl_capture_begin_frame(before.frames, start, width, height)) {
+        esp_bsp_sdl_capture_add_rows(frame, width, width, 0, height);
+        esp_bsp_sdl_capture_end_frame(&before, stats);
+    }
+    if(ret == ESP_OK && board->frame_presented) {
+        board->frame_presented();
+    }
+    return ret;
+}
+
+esp_err_t esp_bsp_sdl_flush_bands(esp_bsp_sdl_band_render_cb_t render, void *user_ctx)
+{
+    if(!render) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const esp_bsp_sdl_board_interface_t *board = esp_bsp_sdl_priv_get_board();
+    esp_lcd_panel_io_handle_t io = esp_bsp_sdl_priv_get_io();
+    if(!board || !io) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int width;
+    int height;
+    esp_bsp_sdl_priv_get_logical_size(&width, &height);
+    esp_bsp_sdl_flush_stats_t *stats = esp_bsp_sdl_priv_get_stats();
+    const esp_bsp_sdl_flush_stats_t before = *stats;
+    int64_t start = esp_timer_get_time();
+
+    esp_err_t ret = ESP_OK;
+    if(board->dbi) {
+        ret = ensure_trans_done(io);
+    }
+    if(ret == ESP_OK) {
+        ret = alloc_bands(width);
+    }
+    if(ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to prepare band flush: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    const int64_t capture_start = esp_timer_get_time();
+    const bool capture = esp_bsp_sdl_capture_begin_frame(before.frames, start, width, height);
+    start += esp_timer_get_time() - capture_start;
+
+    for(int y0 = 0; y0 < height && ret == ESP_OK; y0 += TILE_SIZE) {
+        const int rows = (height - y0) < TILE_SIZE ? (height - y0) : TILE_SIZE;
+        esp_bsp_sdl_surface_t band = {
+            .pixels = next_band(),
+            .width = width,
+            .height = rows,
+            .stride = width,
+        };
+
+        ret = render(&band, y0, user_ctx);
+        if(ret == ESP_OK) {
+            ret = queue_draw(0, y0, width, y0 + rows, band.pixels);
+        }
+        if(ret == ESP_OK && capture) {
+            // The band stays untouched until its transfer completed, encode it meanwhile
+            start += esp_bsp_sdl_capture_add_rows(band.pixels, width, width, y0, rows);
+        }
+    }
+
+    wait_pending(0);
+    // The panel no longer shows what the dirty history describes
+    s_history_valid = false;
+    stats->frames++;
+    stats->flush_time_us += esp_timer_get_time() - start;
+    if(capture) {
+        esp_bsp_sdl_capture_end_frame(&before, stats);
+    }
+    if(ret == ESP_OK && board->frame_presented) {
+        board->frame_presented();
+    }
+    return ret;
+}
+
+esp_err_t esp_bsp_sdl_flush_rects(const esp_bsp_sdl_rect_t *rects,
+                                  int count,
+                                  esp_bsp_sdl_rect_render_cb_t render,
+                                  void *user_ctx)
+{
+    if((!rects && count > 0) || count < 0 || !render) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const esp_bsp_sdl_board_interface_t *board = esp_bsp_sdl_priv_get_board();
+    esp_lcd_panel_io_handle_t io = esp_bsp_sdl_priv_get_io();
+    if(!board || !io) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int width;
+    int height;
+    esp_bsp_sdl_priv_get_logical_size(&width, &height);
+    for(int i = 0; i < count; i++) {
+        const esp_bsp_sdl_rect_t *r = &rects[i];
+        if(r->x < 0 || r->y < 0 || r->w <= 0 || r->h <= 0 || r->x + r->w > width || r->y + r->h > height ||
+           r->h > TILE_SIZE) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    esp_bsp_sdl_flush_stats_t *stats = esp_bsp_sdl_priv_get_stats();
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = ESP_OK;
+    if(board->dbi) {
+        ret = ensure_trans_done(io);
+    }
+    if(ret == ESP_OK && count > 0) {
+        ret = alloc_bands(width);
+    }
+    if(ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to prepare area flush: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    uint64_t sent = 0;
+    for(int i = 0; i < count && ret == ESP_OK; i++) {
+        const esp_bsp_sdl_rect_t *r = &rects[i];
+        esp_bsp_sdl_surface_t band = {
+            .pixels = next_band(),
+            .width = r->w,
+            .height = r->h,
+            .stride = r->w,
+        };
+
+        ret = render(&band, r, user_ctx);
+        if(ret == ESP_OK) {
+            ret = queue_draw(r->x, r->y, r->x + r->w, r->y + r->h, band.pixels);
+        }
+        if(ret == ESP_OK) {
+            sent += (uint64_t) r->w * r->h * sizeof(uint16_t);
+        }
+    }
+
+    wait_pending(0);
+    if(count > 0) {
+        // The panel no longer shows what the dirty history describes
+        s_history_valid = false;
+    }
+    // Overlapping areas are sent twice, the skipped part of the frame cannot go below zero
+    const uint64_t frame_bytes = (uint64_t) width * height * sizeof(uint16_t);
+    stats->skipped_bytes += sent < frame_bytes ? frame_bytes - sent : 0;
+    stats->frames++;
+    stats->flush_time_us += esp_timer_get_time() - start;
+    if(ret == ESP_OK && board->frame_presented) {
+        board->frame_presented();
+    }
+    return ret;
+}
+
+esp_err_t esp_bsp_sdl_flush_rows(const uint16_t *rows, int y_start, int y_end)
+{
+    const esp_bsp_sdl_board_interface_t *board = esp_bsp_sdl_priv_get_board();
+    esp_lcd_panel_io_handle_t io = esp_bsp_sdl_priv_get_io();
+    if(!board || !io) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int width;
+    int height;
+    esp_bsp_sdl_priv_get_logical_size(&width, &height);
+    esp_err_t ret = ESP_OK;
+    if(board->dbi) {
+        ret = ensure_trans_done(io);
+    }
+    if(ret != ESP_OK) {
+        return ret;
+    }
+
+    if(board->dbi && !esp_ptr_dma_capable(rows)) {
+        // Rows in PSRAM go through the band buffers, like flush_bounced()
+        esp_bsp_sdl_flush_stats_t *stats = esp_bsp_sdl_priv_get_stats();
+        ret = alloc_bands(width);
+        for(int y0 = y_start; y0 < y_end && ret == ESP_OK; y0 += TILE_SIZE) {
+            const int count = (y_end - y0) < TILE_SIZE ? (y_end - y0) : TILE_SIZE;
+            const size_t size = (size_t) width * count * sizeof(uint16_t);
+            uint16_t *band = next_band();
+            memcpy(band, rows + (size_t) (y0 - y_start) * width, size);
+            ret = queue_draw(0, y0, width, y0 + count, band);
+            if(ret == ESP_OK) {
+                stats->bounced_bytes += size;
+            }
+        }
+    } else {
+        ret = queue_draw(0, y_start, width, y_end, rows);
+    }
+    wait_pending(0);
+    return ret;
+}
+
+void esp_bsp_sdl_flush_track(int transfers)
+{
+    if(s_trans_done) {
+        s_pending += transfers;
+        // Room for the next draw, a completion given to a full semaphore would be lost
+        wait_pending(TRANS_DONE_MAX - ESP_BSP_SDL_SCROLL_MAX_SPANS);
+    }
+}
+
+esp_err_t esp_bsp_sdl_set_trans_done_callback(esp_lcd_panel_io_color_trans_done_cb_t cb, void *user_ctx)
+{
+    esp_lcd_panel_io_handle_t io = esp_bsp_sdl_priv_get_io();
+    if(!io) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Cleared first, our callback never pairs the new function with the old context
+    s_chained_cb = NULL;
+    s_chained_ctx = user_ctx;
+    s_chained_cb = cb;
+    if(s_trans_done) {
+        return ESP_OK;
+    }
+    // The flush engine has not taken over the panel IO yet
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = cb,
+    };
+    return esp_lcd_panel_io_register_event_callbacks(io, &cbs, user_ctx);
+}
+
+void esp_bsp_sdl_flush_invalidate_history(void)
+{
+    s_history_valid = false;
+}
+
+esp_err_t esp_bsp_sdl_set_placement(esp_bsp_sdl_placement_t placement)
+{
+    switch(placement) {
+        case ESP_BSP_SDL_PLACEMENT_AUTO:
+            s_placement = DEFAULT_PLACEMENT;
+            return ESP_OK;
+        case ESP_BSP_SDL_PLACEMENT_INTERNAL:
+        case ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE:
+            s_placement = placement;
+            return ESP_OK;
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+}
+
+esp_bsp_sdl_placement_t esp_bsp_sdl_get_placement(void)
+{
+    return s_placement;
+}
+
+size_t esp_bsp_sdl_priv_transfer_size(int width, int height)
+{
+    const size_t frame = (size_t) width * height * sizeof(uint16_t);
+#if !CONFIG_SDL_BSP_MIN_FOOTPRINT
+    if(DEFAULT_PLACEMENT != ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE) {
+        return frame;
+    }
+#endif
+    // A band spans the longer side, whatever orientation is selected later
+    const size_t band = (size_t) (width > height ? width : height) * TILE_SIZE * sizeof(uint16_t);
+    return band < frame ? band : frame;
+}
+
+void esp_bsp_sdl_flush_deinit(void)
+{
+    free_buffers();
+    s_mode = ESP_BSP_SDL_DIRTY_OFF;
+    s_placement = DEFAULT_PLACEMENT;
+    if(s_trans_done) {
+        // Hand the panel IO back to the application callback, if any
+        const esp_lcd_panel_io_callbacks_t cbs = {
+            .on_color_trans_done = s_chained_cb,
+        };
+        esp_lcd_panel_io_register_event_callbacks(esp_bsp_sdl_priv_get_io(), &cbs, s_chained_ctx);
+        vSemaphoreDelete(s_trans_done);
+        s_trans_done = NULL;
+    }
+    s_chained_cb = NULL;
+    s_chained_ctx = NULL;
+    s_pending = 0;
+    s_last_transfers = 0;
+}
@@ -0,0 +1,385 @@
+/**
+ * @file esp_bsp_sdl_glyph_cache.c
+ * @brief Glyph atlas cache and text rendering onto RGB565 surfaces
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl_blend.h"
+#include "esp_bsp_sdl_glyph_cache.h"
+#include "esp_bsp_sdl_mem.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define SLOT_NONE (-1)
+
+static const char *TAG = "esp_bsp_sdl_glyph";
+
+typedef struct {
+    uint32_t codepoint;
+    esp_bsp_sdl_glyph_metrics_t metrics;
+    int32_t lru_prev; // Towards most recently used
+    int32_t lru_next;
+    int32_t hash_next;
+    bool used;
+    bool missing; // The font has no such glyph: remembered so it is not rasterized on every draw
+} glyph_slot_t;
+
+struct esp_bsp_sdl_glyph_cache_t {
+    esp_bsp_sdl_glyph_cache_config_t config;
+    size_t slot_bytes;
+    size_t pixel_offset; // Row spans first, then 4bpp pixels
+    uint8_t *atlas;      // Slot data, PSRAM when available
+    glyph_slot_t *slots;
+    int32_t *buckets;
+    uint32_t bucket_mask;
+    int32_t lru_head; // Most recently used
+    int32_t lru_tail;
+    uint8_t *scratch; // 8-bit coverage from the rasterizer, then one unpacked row
+    esp_bsp_sdl_glyph_cache_stats_t stats;
+};
+
+static uint32_t hash_codepoint(const struct esp_bsp_sdl_glyph_cache_t *cache, uint32_t codepoint)
+{
+    uint32_t h = codepoint * 2654435761u;
+    return (h ^ (h >> 16)) & cache->bucket_mask;
+}
+
+static void lru_unlink(esp_bsp_sdl_glyph_cache_handle_t cache, int32_t index)
+{
+    glyph_slot_t *slot = &cache->slots[index];
+    if(slot->lru_prev != SLOT_NONE) {
+        cache->slots[slot->lru_prev].lru_next = slot->lru_next;
+    } else {
+        cache->lru_head = slot->lru_next;
+    }
+    if(slot->lru_next != SLOT_NONE) {
+        cache->slots[slot->lru_next].lru_prev = slot->lru_prev;
+    } else {
+        cache->lru_tail = slot->lru_prev;
+    }
+}
+
+static void lru_push_front(esp_bsp_sdl_glyph_cache_handle_t cache, int32_t index)
+{
+    glyph_slot_t *slot = &cache->slots[index];
+    slot->lru_prev = SLOT_NONE;
+    slot->lru_next = cache->lru_head;
+    if(cache->lru_head != SLOT_NONE) {
+        cache->slots[cache->lru_head].lru_prev = index;
+    }
+    cache->lru_head = index;
+    if(cache->lru_tail == SLOT_NONE) {
+        cache->lru_tail = index;
+    }
+}
+
+void esp_bsp_sdl_glyph_cache_clear(esp_bsp_sdl_glyph_cache_handle_t cache)
+{
+    if(!cache) {
+        return;
+    }
+    for(uint32_t b = 0; b <= cache->bucket_mask; b++) {
+        cache->buckets[b] = SLOT_NONE;
+    }
+    // All slots start free in the LRU list, the tail is taken first
+    cache->lru_head = SLOT_NONE;
+    cache->lru_tail = SLOT_NONE;
+    for(int32_t i = 0; i < cache->config.capacity; i++) {
+        cache->slots[i].used = false;
+        cache->slots[i].missing = false;
+        cache->slots[i].hash_next = SLOT_NONE;
+        lru_push_front(cache, i);
+    }
+}
+
+esp_err_t esp_bsp_sdl_glyph_cache_create(const esp_bsp_sdl_glyph_cache_config_t *config,
+                                         esp_bsp_sdl_glyph_cache_handle_t *ret_cache)
+{
+    if(!config || !ret_cache || !config->rasterize || config->capacity <= 0 || config->max_glyph_width <= 0 ||
+       config->max_glyph_width > 255 || config->max_glyph_height <= 0 || config->max_glyph_height > 255) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_bsp_sdl_glyph_cache_handle_t cache = esp_bsp_sdl_mem_calloc(ESP_BSP_SDL_MEM_RENDER, 1, sizeof(*cache), MALLOC_CAP_DEFAULT);
+    if(!cache) {
+        return ESP_ERR_NO_MEM;
+    }
+    cache->config = *config;
+
+    uint32_t buckets = 1;
+    while(buckets < (uint32_t) config->capacity) {
+        buckets <<= 1;
+    }
+    cache->bucket_mask = buckets - 1;
+    cache->pixel_offset = (size_t) config->max_glyph_height * 2;
+    cache->slot_bytes = cache->pixel_offset + (size_t) ((config->max_glyph_width + 1) / 2) * config->max_glyph_height;
+
+    const size_t atlas_size = cache->slot_bytes * config->capacity;
+    cache->atlas = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, atlas_size, MALLOC_CAP_SPIRAM);
+    if(!cache->atlas) {
+        cache->atlas = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, atlas_size, MALLOC_CAP_DEFAULT);
+    }
+    cache->slots = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, config->capacity * sizeof(glyph_slot_t), MALLOC_CAP_DEFAULT);
+    cache->buckets = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, buckets * sizeof(int32_t), MALLOC_CAP_DEFAULT);
+    cache->scratch = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER,
+                                            (size_t) config->max_glyph_width * config->max_glyph_height,
+                                            MALLOC_CAP_DEFAULT);
+    if(!cache->atlas || !cache->slots || !cache->buckets || !cache->scratch) {
+        ESP_LOGE(TAG, "Failed to allocate %d glyph slots (%u bytes)", config->capacity, (unsigned) atlas_size);
+        esp_bsp_sdl_glyph_cache_delete(cache);
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_bsp_sdl_glyph_cache_clear(cache);
+    *ret_cache = cache;
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_glyph_cache_delete(esp_bsp_sdl_glyph_cache_handle_t cache)
+{
+    if(!cache) {
+        return;
+    }
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, cache->atlas);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, cache->slots);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, cache->buckets);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, cache->scratch);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, cache);
+}
+
+static void hash_remove(esp_bsp_sdl_glyph_cache_handle_t cache, int32_t index)
+{
+    int32_t *link = &cache->buckets[hash_codepoint(cache, cache->slots[index].codepoint)];
+    while(*link != SLOT_NONE && *link != index) {
+        link = &cache->slots[*link].hash_next;
+    }
+    if(*link == index) {
+        *link = cache->slots[index].hash_next;
+    }
+}
+
+// Quantize 8-bit coverage to 4 bits and record the non-empty span of every row
+static void store_glyph(esp_bsp_sdl_glyph_cache_handle_t cache, uint8_t *slot_data, const esp_bsp_sdl_glyph_metrics_t *m)
+{
+    uint8_t *spans = slot_data;
+    uint8_t *pixels = slot_data + cache->pixel_offset;
+    const int row_bytes = (m->width + 1) / 2;
+
+    for(int y = 0; y < m->height; y++) {
+        const uint8_t *src = cache->scratch + y * m->width;
+        uint8_t *dst = pixels + y * row_bytes;
+        int first = m->width;
+        int last = -1;
+        memset(dst, 0, row_bytes);
+        for(int x = 0; x < m->width; x++) {
+            const uint8_t q = (src[x] * 15 + 127) / 255;
+            if(q) {
+                dst[x / 2] |= (x & 1) ? q : (q << 4);
+                first = x < first ? x : first;
+                last = x;
+            }
+        }
+        spans[y * 2] = last < 0 ? 0 : first;
+        spans[y * 2 + 1] = last + 1;
+    }
+}
+
+// Reuse the least recently used slot for a glyph that is not cached
+static int32_t claim_slot(esp_bsp_sdl_glyph_cache_handle_t cache, uint32_t codepoint, uint32_t bucket)
+{
+    const int32_t index = cache->lru_tail;
+    glyph_slot_t *slot = &cache->slots[index];
+    if(slot->used) {
+        hash_remove(cache, index);
+        cache->stats.evictions++;
+    }
+    slot->codepoint = codepoint;
+    slot->used = true;
+    slot->hash_next = cache->buckets[bucket];
+    cache->buckets[bucket] = index;
+    lru_unlink(cache, index);
+    lru_push_front(cache, index);
+    return index;
+}
+
+static esp_err_t lookup(esp_bsp_sdl_glyph_cache_handle_t cache, uint32_t codepoint, int32_t *ret_index)
+{
+    const uint32_t bucket = hash_codepoint(cache, codepoint);
+    for(int32_t i = cache->buckets[bucket]; i != SLOT_NONE; i = cache->slots[i].hash_next) {
+        if(cache->slots[i].codepoint == codepoint) {
+            lru_unlink(cache, i);
+            lru_push_front(cache, i);
+            cache->stats.hits++;
+            *ret_index = i;
+            return cache->slots[i].missing ? ESP_ERR_NOT_FOUND : ESP_OK;
+        }
+    }
+
+    // The scratch holds the largest configured glyph, the callback is told so and checked afterwards
+    const size_t scratch_size = (size_t) cache->config.max_glyph_width * cache->config.max_glyph_height;
+    esp_bsp_sdl_glyph_metrics_t metrics = {0};
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = cache->config.rasterize(codepoint, &metrics, cache->scratch, scratch_size, cache->config.user_ctx);
+    cache->stats.rasterize_time_us += esp_timer_get_time() - start;
+    if(ret == ESP_ERR_NOT_FOUND) {
+        cache->stats.misses++;
+        const int32_t index = claim_slot(cache, codepoint, bucket);
+        cache->slots[index].missing = true;
+        cache->slots[index].metrics = (esp_bsp_sdl_glyph_metrics_t) {0};
+        *ret_index = index;
+        return ret;
+    }
+    if(ret != ESP_OK) {
+        return ret;
+    }
+    if(metrics.width < 0 || metrics.height < 0 || metrics.width > cache->config.max_glyph_width ||
+       metrics.height > cache->config.max_glyph_height) {
+        ESP_LOGE(TAG,
+                 "Glyph U+%04X is %dx%d, larger than the configured maximum",
+                 (unsigned) codepoint,
+                 metrics.width,
+                 metrics.height);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    cache->stats.misses++;
+
+    const int32_t index = claim_slot(cache, codepoint, bucket);
+    cache->slots[index].missing = false;
+    cache->slots[index].metrics = metrics;
+    store_glyph(cache, cache->atlas + index * cache->slot_bytes, &metrics);
+
+    *ret_index = index;
+    return ESP_OK;
+}
+
+static void draw_glyph(esp_bsp_sdl_glyph_cache_handle_t cache,
+                       int32_t index,
+                       esp_bsp_sdl_surface_t *dst,
+                       int pen_x,
+                       int pen_y,
+                       uint16_t color,
+                       const esp_bsp_sdl_blend_kernels_t *blend)
+{
+    const esp_bsp_sdl_glyph_metrics_t *m = &cache->slots[index].metrics;
+    const uint8_t *spans = cache->atlas + index * cache->slot_bytes;
+    const uint8_t *pixels = spans + cache->pixel_offset;
+    const int row_bytes = (m->width + 1) / 2;
+    const int left = pen_x + m->bearing_x;
+    const int top = pen_y - m->bearing_y;
+    uint8_t *line = cache->scratch;
+
+    for(int y = 0; y < m->height; y++) {
+        const int dy = top + y;
+        if(dy < 0 || dy >= dst->height) {
+            continue;
+        }
+        // Only the non-empty span of the row, clipped to the surface
+        int x0 = spans[y * 2];
+        int x1 = spans[y * 2 + 1];
+        x0 = left + x0 < 0 ? -left : x0;
+        x1 = left + x1 > dst->width ? dst->width - left : x1;
+        if(x0 >= x1) {
+            continue;
+        }
+
+        const uint8_t *src = pixels + y * row_bytes;
+        for(int x = x0; x < x1; x++) {
+            const uint8_t q = (x & 1) ? (src[x / 2] & 0x0F) : (src[x / 2] >> 4);
+            line[x - x0] = q * 17;
+        }
+        blend->color_a8_over(dst->pixels + (size_t) dy * dst->stride + left + x0, color, line, x1 - x0);
+    }
+}
+
+static uint32_t next_codepoint(const char **text)
+{
+    const uint8_t *s = (const uint8_t *) *text;
+    uint32_t cp = *s++;
+    int extra = 0;
+    if(cp >= 0xF0) {
+        cp &= 0x07;
+        extra = 3;
+    } else if(cp >= 0xE0) {
+        cp &= 0x0F;
+        extra = 2;
+    } else if(cp >= 0xC0) {
+        cp &= 0x1F;
+        extra = 1;
+    } else if(cp >= 0x80) {
+        // Continuation byte without a lead byte
+        *text = (const char *) s;
+        return 0xFFFD;
+    }
+    for(; extra > 0 && (*s & 0xC0) == 0x80; extra--) {
+        cp = (cp << 6) | (*s++ & 0x3F);
+    }
+    *text = (const char *) s;
+    return extra ? 0xFFFD : cp;
+}
+
+static esp_err_t run_text(esp_bsp_sdl_glyph_cache_handle_t cache,
+                          esp_bsp_sdl_surface_t *dst,
+                          int x,
+                          int y,
+                          const char *text,
+                          uint16_t color,
+                          int *advance)
+{
+    const esp_bsp_sdl_blend_kernels_t *blend = esp_bsp_sdl_blend_get_kernels(ESP_BSP_SDL_BLEND_IMPL_AUTO);
+    int pen = x;
+
+    while(*text) {
+        const uint32_t codepoint = next_codepoint(&text);
+        int32_t index;
+        esp_err_t ret = lookup(cache, codepoint, &index);
+        if(ret == ESP_ERR_NOT_FOUND) {
+            continue;
+        }
+        if(ret != ESP_OK) {
+            return ret;
+        }
+        if(dst) {
+            draw_glyph(cache, index, dst, pen, y, color, blend);
+        }
+        pen += cache->slots[index].metrics.advance;
+    }
+
+    if(advance) {
+        *advance = pen - x;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_text_draw(esp_bsp_sdl_glyph_cache_handle_t cache,
+                                esp_bsp_sdl_surface_t *dst,
+                                int x,
+                                int y,
+                                const char *text,
+                                uint16_t color,
+                                int *advance)
+{
+    if(!cache || !dst || !dst->pixels || !text) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return run_text(cache, dst, x, y, text, color, advance);
+}
+
+esp_err_t esp_bsp_sdl_text_measure(esp_bsp_sdl_glyph_cache_handle_t cache, const char *text, int *advance)
+{
+    if(!cache || !text || !advance) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return run_text(cache, NULL, 0, 0, text, 0, advance);
+}
+
+esp_err_t esp_bsp_sdl_glyph_cache_get_stats(esp_bsp_sdl_glyph_cache_handle_t cache,
+                                            esp_bsp_sdl_glyph_cache_stats_t *stats)
+{
+    if(!cache || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = cache->stats;
+    return ESP_OK;
+}
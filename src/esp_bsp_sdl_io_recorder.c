@@ -0,0 +1,285 @@
+/**
+ * @file esp_bsp_sdl_io_recorder.c
+ * @brief Panel IO command-stream recorder
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "esp_bsp_sdl_io_recorder.h"
+#include "esp_bsp_sdl_mem.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_commands.h"
+#include "esp_lcd_panel_io_interface.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "esp_bsp_sdl_io_rec";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_lcd_panel_io_t *s_io = NULL;
+static esp_lcd_panel_io_t s_orig;  // Original function pointers of s_io
+static esp_bsp_sdl_io_rec_entry_t *s_entries = NULL;
+static size_t s_capacity = 0;
+static size_t s_head = 0;  // Next slot to write
+static size_t s_count = 0;
+static size_t s_oversized_threshold = 0;
+static esp_bsp_sdl_io_rec_summary_t s_summary;
+static uint8_t s_last_caset[4];
+static uint8_t s_last_raset[4];
+static bool s_have_caset = false;
+static bool s_have_raset = false;
+
+static void record(esp_bsp_sdl_io_rec_kind_t kind,
+                   int cmd,
+                   const void *param,
+                   size_t size,
+                   int64_t start,
+                   int64_t end)
+{
+    esp_bsp_sdl_io_rec_entry_t entry = {
+        .timestamp_us = start,
+        .duration_us = (uint32_t) (end - start),
+        .cmd = cmd,
+        .size = (uint32_t) size,
+        .kind = (uint8_t) kind,
+    };
+    if(kind == ESP_BSP_SDL_IO_REC_TX_PARAM && param) {
+        entry.param_len = size < ESP_BSP_SDL_IO_REC_MAX_PARAM ? size : ESP_BSP_SDL_IO_REC_MAX_PARAM;
+        memcpy(entry.param, param, entry.param_len);
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    if(s_entries) {
+        s_entries[s_head] = entry;
+        s_head = (s_head + 1) % s_capacity;
+        if(s_count < s_capacity) {
+            s_count++;
+        } else {
+            s_summary.dropped++;
+        }
+    }
+
+    if(kind == ESP_BSP_SDL_IO_REC_TX_COLOR) {
+        s_summary.color_bytes += size;
+        if(s_oversized_threshold && size > s_oversized_threshold) {
+            s_summary.oversized_color++;
+        }
+    } else if(kind == ESP_BSP_SDL_IO_REC_TX_PARAM) {
+        s_summary.param_bytes += size;
+        if((cmd == LCD_CMD_CASET || cmd == LCD_CMD_RASET) && param && size == 4) {
+            uint8_t *last = cmd == LCD_CMD_CASET ? s_last_caset : s_last_raset;
+            bool *have = cmd == LCD_CMD_CASET ? &s_have_caset : &s_have_raset;
+            if(*have && memcmp(last, param, 4) == 0) {
+                if(cmd == LCD_CMD_CASET) {
+                    s_summary.redundant_caset++;
+                } else {
+                    s_summary.redundant_raset++;
+                }
+            }
+            memcpy(last, param, 4);
+            *have = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static esp_err_t rec_tx_param(esp_lcd_panel_io_t *io, int lcd_cmd, const void *param, size_t param_size)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = s_orig.tx_param(io, lcd_cmd, param, param_size);
+    record(ESP_BSP_SDL_IO_REC_TX_PARAM, lcd_cmd, param, param_size, start, esp_timer_get_time());
+    return ret;
+}
+
+static esp_err_t rec_tx_color(esp_lcd_panel_io_t *io, int lcd_cmd, const void *color, size_t color_size)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = s_orig.tx_color(io, lcd_cmd, color, color_size);
+    record(ESP_BSP_SDL_IO_REC_TX_COLOR, lcd_cmd, NULL, color_size, start, esp_timer_get_time());
+    return ret;
+}
+
+static esp_err_t rec_rx_param(esp_lcd_panel_io_t *io, int lcd_cmd, void *param, size_t param_size)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = s_orig.rx_param(io, lcd_cmd, param, param_size);
+    record(ESP_BSP_SDL_IO_REC_RX_PARAM, lcd_cmd, NULL, param_size, start, esp_timer_get_time());
+    return ret;
+}
+
+esp_err_t esp_bsp_sdl_io_recorder_start(esp_lcd_panel_io_handle_t io, size_t capacity, size_t oversized_threshold)
+{
+    if(!io || capacity == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(s_io) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if(s_capacity != capacity) {
+        esp_bsp_sdl_io_recorder_free();
+        s_entries = esp_bsp_sdl_mem_calloc(ESP_BSP_SDL_MEM_TOOLS,
+                                           capacity,
+                                           sizeof(esp_bsp_sdl_io_rec_entry_t),
+                                           MALLOC_CAP_DEFAULT);
+        if(!s_entries) {
+            ESP_LOGE(TAG, "Failed to allocate %u recorder entries", (unsigned) capacity);
+            return ESP_ERR_NO_MEM;
+        }
+        s_capacity = capacity;
+        esp_bsp_sdl_io_recorder_clear();
+    }
+    s_oversized_threshold = oversized_threshold;
+
+    // Hook the IO in place: the panel driver keeps calling through the same handle
+    s_io = io;
+    s_orig = *io;
+    io->tx_param = rec_tx_param;
+    io->tx_color = rec_tx_color;
+    if(io->rx_param) {
+        io->rx_param = rec_rx_param;
+    }
+
+    ESP_LOGI(TAG, "Recording panel IO (%u entries)", (unsigned) capacity);
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_io_recorder_stop(void)
+{
+    if(!s_io) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_io->tx_param = s_orig.tx_param;
+    s_io->tx_color = s_orig.tx_color;
+    s_io->rx_param = s_orig.rx_param;
+    s_io = NULL;
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_io_recorder_clear(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_head = 0;
+    s_count = 0;
+    memset(&s_summary, 0, sizeof(s_summary));
+    s_have_caset = false;
+    s_have_raset = false;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void esp_bsp_sdl_io_recorder_free(void)
+{
+    if(s_io) {
+        esp_bsp_sdl_io_recorder_stop();
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    esp_bsp_sdl_io_rec_entry_t *entries = s_entries;
+    s_entries = NULL;
+    s_capacity = 0;
+    s_head = 0;
+    s_count = 0;
+    portEXIT_CRITICAL(&s_lock);
+
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_TOOLS, entries);
+}
+
+esp_err_t esp_bsp_sdl_io_recorder_get_entry(size_t index, esp_bsp_sdl_io_rec_entry_t *entry)
+{
+    if(!entry) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&s_lock);
+    if(index >= s_count) {
+        ret = ESP_ERR_NOT_FOUND;
+    } else {
+        size_t oldest = (s_head + s_capacity - s_count) % s_capacity;
+        *entry = s_entries[(oldest + index) % s_capacity];
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ret;
+}
+
+void esp_bsp_sdl_io_recorder_get_summary(esp_bsp_sdl_io_rec_summary_t *summary)
+{
+    if(!summary) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *summary = s_summary;
+    summary->entries = s_count;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t esp_bsp_sdl_io_recorder_dump(FILE *out, bool with_timing)
+{
+    static const char *const kind_names[] = {"TX_PARAM", "TX_COLOR", "RX_PARAM"};
+
+    if(!out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_bsp_sdl_io_rec_entry_t entry;
+    for(size_t i = 0; esp_bsp_sdl_io_recorder_get_entry(i, &entry) == ESP_OK; i++) {
+        if(with_timing) {
+            fprintf(out, "%" PRId64 " %" PRIu32 " ", entry.timestamp_us, entry.duration_us);
+        }
+        fprintf(out, "%s 0x%02" PRIX32 " %" PRIu32, kind_names[entry.kind], (uint32_t) entry.cmd, entry.size);
+        for(int p = 0; p < entry.param_len; p++) {
+            fprintf(out, " %02X", entry.param[p]);
+        }
+        fputc('\n', out);
+    }
+
+    esp_bsp_sdl_io_rec_summary_t summary;
+    esp_bsp_sdl_io_recorder_get_summary(&summary);
+    fprintf(out, "# entries %" PRIu32 " dropped %" PRIu32 "\n", summary.entries, summary.dropped);
+    fprintf(out,
+            "# redundant CASET %" PRIu32 " RASET %" PRIu32 "\n",
+            summary.redundant_caset,
+            summary.redundant_raset);
+    fprintf(out,
+            "# color bytes %" PRIu64 " param bytes %" PRIu64 " oversized color %" PRIu32 "\n",
+            summary.color_bytes,
+            summary.param_bytes,
+            summary.oversized_color);
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_io_recorder_capture_init(esp_lcd_panel_handle_t panel,
+                                               esp_lcd_panel_io_handle_t io,
+                                               size_t capacity)
+{
+    if(!panel || !io) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(s_io != io) {
+        esp_err_t ret = esp_bsp_sdl_io_recorder_start(io, capacity, 0);
+        if(ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    esp_err_t ret = esp_lcd_panel_reset(panel);
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_init(panel);
+    }
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_disp_on_off(panel, true);
+    }
+    if(ret != ESP_OK) {
+        ESP_LOGE(TAG, "Panel re-init failed: %s", esp_err_to_name(ret));
+    }
+
+    // The controller forgot its window, scroll area and content, so must the flush state
+    esp_bsp_sdl_invalidate_window();
+    esp_bsp_sdl_scroll_deinit();
+    esp_bsp_sdl_flush_invalidate_history();
+    return ret;
+}
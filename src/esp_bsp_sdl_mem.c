@@ -0,0 +1,278 @@
+/**
+ * @file esp_bsp_sdl_mem.c
+ * @brief Heap and PSRAM accounting per subsystem
+ */
+
+#include <string.h>
+#include "esp_bsp_sdl_mem.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_memory_utils.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+#if CONFIG_SDL_BSP_MIN_FOOTPRINT
+#    define MEM_BUDGET CONFIG_SDL_BSP_MEM_BUDGET
+#else
+#    define MEM_BUDGET 0
+#endif
+
+static const char *TAG = "esp_bsp_sdl_mem";
+
+static const char *const s_subsys_names[ESP_BSP_SDL_MEM_SUBSYS_MAX] = {"panel", "touch", "flush", "render", "tools"};
+
+// Heap capabilities of the classes for the free heap figures
+static const uint32_t s_class_caps[ESP_BSP_SDL_MEM_CLASS_MAX] = {
+    [ESP_BSP_SDL_MEM_INTERNAL_DMA] = MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL,
+    [ESP_BSP_SDL_MEM_INTERNAL] = MALLOC_CAP_INTERNAL,
+    [ESP_BSP_SDL_MEM_PSRAM] = MALLOC_CAP_SPIRAM,
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static size_t s_current[ESP_BSP_SDL_MEM_SUBSYS_MAX][ESP_BSP_SDL_MEM_CLASS_MAX];
+static size_t s_peak[ESP_BSP_SDL_MEM_SUBSYS_MAX][ESP_BSP_SDL_MEM_CLASS_MAX];
+static size_t s_total[ESP_BSP_SDL_MEM_CLASS_MAX];
+static size_t s_total_peak[ESP_BSP_SDL_MEM_CLASS_MAX];
+static uint32_t s_budget_denied = 0;
+
+// Classified by address, so that allocation and free agree whatever caps were requested
+static esp_bsp_sdl_mem_class_t classify(const void *ptr)
+{
+    if(esp_ptr_external_ram(ptr)) {
+        return ESP_BSP_SDL_MEM_PSRAM;
+    }
+    return esp_ptr_dma_capable(ptr) ? ESP_BSP_SDL_MEM_INTERNAL_DMA : ESP_BSP_SDL_MEM_INTERNAL;
+}
+
+static void book(esp_bsp_sdl_mem_subsys_t subsys, esp_bsp_sdl_mem_class_t cls, size_t size, bool add)
+{
+    portENTER_CRITICAL(&s_lock);
+    if(add) {
+        s_current[subsys][cls] += size;
+        s_total[cls] += size;
+        if(s_current[subsys][cls] > s_peak[subsys][cls]) {
+            s_peak[subsys][cls] = s_current[subsys][cls];
+        }
+        if(s_total[cls] > s_total_peak[cls]) {
+            s_total_peak[cls] = s_total[cls];
+        }
+    } else {
+        size = size < s_current[subsys][cls] ? size : s_current[subsys][cls];
+        s_current[subsys][cls] -= size;
+        s_total[cls] -= size;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static size_t held_bytes(void)
+{
+    size_t held = 0;
+    for(int c = 0; c < ESP_BSP_SDL_MEM_CLASS_MAX; c++) {
+        held += s_total[c];
+    }
+    return held;
+}
+
+// Refuse allocations that would take everything booked, measured ones included, over the budget
+static bool budget_allows(esp_bsp_sdl_mem_subsys_t subsys, size_t size)
+{
+#if MEM_BUDGET
+    portENTER_CRITICAL(&s_lock);
+    const size_t held = held_bytes();
+    const bool allowed = held + size <= MEM_BUDGET;
+    if(!allowed) {
+        s_budget_denied++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if(!allowed) {
+        ESP_LOGW(TAG,
+                 "%s: %u bytes denied, %u of %u budget bytes held",
+                 subsys < ESP_BSP_SDL_MEM_SUBSYS_MAX ? s_subsys_names[subsys] : "?",
+                 (unsigned) size,
+                 (unsigned) held,
+                 (unsigned) MEM_BUDGET);
+    }
+    return allowed;
+#else
+    return true;
+#endif
+}
+
+static void *book_alloc(esp_bsp_sdl_mem_subsys_t subsys, void *ptr)
+{
+    if(ptr && subsys < ESP_BSP_SDL_MEM_SUBSYS_MAX) {
+        book(subsys, classify(ptr), heap_caps_get_allocated_size(ptr), true);
+    }
+    return ptr;
+}
+
+void *esp_bsp_sdl_mem_malloc(esp_bsp_sdl_mem_subsys_t subsys, size_t size, uint32_t caps)
+{
+    if(!budget_allows(subsys, size)) {
+        return NULL;
+    }
+    return book_alloc(subsys, heap_caps_malloc(size, caps));
+}
+
+void *esp_bsp_sdl_mem_calloc(esp_bsp_sdl_mem_subsys_t subsys, size_t n, size_t size, uint32_t caps)
+{
+    if(!budget_allows(subsys, n * size)) {
+        return NULL;
+    }
+    return book_alloc(subsys, heap_caps_calloc(n, size, caps));
+}
+
+void *esp_bsp_sdl_mem_aligned_alloc(esp_bsp_sdl_mem_subsys_t subsys, size_t alignment, size_t size, uint32_t caps)
+{
+    if(!budget_allows(subsys, size)) {
+        return NULL;
+    }
+    return book_alloc(subsys, heap_caps_aligned_alloc(alignment, size, caps));
+}
+
+void *esp_bsp_sdl_mem_realloc(esp_bsp_sdl_mem_subsys_t subsys, void *ptr, size_t size, uint32_t caps)
+{
+    if(!ptr) {
+        return esp_bsp_sdl_mem_malloc(subsys, size, caps);
+    }
+    const size_t old_size = heap_caps_get_allocated_size(ptr);
+    if(size > old_size && !budget_allows(subsys, size - old_size)) {
+        return NULL;
+    }
+    const esp_bsp_sdl_mem_class_t old_cls = classify(ptr);
+    void *moved = heap_caps_realloc(ptr, size, caps);
+    if(moved && subsys < ESP_BSP_SDL_MEM_SUBSYS_MAX) {
+        book(subsys, old_cls, old_size, false);
+        book(subsys, classify(moved), heap_caps_get_allocated_size(moved), true);
+    }
+    return moved;
+}
+
+void esp_bsp_sdl_mem_free(esp_bsp_sdl_mem_subsys_t subsys, void *ptr)
+{
+    if(!ptr) {
+        return;
+    }
+    if(subsys < ESP_BSP_SDL_MEM_SUBSYS_MAX) {
+        book(subsys, classify(ptr), heap_caps_get_allocated_size(ptr), false);
+    }
+    heap_caps_free(ptr);
+}
+
+void esp_bsp_sdl_mem_measure_begin(esp_bsp_sdl_mem_mark_t *mark)
+{
+    portENTER_CRITICAL(&s_lock);
+    memcpy(mark->booked, s_total, sizeof(s_total));
+    portEXIT_CRITICAL(&s_lock);
+    for(int c = 0; c < ESP_BSP_SDL_MEM_CLASS_MAX; c++) {
+        mark->free[c] = heap_caps_get_free_size(s_class_caps[c]);
+    }
+}
+
+void esp_bsp_sdl_mem_measure_end(esp_bsp_sdl_mem_subsys_t subsys, const esp_bsp_sdl_mem_mark_t *mark)
+{
+    size_t used[ESP_BSP_SDL_MEM_CLASS_MAX];
+    for(int c = 0; c < ESP_BSP_SDL_MEM_CLASS_MAX; c++) {
+        const size_t now = heap_caps_get_free_size(s_class_caps[c]);
+        used[c] = mark->free[c] > now ? mark->free[c] - now : 0;
+    }
+    // The internal figures include DMA-capable memory, book only the rest as plain internal
+    used[ESP_BSP_SDL_MEM_INTERNAL] = used[ESP_BSP_SDL_MEM_INTERNAL] > used[ESP_BSP_SDL_MEM_INTERNAL_DMA]
+                                         ? used[ESP_BSP_SDL_MEM_INTERNAL] - used[ESP_BSP_SDL_MEM_INTERNAL_DMA]
+                                         : 0;
+    // Hooked allocations in the window are booked already, e.g. the virtual panel RAM
+    portENTER_CRITICAL(&s_lock);
+    for(int c = 0; c < ESP_BSP_SDL_MEM_CLASS_MAX; c++) {
+        const size_t hooked = s_total[c] > mark->booked[c] ? s_total[c] - mark->booked[c] : 0;
+        used[c] = used[c] > hooked ? used[c] - hooked : 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    for(int c = 0; c < ESP_BSP_SDL_MEM_CLASS_MAX; c++) {
+        if(used[c]) {
+            book(subsys, c, used[c], true);
+        }
+    }
+}
+
+void esp_bsp_sdl_mem_release(esp_bsp_sdl_mem_subsys_t subsys)
+{
+    portENTER_CRITICAL(&s_lock);
+    for(int c = 0; c < ESP_BSP_SDL_MEM_CLASS_MAX; c++) {
+        s_total[c] -= s_current[subsys][c];
+        s_current[subsys][c] = 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t esp_bsp_sdl_mem_get_snapshot(esp_bsp_sdl_mem_snapshot_t *snapshot)
+{
+    if(!snapshot) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_lock);
+    memcpy(snapshot->current, s_current, sizeof(s_current));
+    memcpy(snapshot->peak, s_peak, sizeof(s_peak));
+    memcpy(snapshot->total_peak, s_total_peak, sizeof(s_total_peak));
+    snapshot->held = held_bytes();
+    snapshot->budget_denied = s_budget_denied;
+    portEXIT_CRITICAL(&s_lock);
+    snapshot->budget = MEM_BUDGET;
+
+    for(int c = 0; c < ESP_BSP_SDL_MEM_CLASS_MAX; c++) {
+        snapshot->heap_free[c] = heap_caps_get_free_size(s_class_caps[c]);
+        snapshot->heap_min_free[c] = heap_caps_get_minimum_free_size(s_class_caps[c]);
+    }
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_mem_reset_peaks(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    memcpy(s_peak, s_current, sizeof(s_peak));
+    memcpy(s_total_peak, s_total, sizeof(s_total_peak));
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void esp_bsp_sdl_mem_log(void)
+{
+    esp_bsp_sdl_mem_snapshot_t snap;
+    esp_bsp_sdl_mem_get_snapshot(&snap);
+
+    ESP_LOGI(TAG, "Bytes now/peak   internal DMA      internal         PSRAM");
+    for(int s = 0; s < ESP_BSP_SDL_MEM_SUBSYS_MAX; s++) {
+        ESP_LOGI(TAG,
+                 "  %-8s %8u/%-8u %7u/%-8u %7u/%-8u",
+                 s_subsys_names[s],
+                 (unsigned) snap.current[s][ESP_BSP_SDL_MEM_INTERNAL_DMA],
+                 (unsigned) snap.peak[s][ESP_BSP_SDL_MEM_INTERNAL_DMA],
+                 (unsigned) snap.current[s][ESP_BSP_SDL_MEM_INTERNAL],
+                 (unsigned) snap.peak[s][ESP_BSP_SDL_MEM_INTERNAL],
+                 (unsigned) snap.current[s][ESP_BSP_SDL_MEM_PSRAM],
+                 (unsigned) snap.peak[s][ESP_BSP_SDL_MEM_PSRAM]);
+    }
+    ESP_LOGI(TAG,
+             "  peak     %8u          %7u          %7u",
+             (unsigned) snap.total_peak[ESP_BSP_SDL_MEM_INTERNAL_DMA],
+             (unsigned) snap.total_peak[ESP_BSP_SDL_MEM_INTERNAL],
+             (unsigned) snap.total_peak[ESP_BSP_SDL_MEM_PSRAM]);
+    ESP_LOGI(TAG,
+             "Heap free (min): internal DMA %u (%u), internal %u (%u), PSRAM %u (%u)",
+             (unsigned) snap.heap_free[ESP_BSP_SDL_MEM_INTERNAL_DMA],
+             (unsigned) snap.heap_min_free[ESP_BSP_SDL_MEM_INTERNAL_DMA],
+             (unsigned) snap.heap_free[ESP_BSP_SDL_MEM_INTERNAL],
+             (unsigned) snap.heap_min_free[ESP_BSP_SDL_MEM_INTERNAL],
+             (unsigned) snap.heap_free[ESP_BSP_SDL_MEM_PSRAM],
+             (unsigned) snap.heap_min_free[ESP_BSP_SDL_MEM_PSRAM]);
+    if(snap.budget) {
+        ESP_LOGI(TAG,
+                 "Footprint: %u of %u budget bytes held, %u allocations denied",
+                 (unsigned) snap.held,
+                 (unsigned) snap.budget,
+                 (unsigned) snap.budget_denied);
+        if(snap.held > snap.budget) {
+            ESP_LOGW(TAG, "Board and touch init alone exceed the budget");
+        }
+    }
+}
@@ -0,0 +1,332 @@
+/**
+ * @file esp_bsp_sdl_priv.h
+ * @brief Private helpers shared between the common layer and board implementations
+ */
+
+#pragma once
+
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_mem.h"
+
+// Vendor gamma commands shared by ILI9341/ILI9342/ST7789, not part of esp_lcd_panel_commands.h
+#define LCD_CMD_PGAMCTRL 0xE0
+#define LCD_CMD_NGAMCTRL 0xE1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Apply an orientation through the panel driver (swap_xy + mirror)
+ *
+ * On MIPI-DBI controllers (ILI9341, ST7789, GC9A01, ...) this programs MADCTL, on RGB panels the
+ * esp_lcd driver rotates while copying into its frame buffer.
+ *
+ * @param panel Panel handle
+ * @param orientation Requested orientation
+ * @param mirror_x Mirror X state the BSP applied for ESP_BSP_SDL_ORIENTATION_0
+ * @param mirror_y Mirror Y state the BSP applied for ESP_BSP_SDL_ORIENTATION_0
+ * @return ESP_OK on success, error code from esp_lcd otherwise
+ */
+esp_err_t esp_bsp_sdl_panel_apply_orientation(esp_lcd_panel_handle_t panel,
+                                              esp_bsp_sdl_orientation_t orientation,
+                                              bool mirror_x,
+                                              bool mirror_y);
+
+/**
+ * @brief MIPI-DBI address offsets and mirroring in an orientation
+ *
+ * esp_lcd adds the gaps to host coordinates before MADCTL maps them to controller RAM, so swapping
+ * or mirroring moves a visible area that is not centred in RAM. Derives the gaps that address it
+ * again from the RAM size, and the MADCTL mirroring the orientation ends up with.
+ *
+ * @param native Board description of the native orientation
+ * @param native_width Native display width
+ * @param native_height Native display height
+ * @param orientation Orientation
+ * @param[out] current Description for the orientation, gaps unchanged without RAM size
+ */
+void esp_bsp_sdl_dbi_orient(const esp_bsp_sdl_dbi_info_t *native,
+                            int native_width,
+                            int native_height,
+                            esp_bsp_sdl_orientation_t orientation,
+                            esp_bsp_sdl_dbi_info_t *current);
+
+/**
+ * @brief Whether an orientation swaps display width and height
+ */
+static inline bool esp_bsp_sdl_orientation_swaps_axes(esp_bsp_sdl_orientation_t orientation)
+{
+    return orientation == ESP_BSP_SDL_ORIENTATION_90 || orientation == ESP_BSP_SDL_ORIENTATION_270;
+}
+
+/**
+ * @brief Software rotation blit of an RGB565 rectangle into a native frame buffer
+ *
+ * @param fb Native frame buffer (native_width x native_height RGB565 pixels)
+ * @param native_width Native panel width
+ * @param native_height Native panel height
+ * @param orientation Logical orientation
+ * @param x_start Logical start column
+ * @param y_start Logical start row
+ * @param x_end Logical end column (exclusive)
+ * @param y_end Logical end row (exclusive)
+ * @param src Source pixels, (x_end - x_start) * (y_end - y_start) RGB565 values
+ */
+void esp_bsp_sdl_rotate_blit_rgb565(uint16_t *fb,
+                                    int native_width,
+                                    int native_height,
+                                    esp_bsp_sdl_orientation_t orientation,
+                                    int x_start,
+                                    int y_start,
+                                    int x_end,
+                                    int y_end,
+                                    const uint16_t *src);
+
+/**
+ * @brief Board selected by esp_bsp_sdl_init(), NULL before init
+ */
+const esp_bsp_sdl_board_interface_t *esp_bsp_sdl_priv_get_board(void);
+
+/**
+ * @brief MIPI-DBI description of the board in the current orientation, NULL for other panels
+ */
+const esp_bsp_sdl_dbi_info_t *esp_bsp_sdl_priv_get_dbi(void);
+
+/**
+ * @brief Panel IO handle returned by the board, NULL before init
+ */
+esp_lcd_panel_io_handle_t esp_bsp_sdl_priv_get_io(void);
+
+/**
+ * @brief Current display size in logical (oriented) coordinates
+ */
+void esp_bsp_sdl_priv_get_logical_size(int *width, int *height);
+
+/**
+ * @brief Flush statistics owned by the common layer
+ */
+esp_bsp_sdl_flush_stats_t *esp_bsp_sdl_priv_get_stats(void);
+
+/**
+ * @brief max_transfer_sz for a board under the placement policy selected in menuconfig
+ *
+ * Full frame for ESP_BSP_SDL_PLACEMENT_INTERNAL, one band of ESP_BSP_SDL_FLUSH_BAND_ROWS rows for
+ * ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE and in the minimal-footprint profile (esp_lcd splits larger
+ * color transfers into chunks).
+ */
+size_t esp_bsp_sdl_priv_transfer_size(int width, int height);
+
+/**
+ * @brief esp_bsp_sdl_draw_bitmap() reporting the color transfers it queued
+ *
+ * @param[out] transfers Color transfers queued, each reports its completion; up to
+ *             ESP_BSP_SDL_SCROLL_MAX_SPANS on a scrolled panel, also set on failure
+ */
+esp_err_t esp_bsp_sdl_priv_draw_bitmap(int x_start,
+                                       int y_start,
+                                       int x_end,
+                                       int y_end,
+                                       const void *color_data,
+                                       int *transfers);
+
+/**
+ * @brief Draw full-width rows and wait until the panel has taken them
+ *
+ * Rows that are not DMA-capable are sent through the band buffers on MIPI-DBI panels.
+ *
+ * @param rows Pixels, (y_end - y_start) full-width rows
+ * @param y_start First logical row
+ * @param y_end End logical row (exclusive)
+ */
+esp_err_t esp_bsp_sdl_flush_rows(const uint16_t *rows, int y_start, int y_end);
+
+/**
+ * @brief Render callback of esp_bsp_sdl_flush_rects()
+ *
+ * @param band Band to fill completely, the size of rect
+ * @param rect Display area of the band
+ * @param user_ctx User context
+ * @return ESP_OK to send the band, error code to stop the flush
+ */
+typedef esp_err_t (*esp_bsp_sdl_rect_render_cb_t)(esp_bsp_sdl_surface_t *band,
+                                                  const esp_bsp_sdl_rect_t *rect,
+                                                  void *user_ctx);
+
+/**
+ * @brief Present display areas rendered into the band buffers, like esp_bsp_sdl_flush_bands()
+ *
+ * Counts as one frame in the flush stats, the rest of the display as skipped bytes. Partial
+ * frames are not captured.
+ *
+ * @param rects Areas in logical coordinates, at most ESP_BSP_SDL_FLUSH_BAND_ROWS rows each
+ * @param count Number of areas, 0 only counts the frame
+ * @param render Band render callback
+ * @param user_ctx Context for the callback
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an area outside the display or higher than a
+ *         band, error code otherwise
+ */
+esp_err_t esp_bsp_sdl_flush_rects(const esp_bsp_sdl_rect_t *rects,
+                                  int count,
+                                  esp_bsp_sdl_rect_render_cb_t render,
+                                  void *user_ctx);
+
+/**
+ * @brief Count color transfers queued outside the flush engine
+ *
+ * Their completions are signalled like the engine's own, uncounted they would end its waits early.
+ *
+ * @param transfers Color transfers queued by a draw
+ */
+void esp_bsp_sdl_flush_track(int transfers);
+
+/**
+ * @brief Forget the auto-dirty history after the panel content moved
+ */
+void esp_bsp_sdl_flush_invalidate_history(void);
+
+/**
+ * @brief Release flush engine resources, called from esp_bsp_sdl_deinit()
+ */
+void esp_bsp_sdl_flush_deinit(void);
+
+/**
+ * @brief Release the fill/copy DMA engine, called from esp_bsp_sdl_deinit()
+ */
+void esp_bsp_sdl_dma_deinit(void);
+
+/**
+ * @brief Most row spans a draw is split into on a scrolled panel
+ *
+ * Fixed top rows, the scroll area in two parts around the wrap and fixed bottom rows.
+ */
+#define ESP_BSP_SDL_SCROLL_MAX_SPANS 4
+
+/**
+ * @brief Logical rows of a draw and the controller row they are written to
+ */
+typedef struct {
+    int y_start; /*!< First logical row */
+    int y_end;   /*!< End logical row (exclusive) */
+    int panel_y; /*!< Row the first logical row is addressed at */
+} esp_bsp_sdl_row_span_t;
+
+/**
+ * @brief Map logical rows to the rows they are addressed at while the controller is scrolled
+ *
+ * @param y_start First logical row
+ * @param y_end End logical row (exclusive)
+ * @param[out] spans Spans in logical order, a single unmapped span while not scrolled
+ * @return Number of spans, 1 to ESP_BSP_SDL_SCROLL_MAX_SPANS
+ */
+int esp_bsp_sdl_scroll_map_rows(int y_start, int y_end, esp_bsp_sdl_row_span_t *spans);
+
+/**
+ * @brief Return the panel to its unscrolled state and forget the scroll area
+ *
+ * Called from esp_bsp_sdl_set_orientation() before the orientation changes and from
+ * esp_bsp_sdl_deinit().
+ */
+void esp_bsp_sdl_scroll_deinit(void);
+
+/**
+ * @brief Free heap per memory class, taken before a call whose allocations cannot be hooked
+ */
+typedef struct {
+    size_t free[ESP_BSP_SDL_MEM_CLASS_MAX];
+    size_t booked[ESP_BSP_SDL_MEM_CLASS_MAX]; /* Held through esp_bsp_sdl_mem_malloc() and friends */
+} esp_bsp_sdl_mem_mark_t;
+
+/**
+ * @brief Record the free heap before a BSP call
+ */
+void esp_bsp_sdl_mem_measure_begin(esp_bsp_sdl_mem_mark_t *mark);
+
+/**
+ * @brief Book the drop of free heap since esp_bsp_sdl_mem_measure_begin() to a subsystem
+ *
+ * Blocks allocated through esp_bsp_sdl_mem_malloc() and friends in between are booked already and
+ * left out.
+ */
+void esp_bsp_sdl_mem_measure_end(esp_bsp_sdl_mem_subsys_t subsys, const esp_bsp_sdl_mem_mark_t *mark);
+
+/**
+ * @brief Drop the bytes booked to a measured subsystem once it has been torn down
+ */
+void esp_bsp_sdl_mem_release(esp_bsp_sdl_mem_subsys_t subsys);
+
+/**
+ * @brief Start capturing a presented frame, see esp_bsp_sdl_capture.h
+ *
+ * @param seq Flush frame number
+ * @param timestamp_us esp_timer time at the start of the flush
+ * @param width Frame width
+ * @param height Frame height
+ * @return true if the frame is captured and its rows must be passed to esp_bsp_sdl_capture_add_rows()
+ */
+bool esp_bsp_sdl_capture_begin_frame(uint32_t seq, int64_t timestamp_us, int width, int height);
+
+/**
+ * @brief Capture rows of the current frame, top to bottom
+ *
+ * @param pixels First pixel of the first row
+ * @param stride Distance between rows in pixels
+ * @param width Frame width
+ * @param first_row Frame row of the first row
+ * @param rows Rows to capture
+ * @return Time spent in microseconds, for excluding it from the flush time
+ */
+uint32_t esp_bsp_sdl_capture_add_rows(const uint16_t *pixels, int stride, int width, int first_row, int rows);
+
+/**
+ * @brief Finish the current captured frame
+ *
+ * @param before Flush statistics before the flush
+ * @param after Flush statistics after the flush
+ */
+void esp_bsp_sdl_capture_end_frame(const esp_bsp_sdl_flush_stats_t *before, const esp_bsp_sdl_flush_stats_t *after);
+
+/**
+ * @brief Cached MIPI-DBI address window
+ */
+typedef struct {
+    bool valid;
+    int x0;     /*!< CASET start (controller coordinates) */
+    int x1;     /*!< CASET end, inclusive */
+    int y0;     /*!< RASET start */
+    int y1;     /*!< RASET end, inclusive */
+    int next_y; /*!< Row the controller RAM pointer continues at */
+} esp_bsp_sdl_window_t;
+
+/**
+ * @brief Draw an RGB565 rectangle on a MIPI-DBI panel, sending only the address commands that changed
+ *
+ * The row window is opened down to the last panel row so that consecutive bands with the same
+ * column range continue with RAMWRC.
+ *
+ * @param io Panel IO handle
+ * @param dbi Panel gap description
+ * @param window Cached window state, updated
+ * @param stats Flush statistics, updated
+ * @param height Current (oriented) panel height
+ * @param x_start Start column
+ * @param y_start Start row
+ * @param x_end End column (exclusive)
+ * @param y_end End row (exclusive)
+ * @param color_data Pixel data
+ * @return ESP_OK on success, error code from esp_lcd otherwise
+ */
+esp_err_t esp_bsp_sdl_window_draw(esp_lcd_panel_io_handle_t io,
+                                  const esp_bsp_sdl_dbi_info_t *dbi,
+                                  esp_bsp_sdl_window_t *window,
+                                  esp_bsp_sdl_flush_stats_t *stats,
+                                  int height,
+                                  int x_start,
+                                  int y_start,
+                                  int x_end,
+                                  int y_end,
+                                  const void *color_data);
+
+#ifdef __cplusplus
+}
+#endif
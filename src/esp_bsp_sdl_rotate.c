@@ -0,0 +1,151 @@
+/**
+ * @file esp_bsp_sdl_rotate.c
+ * @brief Display orientation helpers: panel-side rotation and software rotation blit
+ */
+
+#include <string.h>
+#include "esp_bsp_sdl_priv.h"
+#include "esp_log.h"
+
+static const char *TAG = "esp_bsp_sdl_rotate";
+
+// MADCTL MV/MX/MY combinations for clockwise rotation, relative to the BSP default mirroring
+static bool orientation_bits(esp_bsp_sdl_orientation_t orientation, bool *swap, bool *mx, bool *my)
+{
+    *swap = false;
+    *mx = false;
+    *my = false;
+    switch(orientation) {
+        case ESP_BSP_SDL_ORIENTATION_0:
+            break;
+        case ESP_BSP_SDL_ORIENTATION_90:
+            *swap = true;
+            *mx = true;
+            break;
+        case ESP_BSP_SDL_ORIENTATION_180:
+            *mx = true;
+            *my = true;
+            break;
+        case ESP_BSP_SDL_ORIENTATION_270:
+            *swap = true;
+            *my = true;
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+esp_err_t esp_bsp_sdl_panel_apply_orientation(esp_lcd_panel_handle_t panel,
+                                              esp_bsp_sdl_orientation_t orientation,
+                                              bool mirror_x,
+                                              bool mirror_y)
+{
+    if(!panel) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    bool swap;
+    bool mx;
+    bool my;
+    if(!orientation_bits(orientation, &swap, &mx, &my)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = esp_lcd_panel_swap_xy(panel, swap);
+    if(ret != ESP_OK) {
+        ESP_LOGW(TAG, "Panel swap_xy failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = esp_lcd_panel_mirror(panel, mx != mirror_x, my != mirror_y);
+    if(ret != ESP_OK) {
+        ESP_LOGW(TAG, "Panel mirror failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+void esp_bsp_sdl_dbi_orient(const esp_bsp_sdl_dbi_info_t *native,
+                            int native_width,
+                            int native_height,
+                            esp_bsp_sdl_orientation_t orientation,
+                            esp_bsp_sdl_dbi_info_t *current)
+{
+    *current = *native;
+
+    bool swap;
+    bool mx;
+    bool my;
+    if(!orientation_bits(orientation, &swap, &mx, &my)) {
+        return;
+    }
+    mx = mx != native->mirror_x;
+    my = my != native->mirror_y;
+    current->mirror_x = mx;
+    current->mirror_y = my;
+    if(native->ram_width <= 0 || native->ram_height <= 0) {
+        return;
+    }
+
+    // Visible area in RAM: host gaps count from the far RAM edge on mirrored axes
+    const int ram_x = native->mirror_x ? native->ram_width - native->x_gap - native_width : native->x_gap;
+    const int ram_y = native->mirror_y ? native->ram_height - native->y_gap - native_height : native->y_gap;
+    const int column_gap = mx ? native->ram_width - ram_x - native_width : ram_x;
+    const int row_gap = my ? native->ram_height - ram_y - native_height : ram_y;
+
+    // MV sends host columns to RAM rows and host rows to RAM columns
+    current->x_gap = swap ? row_gap : column_gap;
+    current->y_gap = swap ? column_gap : row_gap;
+}
+
+void esp_bsp_sdl_rotate_blit_rgb565(uint16_t *fb,
+                                    int native_width,
+                                    int native_height,
+                                    esp_bsp_sdl_orientation_t orientation,
+                                    int x_start,
+                                    int y_start,
+                                    int x_end,
+                                    int y_end,
+                                    const uint16_t *src)
+{
+    const int w = x_end - x_start;
+    const int h = y_end - y_start;
+    const int stride = native_width;
+
+    // Map logical (x, y) to a native frame buffer index: base + x * step_x + y * step_y
+    int base;
+    int step_x;
+    int step_y;
+    switch(orientation) {
+        case ESP_BSP_SDL_ORIENTATION_90:
+            base = x_start * stride + (native_width - 1 - y_start);
+            step_x = stride;
+            step_y = -1;
+            break;
+        case ESP_BSP_SDL_ORIENTATION_180:
+            base = (native_height - 1 - y_start) * stride + (native_width - 1 - x_start);
+            step_x = -1;
+            step_y = -stride;
+            break;
+        case ESP_BSP_SDL_ORIENTATION_270:
+            base = (native_height - 1 - x_start) * stride + y_start;
+            step_x = -stride;
+            step_y = 1;
+            break;
+        case ESP_BSP_SDL_ORIENTATION_0:
+        default:
+            for(int y = 0; y < h; y++) {
+                memcpy(&fb[(y_start + y) * stride + x_start], &src[y * w], w * sizeof(uint16_t));
+            }
+            return;
+    }
+
+    for(int y = 0; y < h; y++) {
+        uint16_t *dst = fb + base + y * step_y;
+        const uint16_t *row = src + y * w;
+        for(int x = 0; x < w; x++) {
+            *dst = row[x];
+            dst += step_x;
+        }
+    }
+}
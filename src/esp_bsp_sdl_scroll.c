@@ -0,0 +1,271 @@
+/**
+ * @file esp_bsp_sdl_scroll.c
+ * @brief Vertical scrolling: controller scroll on MIPI-DBI panels, frame buffer shift on DPI panels
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl_priv.h"
+#include "esp_bsp_sdl_scroll.h"
+#include "esp_cache.h"
+#include "esp_lcd_panel_commands.h"
+#include "esp_log.h"
+
+#ifndef LCD_CMD_VSCRDEF
+#    define LCD_CMD_VSCRDEF 0x33
+#endif
+#ifndef LCD_CMD_VSCSAD
+#    define LCD_CMD_VSCSAD 0x37
+#endif
+
+#define SCROLL_COMMAND_BYTES 3   // VSCRSADD with its 16-bit start line
+#define ADDRESS_COMMAND_BYTES 5  // CASET/RASET with start and end
+
+typedef enum {
+    SCROLL_NONE = 0,
+    SCROLL_CONTROLLER,   // VSCRDEF/VSCRSADD, draws of the area are remapped
+    SCROLL_FRAME_BUFFER, // Rows moved inside the DPI frame buffer
+} scroll_method_t;
+
+static const char *TAG = "esp_bsp_sdl_scroll";
+
+static int s_top_fixed = 0;
+static int s_bottom_fixed = 0;
+static int s_offset = 0;           // Controller scroll: logical rows the area content moved up, 0 to area - 1
+static bool s_area_defined = false; // VSCRDEF sent for the current area
+
+static scroll_method_t get_method(const esp_bsp_sdl_board_interface_t *board)
+{
+    const esp_bsp_sdl_orientation_t orientation = esp_bsp_sdl_get_orientation();
+    const esp_bsp_sdl_dbi_info_t *dbi = esp_bsp_sdl_priv_get_dbi();
+    if(dbi && dbi->scroll_lines > 0 &&
+       (orientation == ESP_BSP_SDL_ORIENTATION_0 || orientation == ESP_BSP_SDL_ORIENTATION_180)) {
+        return SCROLL_CONTROLLER;
+    }
+    if(!board->dbi && board->get_frame_buffer && orientation == ESP_BSP_SDL_ORIENTATION_0) {
+        return SCROLL_FRAME_BUFFER;
+    }
+    return SCROLL_NONE;
+}
+
+static int area_rows(void)
+{
+    int width;
+    int height;
+    esp_bsp_sdl_priv_get_logical_size(&width, &height);
+    return height - s_top_fixed - s_bottom_fixed;
+}
+
+// The controller scrolls in scan order: mirrored rows run the other way than logical rows
+static bool scan_reversed(const esp_bsp_sdl_dbi_info_t *dbi)
+{
+    return dbi->mirror_y;
+}
+
+// First controller line of the area in scan order
+static int area_first_line(const esp_bsp_sdl_dbi_info_t *dbi, int rows)
+{
+    if(scan_reversed(dbi)) {
+        return dbi->scroll_lines - (dbi->y_gap + s_top_fixed + rows);
+    }
+    return dbi->y_gap + s_top_fixed;
+}
+
+static esp_err_t send_lines(int cmd, const int *values, int count)
+{
+    uint8_t param[6];
+    for(int i = 0; i < count; i++) {
+        param[i * 2] = (values[i] >> 8) & 0xFF;
+        param[i * 2 + 1] = values[i] & 0xFF;
+    }
+    return esp_lcd_panel_io_tx_param(esp_bsp_sdl_priv_get_io(), cmd, param, count * 2);
+}
+
+// VSCRSADD for the current offset, the logical offset runs backwards on a reversed scan
+static esp_err_t send_start_line(const esp_bsp_sdl_dbi_info_t *dbi, int rows)
+{
+    const int scan_offset = scan_reversed(dbi) ? (rows - s_offset) % rows : s_offset;
+    const int start = area_first_line(dbi, rows) + scan_offset;
+    return send_lines(LCD_CMD_VSCSAD, &start, 1);
+}
+
+static esp_err_t define_area(const esp_bsp_sdl_dbi_info_t *dbi)
+{
+    const int rows = area_rows();
+    const int first = area_first_line(dbi, rows);
+    const int lines[3] = {first, rows, dbi->scroll_lines - first - rows};
+    if(first < 0 || lines[2] < 0) {
+        ESP_LOGW(TAG, "Scroll area outside the %d controller lines", dbi->scroll_lines);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    s_offset = 0;
+    esp_err_t ret = send_lines(LCD_CMD_VSCRDEF, lines, 3);
+    if(ret == ESP_OK) {
+        ret = send_start_line(dbi, rows);
+    }
+    s_area_defined = ret == ESP_OK;
+    return ret;
+}
+
+int esp_bsp_sdl_scroll_map_rows(int y_start, int y_end, esp_bsp_sdl_row_span_t *spans)
+{
+    if(!s_offset) {
+        spans[0] = (esp_bsp_sdl_row_span_t) {y_start, y_end, y_start};
+        return 1;
+    }
+
+    // Logical row T + i of the area is addressed at T + (i + offset) % rows: one wrap inside the area
+    const int rows = area_rows();
+    const int top = s_top_fixed;
+    const int bounds[4] = {top, top + rows - s_offset, top + rows, y_end};
+    int count = 0;
+    int y = y_start;
+    for(int b = 0; b < 4 && y < y_end; b++) {
+        const int end = bounds[b] < y_end ? bounds[b] : y_end;
+        if(end <= y) {
+            continue;
+        }
+        const int panel_y = (y >= top && y < top + rows) ? top + (y - top + s_offset) % rows : y;
+        esp_bsp_sdl_row_span_t *last = count ? &spans[count - 1] : NULL;
+        if(last && last->panel_y + (last->y_end - last->y_start) == panel_y) {
+            last->y_end = end;
+        } else {
+            spans[count++] = (esp_bsp_sdl_row_span_t) {y, end, panel_y};
+        }
+        y = end;
+    }
+    return count;
+}
+
+esp_err_t esp_bsp_sdl_scroll_set_area(int top_fixed, int bottom_fixed)
+{
+    const esp_bsp_sdl_board_interface_t *board = esp_bsp_sdl_priv_get_board();
+    if(!board || !esp_bsp_sdl_priv_get_io()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int width;
+    int height;
+    esp_bsp_sdl_priv_get_logical_size(&width, &height);
+    if(top_fixed < 0 || bottom_fixed < 0 || top_fixed + bottom_fixed >= height) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const scroll_method_t method = get_method(board);
+    if(method == SCROLL_NONE) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    s_top_fixed = top_fixed;
+    s_bottom_fixed = bottom_fixed;
+    s_offset = 0;
+    s_area_defined = false;
+    esp_bsp_sdl_flush_invalidate_history();
+    if(method == SCROLL_CONTROLLER) {
+        return define_area(esp_bsp_sdl_priv_get_dbi());
+    }
+    return ESP_OK;
+}
+
+static esp_err_t scroll_frame_buffer(const esp_bsp_sdl_board_interface_t *board,
+                                     int lines,
+                                     esp_bsp_sdl_flush_stats_t *stats)
+{
+    void *fb = NULL;
+    esp_err_t ret = board->get_frame_buffer(&fb);
+    if(ret != ESP_OK || !fb) {
+        return ret != ESP_OK ? ret : ESP_ERR_INVALID_STATE;
+    }
+
+    int width;
+    int height;
+    esp_bsp_sdl_priv_get_logical_size(&width, &height);
+    const int distance = abs(lines);
+    const int kept = area_rows() - distance;
+    if(kept == 0) {
+        return ESP_OK;
+    }
+
+    // Keep the rows that stay visible, the exposed rows are drawn by the caller
+    uint16_t *area = (uint16_t *) fb + (size_t) s_top_fixed * width;
+    const size_t row_bytes = (size_t) width * sizeof(uint16_t);
+    uint16_t *dst = lines > 0 ? area : area + (size_t) distance * width;
+    const uint16_t *src = lines > 0 ? area + (size_t) distance * width : area;
+    memmove(dst, src, kept * row_bytes);
+    esp_cache_msync(dst, kept * row_bytes, ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+    stats->scroll_moved += (uint64_t) kept * row_bytes;
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_scroll(int lines, const uint16_t *exposed)
+{
+    const esp_bsp_sdl_board_interface_t *board = esp_bsp_sdl_priv_get_board();
+    if(!board || !esp_bsp_sdl_priv_get_io()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const int rows = area_rows();
+    const int distance = abs(lines);
+    if(!exposed || distance == 0 || distance > rows) {
+        return lines == 0 ? ESP_OK : ESP_ERR_INVALID_ARG;
+    }
+
+    const scroll_method_t method = get_method(board);
+    if(method == SCROLL_NONE) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    esp_bsp_sdl_flush_stats_t *stats = esp_bsp_sdl_priv_get_stats();
+    const esp_bsp_sdl_flush_stats_t before = *stats;
+    esp_err_t ret;
+    if(method == SCROLL_CONTROLLER) {
+        ret = s_area_defined ? ESP_OK : define_area(esp_bsp_sdl_priv_get_dbi());
+        if(ret == ESP_OK) {
+            s_offset = ((s_offset + lines) % rows + rows) % rows;
+            ret = send_start_line(esp_bsp_sdl_priv_get_dbi(), rows);
+        }
+        if(ret != ESP_OK) {
+            // The controller offset is unknown, start over with the next call
+            s_offset = 0;
+            s_area_defined = false;
+        }
+    } else {
+        ret = scroll_frame_buffer(board, lines, stats);
+    }
+
+    // The panel shows moved content either way, the auto-dirty history no longer describes it
+    esp_bsp_sdl_flush_invalidate_history();
+    if(ret != ESP_OK) {
+        return ret;
+    }
+
+    const int y_start = lines > 0 ? s_top_fixed + rows - distance : s_top_fixed;
+    ret = esp_bsp_sdl_flush_rows(exposed, y_start, y_start + distance);
+
+    stats->scrolls++;
+    stats->scroll_lines += distance;
+    stats->scroll_bytes += stats->pixel_bytes - before.pixel_bytes;
+    if(method == SCROLL_CONTROLLER) {
+        const uint32_t address_commands =
+            (stats->caset_sent - before.caset_sent) + (stats->raset_sent - before.raset_sent);
+        stats->scroll_bytes += SCROLL_COMMAND_BYTES + (uint64_t) address_commands * ADDRESS_COMMAND_BYTES;
+    }
+    return ret;
+}
+
+void esp_bsp_sdl_scroll_deinit(void)
+{
+    const esp_bsp_sdl_board_interface_t *board = esp_bsp_sdl_priv_get_board();
+    if(s_offset && board && esp_bsp_sdl_priv_get_io() && get_method(board) == SCROLL_CONTROLLER) {
+        s_offset = 0;
+        esp_err_t ret = send_start_line(esp_bsp_sdl_priv_get_dbi(), area_rows());
+        if(ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to reset the scroll offset: %s", esp_err_to_name(ret));
+        }
+    }
+    s_top_fixed = 0;
+    s_bottom_fixed = 0;
+    s_offset = 0;
+    s_area_defined = false;
+}
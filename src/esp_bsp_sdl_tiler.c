@@ -0,0 +1,536 @@
+/**
+ * @file esp_bsp_sdl_tiler.c
+ * @brief Tile-based deferred renderer for SDL-style 2D primitives
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl_mem.h"
+#include "esp_bsp_sdl_tiler.h"
+#include "esp_cache.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#define DEFAULT_TILE_WIDTH 64
+#define DEFAULT_TILE_HEIGHT 32
+#define DEFAULT_MAX_COMMANDS 256
+#define DEFAULT_BIN_ENTRIES_PER_COMMAND 8
+#define BIN_NONE UINT32_MAX
+
+static const char *TAG = "esp_bsp_sdl_tiler";
+
+typedef enum {
+    TILER_CMD_FILL,
+    TILER_CMD_BLIT,
+    TILER_CMD_LINE,
+} tiler_cmd_kind_t;
+
+typedef struct {
+    tiler_cmd_kind_t kind;
+    uint16_t color;
+    esp_bsp_sdl_rect_t bounds; // Destination area clipped to the target
+    union {
+        struct {
+            const uint16_t *pixels; // Source pixel for bounds.x, bounds.y
+            int stride;
+        } blit;
+        struct {
+            int x0;
+            int y0;
+            int x1;
+            int y1;
+        } line;
+    };
+} tiler_cmd_t;
+
+typedef struct {
+    uint32_t cmd;
+    uint32_t next;
+} tiler_bin_entry_t;
+
+struct esp_bsp_sdl_tiler_t {
+    esp_bsp_sdl_tiler_config_t config;
+    int tiles_x;
+    int tiles_y;
+    uint16_t *tile; // Internal SRAM raster buffer
+    tiler_cmd_t *cmds;
+    size_t cmd_count;
+    tiler_bin_entry_t *entries;
+    size_t entry_count;
+    uint32_t *bin_head; // Per tile, first entry in submission order
+    uint32_t *bin_tail;
+    uint64_t direct_written;
+    esp_bsp_sdl_tiler_stats_t stats;
+};
+
+static void reset_bins(esp_bsp_sdl_tiler_handle_t tiler)
+{
+    const size_t tiles = (size_t) tiler->tiles_x * tiler->tiles_y;
+    for(size_t i = 0; i < tiles; i++) {
+        tiler->bin_head[i] = BIN_NONE;
+        tiler->bin_tail[i] = BIN_NONE;
+    }
+    tiler->cmd_count = 0;
+    tiler->entry_count = 0;
+    tiler->direct_written = 0;
+}
+
+esp_err_t esp_bsp_sdl_tiler_create(const esp_bsp_sdl_tiler_config_t *config, esp_bsp_sdl_tiler_handle_t *ret_tiler)
+{
+    if(!config || !ret_tiler || config->width <= 0 || config->height <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_bsp_sdl_tiler_handle_t tiler = esp_bsp_sdl_mem_calloc(ESP_BSP_SDL_MEM_RENDER, 1, sizeof(*tiler), MALLOC_CAP_DEFAULT);
+    if(!tiler) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    tiler->config = *config;
+    esp_bsp_sdl_tiler_config_t *cfg = &tiler->config;
+    if(cfg->tile_width <= 0) {
+        cfg->tile_width = DEFAULT_TILE_WIDTH;
+    }
+    if(cfg->tile_height <= 0) {
+        cfg->tile_height = DEFAULT_TILE_HEIGHT;
+    }
+    if(cfg->max_commands == 0) {
+        cfg->max_commands = DEFAULT_MAX_COMMANDS;
+    }
+    if(cfg->max_bin_entries == 0) {
+        cfg->max_bin_entries = cfg->max_commands * DEFAULT_BIN_ENTRIES_PER_COMMAND;
+    }
+    tiler->tiles_x = (cfg->width + cfg->tile_width - 1) / cfg->tile_width;
+    tiler->tiles_y = (cfg->height + cfg->tile_height - 1) / cfg->tile_height;
+    const size_t tiles = (size_t) tiler->tiles_x * tiler->tiles_y;
+
+    tiler->tile = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER,
+                                         (size_t) cfg->tile_width * cfg->tile_height * sizeof(uint16_t),
+                                         MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    tiler->cmds = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, cfg->max_commands * sizeof(tiler_cmd_t), MALLOC_CAP_DEFAULT);
+    tiler->entries = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER,
+                                            cfg->max_bin_entries * sizeof(tiler_bin_entry_t),
+                                            MALLOC_CAP_DEFAULT);
+    tiler->bin_head = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, tiles * sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    tiler->bin_tail = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_RENDER, tiles * sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if(!tiler->tile || !tiler->cmds || !tiler->entries || !tiler->bin_head || !tiler->bin_tail) {
+        ESP_LOGE(TAG, "Failed to allocate tiler for %dx%d", cfg->width, cfg->height);
+        esp_bsp_sdl_tiler_delete(tiler);
+        return ESP_ERR_NO_MEM;
+    }
+
+    reset_bins(tiler);
+    *ret_tiler = tiler;
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_tiler_delete(esp_bsp_sdl_tiler_handle_t tiler)
+{
+    if(!tiler) {
+        return;
+    }
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, tiler->tile);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, tiler->cmds);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, tiler->entries);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, tiler->bin_head);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, tiler->bin_tail);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_RENDER, tiler);
+}
+
+// Bresenham walk over a line command for binning; raster_line() plots the same pixels in closed form
+typedef struct {
+    int x;
+    int y;
+    int dx;
+    int dy;
+    int sx;
+    int sy;
+    int err;
+} line_walk_t;
+
+static void line_walk_begin(line_walk_t *walk, const tiler_cmd_t *cmd)
+{
+    walk->x = cmd->line.x0;
+    walk->y = cmd->line.y0;
+    walk->dx = abs(cmd->line.x1 - cmd->line.x0);
+    walk->dy = -abs(cmd->line.y1 - cmd->line.y0);
+    walk->sx = cmd->line.x0 < cmd->line.x1 ? 1 : -1;
+    walk->sy = cmd->line.y0 < cmd->line.y1 ? 1 : -1;
+    walk->err = walk->dx + walk->dy;
+}
+
+// Step to the next pixel, false after the last one
+static bool line_walk_next(line_walk_t *walk, const tiler_cmd_t *cmd)
+{
+    if(walk->x == cmd->line.x1 && walk->y == cmd->line.y1) {
+        return false;
+    }
+    const int e2 = 2 * walk->err;
+    if(e2 >= walk->dy) {
+        walk->err += walk->dy;
+        walk->x += walk->sx;
+    }
+    if(e2 <= walk->dx) {
+        walk->err += walk->dx;
+        walk->y += walk->sy;
+    }
+    return true;
+}
+
+static void bin_append(esp_bsp_sdl_tiler_handle_t tiler, int tile, uint32_t cmd_index)
+{
+    const uint32_t e = tiler->entry_count++;
+    tiler->entries[e].cmd = cmd_index;
+    tiler->entries[e].next = BIN_NONE;
+    if(tiler->bin_tail[tile] == BIN_NONE) {
+        tiler->bin_head[tile] = e;
+    } else {
+        tiler->entries[tiler->bin_tail[tile]].next = e;
+    }
+    tiler->bin_tail[tile] = e;
+}
+
+// Tiles a line plots pixels in, appended to their bins when append is set. Both coordinates move
+// monotonically, so a tile the walk has left is never entered again.
+static size_t bin_line_tiles(esp_bsp_sdl_tiler_handle_t tiler, uint32_t cmd_index, bool append)
+{
+    const tiler_cmd_t *cmd = &tiler->cmds[cmd_index];
+    const esp_bsp_sdl_rect_t *b = &cmd->bounds;
+    size_t tiles = 0;
+    int last = -1;
+    line_walk_t walk;
+    line_walk_begin(&walk, cmd);
+    do {
+        if(walk.x < b->x || walk.x >= b->x + b->w || walk.y < b->y || walk.y >= b->y + b->h) {
+            continue;
+        }
+        const int tile = (walk.y / tiler->config.tile_height) * tiler->tiles_x + walk.x / tiler->config.tile_width;
+        if(tile != last) {
+            if(append) {
+                bin_append(tiler, tile, cmd_index);
+            }
+            last = tile;
+            tiles++;
+        }
+    } while(line_walk_next(&walk, cmd));
+    return tiles;
+}
+
+// Append the last command to every tile it draws in: the tiles its bounds overlap, or for a line
+// the tiles the segment crosses. Nothing is kept if storage runs out.
+static esp_err_t bin_command(esp_bsp_sdl_tiler_handle_t tiler)
+{
+    const uint32_t cmd_index = tiler->cmd_count;
+    const tiler_cmd_t *cmd = &tiler->cmds[cmd_index];
+    const esp_bsp_sdl_rect_t *b = &cmd->bounds;
+    const int tx0 = b->x / tiler->config.tile_width;
+    const int tx1 = (b->x + b->w - 1) / tiler->config.tile_width;
+    const int ty0 = b->y / tiler->config.tile_height;
+    const int ty1 = (b->y + b->h - 1) / tiler->config.tile_height;
+    const size_t needed = cmd->kind == TILER_CMD_LINE ? bin_line_tiles(tiler, cmd_index, false)
+                                                      : (size_t) (tx1 - tx0 + 1) * (ty1 - ty0 + 1);
+
+    if(tiler->cmd_count >= tiler->config.max_commands || tiler->entry_count + needed > tiler->config.max_bin_entries) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if(cmd->kind == TILER_CMD_LINE) {
+        bin_line_tiles(tiler, cmd_index, true);
+    } else {
+        for(int ty = ty0; ty <= ty1; ty++) {
+            for(int tx = tx0; tx <= tx1; tx++) {
+                bin_append(tiler, ty * tiler->tiles_x + tx, cmd_index);
+            }
+        }
+    }
+    tiler->cmd_count++;
+    return ESP_OK;
+}
+
+static bool clip_to_target(esp_bsp_sdl_tiler_handle_t tiler, const esp_bsp_sdl_rect_t *rect, esp_bsp_sdl_rect_t *out)
+{
+    const esp_bsp_sdl_rect_t target = {0, 0, tiler->config.width, tiler->config.height};
+    return esp_bsp_sdl_rect_intersect(rect, &target, out);
+}
+
+esp_err_t esp_bsp_sdl_tiler_fill_rect(esp_bsp_sdl_tiler_handle_t tiler, const esp_bsp_sdl_rect_t *rect, uint16_t color)
+{
+    if(!tiler || !rect) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(tiler->cmd_count >= tiler->config.max_commands) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    tiler_cmd_t *cmd = &tiler->cmds[tiler->cmd_count];
+    if(!clip_to_target(tiler, rect, &cmd->bounds)) {
+        return ESP_OK;
+    }
+    cmd->kind = TILER_CMD_FILL;
+    cmd->color = color;
+
+    esp_err_t ret = bin_command(tiler);
+    if(ret == ESP_OK) {
+        tiler->direct_written += (uint64_t) cmd->bounds.w * cmd->bounds.h * sizeof(uint16_t);
+    }
+    return ret;
+}
+
+esp_err_t esp_bsp_sdl_tiler_blit(esp_bsp_sdl_tiler_handle_t tiler,
+                                 const esp_bsp_sdl_surface_t *texture,
+                                 const esp_bsp_sdl_rect_t *src,
+                                 int dst_x,
+                                 int dst_y)
+{
+    if(!tiler || !texture || !texture->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(tiler->cmd_count >= tiler->config.max_commands) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_bsp_sdl_rect_t whole = {0, 0, texture->width, texture->height};
+    esp_bsp_sdl_rect_t area;
+    if(!esp_bsp_sdl_rect_intersect(src ? src : &whole, &whole, &area)) {
+        return ESP_OK;
+    }
+
+    // Move the source area to the destination, clip, and remember where the clipped area starts in the source
+    const int dx = dst_x - (src ? src->x : 0);
+    const int dy = dst_y - (src ? src->y : 0);
+    area.x += dx;
+    area.y += dy;
+    tiler_cmd_t *cmd = &tiler->cmds[tiler->cmd_count];
+    if(!clip_to_target(tiler, &area, &cmd->bounds)) {
+        return ESP_OK;
+    }
+    cmd->kind = TILER_CMD_BLIT;
+    cmd->blit.stride = texture->stride;
+    cmd->blit.pixels = texture->pixels + (size_t) (cmd->bounds.y - dy) * texture->stride + (cmd->bounds.x - dx);
+
+    esp_err_t ret = bin_command(tiler);
+    if(ret == ESP_OK) {
+        tiler->direct_written += (uint64_t) cmd->bounds.w * cmd->bounds.h * sizeof(uint16_t);
+    }
+    return ret;
+}
+
+esp_err_t esp_bsp_sdl_tiler_line(esp_bsp_sdl_tiler_handle_t tiler, int x0, int y0, int x1, int y1, uint16_t color)
+{
+    if(!tiler) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(tiler->cmd_count >= tiler->config.max_commands) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_bsp_sdl_rect_t box = {
+        x0 < x1 ? x0 : x1,
+        y0 < y1 ? y0 : y1,
+        abs(x1 - x0) + 1,
+        abs(y1 - y0) + 1,
+    };
+    tiler_cmd_t *cmd = &tiler->cmds[tiler->cmd_count];
+    if(!clip_to_target(tiler, &box, &cmd->bounds)) {
+        return ESP_OK;
+    }
+    cmd->kind = TILER_CMD_LINE;
+    cmd->color = color;
+    cmd->line.x0 = x0;
+    cmd->line.y0 = y0;
+    cmd->line.x1 = x1;
+    cmd->line.y1 = y1;
+
+    esp_err_t ret = bin_command(tiler);
+    if(ret == ESP_OK) {
+        const int steps = box.w > box.h ? box.w : box.h;
+        tiler->direct_written += (uint64_t) steps * sizeof(uint16_t);
+    }
+    return ret;
+}
+
+static int64_t floor_div(int64_t num, int64_t den)
+{
+    return num / den - (num % den < 0);
+}
+
+static int64_t ceil_div(int64_t num, int64_t den)
+{
+    return num / den + (num % den > 0);
+}
+
+// Bresenham in closed form: at major step k the minor offset is floor((2 * b * k + a) / (2 * a)) for
+// major delta a and minor delta b, the same pixels line_walk_next() visits, so tiles join without
+// seams. Only the steps whose pixel lies inside the tile are walked, not the whole line.
+static void raster_line(const tiler_cmd_t *cmd, uint16_t *tile, int stride, const esp_bsp_sdl_rect_t *area)
+{
+    const bool x_major = abs(cmd->line.x1 - cmd->line.x0) >= abs(cmd->line.y1 - cmd->line.y0);
+    const int m0 = x_major ? cmd->line.x0 : cmd->line.y0;
+    const int m1 = x_major ? cmd->line.x1 : cmd->line.y1;
+    const int n0 = x_major ? cmd->line.y0 : cmd->line.x0;
+    const int n1 = x_major ? cmd->line.y1 : cmd->line.x1;
+    const int ms = m0 < m1 ? 1 : -1;
+    const int ns = n0 < n1 ? 1 : -1;
+    const int64_t a = abs(m1 - m0);
+    const int64_t b = abs(n1 - n0);
+
+    // Tile edges as step ranges along both axes
+    const int m_lo = x_major ? area->x : area->y;
+    const int m_hi = m_lo + (x_major ? area->w : area->h) - 1;
+    const int n_lo = x_major ? area->y : area->x;
+    const int n_hi = n_lo + (x_major ? area->h : area->w) - 1;
+    int64_t k_lo = ms > 0 ? m_lo - m0 : m0 - m_hi;
+    int64_t k_hi = ms > 0 ? m_hi - m0 : m0 - m_lo;
+    const int64_t j_lo = ns > 0 ? n_lo - n0 : n0 - n_hi;
+    const int64_t j_hi = ns > 0 ? n_hi - n0 : n0 - n_lo;
+    if(k_lo < 0) {
+        k_lo = 0;
+    }
+    if(k_hi > a) {
+        k_hi = a;
+    }
+    if(b == 0) {
+        if(j_lo > 0 || j_hi < 0) {
+            return;
+        }
+    } else {
+        const int64_t first = ceil_div(2 * a * j_lo - a, 2 * b);
+        const int64_t last = floor_div(2 * a * j_hi + a - 1, 2 * b);
+        k_lo = first > k_lo ? first : k_lo;
+        k_hi = last < k_hi ? last : k_hi;
+    }
+    if(k_lo > k_hi) {
+        return;
+    }
+
+    // The minor offset and its remainder advance incrementally from the first step inside the tile
+    int64_t j = b ? (2 * b * k_lo + a) / (2 * a) : 0;
+    int64_t rem = b ? (2 * b * k_lo + a) % (2 * a) : 0;
+    for(int64_t k = k_lo; k <= k_hi; k++) {
+        const int m = m0 + ms * (int) k;
+        const int n = n0 + ns * (int) j;
+        const int x = x_major ? m : n;
+        const int y = x_major ? n : m;
+        tile[(y - area->y) * stride + (x - area->x)] = cmd->color;
+        rem += 2 * b;
+        if(rem >= 2 * a) {
+            rem -= 2 * a;
+            j++;
+        }
+    }
+}
+
+static void raster_command(const tiler_cmd_t *cmd, uint16_t *tile, int stride, const esp_bsp_sdl_rect_t *area)
+{
+    if(cmd->kind == TILER_CMD_LINE) {
+        raster_line(cmd, tile, stride, area);
+        return;
+    }
+
+    esp_bsp_sdl_rect_t part;
+    if(!esp_bsp_sdl_rect_intersect(&cmd->bounds, area, &part)) {
+        return;
+    }
+    uint16_t *dst = tile + (part.y - area->y) * stride + (part.x - area->x);
+
+    if(cmd->kind == TILER_CMD_FILL) {
+        for(int col = 0; col < part.w; col++) {
+            dst[col] = cmd->color;
+        }
+        for(int row = 1; row < part.h; row++) {
+            memcpy(dst + row * stride, dst, part.w * sizeof(uint16_t));
+        }
+        return;
+    }
+
+    const uint16_t *src = cmd->blit.pixels + (size_t) (part.y - cmd->bounds.y) * cmd->blit.stride +
+                          (part.x - cmd->bounds.x);
+    for(int row = 0; row < part.h; row++) {
+        memcpy(dst + row * stride, src + (size_t) row * cmd->blit.stride, part.w * sizeof(uint16_t));
+    }
+}
+
+esp_err_t esp_bsp_sdl_tiler_render(esp_bsp_sdl_tiler_handle_t tiler, esp_bsp_sdl_surface_t *target)
+{
+    if(!tiler || !target || !target->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const esp_bsp_sdl_tiler_config_t *cfg = &tiler->config;
+    if(target->width < cfg->width || target->height < cfg->height) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_bsp_sdl_tiler_stats_t stats = {
+        .commands = tiler->cmd_count,
+        .direct_written = tiler->direct_written,
+    };
+    const int tile_stride = cfg->tile_width;
+
+    for(int ty = 0; ty < tiler->tiles_y; ty++) {
+        for(int tx = 0; tx < tiler->tiles_x; tx++) {
+            uint32_t e = tiler->bin_head[ty * tiler->tiles_x + tx];
+            if(e == BIN_NONE) {
+                continue;
+            }
+
+            esp_bsp_sdl_rect_t area = {
+                tx * cfg->tile_width,
+                ty * cfg->tile_height,
+                cfg->tile_width,
+                cfg->tile_height,
+            };
+            if(area.x + area.w > cfg->width) {
+                area.w = cfg->width - area.x;
+            }
+            if(area.y + area.h > cfg->height) {
+                area.h = cfg->height - area.y;
+            }
+            uint16_t *fb = target->pixels + (size_t) area.y * target->stride + area.x;
+            const size_t row_bytes = area.w * sizeof(uint16_t);
+
+            // Start the tile from the clear color or from what the target holds today
+            if(cfg->clear) {
+                for(int col = 0; col < area.w; col++) {
+                    tiler->tile[col] = cfg->clear_color;
+                }
+                for(int row = 1; row < area.h; row++) {
+                    memcpy(tiler->tile + row * tile_stride, tiler->tile, row_bytes);
+                }
+            } else {
+                for(int row = 0; row < area.h; row++) {
+                    memcpy(tiler->tile + row * tile_stride, fb + (size_t) row * target->stride, row_bytes);
+                }
+                stats.target_read += (uint64_t) row_bytes * area.h;
+            }
+
+            for(; e != BIN_NONE; e = tiler->entries[e].next) {
+                raster_command(&tiler->cmds[tiler->entries[e].cmd], tiler->tile, tile_stride, &area);
+            }
+
+            for(int row = 0; row < area.h; row++) {
+                memcpy(fb + (size_t) row * target->stride, tiler->tile + row * tile_stride, row_bytes);
+            }
+            if(cfg->cache_writeback) {
+                esp_cache_msync(fb,
+                                ((size_t) (area.h - 1) * target->stride + area.w) * sizeof(uint16_t),
+                                ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+            }
+            stats.target_written += (uint64_t) row_bytes * area.h;
+            stats.tiles_touched++;
+        }
+    }
+
+    tiler->stats = stats;
+    reset_bins(tiler);
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_tiler_get_stats(esp_bsp_sdl_tiler_handle_t tiler, esp_bsp_sdl_tiler_stats_t *stats)
+{
+    if(!tiler || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = tiler->stats;
+    return ESP_OK;
+}
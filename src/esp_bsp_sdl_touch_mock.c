@@ -0,0 +1,303 @@
+/**
+ * @file esp_bsp_sdl_touch_mock.c
+ * @brief Scripted esp_lcd_touch controller
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl_mem.h"
+#include "esp_bsp_sdl_touch_mock.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+
+#if CONFIG_ESP_LCD_TOUCH_MAX_POINTS < ESP_BSP_SDL_TOUCH_MOCK_MAX_POINTS
+#    define MOCK_POINTS CONFIG_ESP_LCD_TOUCH_MAX_POINTS
+#else
+#    define MOCK_POINTS ESP_BSP_SDL_TOUCH_MOCK_MAX_POINTS
+#endif
+
+typedef struct {
+    esp_lcd_touch_t base;
+    esp_bsp_sdl_touch_mock_frame_t *script;
+    size_t script_len;
+    uint32_t loop_period_ms;
+    uint32_t i2c_latency_us;
+    bool manual_clock;
+    int64_t manual_now_us;
+    int64_t start_us;
+    int64_t last_event; // Script frame index over all loops, -1 before the first frame
+    // Injected contacts, guarded by base.data.lock
+    bool injected;
+    bool inject_pending; // Not picked up by a read yet
+    int64_t inject_us;
+    esp_bsp_sdl_touch_mock_frame_t inject_frame;
+    esp_bsp_sdl_touch_mock_stats_t stats;
+} touch_mock_t;
+
+static int64_t mock_now(touch_mock_t *mock)
+{
+    return mock->manual_clock ? mock->manual_now_us : esp_timer_get_time();
+}
+
+// Script frame current at time t (relative to the start), -1 if none yet
+static int64_t current_event(touch_mock_t *mock, int64_t t, int64_t *frame_time_us)
+{
+    int64_t cycle = 0;
+    if(mock->loop_period_ms) {
+        const int64_t period = (int64_t) mock->loop_period_ms * 1000;
+        cycle = t / period;
+        t %= period;
+    }
+
+    // Scripts are short, a linear walk is cheaper than the simulated bus transaction
+    int64_t index = -1;
+    for(size_t i = 0; i < mock->script_len && (int64_t) mock->script[i].time_ms * 1000 <= t; i++) {
+        index = (int64_t) i;
+    }
+    if(index < 0) {
+        // Before the first frame of a later cycle the last frame of the previous cycle is current
+        if(cycle == 0 || mock->script_len == 0) {
+            return -1;
+        }
+        cycle--;
+        index = (int64_t) mock->script_len - 1;
+        t += (int64_t) mock->loop_period_ms * 1000;
+    }
+
+    *frame_time_us = t - (int64_t) mock->script[index].time_ms * 1000;
+    return cycle * (int64_t) mock->script_len + index;
+}
+
+static esp_err_t mock_read_data(esp_lcd_touch_handle_t tp)
+{
+    touch_mock_t *mock = __containerof(tp, touch_mock_t, base);
+    const int64_t start = mock_now(mock);
+
+    // Bus transaction of the register read
+    if(mock->manual_clock) {
+        mock->manual_now_us += mock->i2c_latency_us;
+    } else if(mock->i2c_latency_us) {
+        esp_rom_delay_us(mock->i2c_latency_us);
+    }
+
+    const int64_t now = mock_now(mock);
+    int64_t age_us = 0;
+    const int64_t event = current_event(mock, now - mock->start_us, &age_us);
+    const esp_bsp_sdl_touch_mock_frame_t *frame = NULL;
+    if(event >= 0) {
+        frame = &mock->script[event % (int64_t) mock->script_len];
+    }
+    const bool new_event = event > mock->last_event;
+    const int64_t skipped = new_event ? event - mock->last_event - 1 : 0;
+    if(new_event) {
+        mock->last_event = event;
+    }
+
+    portENTER_CRITICAL(&tp->data.lock);
+    // Script frames passing under an injection are neither reported nor counted
+    int64_t latency_us = -1;
+    if(mock->injected) {
+        frame = &mock->inject_frame;
+        if(mock->inject_pending) {
+            latency_us = now - mock->inject_us;
+            mock->inject_pending = false;
+        }
+    } else if(new_event) {
+        latency_us = age_us;
+        mock->stats.missed_events += (uint32_t) skipped;
+    }
+    if(latency_us >= 0) {
+        mock->stats.events++;
+        mock->stats.latency_us += (uint64_t) latency_us;
+        if(latency_us > mock->stats.max_latency_us) {
+            mock->stats.max_latency_us = (uint32_t) latency_us;
+        }
+    }
+    tp->data.points = 0;
+    if(frame) {
+        const int points = frame->points < MOCK_POINTS ? frame->points : MOCK_POINTS;
+        for(int i = 0; i < points; i++) {
+            tp->data.coords[i].x = frame->coords[i].x;
+            tp->data.coords[i].y = frame->coords[i].y;
+            tp->data.coords[i].strength = frame->coords[i].strength;
+            tp->data.coords[i].track_id = frame->coords[i].track_id;
+        }
+        tp->data.points = points;
+    }
+    portEXIT_CRITICAL(&tp->data.lock);
+
+    mock->stats.reads++;
+    mock->stats.read_time_us += mock_now(mock) - start;
+    return ESP_OK;
+}
+
+static bool mock_get_xy(esp_lcd_touch_handle_t tp,
+                        uint16_t *x,
+                        uint16_t *y,
+                        uint16_t *strength,
+                        uint8_t *point_num,
+                        uint8_t max_point_num)
+{
+    portENTER_CRITICAL(&tp->data.lock);
+    *point_num = tp->data.points > max_point_num ? max_point_num : tp->data.points;
+    for(int i = 0; i < *point_num; i++) {
+        x[i] = tp->data.coords[i].x;
+        y[i] = tp->data.coords[i].y;
+        if(strength) {
+            strength[i] = tp->data.coords[i].strength;
+        }
+    }
+    // Like the real drivers, coordinates are consumed by the read
+    tp->data.points = 0;
+    portEXIT_CRITICAL(&tp->data.lock);
+
+    return *point_num > 0;
+}
+
+static esp_err_t mock_del(esp_lcd_touch_handle_t tp)
+{
+    touch_mock_t *mock = __containerof(tp, touch_mock_t, base);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_TOUCH, mock->script);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_TOUCH, mock);
+    return ESP_OK;
+}
+
+static void mock_restart(touch_mock_t *mock)
+{
+    mock->start_us = mock_now(mock);
+    mock->last_event = -1;
+    memset(&mock->stats, 0, sizeof(mock->stats));
+}
+
+esp_err_t esp_bsp_sdl_touch_mock_new(const esp_bsp_sdl_touch_mock_config_t *config, esp_lcd_touch_handle_t *ret_touch)
+{
+    if(!config || !ret_touch || config->x_max == 0 || config->y_max == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    touch_mock_t *mock = esp_bsp_sdl_mem_calloc(ESP_BSP_SDL_MEM_TOUCH, 1, sizeof(*mock), MALLOC_CAP_DEFAULT);
+    if(!mock) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    mock->base.read_data = mock_read_data;
+    mock->base.get_xy = mock_get_xy;
+    mock->base.del = mock_del;
+    // No set_swap_xy/set_mirror_*: esp_lcd_touch applies the flags in software
+    mock->base.config.x_max = config->x_max;
+    mock->base.config.y_max = config->y_max;
+    mock->base.config.rst_gpio_num = -1;
+    mock->base.config.int_gpio_num = -1;
+    mock->base.config.flags.swap_xy = config->swap_xy;
+    mock->base.config.flags.mirror_x = config->mirror_x;
+    mock->base.config.flags.mirror_y = config->mirror_y;
+    portMUX_INITIALIZE(&mock->base.data.lock);
+    mock->i2c_latency_us = config->i2c_latency_us;
+    mock->manual_clock = config->manual_clock;
+
+    esp_err_t ret = esp_bsp_sdl_touch_mock_load_script(&mock->base,
+                                                       config->script,
+                                                       config->script_len,
+                                                       config->loop_period_ms);
+    if(ret != ESP_OK) {
+        esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_TOUCH, mock);
+        return ret;
+    }
+
+    *ret_touch = &mock->base;
+    return ESP_OK;
+}
+
+bool esp_bsp_sdl_is_touch_mock(esp_lcd_touch_handle_t touch)
+{
+    return touch && touch->read_data == mock_read_data;
+}
+
+esp_err_t esp_bsp_sdl_touch_mock_load_script(esp_lcd_touch_handle_t touch,
+                                             const esp_bsp_sdl_touch_mock_frame_t *script,
+                                             size_t script_len,
+                                             uint32_t loop_period_ms)
+{
+    if(!esp_bsp_sdl_is_touch_mock(touch) || (script_len && !script)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for(size_t i = 1; i < script_len; i++) {
+        if(script[i].time_ms < script[i - 1].time_ms) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if(loop_period_ms && script_len && script[script_len - 1].time_ms >= loop_period_ms) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_bsp_sdl_touch_mock_frame_t *copy = NULL;
+    if(script_len) {
+        copy = esp_bsp_sdl_mem_malloc(ESP_BSP_SDL_MEM_TOUCH, script_len * sizeof(*copy), MALLOC_CAP_DEFAULT);
+        if(!copy) {
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(copy, script, script_len * sizeof(*copy));
+    }
+
+    touch_mock_t *mock = __containerof(touch, touch_mock_t, base);
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_TOUCH, mock->script);
+    mock->script = copy;
+    mock->script_len = script_len;
+    mock->loop_period_ms = loop_period_ms;
+    mock_restart(mock);
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_touch_mock_inject(esp_lcd_touch_handle_t touch, const esp_bsp_sdl_touch_mock_frame_t *contacts)
+{
+    if(!esp_bsp_sdl_is_touch_mock(touch)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    touch_mock_t *mock = __containerof(touch, touch_mock_t, base);
+    const int64_t now = mock_now(mock);
+
+    portENTER_CRITICAL(&touch->data.lock);
+    if(mock->inject_pending) {
+        mock->stats.missed_events++;
+    }
+    mock->injected = contacts != NULL;
+    mock->inject_pending = contacts != NULL;
+    if(contacts) {
+        mock->inject_frame = *contacts;
+        mock->inject_us = now;
+    }
+    portEXIT_CRITICAL(&touch->data.lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_touch_mock_restart(esp_lcd_touch_handle_t touch)
+{
+    if(!esp_bsp_sdl_is_touch_mock(touch)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mock_restart(__containerof(touch, touch_mock_t, base));
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_touch_mock_advance(esp_lcd_touch_handle_t touch, uint32_t delta_us)
+{
+    if(!esp_bsp_sdl_is_touch_mock(touch)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    touch_mock_t *mock = __containerof(touch, touch_mock_t, base);
+    if(!mock->manual_clock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    mock->manual_now_us += delta_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_touch_mock_get_stats(esp_lcd_touch_handle_t touch, esp_bsp_sdl_touch_mock_stats_t *stats)
+{
+    if(!esp_bsp_sdl_is_touch_mock(touch) || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = __containerof(touch, touch_mock_t, base)->stats;
+    return ESP_OK;
+}
@@ -0,0 +1,853 @@
+/**
+ * @file esp_bsp_sdl_virtual_panel.c
+ * @brief RAM-backed MIPI-DBI panel stand-in and frame comparison
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl_mem.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_commands.h"
+#include "esp_lcd_panel_interface.h"
+#include "esp_lcd_panel_io_interface.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#ifndef LCD_CMD_RAMWRC
+#    define LCD_CMD_RAMWRC 0x3C
+#endif
+#ifndef LCD_CMD_VSCRDEF
+#    define LCD_CMD_VSCRDEF 0x33
+#endif
+#ifndef LCD_CMD_VSCSAD
+#    define LCD_CMD_VSCSAD 0x37
+#endif
+
+#define DEFAULT_QUEUE_DEPTH 10
+
+static const char *TAG = "esp_bsp_sdl_virtual_panel";
+
+// Approximate bus setups of the board BSPs
+static const esp_bsp_sdl_virtual_bus_timing_t s_profiles[] = {
+    [ESP_BSP_SDL_VIRTUAL_PROFILE_INSTANT] = {0},
+    [ESP_BSP_SDL_VIRTUAL_PROFILE_ESP_BOX_3] = {
+        .type = ESP_BSP_SDL_VIRTUAL_BUS_SPI,
+        .clock_hz = 40000000,
+        .data_lines = 1,
+        .command_overhead_us = 8,
+        .transfer_overhead_us = 12,
+    },
+    [ESP_BSP_SDL_VIRTUAL_PROFILE_M5STACK_CORE_S3] = {
+        .type = ESP_BSP_SDL_VIRTUAL_BUS_SPI,
+        .clock_hz = 40000000,
+        .data_lines = 1,
+        .command_overhead_us = 8,
+        .transfer_overhead_us = 12,
+    },
+    [ESP_BSP_SDL_VIRTUAL_PROFILE_M5_ATOM_S3] = {
+        .type = ESP_BSP_SDL_VIRTUAL_BUS_SPI,
+        .clock_hz = 40000000,
+        .data_lines = 1,
+        .command_overhead_us = 8,
+        .transfer_overhead_us = 12,
+    },
+    [ESP_BSP_SDL_VIRTUAL_PROFILE_ESP32_P4_FUNCTION_EV] = {
+        .type = ESP_BSP_SDL_VIRTUAL_BUS_DSI,
+        .lane_mbps = 1000,
+        .data_lines = 2,
+        .command_overhead_us = 4,
+        .transfer_overhead_us = 6,
+    },
+    [ESP_BSP_SDL_VIRTUAL_PROFILE_ESP32_S3_LCD_EV] = {
+        .type = ESP_BSP_SDL_VIRTUAL_BUS_I80,
+        .clock_hz = 16000000,
+        .data_lines = 16,
+        .command_overhead_us = 4,
+        .transfer_overhead_us = 6,
+    },
+    [ESP_BSP_SDL_VIRTUAL_PROFILE_M5STACK_TAB5] = {
+        .type = ESP_BSP_SDL_VIRTUAL_BUS_DSI,
+        .lane_mbps = 730,
+        .data_lines = 2,
+        .command_overhead_us = 4,
+        .transfer_overhead_us = 6,
+    },
+};
+
+// Color transfer queued on the simulated bus
+typedef struct {
+    int cmd;
+    const void *color;
+    size_t size;
+    int64_t done_us; // esp_timer time the transfer completes
+} bus_trans_t;
+
+// Controller side: command interpreter and frame memory
+typedef struct {
+    esp_lcd_panel_io_t base;
+    uint16_t *ram; // Controller RAM by scan line: a scrolled area holds what is shown
+    int ram_width;
+    int ram_height;
+    int width; // Visible area in RAM
+    int height;
+    int x_gap;
+    int y_gap;
+    uint8_t madctl;
+    int col_start; // Address window, controller coordinates, inclusive
+    int col_end;
+    int row_start;
+    int row_end;
+    int col; // RAM pointer
+    int row;
+    int scroll_top;    // VSCRDEF top fixed lines
+    int scroll_rows;   // VSCRDEF scroll area lines, 0 without scroll area
+    int scroll_offset; // VSCRSADD relative to the top of the area
+    bool display_on;
+    bool sleeping;
+    bool inverted;
+    esp_bsp_sdl_panel_gamma_t gamma; // PGAMCTRL/NGAMCTRL, length 0 until written after reset
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;
+    void *user_ctx;
+    esp_bsp_sdl_virtual_panel_listener_t listener;
+    void *listener_ctx;
+    esp_bsp_sdl_virtual_panel_stats_t stats;
+    // Bus timing model, unused for ESP_BSP_SDL_VIRTUAL_BUS_INSTANT
+    esp_bsp_sdl_virtual_bus_timing_t bus;
+    uint64_t bus_bits_per_s;
+    esp_timer_handle_t timer;
+    SemaphoreHandle_t slots; // One count per free queue entry
+    portMUX_TYPE lock;
+    bus_trans_t *queue;
+    int queue_head;
+    int queue_count;
+    bool timer_armed;
+    int64_t bus_free_us; // Time the bus finishes the last queued transfer
+} virtual_io_t;
+
+// Host side: behaves like an esp_lcd vendor driver
+typedef struct {
+    esp_lcd_panel_t base;
+    esp_lcd_panel_io_handle_t io;
+    int x_gap;
+    int y_gap;
+    uint8_t madctl;
+} virtual_panel_t;
+
+static void controller_reset(virtual_io_t *vio)
+{
+    vio->madctl = 0;
+    vio->col_start = 0;
+    vio->col_end = vio->ram_width - 1;
+    vio->row_start = 0;
+    vio->row_end = vio->ram_height - 1;
+    vio->col = 0;
+    vio->row = 0;
+    vio->scroll_top = 0;
+    vio->scroll_rows = 0;
+    vio->scroll_offset = 0;
+    vio->display_on = false;
+    vio->sleeping = true;
+    vio->inverted = false;
+    memset(&vio->gamma, 0, sizeof(vio->gamma));
+}
+
+// Visible area of the RAM, what the panel shows
+static esp_bsp_sdl_surface_t visible_frame(const virtual_io_t *vio)
+{
+    return (esp_bsp_sdl_surface_t) {
+        .pixels = vio->ram + vio->y_gap * vio->ram_width + vio->x_gap,
+        .width = vio->width,
+        .height = vio->height,
+        .stride = vio->ram_width,
+    };
+}
+
+// Returns the bounding box of the written pixels in frame coordinates, empty if none is visible
+static esp_bsp_sdl_rect_t write_pixels(virtual_io_t *vio, const uint16_t *px, size_t count)
+{
+    const bool mv = vio->madctl & LCD_CMD_MV_BIT;
+    const bool mx = vio->madctl & LCD_CMD_MX_BIT;
+    const bool my = vio->madctl & LCD_CMD_MY_BIT;
+    int x0 = vio->width;
+    int y0 = vio->height;
+    int x1 = -1;
+    int y1 = -1;
+
+    for(size_t i = 0; i < count; i++) {
+        // Row/column exchange, then mirroring across the whole RAM; gaps are already in the addresses
+        const int column = mv ? vio->row : vio->col;
+        const int row = mv ? vio->col : vio->row;
+        bool visible = false;
+        if(column < vio->ram_width && row < vio->ram_height) {
+            const int ram_x = mx ? vio->ram_width - 1 - column : column;
+            int line = my ? vio->ram_height - 1 - row : row;
+            // Lines of a scrolled area are shown moved up by the offset
+            const int area_line = line - vio->scroll_top;
+            if(vio->scroll_rows && area_line >= 0 && area_line < vio->scroll_rows) {
+                line = (area_line - vio->scroll_offset + vio->scroll_rows) % vio->scroll_rows + vio->scroll_top;
+            }
+            vio->ram[line * vio->ram_width + ram_x] = px[i];
+
+            const int x = ram_x - vio->x_gap;
+            const int y = line - vio->y_gap;
+            visible = x >= 0 && x < vio->width && y >= 0 && y < vio->height;
+            if(visible) {
+                x0 = x < x0 ? x : x0;
+                x1 = x > x1 ? x : x1;
+                y0 = y < y0 ? y : y0;
+                y1 = y > y1 ? y : y1;
+            }
+        }
+        if(!visible) {
+            vio->stats.dropped_pixels++;
+        }
+
+        if(++vio->col > vio->col_end) {
+            vio->col = vio->col_start;
+            if(++vio->row > vio->row_end) {
+                vio->row = vio->row_start;
+            }
+        }
+    }
+
+    if(x1 < 0) {
+        return (esp_bsp_sdl_rect_t) {0};
+    }
+    return (esp_bsp_sdl_rect_t) {x0, y0, x1 - x0 + 1, y1 - y0 + 1};
+}
+
+static void reverse_rows(virtual_io_t *vio, int first, int end)
+{
+    for(int a = first, b = end - 1; a < b; a++, b--) {
+        uint16_t *ra = vio->ram + a * vio->ram_width;
+        uint16_t *rb = vio->ram + b * vio->ram_width;
+        for(int x = 0; x < vio->ram_width; x++) {
+            const uint16_t t = ra[x];
+            ra[x] = rb[x];
+            rb[x] = t;
+        }
+    }
+}
+
+// VSCRSADD moved the shown area: rotate its RAM lines so they keep holding what is shown
+static void apply_scroll(virtual_io_t *vio, int start_line)
+{
+    const int rows = vio->scroll_rows;
+    const int offset = ((start_line - vio->scroll_top) % rows + rows) % rows;
+    const int shift = (offset - vio->scroll_offset + rows) % rows;
+    vio->scroll_offset = offset;
+    if(!shift) {
+        return;
+    }
+
+    const int first = vio->scroll_top;
+    reverse_rows(vio, first, first + shift);
+    reverse_rows(vio, first + shift, first + rows);
+    reverse_rows(vio, first, first + rows);
+
+    // Report the part of the area that is visible
+    const int y0 = first > vio->y_gap ? first - vio->y_gap : 0;
+    const int y1 = first + rows < vio->y_gap + vio->height ? first + rows - vio->y_gap : vio->height;
+    if(vio->listener && y0 < y1) {
+        const esp_bsp_sdl_surface_t frame = visible_frame(vio);
+        const esp_bsp_sdl_rect_t area = {0, y0, vio->width, y1 - y0};
+        vio->listener(&frame, &area, vio->listener_ctx);
+    }
+}
+
+static inline bool is_timed(const virtual_io_t *vio)
+{
+    return vio->bus.type != ESP_BSP_SDL_VIRTUAL_BUS_INSTANT;
+}
+
+static uint32_t bus_time_us(const virtual_io_t *vio, size_t bytes, uint32_t overhead_us)
+{
+    return overhead_us + (uint32_t) ((bytes * 8 * 1000000ULL + vio->bus_bits_per_s - 1) / vio->bus_bits_per_s);
+}
+
+// Wait until every queued color transfer completed, like esp_lcd does before a command
+static void drain_bus(virtual_io_t *vio)
+{
+    if(!is_timed(vio)) {
+        return;
+    }
+    const int depth = vio->bus.queue_depth;
+    for(int i = 0; i < depth; i++) {
+        xSemaphoreTake(vio->slots, portMAX_DELAY);
+    }
+    for(int i = 0; i < depth; i++) {
+        xSemaphoreGive(vio->slots);
+    }
+}
+
+static void arm_timer(virtual_io_t *vio)
+{
+    int64_t due = -1;
+    portENTER_CRITICAL(&vio->lock);
+    if(!vio->timer_armed && vio->queue_count) {
+        vio->timer_armed = true;
+        due = vio->queue[vio->queue_head].done_us;
+    }
+    portEXIT_CRITICAL(&vio->lock);
+
+    if(due >= 0) {
+        const int64_t now = esp_timer_get_time();
+        esp_timer_start_once(vio->timer, due > now ? (uint64_t) (due - now) : 0);
+    }
+}
+
+static void complete_color(virtual_io_t *vio, int lcd_cmd, const void *color, size_t color_size)
+{
+    if(lcd_cmd == LCD_CMD_RAMWR) {
+        vio->col = vio->col_start;
+        vio->row = vio->row_start;
+    }
+    if(lcd_cmd == LCD_CMD_RAMWR || lcd_cmd == LCD_CMD_RAMWRC || lcd_cmd < 0) {
+        const esp_bsp_sdl_rect_t area = write_pixels(vio, color, color_size / sizeof(uint16_t));
+        if(vio->listener && area.w > 0) {
+            const esp_bsp_sdl_surface_t frame = visible_frame(vio);
+            vio->listener(&frame, &area, vio->listener_ctx);
+        }
+    }
+
+    if(vio->on_color_trans_done) {
+        vio->on_color_trans_done(&vio->base, NULL, vio->user_ctx);
+    }
+}
+
+// Transfer at the queue head finished on the simulated bus
+static void bus_timer_cb(void *arg)
+{
+    virtual_io_t *vio = arg;
+
+    portENTER_CRITICAL(&vio->lock);
+    vio->timer_armed = false;
+    const bus_trans_t trans = vio->queue[vio->queue_head];
+    vio->queue_head = (vio->queue_head + 1) % vio->bus.queue_depth;
+    vio->queue_count--;
+    portEXIT_CRITICAL(&vio->lock);
+
+    // Pixels are fetched now, a caller reusing the buffer too early shows up in the frame
+    complete_color(vio, trans.cmd, trans.color, trans.size);
+    xSemaphoreGive(vio->slots);
+    arm_timer(vio);
+}
+
+static esp_err_t virtual_io_rx_param(esp_lcd_panel_io_t *io, int lcd_cmd, void *param, size_t param_size)
+{
+    // Write-only bus, like most SPI panel wirings
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static esp_err_t virtual_io_tx_param(esp_lcd_panel_io_t *io, int lcd_cmd, const void *param, size_t param_size)
+{
+    virtual_io_t *vio = __containerof(io, virtual_io_t, base);
+    const uint8_t *p = param;
+
+    vio->stats.commands++;
+    vio->stats.param_bytes += param_size;
+
+    if(is_timed(vio)) {
+        // Commands are polling transfers behind the queued color data
+        drain_bus(vio);
+        const uint32_t duration = bus_time_us(vio, 1 + param_size, vio->bus.command_overhead_us);
+        esp_rom_delay_us(duration);
+        vio->stats.bus_time_us += duration;
+        vio->bus_free_us = esp_timer_get_time();
+    }
+
+    switch(lcd_cmd) {
+        case LCD_CMD_SWRESET:
+            controller_reset(vio);
+            break;
+        case LCD_CMD_CASET:
+        case LCD_CMD_RASET:
+            if(param_size < 4 || !p) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            if(lcd_cmd == LCD_CMD_CASET) {
+                vio->col_start = (p[0] << 8) | p[1];
+                vio->col_end = (p[2] << 8) | p[3];
+            } else {
+                vio->row_start = (p[0] << 8) | p[1];
+                vio->row_end = (p[2] << 8) | p[3];
+            }
+            break;
+        case LCD_CMD_VSCRDEF: {
+            if(param_size < 6 || !p) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            // Areas reaching past the RAM are ignored, like a controller would misbehave
+            const int top = (p[0] << 8) | p[1];
+            const int rows = (p[2] << 8) | p[3];
+            const bool valid = rows > 0 && top + rows <= vio->ram_height;
+            if(vio->scroll_rows) {
+                // Back to the memory layout before the area changes
+                apply_scroll(vio, vio->scroll_top);
+            }
+            vio->scroll_top = top;
+            vio->scroll_rows = valid ? rows : 0;
+            vio->scroll_offset = 0;
+            break;
+        }
+        case LCD_CMD_VSCSAD:
+            if(param_size < 2 || !p) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            if(vio->scroll_rows) {
+                apply_scroll(vio, (p[0] << 8) | p[1]);
+            }
+            break;
+        case LCD_CMD_MADCTL:
+            if(param_size < 1 || !p) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            vio->madctl = p[0];
+            break;
+        case LCD_CMD_DISPON:
+        case LCD_CMD_DISPOFF:
+            vio->display_on = lcd_cmd == LCD_CMD_DISPON;
+            break;
+        case LCD_CMD_SLPIN:
+        case LCD_CMD_SLPOUT:
+            vio->sleeping = lcd_cmd == LCD_CMD_SLPIN;
+            break;
+        case LCD_CMD_INVON:
+        case LCD_CMD_INVOFF:
+            vio->inverted = lcd_cmd == LCD_CMD_INVON;
+            break;
+        case LCD_CMD_PGAMCTRL:
+        case LCD_CMD_NGAMCTRL:
+            // Kept for inspection only, the frame memory holds the pixels before the gamma stage
+            if(param_size == 0 || param_size > sizeof(vio->gamma.positive) || !p) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            memcpy(lcd_cmd == LCD_CMD_PGAMCTRL ? vio->gamma.positive : vio->gamma.negative, p, param_size);
+            vio->gamma.length = param_size;
+            break;
+        default:
+            // Power and timing commands have no effect on the frame memory
+            break;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t virtual_io_tx_color(esp_lcd_panel_io_t *io, int lcd_cmd, const void *color, size_t color_size)
+{
+    virtual_io_t *vio = __containerof(io, virtual_io_t, base);
+
+    vio->stats.color_writes++;
+    vio->stats.color_bytes += color_size;
+
+    if(!is_timed(vio)) {
+        // The transfer is complete on return, report it like the DMA completion interrupt would
+        complete_color(vio, lcd_cmd, color, color_size);
+        return ESP_OK;
+    }
+
+    if(xSemaphoreTake(vio->slots, 0) != pdTRUE) {
+        vio->stats.queue_waits++;
+        xSemaphoreTake(vio->slots, portMAX_DELAY);
+    }
+
+    const uint32_t duration = bus_time_us(vio, color_size, vio->bus.transfer_overhead_us);
+    const int64_t now = esp_timer_get_time();
+    vio->stats.bus_time_us += duration;
+
+    portENTER_CRITICAL(&vio->lock);
+    const int64_t start = vio->bus_free_us > now ? vio->bus_free_us : now;
+    vio->bus_free_us = start + duration;
+    vio->queue[(vio->queue_head + vio->queue_count) % vio->bus.queue_depth] = (bus_trans_t) {
+        .cmd = lcd_cmd,
+        .color = color,
+        .size = color_size,
+        .done_us = vio->bus_free_us,
+    };
+    vio->queue_count++;
+    portEXIT_CRITICAL(&vio->lock);
+
+    arm_timer(vio);
+    return ESP_OK;
+}
+
+static esp_err_t virtual_io_del(esp_lcd_panel_io_t *io)
+{
+    virtual_io_t *vio = __containerof(io, virtual_io_t, base);
+    if(is_timed(vio)) {
+        drain_bus(vio);
+        esp_timer_delete(vio->timer);
+        vSemaphoreDelete(vio->slots);
+        free(vio->queue);
+    }
+    esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_PANEL, vio->ram);
+    free(vio);
+    return ESP_OK;
+}
+
+static esp_err_t virtual_io_register_event_callbacks(esp_lcd_panel_io_t *io,
+                                                     const esp_lcd_panel_io_callbacks_t *cbs,
+                                                     void *user_ctx)
+{
+    virtual_io_t *vio = __containerof(io, virtual_io_t, base);
+    vio->on_color_trans_done = cbs->on_color_trans_done;
+    vio->user_ctx = user_ctx;
+    return ESP_OK;
+}
+
+static esp_err_t send_madctl(virtual_panel_t *vp)
+{
+    return esp_lcd_panel_io_tx_param(vp->io, LCD_CMD_MADCTL, &vp->madctl, 1);
+}
+
+static esp_err_t virtual_panel_reset(esp_lcd_panel_t *panel)
+{
+    virtual_panel_t *vp = __containerof(panel, virtual_panel_t, base);
+    vp->madctl = 0;
+    return esp_lcd_panel_io_tx_param(vp->io, LCD_CMD_SWRESET, NULL, 0);
+}
+
+static esp_err_t virtual_panel_init(esp_lcd_panel_t *panel)
+{
+    virtual_panel_t *vp = __containerof(panel, virtual_panel_t, base);
+    const uint8_t colmod = 0x55; // 16 bits per pixel
+
+    esp_err_t ret = esp_lcd_panel_io_tx_param(vp->io, LCD_CMD_SLPOUT, NULL, 0);
+    if(ret == ESP_OK) {
+        ret = send_madctl(vp);
+    }
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_io_tx_param(vp->io, LCD_CMD_COLMOD, &colmod, 1);
+    }
+    return ret;
+}
+
+static esp_err_t virtual_panel_del(esp_lcd_panel_t *panel)
+{
+    // Like the vendor drivers, the IO handle is deleted separately
+    free(__containerof(panel, virtual_panel_t, base));
+    return ESP_OK;
+}
+
+static esp_err_t virtual_panel_draw_bitmap(esp_lcd_panel_t *panel,
+                                           int x_start,
+                                           int y_start,
+                                           int x_end,
+                                           int y_end,
+                                           const void *color_data)
+{
+    virtual_panel_t *vp = __containerof(panel, virtual_panel_t, base);
+    if(x_start >= x_end || y_start >= y_end) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    x_start += vp->x_gap;
+    x_end += vp->x_gap;
+    y_start += vp->y_gap;
+    y_end += vp->y_gap;
+
+    const uint8_t caset[4] = {(x_start >> 8) & 0xFF, x_start & 0xFF, ((x_end - 1) >> 8) & 0xFF, (x_end - 1) & 0xFF};
+    const uint8_t raset[4] = {(y_start >> 8) & 0xFF, y_start & 0xFF, ((y_end - 1) >> 8) & 0xFF, (y_end - 1) & 0xFF};
+    esp_err_t ret = esp_lcd_panel_io_tx_param(vp->io, LCD_CMD_CASET, caset, sizeof(caset));
+    if(ret == ESP_OK) {
+        ret = esp_lcd_panel_io_tx_param(vp->io, LCD_CMD_RASET, raset, sizeof(raset));
+    }
+    if(ret == ESP_OK) {
+        const size_t len = (size_t) (x_end - x_start) * (y_end - y_start) * sizeof(uint16_t);
+        ret = esp_lcd_panel_io_tx_color(vp->io, LCD_CMD_RAMWR, color_data, len);
+    }
+    return ret;
+}
+
+static esp_err_t virtual_panel_mirror(esp_lcd_panel_t *panel, bool x_axis, bool y_axis)
+{
+    virtual_panel_t *vp = __containerof(panel, virtual_panel_t, base);
+    vp->madctl &= ~(LCD_CMD_MX_BIT | LCD_CMD_MY_BIT);
+    vp->madctl |= (x_axis ? LCD_CMD_MX_BIT : 0) | (y_axis ? LCD_CMD_MY_BIT : 0);
+    return send_madctl(vp);
+}
+
+static esp_err_t virtual_panel_swap_xy(esp_lcd_panel_t *panel, bool swap_axes)
+{
+    virtual_panel_t *vp = __containerof(panel, virtual_panel_t, base);
+    vp->madctl &= ~LCD_CMD_MV_BIT;
+    vp->madctl |= swap_axes ? LCD_CMD_MV_BIT : 0;
+    return send_madctl(vp);
+}
+
+static esp_err_t virtual_panel_set_gap(esp_lcd_panel_t *panel, int x_gap, int y_gap)
+{
+    virtual_panel_t *vp = __containerof(panel, virtual_panel_t, base);
+    vp->x_gap = x_gap;
+    vp->y_gap = y_gap;
+    return ESP_OK;
+}
+
+static esp_err_t virtual_panel_invert_color(esp_lcd_panel_t *panel, bool invert_color_data)
+{
+    virtual_panel_t *vp = __containerof(panel, virtual_panel_t, base);
+    return esp_lcd_panel_io_tx_param(vp->io, invert_color_data ? LCD_CMD_INVON : LCD_CMD_INVOFF, NULL, 0);
+}
+
+static esp_err_t virtual_panel_disp_on_off(esp_lcd_panel_t *panel, bool on_off)
+{
+    virtual_panel_t *vp = __containerof(panel, virtual_panel_t, base);
+    return esp_lcd_panel_io_tx_param(vp->io, on_off ? LCD_CMD_DISPON : LCD_CMD_DISPOFF, NULL, 0);
+}
+
+static esp_err_t virtual_panel_disp_sleep(esp_lcd_panel_t *panel, bool sleep)
+{
+    virtual_panel_t *vp = __containerof(panel, virtual_panel_t, base);
+    return esp_lcd_panel_io_tx_param(vp->io, sleep ? LCD_CMD_SLPIN : LCD_CMD_SLPOUT, NULL, 0);
+}
+
+esp_err_t esp_bsp_sdl_virtual_panel_new(const esp_bsp_sdl_virtual_panel_config_t *config,
+                                        esp_lcd_panel_io_handle_t *ret_io,
+                                        esp_lcd_panel_handle_t *ret_panel)
+{
+    if(!config || !ret_io || !ret_panel || config->width <= 0 || config->height <= 0 || config->x_gap < 0 ||
+       config->y_gap < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const int ram_width = config->ram_width ? config->ram_width : config->x_gap + config->width;
+    const int ram_height = config->ram_height ? config->ram_height : config->y_gap + config->height;
+    if(ram_width < config->x_gap + config->width || ram_height < config->y_gap + config->height) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const esp_bsp_sdl_virtual_bus_timing_t *bus = &config->bus;
+    uint64_t bus_bits_per_s = 0;
+    switch(bus->type) {
+        case ESP_BSP_SDL_VIRTUAL_BUS_INSTANT:
+            break;
+        case ESP_BSP_SDL_VIRTUAL_BUS_SPI:
+        case ESP_BSP_SDL_VIRTUAL_BUS_I80:
+            bus_bits_per_s = (uint64_t) bus->clock_hz * bus->data_lines;
+            break;
+        case ESP_BSP_SDL_VIRTUAL_BUS_DSI:
+            bus_bits_per_s = (uint64_t) bus->lane_mbps * 1000000 * bus->data_lines;
+            break;
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+    if(bus->type != ESP_BSP_SDL_VIRTUAL_BUS_INSTANT && bus_bits_per_s == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    virtual_io_t *vio = calloc(1, sizeof(*vio));
+    virtual_panel_t *vp = calloc(1, sizeof(*vp));
+    if(!vio || !vp) {
+        free(vio);
+        free(vp);
+        return ESP_ERR_NO_MEM;
+    }
+
+    const size_t ram_size = (size_t) ram_width * ram_height * sizeof(uint16_t);
+    vio->ram = esp_bsp_sdl_mem_calloc(ESP_BSP_SDL_MEM_PANEL, 1, ram_size, MALLOC_CAP_SPIRAM);
+    if(!vio->ram) {
+        vio->ram = esp_bsp_sdl_mem_calloc(ESP_BSP_SDL_MEM_PANEL, 1, ram_size, MALLOC_CAP_DEFAULT);
+    }
+    if(!vio->ram) {
+        ESP_LOGE(TAG, "Failed to allocate %dx%d frame memory", ram_width, ram_height);
+        free(vio);
+        free(vp);
+        return ESP_ERR_NO_MEM;
+    }
+
+    vio->ram_width = ram_width;
+    vio->ram_height = ram_height;
+    vio->width = config->width;
+    vio->height = config->height;
+    vio->x_gap = config->x_gap;
+    vio->y_gap = config->y_gap;
+    vio->bus = *bus;
+    vio->bus_bits_per_s = bus_bits_per_s;
+    controller_reset(vio);
+
+    if(is_timed(vio)) {
+        if(vio->bus.queue_depth == 0) {
+            vio->bus.queue_depth = DEFAULT_QUEUE_DEPTH;
+        }
+        portMUX_INITIALIZE(&vio->lock);
+        vio->queue = calloc(vio->bus.queue_depth, sizeof(bus_trans_t));
+        vio->slots = xSemaphoreCreateCounting(vio->bus.queue_depth, vio->bus.queue_depth);
+        const esp_timer_create_args_t timer_args = {
+            .callback = bus_timer_cb,
+            .arg = vio,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "vpanel_bus",
+        };
+        if(!vio->queue || !vio->slots || esp_timer_create(&timer_args, &vio->timer) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set up the bus timing model");
+            if(vio->slots) {
+                vSemaphoreDelete(vio->slots);
+            }
+            free(vio->queue);
+            esp_bsp_sdl_mem_free(ESP_BSP_SDL_MEM_PANEL, vio->ram);
+            free(vio);
+            free(vp);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    vio->base.rx_param = virtual_io_rx_param;
+    vio->base.tx_param = virtual_io_tx_param;
+    vio->base.tx_color = virtual_io_tx_color;
+    vio->base.del = virtual_io_del;
+    vio->base.register_event_callbacks = virtual_io_register_event_callbacks;
+
+    vp->io = &vio->base;
+    vp->base.reset = virtual_panel_reset;
+    vp->base.init = virtual_panel_init;
+    vp->base.del = virtual_panel_del;
+    vp->base.draw_bitmap = virtual_panel_draw_bitmap;
+    vp->base.mirror = virtual_panel_mirror;
+    vp->base.swap_xy = virtual_panel_swap_xy;
+    vp->base.set_gap = virtual_panel_set_gap;
+    vp->base.invert_color = virtual_panel_invert_color;
+    vp->base.disp_on_off = virtual_panel_disp_on_off;
+    vp->base.disp_sleep = virtual_panel_disp_sleep;
+
+    *ret_io = &vio->base;
+    *ret_panel = &vp->base;
+    ESP_LOGI(TAG,
+             "Virtual panel %dx%d (gap %d,%d in %dx%d RAM)",
+             config->width,
+             config->height,
+             config->x_gap,
+             config->y_gap,
+             ram_width,
+             ram_height);
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_virtual_bus_get_profile(esp_bsp_sdl_virtual_profile_t profile,
+                                              esp_bsp_sdl_virtual_bus_timing_t *timing)
+{
+    if(!timing || profile < 0 || profile >= sizeof(s_profiles) / sizeof(s_profiles[0])) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *timing = s_profiles[profile];
+    return ESP_OK;
+}
+
+bool esp_bsp_sdl_is_virtual_panel(esp_lcd_panel_handle_t panel)
+{
+    return panel && panel->del == virtual_panel_del;
+}
+
+static virtual_io_t *get_io(esp_lcd_panel_handle_t panel)
+{
+    if(!esp_bsp_sdl_is_virtual_panel(panel)) {
+        return NULL;
+    }
+    return __containerof(__containerof(panel, virtual_panel_t, base)->io, virtual_io_t, base);
+}
+
+esp_err_t esp_bsp_sdl_virtual_panel_get_frame(esp_lcd_panel_handle_t panel, esp_bsp_sdl_surface_t *frame)
+{
+    virtual_io_t *vio = get_io(panel);
+    if(!vio || !frame) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    drain_bus(vio);
+    *frame = visible_frame(vio);
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_virtual_panel_get_stats(esp_lcd_panel_handle_t panel, esp_bsp_sdl_virtual_panel_stats_t *stats)
+{
+    virtual_io_t *vio = get_io(panel);
+    if(!vio || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *stats = vio->stats;
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_virtual_panel_get_gamma(esp_lcd_panel_handle_t panel, esp_bsp_sdl_panel_gamma_t *gamma)
+{
+    virtual_io_t *vio = get_io(panel);
+    if(!vio || !gamma) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *gamma = vio->gamma;
+    return ESP_OK;
+}
+
+void esp_bsp_sdl_virtual_panel_reset_stats(esp_lcd_panel_handle_t panel)
+{
+    virtual_io_t *vio = get_io(panel);
+    if(vio) {
+        memset(&vio->stats, 0, sizeof(vio->stats));
+    }
+}
+
+esp_err_t esp_bsp_sdl_virtual_panel_set_listener(esp_lcd_panel_handle_t panel,
+                                                 esp_bsp_sdl_virtual_panel_listener_t listener,
+                                                 void *user_ctx)
+{
+    virtual_io_t *vio = get_io(panel);
+    if(!vio) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Completions in flight keep reporting to the previous listener
+    drain_bus(vio);
+    vio->listener = listener;
+    vio->listener_ctx = user_ctx;
+    return ESP_OK;
+}
+
+esp_err_t esp_bsp_sdl_frame_compare(const esp_bsp_sdl_surface_t *frame,
+                                    const esp_bsp_sdl_surface_t *reference,
+                                    int tolerance,
+                                    esp_bsp_sdl_frame_diff_t *diff)
+{
+    if(!frame || !reference || !frame->pixels || !reference->pixels || tolerance < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(frame->width != reference->width || frame->height != reference->height) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_bsp_sdl_frame_diff_t result = {0};
+    int x0 = frame->width;
+    int y0 = frame->height;
+    int x1 = -1;
+    int y1 = -1;
+    for(int y = 0; y < frame->height; y++) {
+        const uint16_t *a = frame->pixels + y * frame->stride;
+        const uint16_t *b = reference->pixels + y * reference->stride;
+        for(int x = 0; x < frame->width; x++) {
+            if(a[x] == b[x]) {
+                continue;
+            }
+            const int dr = abs((a[x] >> 11) - (b[x] >> 11));
+            const int dg = abs(((a[x] >> 5) & 0x3F) - ((b[x] >> 5) & 0x3F));
+            const int db = abs((a[x] & 0x1F) - (b[x] & 0x1F));
+            int delta = dr > dg ? dr : dg;
+            delta = delta > db ? delta : db;
+            if(delta > result.max_delta) {
+                result.max_delta = delta;
+            }
+            if(delta > tolerance) {
+                result.mismatched++;
+                x0 = x < x0 ? x : x0;
+                x1 = x > x1 ? x : x1;
+                y0 = y < y0 ? y : y0;
+                y1 = y > y1 ? y : y1;
+            }
+        }
+    }
+
+    if(result.mismatched) {
+        result.bounds = (esp_bsp_sdl_rect_t) {x0, y0, x1 - x0 + 1, y1 - y0 + 1};
+    }
+    if(diff) {
+        *diff = result;
+    }
+    return result.mismatched ? ESP_FAIL : ESP_OK;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file esp_bsp_sdl_window.c
+ * @brief MIPI-DBI draw path with address window caching
+ */
+
+#include "esp_bsp_sdl_priv.h"
+#include "esp_lcd_panel_commands.h"
+
+#ifndef LCD_CMD_RAMWRC
+#    define LCD_CMD_RAMWRC 0x3C
+#endif
+
+static esp_err_t send_address(esp_lcd_panel_io_handle_t io, int cmd, int start, int end)
+{
+    const uint8_t param[4] = {
+        (start >> 8) & 0xFF,
+        start & 0xFF,
+        (end >> 8) & 0xFF,
+        end & 0xFF,
+    };
+    return esp_lcd_panel_io_tx_param(io, cmd, param, sizeof(param));
+}
+
+esp_err_t esp_bsp_sdl_window_draw(esp_lcd_panel_io_handle_t io,
+                                  const esp_bsp_sdl_dbi_info_t *dbi,
+                                  esp_bsp_sdl_window_t *window,
+                                  esp_bsp_sdl_flush_stats_t *stats,
+                                  int height,
+                                  int x_start,
+                                  int y_start,
+                                  int x_end,
+                                  int y_end,
+                                  const void *color_data)
+{
+    const int x0 = x_start + dbi->x_gap;
+    const int x1 = x_end - 1 + dbi->x_gap;
+    const int y0 = y_start + dbi->y_gap;
+    const int y1 = y_end - 1 + dbi->y_gap;
+    const size_t len = (size_t) (x_end - x_start) * (y_end - y_start) * sizeof(uint16_t);
+    const bool same_columns = window->valid && window->x0 == x0 && window->x1 == x1;
+    esp_err_t ret;
+
+    // Band continues exactly where the controller RAM pointer stands: no address commands at all
+    if(same_columns && y0 == window->next_y && y1 <= window->y1) {
+        ret = esp_lcd_panel_io_tx_color(io, LCD_CMD_RAMWRC, color_data, len);
+        if(ret != ESP_OK) {
+            window->valid = false;
+            return ret;
+        }
+        window->next_y = y1 + 1;
+        stats->caset_elided++;
+        stats->raset_elided++;
+        stats->ramwrc_writes++;
+        return ESP_OK;
+    }
+
+    // Invalidate first, a failed command leaves the controller window unknown
+    const bool same_rows = window->valid && window->y0 == y0;
+    window->valid = false;
+
+    if(same_columns) {
+        stats->caset_elided++;
+    } else {
+        ret = send_address(io, LCD_CMD_CASET, x0, x1);
+        if(ret != ESP_OK) {
+            return ret;
+        }
+        stats->caset_sent++;
+    }
+
+    // Keep the row window open to the bottom of the panel so following bands can use RAMWRC
+    const int row_end = height - 1 + dbi->y_gap;
+    if(same_rows && window->y1 == row_end) {
+        stats->raset_elided++;
+    } else {
+        ret = send_address(io, LCD_CMD_RASET, y0, row_end);
+        if(ret != ESP_OK) {
+            return ret;
+        }
+        stats->raset_sent++;
+    }
+
+    ret = esp_lcd_panel_io_tx_color(io, LCD_CMD_RAMWR, color_data, len);
+    if(ret != ESP_OK) {
+        return ret;
+    }
+
+    window->valid = true;
+    window->x0 = x0;
+    window->x1 = x1;
+    window->y0 = y0;
+    window->y1 = row_end;
+    window->next_y = y1 + 1;
+    return ESP_OK;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file bench_blend.c
+ * @brief Blend kernel throughput of the scalar and SWAR implementations on the host CPU
+ *
+ * Host numbers only show the relative cost of the implementations; target numbers come from
+ * running the same loop on the board.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_bsp_sdl_blend.h"
+#include "test_util.h"
+
+#define PIXELS (320 * 240)
+#define ROUNDS 200
+
+static uint16_t s_dst[PIXELS];
+static uint16_t s_src565[PIXELS];
+static uint32_t s_src8888[PIXELS];
+static uint8_t s_alpha[PIXELS];
+
+static double mpixels_per_s(int64_t elapsed_us)
+{
+    return (double) PIXELS * ROUNDS / (elapsed_us > 0 ? elapsed_us : 1);
+}
+
+int main(void)
+{
+    for(int i = 0; i < PIXELS; i++) {
+        s_dst[i] = test_random();
+        s_src565[i] = test_random();
+        s_src8888[i] = test_random();
+        s_alpha[i] = test_random();
+    }
+
+    static const struct {
+        const char *name;
+        esp_bsp_sdl_blend_impl_t impl;
+    } impls[] = {
+        {"scalar", ESP_BSP_SDL_BLEND_IMPL_SCALAR},
+        {"SWAR", ESP_BSP_SDL_BLEND_IMPL_SWAR},
+    };
+
+    printf("Mpixels/s over %d frames of %d pixels\n", ROUNDS, PIXELS);
+    printf("%-8s %14s %14s %14s %14s %14s %14s\n", "", "argb8888", "argb8888 pre", "rgb565 a8",
+           "rgb565 a8 pre", "rgb565 const", "color a8");
+    for(size_t n = 0; n < sizeof(impls) / sizeof(impls[0]); n++) {
+        const esp_bsp_sdl_blend_kernels_t *k = esp_bsp_sdl_blend_get_kernels(impls[n].impl);
+        double result[6];
+        for(int kernel = 0; kernel < 6; kernel++) {
+            const int64_t start = test_wall_time_us();
+            for(int r = 0; r < ROUNDS; r++) {
+                switch(kernel) {
+                    case 0:
+                        k->argb8888_over(s_dst, s_src8888, PIXELS);
+                        break;
+                    case 1:
+                        k->argb8888_premul_over(s_dst, s_src8888, PIXELS);
+                        break;
+                    case 2:
+                        k->rgb565_a8_over(s_dst, s_src565, s_alpha, PIXELS);
+                        break;
+                    case 3:
+                        k->rgb565_a8_premul_over(s_dst, s_src565, s_alpha, PIXELS);
+                        break;
+                    case 4:
+                        k->rgb565_const_over(s_dst, s_src565, 100, PIXELS);
+                        break;
+                    default:
+                        k->color_a8_over(s_dst, 0xFFE0, s_alpha, PIXELS);
+                        break;
+                }
+            }
+            result[kernel] = mpixels_per_s(test_wall_time_us() - start);
+        }
+        printf("%-8s %14.1f %14.1f %14.1f %14.1f %14.1f %14.1f\n", impls[n].name, result[0], result[1], result[2],
+               result[3], result[4], result[5]);
+    }
+    return 0;
+}
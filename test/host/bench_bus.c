@@ -0,0 +1,117 @@
+/**
+ * @file bench_bus.c
+ * @brief Frame time of single and double buffered band rendering per board bus profile
+ *
+ * Runs on the simulated clock: rendering a band costs a fixed time per pixel, color transfers
+ * take the time of the board's bus timing model. The numbers show how much of the bus time double
+ * buffering hides behind rendering, independent of the host machine.
+ *
+ * Usage: bench_bus [render_pixels_per_us], default 20
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "esp_host_port.h"
+#include "esp_lcd_panel_commands.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+
+#define PANEL_W   320
+#define PANEL_H   240
+#define BAND_ROWS 16
+#define BANDS     (PANEL_H / BAND_ROWS)
+#define FRAMES    10
+
+static uint16_t s_bands[2][PANEL_W * BAND_ROWS];
+static volatile int s_done;
+
+static bool on_done(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    s_done++;
+    return false;
+}
+
+// Block like a task waiting on the completion semaphore
+static void wait_done(int count)
+{
+    while(s_done < count && esp_host_port_run_next_timer()) {
+    }
+}
+
+static int64_t run_frames(esp_lcd_panel_io_handle_t io, int buffers, uint32_t render_us)
+{
+    const uint8_t caset[4] = {0, 0, (PANEL_W - 1) >> 8, (PANEL_W - 1) & 0xFF};
+    const uint8_t raset[4] = {0, 0, (PANEL_H - 1) >> 8, (PANEL_H - 1) & 0xFF};
+    int sent = 0;
+    s_done = 0;
+
+    const int64_t start = esp_timer_get_time();
+    for(int frame = 0; frame < FRAMES; frame++) {
+        esp_lcd_panel_io_tx_param(io, LCD_CMD_CASET, caset, sizeof(caset));
+        esp_lcd_panel_io_tx_param(io, LCD_CMD_RASET, raset, sizeof(raset));
+        for(int band = 0; band < BANDS; band++) {
+            // The buffer is free once the transfer that used it last completed
+            wait_done(sent - buffers + 1);
+            esp_rom_delay_us(render_us);
+            esp_lcd_panel_io_tx_color(io,
+                                      band ? LCD_CMD_RAMWRC : LCD_CMD_RAMWR,
+                                      s_bands[sent % buffers],
+                                      sizeof(s_bands[0]));
+            sent++;
+        }
+        wait_done(sent);
+    }
+    return (esp_timer_get_time() - start) / FRAMES;
+}
+
+int main(int argc, char **argv)
+{
+    const int pixels_per_us = argc > 1 ? atoi(argv[1]) : 20;
+    if(pixels_per_us <= 0) {
+        fprintf(stderr, "usage: %s [render_pixels_per_us]\n", argv[0]);
+        return 1;
+    }
+    const uint32_t render_us = PANEL_W * BAND_ROWS / pixels_per_us;
+
+    static const struct {
+        const char *name;
+        esp_bsp_sdl_virtual_profile_t profile;
+    } profiles[] = {
+        {"ESP-Box-3", ESP_BSP_SDL_VIRTUAL_PROFILE_ESP_BOX_3},
+        {"M5Stack CoreS3", ESP_BSP_SDL_VIRTUAL_PROFILE_M5STACK_CORE_S3},
+        {"M5 Atom S3", ESP_BSP_SDL_VIRTUAL_PROFILE_M5_ATOM_S3},
+        {"ESP32-S3-LCD-EV", ESP_BSP_SDL_VIRTUAL_PROFILE_ESP32_S3_LCD_EV},
+        {"ESP32-P4-Function-EV", ESP_BSP_SDL_VIRTUAL_PROFILE_ESP32_P4_FUNCTION_EV},
+        {"M5Stack Tab5", ESP_BSP_SDL_VIRTUAL_PROFILE_M5STACK_TAB5},
+    };
+
+    printf("%dx%d in %d-row bands, rendering %d pixels/us (%u us per band), simulated time\n",
+           PANEL_W, PANEL_H, BAND_ROWS, pixels_per_us, (unsigned) render_us);
+    printf("%-22s %12s %12s %12s %10s %10s\n", "", "bus us", "single us", "double us", "single fps", "double fps");
+    for(size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++) {
+        esp_bsp_sdl_virtual_panel_config_t config = {.width = PANEL_W, .height = PANEL_H};
+        esp_bsp_sdl_virtual_bus_get_profile(profiles[i].profile, &config.bus);
+
+        esp_lcd_panel_io_handle_t io;
+        esp_lcd_panel_handle_t panel;
+        if(esp_bsp_sdl_virtual_panel_new(&config, &io, &panel) != ESP_OK) {
+            fprintf(stderr, "%s: cannot create the panel\n", profiles[i].name);
+            return 1;
+        }
+        const esp_lcd_panel_io_callbacks_t cbs = {.on_color_trans_done = on_done};
+        esp_lcd_panel_io_register_event_callbacks(io, &cbs, NULL);
+
+        const int64_t single_us = run_frames(io, 1, render_us);
+        const int64_t double_us = run_frames(io, 2, render_us);
+        esp_bsp_sdl_virtual_panel_stats_t stats;
+        esp_bsp_sdl_virtual_panel_get_stats(panel, &stats);
+        printf("%-22s %12llu %12lld %12lld %10.1f %10.1f\n", profiles[i].name,
+               (unsigned long long) (stats.bus_time_us / (2 * FRAMES)), (long long) single_us, (long long) double_us,
+               1e6 / single_us, 1e6 / double_us);
+
+        esp_lcd_panel_del(panel);
+        esp_lcd_panel_io_del(io);
+    }
+    return 0;
+}
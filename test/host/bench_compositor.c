@@ -0,0 +1,163 @@
+/**
+ * @file bench_compositor.c
+ * @brief Compositor cost per frame with and without the cached lower layers
+ *
+ * A 320x240 UI of an opaque background, a widget layer with an alpha plane that changes one
+ * widget every 10 frames and a 32x32 sprite with an alpha plane moving every frame. Each setup
+ * renders the same frames into a target surface:
+ * - full: every layer invalidated every frame, what recomposing everything costs;
+ * - uncached: only dirty tiles composed, all layers read for them;
+ * - cached: background and widgets composed into the cache frame, rebuilt only where they change.
+ *
+ * Bytes read are independent of the machine; times are host CPU time and only show the relative
+ * cost, target numbers come from running the same loop on the board.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_bsp_sdl_compositor.h"
+#include "test_util.h"
+
+#define W        320
+#define H        240
+#define SPRITE   32
+#define WIDGET_W 64
+#define WIDGET_H 40
+#define FRAMES   300
+
+static uint16_t s_background[W * H];
+static uint16_t s_widgets[W * H];
+static uint8_t s_widgets_alpha[W * H];
+static uint16_t s_sprite[SPRITE * SPRITE];
+static uint8_t s_sprite_alpha[SPRITE * SPRITE];
+static uint16_t s_target[3][W * H];
+
+static void init_layers(void)
+{
+    for(int y = 0; y < H; y++) {
+        for(int x = 0; x < W; x++) {
+            s_background[y * W + x] = (uint16_t) ((x >> 3) << 11 | (y >> 2) << 5 | 0x08);
+        }
+    }
+    // Widget boxes on a 4x4 grid, translucent fill with an opaque border
+    memset(s_widgets_alpha, 0, sizeof(s_widgets_alpha));
+    for(int wy = 0; wy < 4; wy++) {
+        for(int wx = 0; wx < 4; wx++) {
+            for(int y = 0; y < WIDGET_H; y++) {
+                for(int x = 0; x < WIDGET_W; x++) {
+                    const int i = (wy * 60 + 10 + y) * W + wx * 80 + 8 + x;
+                    const bool border = x == 0 || y == 0 || x == WIDGET_W - 1 || y == WIDGET_H - 1;
+                    s_widgets[i] = border ? 0xFFFF : 0x2104;
+                    s_widgets_alpha[i] = border ? 255 : 160;
+                }
+            }
+        }
+    }
+    for(int y = 0; y < SPRITE; y++) {
+        for(int x = 0; x < SPRITE; x++) {
+            const int dx = x - SPRITE / 2;
+            const int dy = y - SPRITE / 2;
+            const int d2 = dx * dx + dy * dy;
+            s_sprite[y * SPRITE + x] = 0xFD20;
+            s_sprite_alpha[y * SPRITE + x] = d2 < 14 * 14 ? 255 : d2 < 16 * 16 ? 128 : 0;
+        }
+    }
+}
+
+typedef struct {
+    const char *name;
+    int cached_layers;
+    bool full;
+} setup_t;
+
+static int run(const setup_t *setup, uint16_t *target)
+{
+    const esp_bsp_sdl_compositor_config_t config = {
+        .width = W,
+        .height = H,
+        .layers = 3,
+        .cached_layers = setup->cached_layers,
+    };
+    esp_bsp_sdl_compositor_handle_t comp;
+    if(esp_bsp_sdl_compositor_create(&config, &comp) != ESP_OK) {
+        fprintf(stderr, "%s: cannot create the compositor\n", setup->name);
+        return 1;
+    }
+    const esp_bsp_sdl_layer_t layers[3] = {
+        {.surface = {s_background, W, H, W}, .opacity = 255, .visible = true},
+        {.surface = {s_widgets, W, H, W}, .alpha = s_widgets_alpha, .opacity = 255, .visible = true},
+        {.surface = {s_sprite, SPRITE, SPRITE, SPRITE}, .alpha = s_sprite_alpha, .opacity = 255, .visible = true},
+    };
+    for(int i = 0; i < 3; i++) {
+        esp_bsp_sdl_compositor_set_layer(comp, i, &layers[i]);
+    }
+    esp_bsp_sdl_surface_t out = {target, W, H, W};
+    esp_bsp_sdl_compositor_render(comp, &out);
+    esp_bsp_sdl_compositor_reset_stats(comp);
+
+    const int64_t start = test_wall_time_us();
+    for(int frame = 0; frame < FRAMES; frame++) {
+        // Sprite bounces across the screen
+        const int x = (frame * 3) % (2 * (W - SPRITE));
+        const int y = (frame * 2) % (2 * (H - SPRITE));
+        esp_bsp_sdl_compositor_move_layer(comp,
+                                          2,
+                                          x < W - SPRITE ? x : 2 * (W - SPRITE) - x,
+                                          y < H - SPRITE ? y : 2 * (H - SPRITE) - y);
+        if(frame % 10 == 0) {
+            // A widget value changes: recolor the inside of one box
+            const int box = (frame / 10) % 16;
+            const esp_bsp_sdl_rect_t rect = {(box % 4) * 80 + 9, (box / 4) * 60 + 11, WIDGET_W - 2, WIDGET_H - 2};
+            for(int r = 0; r < rect.h; r++) {
+                for(int c = 0; c < rect.w; c++) {
+                    s_widgets[(rect.y + r) * W + rect.x + c] = (uint16_t) (frame * 0x0841);
+                }
+            }
+            esp_bsp_sdl_compositor_invalidate(comp, 1, &rect);
+        }
+        if(setup->full) {
+            for(int i = 0; i < 3; i++) {
+                esp_bsp_sdl_compositor_invalidate(comp, i, NULL);
+            }
+        }
+        esp_bsp_sdl_compositor_render(comp, &out);
+    }
+    const int64_t elapsed = test_wall_time_us() - start;
+
+    esp_bsp_sdl_compositor_stats_t stats;
+    esp_bsp_sdl_compositor_get_stats(comp, &stats);
+    printf("%-10s %10llu %10llu %10u %10u %10.1f\n", setup->name, (unsigned long long) (stats.read_bytes / FRAMES),
+           (unsigned long long) (stats.full_bytes / FRAMES), (unsigned) (stats.tiles_composed / FRAMES),
+           (unsigned) stats.cache_rebuilds, (double) elapsed / FRAMES);
+    esp_bsp_sdl_compositor_delete(comp);
+    return 0;
+}
+
+int main(void)
+{
+    static const setup_t setups[3] = {
+        {"full", 0, true},
+        {"uncached", 0, false},
+        {"cached", 2, false},
+    };
+
+    printf("%dx%d, 3 layers, %d frames; per frame: bytes read, full-composition bytes, tiles composed\n", W, H,
+           FRAMES);
+    printf("%-10s %10s %10s %10s %10s %10s\n", "", "read B", "full B", "tiles", "rebuilds", "host us");
+    for(int i = 0; i < 3; i++) {
+        // Every setup starts from the same widget content
+        init_layers();
+        if(run(&setups[i], s_target[i])) {
+            return 1;
+        }
+    }
+
+    // All setups must end with the same picture
+    for(int i = 1; i < 3; i++) {
+        if(memcmp(s_target[0], s_target[i], sizeof(s_target[0])) != 0) {
+            fprintf(stderr, "%s output differs from %s\n", setups[i].name, setups[0].name);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file bench_dirty.c
+ * @brief Auto-dirty detection: diff cost against the SPI bus time it saves
+ *
+ * Flushes the same frame sequences through esp_bsp_sdl_flush_frame() on the virtual board (ESP-Box-3
+ * SPI timing model) with dirty detection off, in shadow mode and in tile hash mode. The scenes
+ * change no tile, one 16x16 tile, one tile row or every pixel per frame.
+ *
+ * Bytes and bus time come from the simulated clock and do not depend on the machine. The diff cost
+ * is the host wall time of flushing the static scene: every tile is compared in full (no early exit)
+ * and nothing is sent, so the flush is the diff alone. It is host CPU time and only shows the
+ * relative cost of the modes; on the board the diff is the same linear pass over the frame, to be
+ * weighed against the bus time saved per scene.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "sdkconfig.h"
+#include "test_util.h"
+
+#define W      CONFIG_SDL_BSP_VIRTUAL_WIDTH
+#define H      CONFIG_SDL_BSP_VIRTUAL_HEIGHT
+#define FRAMES 2000
+
+typedef enum {
+    SCENE_STATIC,
+    SCENE_TILE,
+    SCENE_ROW,
+    SCENE_FULL,
+} scene_t;
+
+static uint16_t s_frame[W * H];
+static esp_lcd_panel_handle_t s_panel;
+
+static void change(scene_t scene, int frame)
+{
+    switch(scene) {
+        case SCENE_STATIC:
+            break;
+        case SCENE_TILE:
+            s_frame[(frame % 16) * W + 20] = (uint16_t) frame;
+            break;
+        case SCENE_ROW:
+            for(int x = 0; x < W; x += 16) {
+                s_frame[16 * W + x + frame % 16] = (uint16_t) frame;
+            }
+            break;
+        case SCENE_FULL:
+            for(int i = 0; i < W * H; i++) {
+                s_frame[i] += 1;
+            }
+            break;
+    }
+}
+
+typedef struct {
+    double bytes;
+    double bus_us;
+    double cpu_us;
+} result_t;
+
+static int run(esp_bsp_sdl_dirty_mode_t mode, scene_t scene, result_t *result)
+{
+    if(esp_bsp_sdl_set_dirty_mode(mode) != ESP_OK) {
+        return 1;
+    }
+    for(int i = 0; i < W * H; i++) {
+        s_frame[i] = (uint16_t) (i * 7);
+    }
+    // Seed the history, so every mode starts from a flushed frame
+    esp_bsp_sdl_flush_frame(s_frame);
+    esp_bsp_sdl_virtual_panel_reset_stats(s_panel);
+
+    int64_t cpu_us = 0;
+    for(int frame = 0; frame < FRAMES; frame++) {
+        change(scene, frame);
+        const int64_t start = test_wall_time_us();
+        if(esp_bsp_sdl_flush_frame(s_frame) != ESP_OK) {
+            return 1;
+        }
+        cpu_us += test_wall_time_us() - start;
+    }
+
+    esp_bsp_sdl_virtual_panel_stats_t stats;
+    esp_bsp_sdl_virtual_panel_get_stats(s_panel, &stats);
+    result->bytes = (double) stats.color_bytes / FRAMES;
+    result->bus_us = (double) stats.bus_time_us / FRAMES;
+    result->cpu_us = (double) cpu_us / FRAMES;
+    return 0;
+}
+
+int main(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_io_handle_t io;
+    if(esp_bsp_sdl_init(&config, &s_panel, &io) != ESP_OK) {
+        fprintf(stderr, "cannot initialize the virtual board\n");
+        return 1;
+    }
+
+    static const char *scene_names[] = {"static", "one tile", "tile row", "every pixel"};
+    static const struct {
+        const char *name;
+        esp_bsp_sdl_dirty_mode_t mode;
+    } modes[] = {
+        {"off", ESP_BSP_SDL_DIRTY_OFF},
+        {"shadow", ESP_BSP_SDL_DIRTY_SHADOW},
+        {"tile hash", ESP_BSP_SDL_DIRTY_TILE_HASH},
+    };
+    const int modes_count = sizeof(modes) / sizeof(modes[0]);
+    const int tiles = ((W + 15) / 16) * ((H + 15) / 16);
+    result_t results[SCENE_FULL + 1][3];
+    for(int scene = SCENE_STATIC; scene <= SCENE_FULL; scene++) {
+        for(int m = 0; m < modes_count; m++) {
+            if(run(modes[m].mode, (scene_t) scene, &results[scene][m])) {
+                fprintf(stderr, "%s/%s failed\n", scene_names[scene], modes[m].name);
+                return 1;
+            }
+        }
+    }
+
+    printf("%dx%d, %d tiles of 16x16, ESP-Box-3 SPI timing, %d frames per run\n", W, H, tiles, FRAMES);
+    printf("\ndiff cost (host CPU, static scene)\n");
+    printf("%-10s %12s %12s\n", "mode", "us/frame", "ns/tile");
+    for(int m = 1; m < modes_count; m++) {
+        const double us = results[SCENE_STATIC][m].cpu_us;
+        printf("%-10s %12.2f %12.1f\n", modes[m].name, us, us * 1000 / tiles);
+    }
+
+    printf("\nbus traffic per frame (simulated)\n");
+    printf("%-12s %-10s %10s %12s %12s\n", "scene", "mode", "bytes", "bus us", "bus us saved");
+    for(int scene = SCENE_STATIC; scene <= SCENE_FULL; scene++) {
+        const result_t *plain = &results[scene][0];
+        for(int m = 0; m < modes_count; m++) {
+            const result_t *r = &results[scene][m];
+            printf("%-12s %-10s %10.0f %12.1f %12.1f\n", scene_names[scene], modes[m].name, r->bytes, r->bus_us,
+                   plain->bus_us - r->bus_us);
+        }
+    }
+
+    esp_bsp_sdl_set_dirty_mode(ESP_BSP_SDL_DIRTY_OFF);
+    esp_bsp_sdl_deinit();
+    return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file bench_placement.c
+ * @brief Throughput and internal memory per placement policy
+ *
+ * Flushes full frames through esp_bsp_sdl_flush_frame() on the virtual board (ESP-Box-3 SPI timing
+ * model) with:
+ * - internal: the frame in internal DMA memory, sent in one transfer;
+ * - PSRAM bounce: the frame in PSRAM (marked with esp_host_port_set_external_ram()), copied band
+ *   by band into the internal band buffers while the previous band is sent.
+ *
+ * Frame time and bus time run on the simulated clock. The band copies take no simulated time: on
+ * the board they overlap the transfer of the previous band, and that holds as long as copying a
+ * band from PSRAM is faster than sending it, as it is for SPI panels. Host CPU time shows what the
+ * copies cost on the host. Internal bytes are the frame when it is internal plus the buffers the
+ * flush engine holds.
+ */
+
+#include <stdio.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_mem.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "esp_host_port.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "test_util.h"
+
+#define W      CONFIG_SDL_BSP_VIRTUAL_WIDTH
+#define H      CONFIG_SDL_BSP_VIRTUAL_HEIGHT
+#define FRAMES 1000
+
+static uint16_t s_frame[W * H];
+static esp_lcd_panel_handle_t s_panel;
+
+static size_t flush_held(void)
+{
+    esp_bsp_sdl_mem_snapshot_t snap;
+    esp_bsp_sdl_mem_get_snapshot(&snap);
+    size_t bytes = 0;
+    for(int c = 0; c < ESP_BSP_SDL_MEM_CLASS_MAX; c++) {
+        bytes += snap.current[ESP_BSP_SDL_MEM_FLUSH][c];
+    }
+    return bytes;
+}
+
+static int run(const char *name, esp_bsp_sdl_placement_t placement, bool psram)
+{
+    if(esp_bsp_sdl_set_placement(placement) != ESP_OK) {
+        return 1;
+    }
+    esp_host_port_set_external_ram(psram ? s_frame : NULL, sizeof(s_frame));
+    esp_bsp_sdl_reset_flush_stats();
+    esp_bsp_sdl_virtual_panel_reset_stats(s_panel);
+
+    const int64_t start = esp_timer_get_time();
+    const int64_t wall_start = test_wall_time_us();
+    for(int frame = 0; frame < FRAMES; frame++) {
+        s_frame[frame % (W * H)] = (uint16_t) frame;
+        if(esp_bsp_sdl_flush_frame(s_frame) != ESP_OK) {
+            return 1;
+        }
+    }
+    const double frame_us = (double) (esp_timer_get_time() - start) / FRAMES;
+    const double cpu_us = (double) (test_wall_time_us() - wall_start) / FRAMES;
+
+    esp_bsp_sdl_virtual_panel_stats_t panel;
+    esp_bsp_sdl_virtual_panel_get_stats(s_panel, &panel);
+    esp_bsp_sdl_flush_stats_t stats;
+    esp_bsp_sdl_get_flush_stats(&stats);
+    const size_t internal = (psram ? 0 : sizeof(s_frame)) + flush_held();
+    printf("%-14s %10.1f %10.0f %12.1f %10.1f %10.0f %10zu %10.2f\n", name, (double) panel.color_writes / FRAMES,
+           (double) panel.color_bytes / panel.color_writes, frame_us, 1e6 / frame_us,
+           (double) stats.bounced_bytes / FRAMES, internal, cpu_us);
+    return 0;
+}
+
+int main(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_io_handle_t io;
+    if(esp_bsp_sdl_init(&config, &s_panel, &io) != ESP_OK) {
+        fprintf(stderr, "cannot initialize the virtual board\n");
+        return 1;
+    }
+
+    printf("%dx%d, ESP-Box-3 SPI timing, %d frames per policy\n", W, H, FRAMES);
+    printf("%-14s %10s %10s %12s %10s %10s %10s %10s\n", "policy", "transfers", "bytes/xfer", "frame us", "fps",
+           "bounced", "internal", "host cpu us");
+    int ret = run("internal", ESP_BSP_SDL_PLACEMENT_INTERNAL, false);
+    ret = ret ? ret : run("psram bounce", ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE, true);
+    if(ret) {
+        fprintf(stderr, "flush failed\n");
+    }
+    // The band buffers do not grow with the height, the internal frame does
+    const int w = 320;
+    const int h = 240;
+    printf("internal bytes at %dx%d (computed): internal %d, psram bounce %d in %d transfers\n", w, h,
+           w * h * 2, 2 * w * ESP_BSP_SDL_FLUSH_BAND_ROWS * 2, h / ESP_BSP_SDL_FLUSH_BAND_ROWS);
+
+    esp_host_port_set_external_ram(NULL, 0);
+    esp_bsp_sdl_deinit();
+    return ret;
+}
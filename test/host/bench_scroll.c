@@ -0,0 +1,107 @@
+/**
+ * @file bench_scroll.c
+ * @brief Controller scrolling: bus bytes and bus time per scrolled line against a full redraw
+ *
+ * Scrolls the whole display of the virtual board (ESP-Box-3 SPI timing model) by 1 to 16 lines per
+ * step with esp_bsp_sdl_scroll(), then redraws the same content with esp_bsp_sdl_flush_frame() and
+ * dirty detection off, as a frame buffer without controller scrolling would have to.
+ *
+ * Bytes are one per parameter command, the parameters and the pixels, bus time runs on the simulated
+ * clock; neither depends on the machine. Exposed rows that continue the previous write go out with
+ * RAMWRC and no address window, so small steps cost VSCRSADD and the pixels alone.
+ */
+
+#include <stdio.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_scroll.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "sdkconfig.h"
+
+#define W     CONFIG_SDL_BSP_VIRTUAL_WIDTH
+#define H     CONFIG_SDL_BSP_VIRTUAL_HEIGHT
+#define STEPS 200
+
+static uint16_t s_frame[W * H];
+static esp_lcd_panel_handle_t s_panel;
+
+typedef struct {
+    double bytes;
+    double bus_us;
+} result_t;
+
+static void take(result_t *result, int count)
+{
+    esp_bsp_sdl_virtual_panel_stats_t stats;
+    esp_bsp_sdl_virtual_panel_get_stats(s_panel, &stats);
+    result->bytes = (double) (stats.commands + stats.param_bytes + stats.color_bytes) / count;
+    result->bus_us = (double) stats.bus_time_us / count;
+}
+
+static int run_scroll(int lines, result_t *result)
+{
+    esp_bsp_sdl_virtual_panel_reset_stats(s_panel);
+    for(int step = 0; step < STEPS; step++) {
+        s_frame[step % W] = (uint16_t) step;
+        if(esp_bsp_sdl_scroll(lines, s_frame) != ESP_OK) {
+            return 1;
+        }
+    }
+    take(result, STEPS);
+    return 0;
+}
+
+static int run_redraw(result_t *result)
+{
+    esp_bsp_sdl_virtual_panel_reset_stats(s_panel);
+    for(int step = 0; step < STEPS; step++) {
+        s_frame[step % (W * H)] = (uint16_t) step;
+        if(esp_bsp_sdl_flush_frame(s_frame) != ESP_OK) {
+            return 1;
+        }
+    }
+    take(result, STEPS);
+    return 0;
+}
+
+int main(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_io_handle_t io;
+    if(esp_bsp_sdl_init(&config, &s_panel, &io) != ESP_OK) {
+        fprintf(stderr, "cannot initialize the virtual board\n");
+        return 1;
+    }
+    esp_bsp_sdl_set_dirty_mode(ESP_BSP_SDL_DIRTY_OFF);
+    if(esp_bsp_sdl_scroll_set_area(0, 0) != ESP_OK) {
+        fprintf(stderr, "the virtual board cannot scroll\n");
+        return 1;
+    }
+
+    result_t redraw;
+    if(run_redraw(&redraw)) {
+        fprintf(stderr, "redraw failed\n");
+        return 1;
+    }
+
+    printf("%dx%d, ESP-Box-3 SPI timing, %d steps per distance, full redraw %.0f bytes %.1f bus us\n", W, H, STEPS,
+           redraw.bytes, redraw.bus_us);
+    printf("%-6s %10s %12s %10s %12s %12s\n", "lines", "bytes", "bytes/line", "bus us", "bus us/line", "vs redraw");
+    for(int lines = 1; lines <= 16; lines++) {
+        result_t scroll;
+        if(run_scroll(lines, &scroll)) {
+            fprintf(stderr, "scroll by %d failed\n", lines);
+            return 1;
+        }
+        printf("%-6d %10.0f %12.1f %10.1f %12.2f %11.1f%%\n", lines, scroll.bytes, scroll.bytes / lines,
+               scroll.bus_us, scroll.bus_us / lines, 100.0 * scroll.bus_us / redraw.bus_us);
+    }
+
+    // VSCRSADD and the exposed rows, plus CASET/RASET when the rows do not continue the last write
+    const int w = 320;
+    const int h = 240;
+    printf("bytes at %dx%d (computed): full redraw %d, scroll by 1 line %d to %d, by 16 lines %d to %d\n", w, h,
+           w * h * 2, w * 2 + 3, w * 2 + 3 + 2 * 5, 16 * w * 2 + 3, 16 * w * 2 + 3 + 2 * 5);
+
+    esp_bsp_sdl_deinit();
+    return 0;
+}
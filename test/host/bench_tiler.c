@@ -0,0 +1,196 @@
+/**
+ * @file bench_tiler.c
+ * @brief Frame buffer traffic of the tiler against immediate-mode drawing
+ *
+ * A 1280x800 frame, the size of the P4 board, cleared to a color and then covered by layers of
+ * 200x120 windows (each layer about one screen of overdraw), 64 opaque 32x32 sprites and 64 lines.
+ * For every overdraw depth the same commands are:
+ * - direct: drawn straight into the frame, every pixel written as often as it is drawn, plus the clear;
+ * - tiled: recorded into the tiler and rendered with clear set, each touched tile written once.
+ *
+ * Bytes are independent of the machine and are the PSRAM traffic on the board. Times are host CPU
+ * time; the 2.0 MB frame does not fit a host L2 cache, the way the P4 frame does not fit its cache.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl_tiler.h"
+#include "test_util.h"
+
+#define W          1280
+#define H          800
+#define WINDOW_W   200
+#define WINDOW_H   120
+#define WINDOWS    40
+#define SPRITES    64
+#define SPRITE     32
+#define LINES      64
+#define MAX_DEPTH  8
+#define FRAMES     10
+#define CLEAR      0x0841
+
+typedef struct {
+    esp_bsp_sdl_rect_t rects[MAX_DEPTH * WINDOWS];
+    uint16_t colors[MAX_DEPTH * WINDOWS];
+    int sprite_pos[SPRITES][2];
+    int lines[LINES][4];
+} scene_t;
+
+static scene_t s_scene;
+static uint16_t s_sprite[SPRITE * SPRITE];
+static uint16_t s_frame[W * H];
+
+static void init_scene(void)
+{
+    for(int i = 0; i < SPRITE * SPRITE; i++) {
+        s_sprite[i] = (uint16_t) test_random();
+    }
+    for(int i = 0; i < MAX_DEPTH * WINDOWS; i++) {
+        s_scene.rects[i] = (esp_bsp_sdl_rect_t) {
+            (int) (test_random() % (W - WINDOW_W / 2)) - WINDOW_W / 4,
+            (int) (test_random() % (H - WINDOW_H / 2)) - WINDOW_H / 4,
+            WINDOW_W,
+            WINDOW_H,
+        };
+        s_scene.colors[i] = (uint16_t) test_random();
+    }
+    for(int i = 0; i < SPRITES; i++) {
+        s_scene.sprite_pos[i][0] = (int) (test_random() % (W - SPRITE));
+        s_scene.sprite_pos[i][1] = (int) (test_random() % (H - SPRITE));
+    }
+    for(int i = 0; i < LINES; i++) {
+        s_scene.lines[i][0] = (int) (test_random() % W);
+        s_scene.lines[i][1] = (int) (test_random() % H);
+        s_scene.lines[i][2] = (int) (test_random() % W);
+        s_scene.lines[i][3] = (int) (test_random() % H);
+    }
+}
+
+// Immediate mode, counting every pixel written
+static uint64_t draw_direct(int depth)
+{
+    uint64_t written = (uint64_t) W * H * sizeof(uint16_t);
+    for(int i = 0; i < W * H; i++) {
+        s_frame[i] = CLEAR;
+    }
+    const esp_bsp_sdl_rect_t frame = {0, 0, W, H};
+    for(int i = 0; i < depth * WINDOWS; i++) {
+        esp_bsp_sdl_rect_t r;
+        if(!esp_bsp_sdl_rect_intersect(&s_scene.rects[i], &frame, &r)) {
+            continue;
+        }
+        for(int y = r.y; y < r.y + r.h; y++) {
+            for(int x = r.x; x < r.x + r.w; x++) {
+                s_frame[y * W + x] = s_scene.colors[i];
+            }
+        }
+        written += (uint64_t) r.w * r.h * sizeof(uint16_t);
+    }
+    for(int i = 0; i < SPRITES; i++) {
+        uint16_t *dst = s_frame + s_scene.sprite_pos[i][1] * W + s_scene.sprite_pos[i][0];
+        for(int row = 0; row < SPRITE; row++) {
+            memcpy(dst + row * W, s_sprite + row * SPRITE, SPRITE * sizeof(uint16_t));
+        }
+        written += SPRITE * SPRITE * sizeof(uint16_t);
+    }
+    for(int i = 0; i < LINES; i++) {
+        int x0 = s_scene.lines[i][0];
+        int y0 = s_scene.lines[i][1];
+        const int x1 = s_scene.lines[i][2];
+        const int y1 = s_scene.lines[i][3];
+        const int dx = abs(x1 - x0);
+        const int dy = -abs(y1 - y0);
+        const int sx = x0 < x1 ? 1 : -1;
+        const int sy = y0 < y1 ? 1 : -1;
+        int err = dx + dy;
+        for(;;) {
+            s_frame[y0 * W + x0] = 0xFFFF;
+            written += sizeof(uint16_t);
+            if(x0 == x1 && y0 == y1) {
+                break;
+            }
+            const int e2 = 2 * err;
+            if(e2 >= dy) {
+                err += dy;
+                x0 += sx;
+            }
+            if(e2 <= dx) {
+                err += dx;
+                y0 += sy;
+            }
+        }
+    }
+    return written;
+}
+
+static esp_err_t draw_tiled(esp_bsp_sdl_tiler_handle_t tiler, int depth)
+{
+    const esp_bsp_sdl_surface_t sprite = {s_sprite, SPRITE, SPRITE, SPRITE};
+    esp_err_t ret = ESP_OK;
+    for(int i = 0; i < depth * WINDOWS && ret == ESP_OK; i++) {
+        ret = esp_bsp_sdl_tiler_fill_rect(tiler, &s_scene.rects[i], s_scene.colors[i]);
+    }
+    for(int i = 0; i < SPRITES && ret == ESP_OK; i++) {
+        ret = esp_bsp_sdl_tiler_blit(tiler, &sprite, NULL, s_scene.sprite_pos[i][0], s_scene.sprite_pos[i][1]);
+    }
+    for(int i = 0; i < LINES && ret == ESP_OK; i++) {
+        const int *l = s_scene.lines[i];
+        ret = esp_bsp_sdl_tiler_line(tiler, l[0], l[1], l[2], l[3], 0xFFFF);
+    }
+    if(ret != ESP_OK) {
+        return ret;
+    }
+    esp_bsp_sdl_surface_t target = {s_frame, W, H, W};
+    return esp_bsp_sdl_tiler_render(tiler, &target);
+}
+
+int main(void)
+{
+    init_scene();
+    const esp_bsp_sdl_tiler_config_t config = {
+        .width = W,
+        .height = H,
+        .max_commands = MAX_DEPTH * WINDOWS + SPRITES + LINES,
+        .max_bin_entries = 32768,
+        .clear = true,
+        .clear_color = CLEAR,
+    };
+    esp_bsp_sdl_tiler_handle_t tiler;
+    if(esp_bsp_sdl_tiler_create(&config, &tiler) != ESP_OK) {
+        fprintf(stderr, "cannot create the tiler\n");
+        return 1;
+    }
+
+    printf("%dx%d, %d windows of %dx%d per layer, %d %dx%d sprites, %d lines, %d frames per depth\n", W, H, WINDOWS,
+           WINDOW_W, WINDOW_H, SPRITES, SPRITE, SPRITE, LINES, FRAMES);
+    printf("%6s %14s %14s %14s %8s %10s %10s\n", "layers", "direct KB", "tiled read KB", "tiled write KB", "saved",
+           "direct us", "tiled us");
+    for(int depth = 1; depth <= MAX_DEPTH; depth *= 2) {
+        uint64_t direct_bytes = 0;
+        int64_t start = test_wall_time_us();
+        for(int frame = 0; frame < FRAMES; frame++) {
+            direct_bytes = draw_direct(depth);
+        }
+        const double direct_us = (double) (test_wall_time_us() - start) / FRAMES;
+
+        start = test_wall_time_us();
+        for(int frame = 0; frame < FRAMES; frame++) {
+            if(draw_tiled(tiler, depth) != ESP_OK) {
+                fprintf(stderr, "tiled frame failed at %d layers\n", depth);
+                esp_bsp_sdl_tiler_delete(tiler);
+                return 1;
+            }
+        }
+        const double tiled_us = (double) (test_wall_time_us() - start) / FRAMES;
+
+        esp_bsp_sdl_tiler_stats_t stats;
+        esp_bsp_sdl_tiler_get_stats(tiler, &stats);
+        const uint64_t tiled_bytes = stats.target_read + stats.target_written;
+        printf("%6d %14.0f %14.0f %14.0f %7.0f%% %10.0f %10.0f\n", depth, direct_bytes / 1024.0,
+               stats.target_read / 1024.0, stats.target_written / 1024.0,
+               100.0 - 100.0 * (double) tiled_bytes / (double) direct_bytes, direct_us, tiled_us);
+    }
+    esp_bsp_sdl_tiler_delete(tiler);
+    return 0;
+}
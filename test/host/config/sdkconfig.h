@@ -0,0 +1,26 @@
+/**
+ * @file sdkconfig.h
+ * @brief Configuration of the host build: virtual board with an off-centre visible area
+ *
+ * The 64x48 panel sits at column 2, row 8 of a 68x64 controller RAM, so rotation only lands on
+ * the visible area when the gaps are recomputed per orientation.
+ */
+
+#pragma once
+
+#define CONFIG_SDL_BSP_VIRTUAL                  1
+#define CONFIG_SDL_BSP_VIRTUAL_WIDTH            64
+#define CONFIG_SDL_BSP_VIRTUAL_HEIGHT           48
+#define CONFIG_SDL_BSP_VIRTUAL_X_GAP            2
+#define CONFIG_SDL_BSP_VIRTUAL_Y_GAP            8
+#define CONFIG_SDL_BSP_VIRTUAL_RAM_WIDTH        68
+#define CONFIG_SDL_BSP_VIRTUAL_RAM_HEIGHT       64
+#define CONFIG_SDL_BSP_VIRTUAL_TOUCH_LATENCY_US 400
+#define CONFIG_SDL_BSP_VIRTUAL_BUS_ESP_BOX_3    1
+
+#define CONFIG_SDL_BSP_WINDOW_CACHE    1
+#define CONFIG_SDL_BSP_PLACEMENT_AUTO  1
+#define CONFIG_SDL_BSP_DMA_COPY        1
+#define CONFIG_SDL_BSP_DMA_MIN_BYTES   4096
+#define CONFIG_SDL_BSP_PANEL_GAMMA     1
+#define CONFIG_ESP_LCD_TOUCH_MAX_POINTS 5
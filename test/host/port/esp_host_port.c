@@ -0,0 +1,595 @@
+/**
+ * @file esp_host_port.c
+ * @brief Single-threaded ESP-IDF stand-ins for running the component on Linux
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_async_memcpy.h"
+#include "esp_cache.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_host_port.h"
+#include "esp_lcd_panel_interface.h"
+#include "esp_lcd_panel_io_interface.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_touch.h"
+#include "esp_memory_utils.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define MAX_TIMERS 8
+#define US_PER_TICK 1000
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    bool used;
+    bool armed;
+    int64_t due_us;
+};
+
+struct host_semaphore_t {
+    UBaseType_t count;
+    UBaseType_t max_count;
+};
+
+static int64_t s_now_us = 0;
+static struct esp_timer s_timers[MAX_TIMERS];
+static size_t s_heap_used = 0;
+
+// Error names
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch(code) {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:
+            return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:
+            return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:
+            return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        default:
+            return "UNKNOWN ERROR";
+    }
+}
+
+// Heap: every allocation is internal DMA-capable memory. malloc() and friends are wrapped at link
+// time (-Wl,--wrap), so plain allocations of the component count like on the target heap.
+
+#define HOST_HEAP_SIZE (64 * 1024 * 1024)
+
+static size_t s_heap_min_free = HOST_HEAP_SIZE;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__real_aligned_alloc(size_t alignment, size_t size);
+void __real_free(void *ptr);
+
+static void *track(void *ptr)
+{
+    if(ptr) {
+        s_heap_used += malloc_usable_size(ptr);
+        if(HOST_HEAP_SIZE - s_heap_used < s_heap_min_free) {
+            s_heap_min_free = HOST_HEAP_SIZE - s_heap_used;
+        }
+    }
+    return ptr;
+}
+
+void *__wrap_malloc(size_t size)
+{
+    return track(__real_malloc(size));
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    return track(__real_calloc(n, size));
+}
+
+void *__wrap_aligned_alloc(size_t alignment, size_t size)
+{
+    return track(__real_aligned_alloc(alignment, size));
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    const size_t old_size = ptr ? malloc_usable_size(ptr) : 0;
+    void *moved = __real_realloc(ptr, size);
+    if(moved || size == 0) {
+        s_heap_used -= old_size;
+    }
+    return track(moved);
+}
+
+void __wrap_free(void *ptr)
+{
+    if(ptr) {
+        s_heap_used -= malloc_usable_size(ptr);
+        __real_free(ptr);
+    }
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    return calloc(n, size);
+}
+
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps)
+{
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps)
+{
+    return realloc(ptr, size);
+}
+
+void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? 0 : HOST_HEAP_SIZE - s_heap_used;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) ? 0 : s_heap_min_free;
+}
+
+size_t heap_caps_get_allocated_size(void *ptr)
+{
+    return malloc_usable_size(ptr);
+}
+
+size_t esp_host_port_heap_used(void)
+{
+    return s_heap_used;
+}
+
+// Caller-owned memory standing in for PSRAM
+static const void *s_external_start = NULL;
+static size_t s_external_size = 0;
+
+void esp_host_port_set_external_ram(const void *start, size_t size)
+{
+    s_external_start = start;
+    s_external_size = start ? size : 0;
+}
+
+bool esp_ptr_external_ram(const void *p)
+{
+    return s_external_size && (uintptr_t) p - (uintptr_t) s_external_start < s_external_size;
+}
+
+// The host has no DMA restrictions, only memory marked as PSRAM is out of reach like on the chip
+bool esp_ptr_dma_capable(const void *p)
+{
+    return !esp_ptr_external_ram(p);
+}
+
+// Cache and DMA memcpy: host memory is coherent, there is no DMA engine
+
+esp_err_t esp_cache_msync(void *addr, size_t size, int flags)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_cache_get_alignment(uint32_t heap_caps, size_t *out_alignment)
+{
+    *out_alignment = 4;
+    return ESP_OK;
+}
+
+// DMA memcpy: transfers complete synchronously, their callback runs before esp_async_memcpy() returns
+
+static struct async_memcpy_context_t {
+    bool installed;
+    esp_host_port_dma_stats_t stats;
+} s_mcp;
+
+esp_err_t esp_async_memcpy_install(const async_memcpy_config_t *config, async_memcpy_handle_t *mcp)
+{
+    if(s_mcp.installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_mcp.installed = true;
+    *mcp = &s_mcp;
+    return ESP_OK;
+}
+
+esp_err_t esp_async_memcpy_uninstall(async_memcpy_handle_t mcp)
+{
+    mcp->installed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_async_memcpy(async_memcpy_handle_t mcp,
+                           void *dst,
+                           void *src,
+                           size_t n,
+                           async_memcpy_isr_cb_t cb_isr,
+                           void *cb_args)
+{
+    if(!mcp->installed || n == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, src, n);
+    mcp->stats.transfers++;
+    mcp->stats.bytes += n;
+    if(!mcp->stats.min_size || n < mcp->stats.min_size) {
+        mcp->stats.min_size = n;
+    }
+    if(n > mcp->stats.max_size) {
+        mcp->stats.max_size = n;
+    }
+    if(cb_isr) {
+        async_memcpy_event_t event = {0};
+        cb_isr(mcp, &event, cb_args);
+    }
+    return ESP_OK;
+}
+
+void esp_host_port_dma_get_stats(esp_host_port_dma_stats_t *stats)
+{
+    *stats = s_mcp.stats;
+}
+
+void esp_host_port_dma_reset_stats(void)
+{
+    memset(&s_mcp.stats, 0, sizeof(s_mcp.stats));
+}
+
+// Simulated clock and one-shot timers
+
+static struct esp_timer *next_timer(int64_t until_us)
+{
+    struct esp_timer *next = NULL;
+    for(int i = 0; i < MAX_TIMERS; i++) {
+        struct esp_timer *t = &s_timers[i];
+        if(t->used && t->armed && t->due_us <= until_us && (!next || t->due_us < next->due_us)) {
+            next = t;
+        }
+    }
+    return next;
+}
+
+static void run_timer(struct esp_timer *timer)
+{
+    if(timer->due_us > s_now_us) {
+        s_now_us = timer->due_us;
+    }
+    timer->armed = false;
+    timer->callback(timer->arg);
+}
+
+int esp_host_port_run_next_timer(void)
+{
+    struct esp_timer *timer = next_timer(INT64_MAX);
+    if(!timer) {
+        return 0;
+    }
+    run_timer(timer);
+    return 1;
+}
+
+void esp_host_port_advance(int64_t us)
+{
+    const int64_t until_us = s_now_us + us;
+    struct esp_timer *timer;
+    while((timer = next_timer(until_us)) != NULL) {
+        run_timer(timer);
+    }
+    s_now_us = until_us;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if(!create_args || !create_args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for(int i = 0; i < MAX_TIMERS; i++) {
+        if(!s_timers[i].used) {
+            s_timers[i] = (struct esp_timer) {
+                .callback = create_args->callback,
+                .arg = create_args->arg,
+                .used = true,
+            };
+            *out_handle = &s_timers[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if(!timer || timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = true;
+    timer->due_us = s_now_us + (int64_t) timeout_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if(!timer || !timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if(!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->used = false;
+    timer->armed = false;
+    return ESP_OK;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    esp_host_port_advance(us);
+}
+
+// FreeRTOS: one task, blocking runs the clock
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    SemaphoreHandle_t semaphore = calloc(1, sizeof(*semaphore));
+    if(semaphore) {
+        semaphore->count = initial_count;
+        semaphore->max_count = max_count;
+    }
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait)
+{
+    const int64_t deadline_us =
+        ticks_to_wait == portMAX_DELAY ? INT64_MAX : s_now_us + (int64_t) ticks_to_wait * US_PER_TICK;
+    while(semaphore->count == 0) {
+        struct esp_timer *timer = next_timer(deadline_us);
+        if(timer) {
+            run_timer(timer);
+        } else if(ticks_to_wait == portMAX_DELAY) {
+            fprintf(stderr, "host port: semaphore taken forever with no timer armed\n");
+            abort();
+        } else {
+            s_now_us = deadline_us;
+            return pdFALSE;
+        }
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    if(semaphore->count >= semaphore->max_count) {
+        return pdFALSE;
+    }
+    semaphore->count++;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *higher_priority_task_woken)
+{
+    if(higher_priority_task_woken) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+    return xSemaphoreGive(semaphore);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore)
+{
+    return semaphore->count;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    free(semaphore);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    esp_host_port_advance((int64_t) ticks * US_PER_TICK);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function,
+                       const char *name,
+                       uint32_t stack_depth,
+                       void *arg,
+                       UBaseType_t priority,
+                       TaskHandle_t *created_task)
+{
+    fprintf(stderr, "host port: task %s not created, the host runs a single task\n", name);
+    return pdFAIL;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    if(ticks_to_wait != portMAX_DELAY) {
+        vTaskDelay(ticks_to_wait);
+    }
+    return 0;
+}
+
+// esp_lcd: dispatch to the driver interfaces
+
+esp_err_t esp_lcd_panel_io_rx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, void *param, size_t param_size)
+{
+    return io->rx_param ? io->rx_param(io, lcd_cmd, param, param_size) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
+{
+    return io->tx_param(io, lcd_cmd, param, param_size);
+}
+
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color, size_t color_size)
+{
+    return io->tx_color(io, lcd_cmd, color, color_size);
+}
+
+esp_err_t esp_lcd_panel_io_del(esp_lcd_panel_io_handle_t io)
+{
+    return io->del(io);
+}
+
+esp_err_t esp_lcd_panel_io_register_event_callbacks(esp_lcd_panel_io_handle_t io,
+                                                    const esp_lcd_panel_io_callbacks_t *cbs,
+                                                    void *user_ctx)
+{
+    return io->register_event_callbacks(io, cbs, user_ctx);
+}
+
+esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel)
+{
+    return panel->reset(panel);
+}
+
+esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel)
+{
+    return panel->init(panel);
+}
+
+esp_err_t esp_lcd_panel_del(esp_lcd_panel_handle_t panel)
+{
+    return panel->del(panel);
+}
+
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel,
+                                    int x_start,
+                                    int y_start,
+                                    int x_end,
+                                    int y_end,
+                                    const void *color_data)
+{
+    return panel->draw_bitmap(panel, x_start, y_start, x_end, y_end, color_data);
+}
+
+esp_err_t esp_lcd_panel_mirror(esp_lcd_panel_handle_t panel, bool mirror_x, bool mirror_y)
+{
+    return panel->mirror ? panel->mirror(panel, mirror_x, mirror_y) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_swap_xy(esp_lcd_panel_handle_t panel, bool swap_axes)
+{
+    return panel->swap_xy ? panel->swap_xy(panel, swap_axes) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_set_gap(esp_lcd_panel_handle_t panel, int x_gap, int y_gap)
+{
+    return panel->set_gap ? panel->set_gap(panel, x_gap, y_gap) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_invert_color(esp_lcd_panel_handle_t panel, bool invert_color_data)
+{
+    return panel->invert_color ? panel->invert_color(panel, invert_color_data) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_disp_on_off(esp_lcd_panel_handle_t panel, bool on_off)
+{
+    return panel->disp_on_off ? panel->disp_on_off(panel, on_off) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_disp_sleep(esp_lcd_panel_handle_t panel, bool sleep)
+{
+    return panel->disp_sleep ? panel->disp_sleep(panel, sleep) : ESP_ERR_NOT_SUPPORTED;
+}
+
+// esp_lcd_touch: software mirror and swap for drivers without the setters
+
+esp_err_t esp_lcd_touch_read_data(esp_lcd_touch_handle_t tp)
+{
+    return tp->read_data(tp);
+}
+
+bool esp_lcd_touch_get_coordinates(esp_lcd_touch_handle_t tp,
+                                   uint16_t *x,
+                                   uint16_t *y,
+                                   uint16_t *strength,
+                                   uint8_t *point_num,
+                                   uint8_t max_point_num)
+{
+    const bool touched = tp->get_xy(tp, x, y, strength, point_num, max_point_num);
+    if(!touched) {
+        return false;
+    }
+    if(tp->config.process_coordinates) {
+        tp->config.process_coordinates(tp, x, y, strength, point_num, max_point_num);
+    }
+    for(int i = 0; i < *point_num; i++) {
+        if(tp->config.flags.mirror_x && !tp->set_mirror_x) {
+            x[i] = tp->config.x_max - x[i];
+        }
+        if(tp->config.flags.mirror_y && !tp->set_mirror_y) {
+            y[i] = tp->config.y_max - y[i];
+        }
+        if(tp->config.flags.swap_xy && !tp->set_swap_xy) {
+            const uint16_t t = x[i];
+            x[i] = y[i];
+            y[i] = t;
+        }
+    }
+    return touched;
+}
+
+esp_err_t esp_lcd_touch_del(esp_lcd_touch_handle_t tp)
+{
+    return tp->del ? tp->del(tp) : ESP_OK;
+}
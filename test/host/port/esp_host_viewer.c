@@ -0,0 +1,128 @@
+/**
+ * @file esp_host_viewer.c
+ * @brief Shared-memory export of a virtual panel for a live preview on the host
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "esp_bsp_sdl_touch_mock.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "esp_host_viewer.h"
+#include "esp_log.h"
+
+static const char *TAG = "esp_host_viewer";
+
+static esp_host_viewer_shm_t *s_shm;
+static size_t s_shm_size;
+static char s_name[64];
+static esp_lcd_panel_handle_t s_panel;
+static esp_lcd_touch_handle_t s_touch;
+static uint32_t s_touch_seq;
+
+static void copy_area(const esp_bsp_sdl_surface_t *frame, const esp_bsp_sdl_rect_t *area)
+{
+    __atomic_store_n(&s_shm->frame_seq, s_shm->frame_seq + 1, __ATOMIC_RELEASE);
+    for(int y = area->y; y < area->y + area->h; y++) {
+        memcpy(&s_shm->pixels[y * s_shm->width + area->x],
+               &frame->pixels[y * frame->stride + area->x],
+               area->w * sizeof(uint16_t));
+    }
+    s_shm->dirty_x = area->x;
+    s_shm->dirty_y = area->y;
+    s_shm->dirty_w = area->w;
+    s_shm->dirty_h = area->h;
+    __atomic_store_n(&s_shm->frame_seq, s_shm->frame_seq + 1, __ATOMIC_RELEASE);
+}
+
+static void on_frame(const esp_bsp_sdl_surface_t *frame, const esp_bsp_sdl_rect_t *area, void *user_ctx)
+{
+    copy_area(frame, area);
+}
+
+esp_err_t esp_host_viewer_start(const char *name, esp_lcd_panel_handle_t panel, esp_lcd_touch_handle_t touch)
+{
+    if(!name || name[0] != '/' || strlen(name) >= sizeof(s_name) || !esp_bsp_sdl_is_virtual_panel(panel) ||
+       (touch && !esp_bsp_sdl_is_touch_mock(touch))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(s_shm) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_bsp_sdl_surface_t frame;
+    esp_err_t ret = esp_bsp_sdl_virtual_panel_get_frame(panel, &frame);
+    if(ret != ESP_OK) {
+        return ret;
+    }
+
+    const size_t size = sizeof(esp_host_viewer_shm_t) + (size_t) frame.width * frame.height * sizeof(uint16_t);
+    const int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if(fd < 0) {
+        ESP_LOGE(TAG, "Failed to create %s", name);
+        return ESP_FAIL;
+    }
+    void *map = MAP_FAILED;
+    if(ftruncate(fd, (off_t) size) == 0) {
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if(map == MAP_FAILED) {
+        ESP_LOGE(TAG, "Failed to map %s", name);
+        shm_unlink(name);
+        return ESP_FAIL;
+    }
+
+    s_shm = map;
+    s_shm_size = size;
+    strcpy(s_name, name);
+    s_panel = panel;
+    s_touch = touch;
+    s_touch_seq = 0;
+    s_shm->width = frame.width;
+    s_shm->height = frame.height;
+    copy_area(&frame, &(esp_bsp_sdl_rect_t) {0, 0, frame.width, frame.height});
+    __atomic_store_n(&s_shm->magic, ESP_HOST_VIEWER_MAGIC, __ATOMIC_RELEASE);
+
+    esp_bsp_sdl_virtual_panel_set_listener(panel, on_frame, NULL);
+    ESP_LOGI(TAG, "Exporting %dx%d frames to %s", frame.width, frame.height, name);
+    return ESP_OK;
+}
+
+esp_err_t esp_host_viewer_poll(void)
+{
+    if(!s_shm) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const uint32_t seq = __atomic_load_n(&s_shm->touch_seq, __ATOMIC_ACQUIRE);
+    if(!s_touch || seq == s_touch_seq) {
+        return ESP_OK;
+    }
+    s_touch_seq = seq;
+
+    esp_bsp_sdl_touch_mock_frame_t contact = {0};
+    if(s_shm->touch_pressed) {
+        contact.points = 1;
+        contact.coords[0].x = s_shm->touch_x;
+        contact.coords[0].y = s_shm->touch_y;
+        contact.coords[0].strength = 1;
+    }
+    return esp_bsp_sdl_touch_mock_inject(s_touch, &contact);
+}
+
+void esp_host_viewer_stop(void)
+{
+    if(!s_shm) {
+        return;
+    }
+    esp_bsp_sdl_virtual_panel_set_listener(s_panel, NULL, NULL);
+    if(s_touch) {
+        esp_bsp_sdl_touch_mock_inject(s_touch, NULL);
+    }
+    munmap(s_shm, s_shm_size);
+    shm_unlink(s_name);
+    s_shm = NULL;
+    s_panel = NULL;
+    s_touch = NULL;
+}
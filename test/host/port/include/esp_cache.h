@@ -0,0 +1,18 @@
+/**
+ * @file esp_cache.h
+ * @brief Host stand-in for the cache maintenance API, host memory is coherent
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define ESP_CACHE_MSYNC_FLAG_INVALIDATE (1 << 0)
+#define ESP_CACHE_MSYNC_FLAG_UNALIGNED  (1 << 1)
+#define ESP_CACHE_MSYNC_FLAG_DIR_C2M    (1 << 2)
+#define ESP_CACHE_MSYNC_FLAG_DIR_M2C    (1 << 3)
+
+esp_err_t esp_cache_msync(void *addr, size_t size, int flags);
+esp_err_t esp_cache_get_alignment(uint32_t heap_caps, size_t *out_alignment);
@@ -0,0 +1,72 @@
+/**
+ * @file esp_host_port.h
+ * @brief Controls of the host port that runs the component on Linux
+ *
+ * The port replaces esp_lcd, esp_timer, the heap, DMA memcpy and FreeRTOS semaphores with single-threaded
+ * stand-ins. Time is simulated: it advances in busy waits, task delays and semaphore takes that
+ * would block, which run due one-shot timers in order. Bus transfers of a virtual panel with a
+ * timing model therefore take their modelled duration, independent of the host machine.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Run the simulated clock forward, calling the timers that become due
+ *
+ * @param us Microseconds to advance
+ */
+void esp_host_port_advance(int64_t us);
+
+/**
+ * @brief Run the simulated clock to the next armed timer and call it
+ *
+ * @return 1 if a timer ran, 0 if none is armed
+ */
+int esp_host_port_run_next_timer(void);
+
+/**
+ * @brief Bytes currently allocated on the heap stand-in, plain malloc() included
+ */
+size_t esp_host_port_heap_used(void);
+
+/**
+ * @brief Treat a memory region as PSRAM
+ *
+ * esp_ptr_external_ram() is true and esp_ptr_dma_capable() false inside the region, so code paths
+ * for frames in PSRAM run on the host. All other memory stays internal and DMA-capable.
+ *
+ * @param start First byte of the region, NULL to clear it
+ * @param size Region size in bytes
+ */
+void esp_host_port_set_external_ram(const void *start, size_t size);
+
+/**
+ * @brief Transfers through the DMA memcpy stand-in
+ */
+typedef struct {
+    uint32_t transfers; /*!< esp_async_memcpy() calls accepted */
+    uint64_t bytes;     /*!< Bytes copied */
+    size_t min_size;    /*!< Smallest transfer, 0 before the first one */
+    size_t max_size;    /*!< Largest transfer */
+} esp_host_port_dma_stats_t;
+
+/**
+ * @brief Get the DMA memcpy counters
+ */
+void esp_host_port_dma_get_stats(esp_host_port_dma_stats_t *stats);
+
+/**
+ * @brief Reset the DMA memcpy counters
+ */
+void esp_host_port_dma_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,80 @@
+/**
+ * @file esp_host_viewer.h
+ * @brief Shared-memory export of a virtual panel for a live preview on the host
+ *
+ * The exporter copies every completed color transfer from the virtual panel's frame listener
+ * into a POSIX shared memory segment, the only copy of the pixels. A viewer process maps the
+ * segment, shows the frame at board resolution and writes the mouse state back, which
+ * esp_host_viewer_poll() injects into the mock touch controller. The segment layout is the
+ * contract between both sides; viewer_sdl.c is the reference viewer.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_touch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_HOST_VIEWER_MAGIC 0x57564245 /*!< "EBVW", set once the segment is initialized */
+
+/**
+ * @brief Shared memory segment, followed by the frame pixels
+ *
+ * frame_seq is odd while the exporter writes pixels and even otherwise, so a viewer that reads
+ * the same even value before and after reading the pixels got a consistent frame. touch_seq is
+ * incremented by the viewer after it updated the touch fields.
+ */
+typedef struct {
+    uint32_t magic;          /*!< ESP_HOST_VIEWER_MAGIC */
+    uint16_t width;          /*!< Frame width, native panel orientation */
+    uint16_t height;         /*!< Frame height */
+    uint32_t frame_seq;      /*!< Written by the exporter */
+    int16_t dirty_x;         /*!< Area written by the last update */
+    int16_t dirty_y;         /*!< Area written by the last update */
+    int16_t dirty_w;         /*!< Area written by the last update */
+    int16_t dirty_h;         /*!< Area written by the last update */
+    uint32_t touch_seq;      /*!< Written by the viewer */
+    uint16_t touch_x;        /*!< Contact column in frame pixels */
+    uint16_t touch_y;        /*!< Contact row in frame pixels */
+    uint8_t touch_pressed;   /*!< Mouse button held over the frame */
+    uint8_t reserved[3];     /*!< Zero */
+    uint16_t pixels[];       /*!< width * height pixels in the byte order sent to the panel */
+} esp_host_viewer_shm_t;
+
+/**
+ * @brief Start exporting a virtual panel
+ *
+ * Creates (or replaces) the segment, fills it with the current frame and takes over the panel's
+ * frame listener until esp_host_viewer_stop().
+ *
+ * @param name Shared memory name, starting with '/'
+ * @param panel Virtual panel handle
+ * @param touch Mock touch handle fed by the viewer's mouse (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if panel is not a virtual panel or touch not a
+ *         mock, ESP_ERR_INVALID_STATE if already exporting, ESP_FAIL if the segment cannot be created
+ */
+esp_err_t esp_host_viewer_start(const char *name, esp_lcd_panel_handle_t panel, esp_lcd_touch_handle_t touch);
+
+/**
+ * @brief Pick up mouse input written by the viewer
+ *
+ * Injects the contact into the mock touch controller when touch_seq changed; a released button
+ * injects a release. Call it from the loop that reads the touch.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not exporting
+ */
+esp_err_t esp_host_viewer_poll(void);
+
+/**
+ * @brief Stop exporting, remove the segment and hand touch back to its script
+ */
+void esp_host_viewer_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,8 @@
+/**
+ * @file esp_lcd_panel_vendor.h
+ * @brief Host stand-in, vendor panel drivers are not available on the host
+ */
+
+#pragma once
+
+#include "esp_lcd_types.h"
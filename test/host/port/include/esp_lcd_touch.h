@@ -0,0 +1,89 @@
+/**
+ * @file esp_lcd_touch.h
+ * @brief Host stand-in for the esp_lcd_touch component
+ *
+ * esp_lcd_touch_get_coordinates() applies mirror and swap flags in software for drivers without
+ * the matching setters, like the component does.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_lcd_types.h"
+#include "freertos/FreeRTOS.h"
+
+#ifndef CONFIG_ESP_LCD_TOUCH_MAX_POINTS
+#    define CONFIG_ESP_LCD_TOUCH_MAX_POINTS 5
+#endif
+
+typedef struct esp_lcd_touch_s esp_lcd_touch_t;
+typedef esp_lcd_touch_t *esp_lcd_touch_handle_t;
+typedef void (*esp_lcd_touch_interrupt_callback_t)(esp_lcd_touch_handle_t tp);
+
+typedef struct {
+    uint16_t x_max;
+    uint16_t y_max;
+    int rst_gpio_num;
+    int int_gpio_num;
+    struct {
+        unsigned int reset : 1;
+        unsigned int interrupt : 1;
+    } levels;
+    struct {
+        unsigned int swap_xy : 1;
+        unsigned int mirror_x : 1;
+        unsigned int mirror_y : 1;
+    } flags;
+    void (*process_coordinates)(esp_lcd_touch_handle_t tp,
+                                uint16_t *x,
+                                uint16_t *y,
+                                uint16_t *strength,
+                                uint8_t *point_num,
+                                uint8_t max_point_num);
+    esp_lcd_touch_interrupt_callback_t interrupt_callback;
+    void *user_data;
+    void *driver_data;
+} esp_lcd_touch_config_t;
+
+typedef struct {
+    uint8_t points;
+    struct {
+        uint16_t x;
+        uint16_t y;
+        uint16_t strength;
+        uint8_t track_id;
+    } coords[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
+    portMUX_TYPE lock;
+} esp_lcd_touch_data_t;
+
+struct esp_lcd_touch_s {
+    esp_err_t (*enter_sleep)(esp_lcd_touch_handle_t tp);
+    esp_err_t (*exit_sleep)(esp_lcd_touch_handle_t tp);
+    esp_err_t (*read_data)(esp_lcd_touch_handle_t tp);
+    bool (*get_xy)(esp_lcd_touch_handle_t tp,
+                   uint16_t *x,
+                   uint16_t *y,
+                   uint16_t *strength,
+                   uint8_t *point_num,
+                   uint8_t max_point_num);
+    esp_err_t (*set_swap_xy)(esp_lcd_touch_handle_t tp, bool swap);
+    esp_err_t (*get_swap_xy)(esp_lcd_touch_handle_t tp, bool *swap);
+    esp_err_t (*set_mirror_x)(esp_lcd_touch_handle_t tp, bool mirror);
+    esp_err_t (*get_mirror_x)(esp_lcd_touch_handle_t tp, bool *mirror);
+    esp_err_t (*set_mirror_y)(esp_lcd_touch_handle_t tp, bool mirror);
+    esp_err_t (*get_mirror_y)(esp_lcd_touch_handle_t tp, bool *mirror);
+    esp_err_t (*del)(esp_lcd_touch_handle_t tp);
+    esp_lcd_touch_config_t config;
+    esp_lcd_panel_io_handle_t io;
+    esp_lcd_touch_data_t data;
+};
+
+esp_err_t esp_lcd_touch_read_data(esp_lcd_touch_handle_t tp);
+bool esp_lcd_touch_get_coordinates(esp_lcd_touch_handle_t tp,
+                                   uint16_t *x,
+                                   uint16_t *y,
+                                   uint16_t *strength,
+                                   uint8_t *point_num,
+                                   uint8_t max_point_num);
+esp_err_t esp_lcd_touch_del(esp_lcd_touch_handle_t tp);
@@ -0,0 +1,35 @@
+/**
+ * @file esp_lcd_types.h
+ * @brief Host stand-in for the esp_lcd handle and callback types
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifndef __containerof
+#    define __containerof(ptr, type, member) ((type *) ((char *) (ptr) - offsetof(type, member)))
+#endif
+
+typedef struct esp_lcd_panel_io_t *esp_lcd_panel_io_handle_t;
+typedef struct esp_lcd_panel_t *esp_lcd_panel_handle_t;
+
+typedef struct {
+    void *reserved;
+} esp_lcd_panel_io_event_data_t;
+
+typedef bool (*esp_lcd_panel_io_color_trans_done_cb_t)(esp_lcd_panel_io_handle_t panel_io,
+                                                       esp_lcd_panel_io_event_data_t *edata,
+                                                       void *user_ctx);
+
+typedef enum {
+    LCD_RGB_ELEMENT_ORDER_RGB,
+    LCD_RGB_ELEMENT_ORDER_BGR,
+} lcd_rgb_element_order_t;
+
+typedef enum {
+    LCD_RGB_DATA_ENDIAN_BIG,
+    LCD_RGB_DATA_ENDIAN_LITTLE,
+} lcd_rgb_data_endian_t;
@@ -0,0 +1,23 @@
+/**
+ * @file esp_log.h
+ * @brief Host stand-in for the ESP-IDF logging macros, errors and warnings go to stderr
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W %s: " format "\n", tag, ##__VA_ARGS__)
+
+// Below the host log level, still type-checked like the IDF macros
+#define ESP_LOG_SILENT(tag, format, ...)                                                                               \
+    do {                                                                                                               \
+        if(0) {                                                                                                        \
+            printf("%s: " format "\n", tag, ##__VA_ARGS__);                                                            \
+        }                                                                                                              \
+    } while(0)
+
+#define ESP_LOGI(tag, format, ...) ESP_LOG_SILENT(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_SILENT(tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_SILENT(tag, format, ##__VA_ARGS__)
@@ -0,0 +1,11 @@
+/**
+ * @file esp_memory_utils.h
+ * @brief Host stand-in for the memory region checks
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+bool esp_ptr_external_ram(const void *p);
+bool esp_ptr_dma_capable(const void *p);
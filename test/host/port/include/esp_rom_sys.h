@@ -0,0 +1,10 @@
+/**
+ * @file esp_rom_sys.h
+ * @brief Host stand-in for the ROM busy wait, advances the simulated clock
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+void esp_rom_delay_us(uint32_t us);
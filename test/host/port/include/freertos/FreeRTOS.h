@@ -0,0 +1,31 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS types, the host runs a single task
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE           1
+#define pdFALSE          0
+#define pdPASS           pdTRUE
+#define pdFAIL           pdFALSE
+#define portMAX_DELAY    ((TickType_t) 0xFFFFFFFF)
+#define pdMS_TO_TICKS(x) ((TickType_t) (x)) // 1 kHz tick
+
+typedef struct {
+    int owner;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portMUX_INITIALIZE(mux)      ((mux)->owner = 0)
+#define portENTER_CRITICAL(mux)      ((void) (mux))
+#define portEXIT_CRITICAL(mux)       ((void) (mux))
+#define portENTER_CRITICAL_ISR(mux)  ((void) (mux))
+#define portEXIT_CRITICAL_ISR(mux)   ((void) (mux))
+#define portYIELD_FROM_ISR()         ((void) 0)
@@ -0,0 +1,24 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for FreeRTOS task delays, tasks cannot be created on the host
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task_t *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+#define tskIDLE_PRIORITY 0
+
+void vTaskDelay(TickType_t ticks);
+BaseType_t xTaskCreate(TaskFunction_t function,
+                       const char *name,
+                       uint32_t stack_depth,
+                       void *arg,
+                       UBaseType_t priority,
+                       TaskHandle_t *created_task);
+void vTaskDelete(TaskHandle_t task);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
@@ -0,0 +1,78 @@
+/**
+ * @file preview_demo.c
+ * @brief Virtual board exported for viewer_sdl: an animated frame with a marker under the mouse
+ *
+ * Usage: preview_demo [name], default /esp_bsp_sdl_preview; stop with Ctrl+C
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_touch_mock.h"
+#include "esp_host_port.h"
+#include "esp_host_viewer.h"
+#include "sdkconfig.h"
+
+#define NATIVE_W CONFIG_SDL_BSP_VIRTUAL_WIDTH
+#define NATIVE_H CONFIG_SDL_BSP_VIRTUAL_HEIGHT
+#define FRAME_US 33000
+
+static uint16_t s_frame[NATIVE_W * NATIVE_H];
+static volatile sig_atomic_t s_running = 1;
+
+static void on_signal(int sig)
+{
+    s_running = 0;
+}
+
+static void render(int t, const esp_bsp_sdl_touch_info_t *touch)
+{
+    for(int y = 0; y < NATIVE_H; y++) {
+        for(int x = 0; x < NATIVE_W; x++) {
+            const int r = (x + t) & 0x1F;
+            const int g = (y * 2 + t) & 0x3F;
+            s_frame[y * NATIVE_W + x] = (uint16_t) (r << 11 | g << 5 | 0x10);
+        }
+    }
+    if(touch->pressed) {
+        for(int y = touch->y - 2; y <= touch->y + 2; y++) {
+            for(int x = touch->x - 2; x <= touch->x + 2; x++) {
+                if(x >= 0 && x < NATIVE_W && y >= 0 && y < NATIVE_H) {
+                    s_frame[y * NATIVE_W + x] = 0xFFFF;
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = argc > 1 ? argv[1] : "/esp_bsp_sdl_preview";
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_handle_t panel;
+    esp_lcd_panel_io_handle_t io;
+    if(esp_bsp_sdl_init(&config, &panel, &io) != ESP_OK || esp_bsp_sdl_touch_init() != ESP_OK ||
+       esp_host_viewer_start(name, panel, esp_bsp_sdl_virtual_get_touch()) != ESP_OK) {
+        fprintf(stderr, "cannot start the export\n");
+        return 1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    printf("Exporting to %s, run: viewer_sdl %s 4\n", name, name);
+
+    for(int t = 0; s_running; t++) {
+        esp_bsp_sdl_touch_info_t touch = {0};
+        esp_host_viewer_poll();
+        esp_bsp_sdl_touch_read(&touch);
+        render(t, &touch);
+        esp_bsp_sdl_flush_frame(s_frame);
+        // Keep the simulated clock roughly in step with the wall clock
+        esp_host_port_advance(FRAME_US);
+        usleep(FRAME_US);
+    }
+
+    esp_host_viewer_stop();
+    esp_bsp_sdl_deinit();
+    return 0;
+}
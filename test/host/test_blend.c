@@ -0,0 +1,160 @@
+/**
+ * @file test_blend.c
+ * @brief SWAR blend kernels are bit-exact with the scalar reference
+ *
+ * Every kernel runs over every destination pixel for every alpha value with random sources, then
+ * over all pairs of channel extremes, where carries and saturation between channels would show.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_bsp_sdl_blend.h"
+#include "test_util.h"
+
+#define PIXELS 65536
+
+static uint16_t s_dst_scalar[PIXELS];
+static uint16_t s_dst_swar[PIXELS];
+static uint16_t s_dst_init[PIXELS];
+static uint16_t s_src565[PIXELS];
+static uint32_t s_src8888[PIXELS];
+static uint8_t s_alpha[PIXELS];
+
+static const esp_bsp_sdl_blend_kernels_t *s_scalar;
+static const esp_bsp_sdl_blend_kernels_t *s_swar;
+
+typedef enum {
+    KERNEL_ARGB8888_OVER,
+    KERNEL_ARGB8888_PREMUL_OVER,
+    KERNEL_RGB565_A8_OVER,
+    KERNEL_RGB565_A8_PREMUL_OVER,
+    KERNEL_RGB565_CONST_OVER,
+    KERNEL_COLOR_A8_OVER,
+    KERNEL_MAX,
+} kernel_t;
+
+static const char *const s_kernel_names[KERNEL_MAX] = {
+    "argb8888_over",
+    "argb8888_premul_over",
+    "rgb565_a8_over",
+    "rgb565_a8_premul_over",
+    "rgb565_const_over",
+    "color_a8_over",
+};
+
+static void run(const esp_bsp_sdl_blend_kernels_t *k, kernel_t kernel, uint16_t *dst, uint8_t alpha, int count)
+{
+    switch(kernel) {
+        case KERNEL_ARGB8888_OVER:
+            k->argb8888_over(dst, s_src8888, count);
+            break;
+        case KERNEL_ARGB8888_PREMUL_OVER:
+            k->argb8888_premul_over(dst, s_src8888, count);
+            break;
+        case KERNEL_RGB565_A8_OVER:
+            k->rgb565_a8_over(dst, s_src565, s_alpha, count);
+            break;
+        case KERNEL_RGB565_A8_PREMUL_OVER:
+            k->rgb565_a8_premul_over(dst, s_src565, s_alpha, count);
+            break;
+        case KERNEL_RGB565_CONST_OVER:
+            k->rgb565_const_over(dst, s_src565, alpha, count);
+            break;
+        default:
+            k->color_a8_over(dst, s_src565[0], s_alpha, count);
+            break;
+    }
+}
+
+// Run a kernel with both implementations on the prepared rows, report the first difference
+static bool compare(kernel_t kernel, uint8_t alpha, int count)
+{
+    memcpy(s_dst_scalar, s_dst_init, count * sizeof(uint16_t));
+    memcpy(s_dst_swar, s_dst_init, count * sizeof(uint16_t));
+    run(s_scalar, kernel, s_dst_scalar, alpha, count);
+    run(s_swar, kernel, s_dst_swar, alpha, count);
+    for(int i = 0; i < count; i++) {
+        if(s_dst_scalar[i] != s_dst_swar[i]) {
+            fprintf(stderr,
+                    "%s: dst 0x%04X src 0x%04X/0x%08X alpha %u: scalar 0x%04X, SWAR 0x%04X\n",
+                    s_kernel_names[kernel],
+                    s_dst_init[i],
+                    s_src565[i],
+                    (unsigned) s_src8888[i],
+                    kernel == KERNEL_RGB565_CONST_OVER ? alpha : s_alpha[i],
+                    s_dst_scalar[i],
+                    s_dst_swar[i]);
+            test_failures++;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every destination pixel for every alpha, random sources
+static void test_exhaustive_destination(void)
+{
+    for(int i = 0; i < PIXELS; i++) {
+        s_dst_init[i] = i;
+    }
+    bool failed[KERNEL_MAX] = {0};
+    for(int a = 0; a < 256; a++) {
+        for(int i = 0; i < PIXELS; i++) {
+            s_src565[i] = test_random();
+            s_src8888[i] = (test_random() & 0x00FFFFFF) | ((uint32_t) a << 24);
+            s_alpha[i] = a;
+        }
+        for(kernel_t kernel = 0; kernel < KERNEL_MAX; kernel++) {
+            if(!failed[kernel]) {
+                failed[kernel] = !compare(kernel, a, PIXELS);
+            }
+        }
+    }
+}
+
+// All pairs of colors built from channel extremes, where carries between channels would show
+static void test_channel_extremes(void)
+{
+    static const uint8_t levels5[] = {0, 1, 15, 16, 30, 31};
+    static const uint8_t levels6[] = {0, 1, 31, 32, 62, 63};
+    enum { LEVELS = sizeof(levels5), COLORS = LEVELS * LEVELS * LEVELS };
+    static uint16_t colors[COLORS];
+    for(int i = 0; i < COLORS; i++) {
+        colors[i] = (levels5[i / (LEVELS * LEVELS)] << 11) | (levels6[(i / LEVELS) % LEVELS] << 5) | levels5[i % LEVELS];
+    }
+
+    // One alpha per 5-bit weight the kernels use, 255 for the opaque one
+    for(kernel_t kernel = 0; kernel < KERNEL_MAX; kernel++) {
+        for(int step = 0; step <= 32; step++) {
+            const int a = step < 32 ? step * 8 : 255;
+            bool ok = true;
+            for(int s = 0; s < COLORS && ok; s++) {
+                for(int d = 0; d < COLORS; d++) {
+                    s_dst_init[d] = colors[d];
+                    s_src565[d] = colors[s];
+                    s_src8888[d] = ((uint32_t) a << 24) | ((colors[s] & 0xF800) << 8) | ((colors[s] & 0x07E0) << 5) |
+                                   ((colors[s] & 0x001F) << 3);
+                    s_alpha[d] = a;
+                }
+                ok = compare(kernel, a, COLORS);
+            }
+            if(!ok) {
+                break;
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    s_scalar = esp_bsp_sdl_blend_get_kernels(ESP_BSP_SDL_BLEND_IMPL_SCALAR);
+    s_swar = esp_bsp_sdl_blend_get_kernels(ESP_BSP_SDL_BLEND_IMPL_SWAR);
+    TEST_CHECK(s_scalar && s_swar);
+    if(test_failures) {
+        return test_finish("test_blend");
+    }
+
+    test_exhaustive_destination();
+    test_channel_extremes();
+    return test_finish("test_blend");
+}
@@ -0,0 +1,267 @@
+/**
+ * @file test_blit_queue.c
+ * @brief Blit queue: sorted, band-batched drawing matches drawing the sprites one by one
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_blend.h"
+#include "esp_bsp_sdl_blit_queue.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "test_util.h"
+
+#define TARGET_W  120
+#define TARGET_H  90
+#define TEXTURES  4
+#define TEX_SIZE  24
+#define SPRITES   300
+
+static uint16_t s_tex_pixels[TEXTURES][TEX_SIZE * TEX_SIZE];
+static esp_bsp_sdl_surface_t s_textures[TEXTURES];
+static esp_bsp_sdl_sprite_t s_sprites[SPRITES];
+static uint16_t s_target[TARGET_W * TARGET_H];
+static uint16_t s_expected[TARGET_W * TARGET_H];
+
+static int random_range(int lo, int hi)
+{
+    return lo + (int) (test_random() % (uint32_t) (hi - lo + 1));
+}
+
+static void init_textures(void)
+{
+    for(int t = 0; t < TEXTURES; t++) {
+        for(int i = 0; i < TEX_SIZE * TEX_SIZE; i++) {
+            s_tex_pixels[t][i] = (uint16_t) test_random();
+        }
+        s_textures[t] = (esp_bsp_sdl_surface_t) {s_tex_pixels[t], TEX_SIZE, TEX_SIZE, TEX_SIZE};
+    }
+}
+
+// Sprites partly outside their texture and the target, few z levels so textures share them
+static void make_sprites(int count)
+{
+    for(int i = 0; i < count; i++) {
+        esp_bsp_sdl_sprite_t *s = &s_sprites[i];
+        s->texture = &s_textures[random_range(0, TEXTURES - 1)];
+        s->src = (esp_bsp_sdl_rect_t) {random_range(-4, 16), random_range(-4, 16), random_range(1, 20), random_range(1, 20)};
+        s->dst_x = random_range(-20, TARGET_W);
+        s->dst_y = random_range(-20, TARGET_H);
+        s->z = random_range(0, 3);
+        s->alpha = test_random() & 1 ? 255 : (uint8_t) test_random();
+    }
+}
+
+static int compare_order(const void *a, const void *b)
+{
+    const esp_bsp_sdl_sprite_t *sa = *(const esp_bsp_sdl_sprite_t *const *) a;
+    const esp_bsp_sdl_sprite_t *sb = *(const esp_bsp_sdl_sprite_t *const *) b;
+    if(sa->z != sb->z) {
+        return sa->z < sb->z ? -1 : 1;
+    }
+    if(sa->texture->pixels != sb->texture->pixels) {
+        return sa->texture->pixels < sb->texture->pixels ? -1 : 1;
+    }
+    return sa < sb ? -1 : (sa > sb);
+}
+
+// Documented order (z, then texture, then submission), one pixel at a time
+static void draw_reference(uint16_t *target, int count)
+{
+    const esp_bsp_sdl_blend_kernels_t *scalar = esp_bsp_sdl_blend_get_kernels(ESP_BSP_SDL_BLEND_IMPL_SCALAR);
+    const esp_bsp_sdl_sprite_t *order[SPRITES];
+    for(int i = 0; i < count; i++) {
+        order[i] = &s_sprites[i];
+    }
+    qsort(order, count, sizeof(order[0]), compare_order);
+
+    for(int i = 0; i < count; i++) {
+        const esp_bsp_sdl_sprite_t *s = order[i];
+        for(int y = 0; y < s->src.h; y++) {
+            for(int x = 0; x < s->src.w; x++) {
+                const int sx = s->src.x + x;
+                const int sy = s->src.y + y;
+                const int dx = s->dst_x + x;
+                const int dy = s->dst_y + y;
+                if(sx < 0 || sy < 0 || sx >= s->texture->width || sy >= s->texture->height || dx < 0 || dy < 0 ||
+                   dx >= TARGET_W || dy >= TARGET_H || s->alpha == 0) {
+                    continue;
+                }
+                const uint16_t src = s->texture->pixels[sy * s->texture->stride + sx];
+                uint16_t *dst = &target[dy * TARGET_W + dx];
+                if(s->alpha == 255) {
+                    *dst = src;
+                } else {
+                    scalar->rgb565_const_over(dst, &src, s->alpha, 1);
+                }
+            }
+        }
+    }
+}
+
+static void fill_background(uint16_t *pixels)
+{
+    for(int i = 0; i < TARGET_W * TARGET_H; i++) {
+        pixels[i] = (uint16_t) (i * 0x0123);
+    }
+}
+
+static void test_render_matches_reference(void)
+{
+    esp_bsp_sdl_blit_queue_handle_t queue;
+    const esp_bsp_sdl_blit_queue_config_t config = {.width = TARGET_W, .height = TARGET_H};
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_create(&config, &queue));
+
+    for(int round = 0; round < 5; round++) {
+        make_sprites(SPRITES);
+        for(int i = 0; i < SPRITES; i++) {
+            TEST_CHECK_OK(esp_bsp_sdl_blit_queue_push(queue, &s_sprites[i]));
+        }
+        fill_background(s_target);
+        fill_background(s_expected);
+        esp_bsp_sdl_surface_t target = {s_target, TARGET_W, TARGET_H, TARGET_W};
+        TEST_CHECK_OK(esp_bsp_sdl_blit_queue_render(queue, &target));
+        draw_reference(s_expected, SPRITES);
+        TEST_CHECK(memcmp(s_target, s_expected, sizeof(s_target)) == 0);
+
+        // Texture grouping: within a band at most one switch per z level and texture change
+        esp_bsp_sdl_blit_queue_stats_t stats;
+        TEST_CHECK_OK(esp_bsp_sdl_blit_queue_get_stats(queue, &stats));
+        const int bands = (TARGET_H + ESP_BSP_SDL_FLUSH_BAND_ROWS - 1) / ESP_BSP_SDL_FLUSH_BAND_ROWS;
+        TEST_CHECK(stats.bands <= (uint32_t) bands && stats.bands > 0);
+        TEST_CHECK(stats.texture_switches <= (uint32_t) (bands * (4 * TEXTURES - 1)));
+    }
+
+    // The queue is empty after rendering
+    memcpy(s_expected, s_target, sizeof(s_target));
+    esp_bsp_sdl_surface_t target = {s_target, TARGET_W, TARGET_H, TARGET_W};
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_render(queue, &target));
+    TEST_CHECK(memcmp(s_target, s_expected, sizeof(s_target)) == 0);
+
+    esp_bsp_sdl_surface_t small = {s_target, TARGET_W - 1, TARGET_H, TARGET_W};
+    TEST_CHECK(esp_bsp_sdl_blit_queue_render(queue, &small) == ESP_ERR_INVALID_ARG);
+    esp_bsp_sdl_blit_queue_delete(queue);
+}
+
+// z decides over submission order, counters count visible sprites once
+static void test_order_and_stats(void)
+{
+    esp_bsp_sdl_blit_queue_handle_t queue;
+    const esp_bsp_sdl_blit_queue_config_t config = {.width = TARGET_W, .height = TARGET_H};
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_create(&config, &queue));
+
+    const esp_bsp_sdl_sprite_t top = {&s_textures[0], {0, 0, 20, 20}, 10, 10, 2, 255};
+    const esp_bsp_sdl_sprite_t bottom = {&s_textures[1], {0, 0, 20, 20}, 15, 15, 1, 255};
+    const esp_bsp_sdl_sprite_t outside = {&s_textures[1], {0, 0, 20, 20}, TARGET_W, 0, 0, 255};
+    const esp_bsp_sdl_sprite_t invisible = {&s_textures[1], {0, 0, 20, 20}, 0, 0, 0, 0};
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_push(queue, &top));
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_push(queue, &bottom));
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_push(queue, &outside));
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_push(queue, &invisible));
+
+    memset(s_target, 0, sizeof(s_target));
+    esp_bsp_sdl_surface_t target = {s_target, TARGET_W, TARGET_H, TARGET_W};
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_render(queue, &target));
+    // Overlap at (15..29, 15..29): the higher z wins although it was pushed first
+    TEST_CHECK(s_target[20 * TARGET_W + 20] == s_tex_pixels[0][10 * TEX_SIZE + 10]);
+    TEST_CHECK(s_target[32 * TARGET_W + 32] == s_tex_pixels[1][17 * TEX_SIZE + 17]);
+
+    // Rows 10..34 span bands 0..2, the two sprites switch texture once per shared band
+    esp_bsp_sdl_blit_queue_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_get_stats(queue, &stats));
+    TEST_CHECK(stats.sprites == 2);
+    TEST_CHECK(stats.bands == 3);
+    TEST_CHECK(stats.texture_switches == 2);
+    esp_bsp_sdl_blit_queue_delete(queue);
+}
+
+static void test_limits(void)
+{
+    esp_bsp_sdl_blit_queue_handle_t queue;
+    const esp_bsp_sdl_blit_queue_config_t config = {
+        .width = TARGET_W,
+        .height = TARGET_H,
+        .max_sprites = 4,
+        .max_bin_entries = 5,
+    };
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_create(&config, &queue));
+
+    // Each sprite covers rows 0..31, two bands
+    const esp_bsp_sdl_sprite_t sprite = {&s_textures[0], {0, 0, 20, 20}, 0, 12, 0, 255};
+    for(int i = 0; i < 4; i++) {
+        TEST_CHECK_OK(esp_bsp_sdl_blit_queue_push(queue, &sprite));
+    }
+    TEST_CHECK(esp_bsp_sdl_blit_queue_push(queue, &sprite) == ESP_ERR_NO_MEM);
+    const esp_bsp_sdl_sprite_t no_texture = {NULL, {0, 0, 1, 1}, 0, 0, 0, 255};
+    TEST_CHECK(esp_bsp_sdl_blit_queue_push(queue, &no_texture) == ESP_ERR_INVALID_ARG);
+
+    // 8 bin entries needed, 5 available
+    esp_bsp_sdl_surface_t target = {s_target, TARGET_W, TARGET_H, TARGET_W};
+    TEST_CHECK(esp_bsp_sdl_blit_queue_render(queue, &target) == ESP_ERR_NO_MEM);
+
+    // The queue was cleared, two sprites fit
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_push(queue, &sprite));
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_push(queue, &sprite));
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_render(queue, &target));
+    esp_bsp_sdl_blit_queue_delete(queue);
+}
+
+// Flushing through the band engine shows the background with the sprites on top
+static void test_flush(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_handle_t panel;
+    esp_lcd_panel_io_handle_t io;
+    TEST_CHECK_OK(esp_bsp_sdl_init(&config, &panel, &io));
+
+    esp_bsp_sdl_blit_queue_handle_t queue;
+    const esp_bsp_sdl_blit_queue_config_t wrong = {.width = TARGET_W, .height = TARGET_H};
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_create(&wrong, &queue));
+    TEST_CHECK(esp_bsp_sdl_blit_queue_flush(queue, NULL, 0) == ESP_ERR_INVALID_SIZE);
+    esp_bsp_sdl_blit_queue_delete(queue);
+
+    const int w = config.width;
+    const int h = config.height;
+    const esp_bsp_sdl_blit_queue_config_t qconfig = {.width = w, .height = h};
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_create(&qconfig, &queue));
+    uint16_t *background = malloc((size_t) w * h * sizeof(uint16_t));
+    uint16_t *expected = malloc((size_t) w * h * sizeof(uint16_t));
+    TEST_CHECK(background && expected);
+    if(background && expected) {
+        for(int i = 0; i < w * h; i++) {
+            background[i] = (uint16_t) (i * 0x0321);
+        }
+        memcpy(expected, background, (size_t) w * h * sizeof(uint16_t));
+        esp_bsp_sdl_surface_t expected_surface = {expected, w, h, w};
+
+        esp_bsp_sdl_blit_queue_handle_t reference;
+        TEST_CHECK_OK(esp_bsp_sdl_blit_queue_create(&qconfig, &reference));
+        make_sprites(60);
+        for(int i = 0; i < 60; i++) {
+            TEST_CHECK_OK(esp_bsp_sdl_blit_queue_push(queue, &s_sprites[i]));
+            TEST_CHECK_OK(esp_bsp_sdl_blit_queue_push(reference, &s_sprites[i]));
+        }
+        TEST_CHECK_OK(esp_bsp_sdl_blit_queue_render(reference, &expected_surface));
+        esp_bsp_sdl_blit_queue_delete(reference);
+
+        const esp_bsp_sdl_surface_t bg = {background, w, h, w};
+        TEST_CHECK_OK(esp_bsp_sdl_blit_queue_flush(queue, &bg, 0));
+        esp_bsp_sdl_surface_t frame;
+        TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(panel, &frame));
+        TEST_CHECK_OK(esp_bsp_sdl_frame_compare(&frame, &expected_surface, 0, NULL));
+    }
+    free(background);
+    free(expected);
+    esp_bsp_sdl_blit_queue_delete(queue);
+    TEST_CHECK_OK(esp_bsp_sdl_deinit());
+}
+
+int main(void)
+{
+    init_textures();
+    test_render_matches_reference();
+    test_order_and_stats();
+    test_limits();
+    test_flush();
+    return test_finish("test_blit_queue");
+}
@@ -0,0 +1,174 @@
+/**
+ * @file test_bus_timing.c
+ * @brief Bus timing model of the virtual panel on the simulated clock
+ */
+
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "esp_host_port.h"
+#include "esp_lcd_panel_commands.h"
+#include "esp_timer.h"
+#include "test_util.h"
+
+#define PANEL_W     64
+#define PANEL_H     48
+#define FRAME_BYTES (PANEL_W * PANEL_H * 2)
+
+static uint16_t s_pixels[PANEL_W * PANEL_H];
+static int s_done;
+static int64_t s_done_at[8];
+static int s_listened;
+
+static bool on_done(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    if(s_done < 8) {
+        s_done_at[s_done] = esp_timer_get_time();
+    }
+    s_done++;
+    return false;
+}
+
+static void on_frame(const esp_bsp_sdl_surface_t *frame, const esp_bsp_sdl_rect_t *area, void *user_ctx)
+{
+    s_listened++;
+}
+
+static void new_panel(const esp_bsp_sdl_virtual_bus_timing_t *bus,
+                      esp_lcd_panel_io_handle_t *io,
+                      esp_lcd_panel_handle_t *panel)
+{
+    const esp_bsp_sdl_virtual_panel_config_t config = {
+        .width = PANEL_W,
+        .height = PANEL_H,
+        .bus = *bus,
+    };
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_new(&config, io, panel));
+    const esp_lcd_panel_io_callbacks_t cbs = {.on_color_trans_done = on_done};
+    TEST_CHECK_OK(esp_lcd_panel_io_register_event_callbacks(*io, &cbs, NULL));
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_set_listener(*panel, on_frame, NULL));
+    s_done = 0;
+    s_listened = 0;
+}
+
+// A full frame takes bits / bit rate (rounded up) plus the transfer overhead, on every bus type
+static void test_profiles(void)
+{
+    static const struct {
+        esp_bsp_sdl_virtual_profile_t profile;
+        int64_t frame_us;
+        int64_t command_us; // CASET with 4 parameter bytes
+    } cases[] = {
+        // 49152 bits at 40 Mbit/s = 1228.8 us, + 12 us; 40 bits = 1 us, + 8 us
+        {ESP_BSP_SDL_VIRTUAL_PROFILE_ESP_BOX_3, 1229 + 12, 1 + 8},
+        // 16 bits x 16 MHz = 256 Mbit/s: 192 us, + 6 us
+        {ESP_BSP_SDL_VIRTUAL_PROFILE_ESP32_S3_LCD_EV, 192 + 6, 1 + 4},
+        // 2 lanes x 1000 Mbit/s: 24.6 us, + 6 us
+        {ESP_BSP_SDL_VIRTUAL_PROFILE_ESP32_P4_FUNCTION_EV, 25 + 6, 1 + 4},
+        // 2 lanes x 730 Mbit/s: 33.7 us, + 6 us
+        {ESP_BSP_SDL_VIRTUAL_PROFILE_M5STACK_TAB5, 34 + 6, 1 + 4},
+    };
+
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        esp_bsp_sdl_virtual_bus_timing_t bus;
+        TEST_CHECK_OK(esp_bsp_sdl_virtual_bus_get_profile(cases[i].profile, &bus));
+        esp_lcd_panel_io_handle_t io;
+        esp_lcd_panel_handle_t panel;
+        new_panel(&bus, &io, &panel);
+
+        // Commands are polling transfers: the call returns when the bus is done
+        const uint8_t caset[4] = {0, 0, 0, PANEL_W - 1};
+        int64_t start = esp_timer_get_time();
+        TEST_CHECK_OK(esp_lcd_panel_io_tx_param(io, LCD_CMD_CASET, caset, sizeof(caset)));
+        TEST_CHECK(esp_timer_get_time() - start == cases[i].command_us);
+
+        // Color transfers return at once and complete from the timer, pixels land only then
+        start = esp_timer_get_time();
+        TEST_CHECK_OK(esp_lcd_panel_io_tx_color(io, LCD_CMD_RAMWR, s_pixels, FRAME_BYTES));
+        TEST_CHECK(esp_timer_get_time() == start);
+        TEST_CHECK(s_done == 0 && s_listened == 0);
+        TEST_CHECK(esp_host_port_run_next_timer() == 1);
+        TEST_CHECK(s_done == 1 && s_listened == 1);
+        TEST_CHECK(s_done_at[0] - start == cases[i].frame_us);
+
+        esp_bsp_sdl_virtual_panel_stats_t stats;
+        TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_stats(panel, &stats));
+        TEST_CHECK(stats.bus_time_us == (uint64_t) (cases[i].command_us + cases[i].frame_us));
+        TEST_CHECK(stats.queue_waits == 0);
+
+        TEST_CHECK_OK(esp_lcd_panel_del(panel));
+        TEST_CHECK_OK(esp_lcd_panel_io_del(io));
+    }
+}
+
+// Queued transfers run back to back, a full queue blocks tx_color, a command waits for the queue
+static void test_queue(void)
+{
+    esp_bsp_sdl_virtual_bus_timing_t bus;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_bus_get_profile(ESP_BSP_SDL_VIRTUAL_PROFILE_ESP_BOX_3, &bus));
+    bus.queue_depth = 2;
+    esp_lcd_panel_io_handle_t io;
+    esp_lcd_panel_handle_t panel;
+    new_panel(&bus, &io, &panel);
+
+    // Quarter frames: 1536 bytes = 307.2 us, + 12 us
+    const size_t quarter = FRAME_BYTES / 4;
+    const int64_t quarter_us = 308 + 12;
+    const int64_t start = esp_timer_get_time();
+    for(int i = 0; i < 4; i++) {
+        TEST_CHECK_OK(esp_lcd_panel_io_tx_color(io,
+                                                i ? LCD_CMD_RAMWRC : LCD_CMD_RAMWR,
+                                                (const uint8_t *) s_pixels + i * quarter,
+                                                quarter));
+    }
+    // The third and fourth call each waited for a slot
+    TEST_CHECK(esp_timer_get_time() - start == 2 * quarter_us);
+    TEST_CHECK(s_done == 2);
+
+    TEST_CHECK_OK(esp_lcd_panel_io_tx_param(io, LCD_CMD_DISPON, NULL, 0));
+    TEST_CHECK(s_done == 4);
+    for(int i = 0; i < 4; i++) {
+        TEST_CHECK(s_done_at[i] - start == (i + 1) * quarter_us);
+    }
+    // DISPON: 8 bits rounded up to 1 us, + 8 us
+    TEST_CHECK(esp_timer_get_time() - start == 4 * quarter_us + 9);
+
+    esp_bsp_sdl_virtual_panel_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_stats(panel, &stats));
+    TEST_CHECK(stats.queue_waits == 2);
+    TEST_CHECK(stats.bus_time_us == (uint64_t) (4 * quarter_us + 9));
+
+    TEST_CHECK_OK(esp_lcd_panel_del(panel));
+    TEST_CHECK_OK(esp_lcd_panel_io_del(io));
+}
+
+// The buffer is read when the transfer completes, not when it is queued
+static void test_late_read(void)
+{
+    esp_bsp_sdl_virtual_bus_timing_t bus;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_bus_get_profile(ESP_BSP_SDL_VIRTUAL_PROFILE_ESP_BOX_3, &bus));
+    esp_lcd_panel_io_handle_t io;
+    esp_lcd_panel_handle_t panel;
+    new_panel(&bus, &io, &panel);
+
+    for(int i = 0; i < PANEL_W * PANEL_H; i++) {
+        s_pixels[i] = 0x1234;
+    }
+    TEST_CHECK_OK(esp_lcd_panel_draw_bitmap(panel, 0, 0, PANEL_W, PANEL_H, s_pixels));
+    // Reusing the buffer before completion shows up in the frame, like on the real bus
+    for(int i = 0; i < PANEL_W * PANEL_H; i++) {
+        s_pixels[i] = 0xABCD;
+    }
+    esp_bsp_sdl_surface_t frame;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(panel, &frame));
+    TEST_CHECK(frame.pixels[0] == 0xABCD && frame.pixels[(PANEL_H - 1) * frame.stride + PANEL_W - 1] == 0xABCD);
+
+    TEST_CHECK_OK(esp_lcd_panel_del(panel));
+    TEST_CHECK_OK(esp_lcd_panel_io_del(io));
+}
+
+int main(void)
+{
+    test_profiles();
+    test_queue();
+    test_late_read();
+    return test_finish("test_bus_timing");
+}
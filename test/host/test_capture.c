@@ -0,0 +1,395 @@
+/**
+ * @file test_capture.c
+ * @brief Frame capture: the container read back and every decoded frame against the flushed one
+ *
+ * The reader below follows the layout in esp_bsp_sdl_capture.h: frame records one after the
+ * other, DELTA runs applied to the previous decoded frame, then the index and the trailer. It
+ * checks the structure on the way, so a frame that decodes to the right pixels through a broken
+ * container still fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_capture.h"
+#include "sdkconfig.h"
+#include "test_util.h"
+
+#define W          CONFIG_SDL_BSP_VIRTUAL_WIDTH
+#define H          CONFIG_SDL_BSP_VIRTUAL_HEIGHT
+#define MAX_FRAMES 16
+
+typedef struct {
+    esp_bsp_sdl_capture_file_header_t header;
+    int frames;
+    bool indexed; // Index and trailer present and consistent with the frame records
+    uint32_t seq[MAX_FRAMES];
+    uint32_t flags[MAX_FRAMES];
+    int chunks[MAX_FRAMES]; // RAW and DELTA chunks
+    uint16_t pixels[MAX_FRAMES][W * H];
+} capture_t;
+
+static capture_t s_capture;
+static uint16_t s_flushed[MAX_FRAMES][W * H];
+static uint16_t s_frame[W * H];
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+} cursor_t;
+
+static const void *take(cursor_t *cur, size_t size)
+{
+    if(cur->size - cur->pos < size) {
+        return NULL;
+    }
+    const void *p = cur->data + cur->pos;
+    cur->pos += size;
+    return p;
+}
+
+// One frame record into the current picture, false if it is malformed
+static bool read_frame(cursor_t *cur, capture_t *cap, uint16_t *picture, uint64_t *offset)
+{
+    *offset = cur->pos;
+    esp_bsp_sdl_capture_frame_header_t header;
+    const void *p = take(cur, sizeof(header));
+    if(!p || cap->frames == MAX_FRAMES) {
+        return false;
+    }
+    memcpy(&header, p, sizeof(header));
+    if(memcmp(header.magic, "FRME", 4) || header.width != W || header.height != H) {
+        return false;
+    }
+    const bool key = header.flags & ESP_BSP_SDL_CAPTURE_FLAG_KEY;
+    if(key) {
+        // Key frames stand alone, every row must come from the record
+        memset(picture, 0, W * H * sizeof(uint16_t));
+    }
+
+    int chunks = 0;
+    for(;;) {
+        esp_bsp_sdl_capture_chunk_t chunk;
+        p = take(cur, sizeof(chunk));
+        if(!p) {
+            return false;
+        }
+        memcpy(&chunk, p, sizeof(chunk));
+        const uint8_t *payload = take(cur, chunk.size);
+        if(!payload) {
+            return false;
+        }
+        if(chunk.type == ESP_BSP_SDL_CAPTURE_CHUNK_END) {
+            if(chunk.size != sizeof(esp_bsp_sdl_capture_frame_stats_t)) {
+                return false;
+            }
+            break;
+        }
+        if(chunk.first_row + chunk.rows > H) {
+            return false;
+        }
+        uint16_t *rows = picture + chunk.first_row * W;
+        const size_t pixels = (size_t) chunk.rows * W;
+        if(chunk.type == ESP_BSP_SDL_CAPTURE_CHUNK_RAW) {
+            if(chunk.size != pixels * sizeof(uint16_t)) {
+                return false;
+            }
+            memcpy(rows, payload, chunk.size);
+        } else if(chunk.type == ESP_BSP_SDL_CAPTURE_CHUNK_DELTA && !key) {
+            // (skip, copy) pairs, each followed by copy pixels
+            const uint16_t *runs = (const uint16_t *) payload;
+            const size_t words = chunk.size / sizeof(uint16_t);
+            size_t w = 0;
+            size_t at = 0;
+            while(w < words) {
+                if(words - w < 2) {
+                    return false;
+                }
+                const uint16_t skip = runs[w++];
+                const uint16_t copy = runs[w++];
+                if(at + skip + copy > pixels || words - w < copy) {
+                    return false;
+                }
+                at += skip;
+                memcpy(rows + at, runs + w, copy * sizeof(uint16_t));
+                at += copy;
+                w += copy;
+            }
+        } else {
+            return false;
+        }
+        chunks++;
+    }
+
+    cap->seq[cap->frames] = header.seq;
+    cap->flags[cap->frames] = header.flags;
+    cap->chunks[cap->frames] = chunks;
+    memcpy(cap->pixels[cap->frames], picture, W * H * sizeof(uint16_t));
+    cap->frames++;
+    return true;
+}
+
+// Header, frame records and, for a completed capture, index and trailer
+static bool parse_capture(cursor_t *cur, capture_t *cap)
+{
+    static uint16_t picture[W * H];
+    uint64_t offsets[MAX_FRAMES];
+    const void *p = take(cur, sizeof(cap->header));
+    if(!p) {
+        return false;
+    }
+    memcpy(&cap->header, p, sizeof(cap->header));
+    if(memcmp(cap->header.magic, "SDLC", 4) || cap->header.version != ESP_BSP_SDL_CAPTURE_VERSION) {
+        return false;
+    }
+    // Frame records until the index, or the end of a capture cut short
+    while(cur->size - cur->pos >= 4 && memcmp(cur->data + cur->pos, "FRME", 4) == 0) {
+        if(!read_frame(cur, cap, picture, &offsets[cap->frames])) {
+            return false;
+        }
+    }
+    if(cur->pos == cur->size) {
+        return true;
+    }
+
+    const size_t index_offset = cur->pos;
+    const uint8_t *index = take(cur, cap->frames * sizeof(esp_bsp_sdl_capture_index_entry_t));
+    esp_bsp_sdl_capture_trailer_t trailer;
+    p = take(cur, sizeof(trailer));
+    if(!index || !p || cur->pos != cur->size) {
+        return false;
+    }
+    memcpy(&trailer, p, sizeof(trailer));
+    if(memcmp(trailer.magic, "SDLX", 4) || trailer.count != (uint32_t) cap->frames ||
+       trailer.index_offset != index_offset) {
+        return false;
+    }
+    for(int i = 0; i < cap->frames; i++) {
+        esp_bsp_sdl_capture_index_entry_t entry;
+        memcpy(&entry, index + i * sizeof(entry), sizeof(entry));
+        if(entry.seq != cap->seq[i] || entry.flags != cap->flags[i] || entry.offset != offsets[i]) {
+            return false;
+        }
+    }
+    cap->indexed = true;
+    return true;
+}
+
+// Read the whole stream written so far, false if it is malformed
+static bool read_capture(FILE *in, capture_t *cap)
+{
+    memset(cap, 0, sizeof(*cap));
+    fflush(in);
+    fseek(in, 0, SEEK_END);
+    const long size = ftell(in);
+    rewind(in);
+    uint8_t *data = malloc(size);
+    bool ok = data && fread(data, 1, size, in) == (size_t) size;
+    // Later writes append
+    fseek(in, 0, SEEK_END);
+    if(ok) {
+        cursor_t cur = {data, size, 0};
+        ok = parse_capture(&cur, cap);
+    }
+    free(data);
+    return ok;
+}
+
+// Background with a few changed pixels and a changed block, moving with n
+static void make_frame(uint16_t *frame, int n)
+{
+    for(int y = 0; y < H; y++) {
+        for(int x = 0; x < W; x++) {
+            frame[y * W + x] = (uint16_t) (x * 31 + y * 1024);
+        }
+    }
+    for(int y = 0; y < 6; y++) {
+        for(int x = 0; x < 10; x++) {
+            frame[((n * 7 + y) % H) * W + (n * 5 + x) % W] = (uint16_t) (0xF000 + n);
+        }
+    }
+    frame[(n * 13 % H) * W + n % W] = (uint16_t) n;
+}
+
+static uint32_t frames_flushed(void)
+{
+    esp_bsp_sdl_flush_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_get_flush_stats(&stats));
+    return stats.frames;
+}
+
+static void check_frames(const char *name, const capture_t *cap, const int *flushed, const bool *key, int count,
+                         uint32_t first_seq)
+{
+    if(cap->frames != count) {
+        fprintf(stderr, "%s: %d frames read, %d expected\n", name, cap->frames, count);
+        test_failures++;
+        return;
+    }
+    for(int i = 0; i < count; i++) {
+        if(memcmp(cap->pixels[i], s_flushed[flushed[i]], sizeof(s_flushed[0])) != 0) {
+            fprintf(stderr, "%s: frame %d differs from flushed frame %d\n", name, i, flushed[i]);
+            test_failures++;
+        }
+        if(cap->seq[i] != first_seq + flushed[i]) {
+            fprintf(stderr, "%s: frame %d has seq %u, %u expected\n", name, i, (unsigned) cap->seq[i],
+                    (unsigned) (first_seq + flushed[i]));
+            test_failures++;
+        }
+        if(!!(cap->flags[i] & ESP_BSP_SDL_CAPTURE_FLAG_KEY) != key[i]) {
+            fprintf(stderr, "%s: frame %d key flag %u, %d expected\n", name, i, (unsigned) cap->flags[i], key[i]);
+            test_failures++;
+        }
+    }
+}
+
+// Raw container: every flushed frame complete as a key frame
+static void test_raw(void)
+{
+    FILE *out = tmpfile();
+    const uint32_t first_seq = frames_flushed();
+    const esp_bsp_sdl_capture_config_t config = {.out = out};
+    TEST_CHECK_OK(esp_bsp_sdl_capture_start(&config));
+    for(int i = 0; i < 4; i++) {
+        make_frame(s_flushed[i], i);
+        TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_flushed[i]));
+    }
+    TEST_CHECK_OK(esp_bsp_sdl_capture_stop());
+
+    TEST_CHECK(read_capture(out, &s_capture));
+    TEST_CHECK(s_capture.indexed && !(s_capture.header.flags & ESP_BSP_SDL_CAPTURE_FLAG_DELTA));
+    check_frames("raw", &s_capture, (const int[]) {0, 1, 2, 3}, (const bool[]) {1, 1, 1, 1}, 4, first_seq);
+    fclose(out);
+}
+
+// Delta container: unchanged frames have no chunks, changed ones are smaller than raw
+static void test_delta(void)
+{
+    FILE *out = tmpfile();
+    const uint32_t first_seq = frames_flushed();
+    const esp_bsp_sdl_capture_config_t config = {.out = out, .delta = true};
+    TEST_CHECK_OK(esp_bsp_sdl_capture_start(&config));
+    make_frame(s_flushed[0], 0);
+    memcpy(s_flushed[1], s_flushed[0], sizeof(s_flushed[0]));
+    make_frame(s_flushed[2], 1);
+    // Every pixel changed, RAW chunks inside a delta frame
+    for(int i = 0; i < W * H; i++) {
+        s_flushed[3][i] = (uint16_t) ~s_flushed[2][i];
+    }
+    make_frame(s_flushed[4], 2);
+    for(int i = 0; i < 5; i++) {
+        TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_flushed[i]));
+    }
+    TEST_CHECK_OK(esp_bsp_sdl_capture_stop());
+
+    TEST_CHECK(read_capture(out, &s_capture));
+    TEST_CHECK(s_capture.indexed && (s_capture.header.flags & ESP_BSP_SDL_CAPTURE_FLAG_DELTA));
+    check_frames("delta", &s_capture, (const int[]) {0, 1, 2, 3, 4}, (const bool[]) {1, 0, 0, 0, 0}, 5, first_seq);
+    TEST_CHECK(s_capture.chunks[1] == 0);
+
+    esp_bsp_sdl_capture_summary_t summary;
+    esp_bsp_sdl_capture_get_summary(&summary);
+    TEST_CHECK(summary.frames_written == 5 && summary.key_frames == 1);
+    // Two frames delta encoded, three complete
+    TEST_CHECK(summary.written_bytes < summary.raw_bytes * 3 / 4);
+    fclose(out);
+}
+
+// every_nth picks the frames, key_interval counts captured frames; a capture cut short reads without index
+static void test_every_nth_key_interval(void)
+{
+    FILE *out = tmpfile();
+    const uint32_t first_seq = frames_flushed();
+    const esp_bsp_sdl_capture_config_t config = {.out = out, .every_nth = 3, .delta = true, .key_interval = 2};
+    TEST_CHECK_OK(esp_bsp_sdl_capture_start(&config));
+    for(int i = 0; i < 11; i++) {
+        make_frame(s_flushed[i], i);
+        TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_flushed[i]));
+    }
+    static const int captured[] = {0, 3, 6, 9};
+    static const bool key[] = {1, 0, 1, 0};
+
+    TEST_CHECK(read_capture(out, &s_capture));
+    TEST_CHECK(!s_capture.indexed);
+    check_frames("cut short", &s_capture, captured, key, 4, first_seq);
+
+    TEST_CHECK_OK(esp_bsp_sdl_capture_stop());
+    TEST_CHECK(read_capture(out, &s_capture));
+    TEST_CHECK(s_capture.indexed && s_capture.header.every_nth == 3);
+    check_frames("every_nth", &s_capture, captured, key, 4, first_seq);
+    fclose(out);
+}
+
+static esp_err_t render_band(esp_bsp_sdl_surface_t *band, int y, void *user_ctx)
+{
+    const uint16_t *frame = user_ctx;
+    for(int row = 0; row < band->height; row++) {
+        memcpy(band->pixels + row * band->stride, frame + (y + row) * W, W * sizeof(uint16_t));
+    }
+    return ESP_OK;
+}
+
+// Band flushes are encoded band by band as they are sent
+static void test_bands(void)
+{
+    FILE *out = tmpfile();
+    const uint32_t first_seq = frames_flushed();
+    const esp_bsp_sdl_capture_config_t config = {.out = out, .delta = true};
+    TEST_CHECK_OK(esp_bsp_sdl_capture_start(&config));
+    for(int i = 0; i < 3; i++) {
+        make_frame(s_flushed[i], i + 5);
+        TEST_CHECK_OK(esp_bsp_sdl_flush_bands(render_band, s_flushed[i]));
+    }
+    TEST_CHECK_OK(esp_bsp_sdl_capture_stop());
+
+    TEST_CHECK(read_capture(out, &s_capture));
+    check_frames("bands", &s_capture, (const int[]) {0, 1, 2}, (const bool[]) {1, 0, 0}, 3, first_seq);
+    fclose(out);
+}
+
+// Manual captures take surfaces with a stride and number them on their own
+static void test_surface(void)
+{
+    FILE *out = tmpfile();
+    const esp_bsp_sdl_capture_config_t config = {.out = out, .delta = true, .manual = true};
+    TEST_CHECK_OK(esp_bsp_sdl_capture_start(&config));
+    static uint16_t padded[H][W + 8];
+    for(int i = 0; i < 3; i++) {
+        make_frame(s_flushed[i], i + 9);
+        for(int y = 0; y < H; y++) {
+            memcpy(padded[y], s_flushed[i] + y * W, W * sizeof(uint16_t));
+        }
+        const esp_bsp_sdl_surface_t surface = {&padded[0][0], W, H, W + 8};
+        TEST_CHECK_OK(esp_bsp_sdl_capture_surface(&surface));
+        // Not captured in a manual capture
+        make_frame(s_frame, 40 + i);
+        TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_frame));
+    }
+    TEST_CHECK_OK(esp_bsp_sdl_capture_stop());
+
+    TEST_CHECK(read_capture(out, &s_capture));
+    check_frames("surface", &s_capture, (const int[]) {0, 1, 2}, (const bool[]) {1, 0, 0}, 3, 0);
+    fclose(out);
+}
+
+int main(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_handle_t panel;
+    esp_lcd_panel_io_handle_t io;
+    TEST_CHECK_OK(esp_bsp_sdl_init(&config, &panel, &io));
+    if(test_failures) {
+        return test_finish("test_capture");
+    }
+
+    test_raw();
+    test_delta();
+    test_every_nth_key_interval();
+    test_bands();
+    test_surface();
+
+    TEST_CHECK_OK(esp_bsp_sdl_deinit());
+    return test_finish("test_capture");
+}
@@ -0,0 +1,100 @@
+/**
+ * @file test_color.c
+ * @brief Table-driven RGB888 to RGB565 conversion against a float evaluation of the profile
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_bsp_sdl_color.h"
+#include "test_util.h"
+
+static const int s_bits[3] = {5, 6, 5};
+
+static int reference(const esp_bsp_sdl_color_profile_t *profile, const uint8_t *in, int c)
+{
+    double sum = 0.0;
+    for(int k = 0; k < 3; k++) {
+        sum += profile->matrix[c][k] * in[k];
+    }
+    sum = sum < 0.0 ? 0.0 : (sum > 255.0 ? 255.0 : sum);
+    return (int) lround(pow(sum / 255.0, profile->gamma[c]) * ((1 << s_bits[c]) - 1));
+}
+
+static int check_pixel(const esp_bsp_sdl_color_profile_t *profile,
+                       const esp_bsp_sdl_color_lut_t *lut,
+                       const uint8_t *in,
+                       bool swap_bytes)
+{
+    uint16_t px;
+    esp_bsp_sdl_color_convert_rgb888_to_rgb565(lut, in, &px, 1, swap_bytes);
+    if(swap_bytes) {
+        px = (uint16_t) ((px >> 8) | (px << 8));
+    }
+    const int got[3] = {px >> 11, (px >> 5) & 0x3F, px & 0x1F};
+    int worst = 0;
+    for(int c = 0; c < 3; c++) {
+        const int err = abs(got[c] - reference(profile, in, c));
+        worst = err > worst ? err : worst;
+    }
+    return worst;
+}
+
+// Largest channel difference to the float reference. An identity matrix keeps the channels
+// independent, so every value in every channel covers all inputs; otherwise a grid is sampled.
+static int max_error(const char *name, const esp_bsp_sdl_color_profile_t *profile, bool swap_bytes)
+{
+    static esp_bsp_sdl_color_lut_t lut;
+    TEST_CHECK_OK(esp_bsp_sdl_color_lut_build(profile, &lut));
+    int worst = 0;
+    if(lut.identity_matrix) {
+        for(int v = 0; v < 256; v++) {
+            const uint8_t in[3] = {v, 255 - v, v ^ 0x5A};
+            const int err = check_pixel(profile, &lut, in, swap_bytes);
+            worst = err > worst ? err : worst;
+        }
+    } else {
+        for(int r = 0; r < 256; r += 5) {
+            for(int g = 0; g < 256; g += 5) {
+                for(int b = 0; b < 256; b += 5) {
+                    const uint8_t in[3] = {r, g, b};
+                    const int err = check_pixel(profile, &lut, in, swap_bytes);
+                    worst = err > worst ? err : worst;
+                }
+            }
+        }
+    }
+    printf("%s: max error %d LSB\n", name, worst);
+    return worst;
+}
+
+int main(void)
+{
+    TEST_CHECK(max_error("identity", &esp_bsp_sdl_color_profile_identity, false) == 0);
+    const esp_bsp_sdl_color_profile_t curves = {
+        .matrix = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+        .gamma = {0.45f, 1.0f, 2.2f},
+    };
+    TEST_CHECK(max_error("identity matrix, gamma 0.45/1.0/2.2", &curves, true) == 0);
+
+    // Mixing matrices round to 8 bits before the gamma stage
+    static const float gammas[] = {0.6f, 1.0f, 2.2f};
+    for(size_t i = 0; i < sizeof(gammas) / sizeof(gammas[0]); i++) {
+        const float g = gammas[i];
+        const esp_bsp_sdl_color_profile_t mixing = {
+            .matrix = {{1.2f, -0.1f, -0.1f}, {-0.2f, 1.3f, -0.1f}, {0.05f, -0.25f, 1.2f}},
+            .gamma = {g, g, g},
+        };
+        char name[48];
+        snprintf(name, sizeof(name), "mixing matrix, gamma %.1f", g);
+        TEST_CHECK(max_error(name, &mixing, false) <= 1);
+    }
+
+    esp_bsp_sdl_color_lut_t lut;
+    const esp_bsp_sdl_color_profile_t out_of_range = {
+        .matrix = {{2.5f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+        .gamma = {1.0f, 1.0f, 1.0f},
+    };
+    TEST_CHECK(esp_bsp_sdl_color_lut_build(&out_of_range, &lut) == ESP_ERR_INVALID_ARG);
+    return test_finish("test_color");
+}
@@ -0,0 +1,259 @@
+/**
+ * @file test_compositor.c
+ * @brief Compositor: dirty-only and cached output match a full per-pixel composition
+ *
+ * Three compositors with no cache, two and three cached layers render the same random sequence of
+ * layer moves, pixel updates, opacity and visibility changes. After every frame each target must
+ * equal the reference, every layer blended over every pixel.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_bsp_sdl_blend.h"
+#include "esp_bsp_sdl_compositor.h"
+#include "test_util.h"
+
+// Not a multiple of the tile size, so the last tile column and row are partial
+#define W      100
+#define H      70
+#define LAYERS 4
+#define SPRITE 20
+#define FRAMES 300
+#define CLEAR  0x1234
+
+static uint16_t s_background[W * H];
+static uint16_t s_widgets[W * H];
+static uint8_t s_widgets_alpha[W * H];
+static uint16_t s_panel[48 * 30];
+static uint16_t s_sprite[SPRITE * SPRITE];
+static uint8_t s_sprite_alpha[SPRITE * SPRITE];
+static uint16_t s_targets[3][W * H];
+static uint16_t s_expected[W * H];
+static esp_bsp_sdl_layer_t s_layers[LAYERS];
+
+static int random_range(int lo, int hi)
+{
+    return lo + (int) (test_random() % (uint32_t) (hi - lo + 1));
+}
+
+static void init_layers(void)
+{
+    for(int i = 0; i < W * H; i++) {
+        s_background[i] = (uint16_t) test_random();
+        s_widgets[i] = (uint16_t) test_random();
+        // Transparent, opaque and translucent pixels
+        const uint32_t r = test_random() % 3;
+        s_widgets_alpha[i] = r == 0 ? 0 : r == 1 ? 255 : (uint8_t) test_random();
+    }
+    for(size_t i = 0; i < sizeof(s_panel) / sizeof(s_panel[0]); i++) {
+        s_panel[i] = (uint16_t) test_random();
+    }
+    for(int i = 0; i < SPRITE * SPRITE; i++) {
+        s_sprite[i] = (uint16_t) test_random();
+        s_sprite_alpha[i] = (uint8_t) test_random();
+    }
+
+    s_layers[0] = (esp_bsp_sdl_layer_t) {.surface = {s_background, W, H, W}, .opacity = 255, .visible = true};
+    s_layers[1] = (esp_bsp_sdl_layer_t) {
+        .surface = {s_widgets, W, H, W}, .alpha = s_widgets_alpha, .opacity = 255, .visible = true};
+    // Constant alpha, partly outside the output
+    s_layers[2] = (esp_bsp_sdl_layer_t) {.surface = {s_panel, 40, 30, 48}, .x = 70, .y = -6, .opacity = 128,
+                                         .visible = true};
+    s_layers[3] = (esp_bsp_sdl_layer_t) {
+        .surface = {s_sprite, SPRITE, SPRITE, SPRITE}, .alpha = s_sprite_alpha, .opacity = 255, .visible = true};
+}
+
+// Every visible layer blended over each output pixel on its own
+static void compose_reference(void)
+{
+    const esp_bsp_sdl_blend_kernels_t *blend = esp_bsp_sdl_blend_get_kernels(ESP_BSP_SDL_BLEND_IMPL_AUTO);
+    for(int y = 0; y < H; y++) {
+        for(int x = 0; x < W; x++) {
+            uint16_t *dst = &s_expected[y * W + x];
+            *dst = CLEAR;
+            for(int i = 0; i < LAYERS; i++) {
+                const esp_bsp_sdl_layer_t *layer = &s_layers[i];
+                const int lx = x - layer->x;
+                const int ly = y - layer->y;
+                if(!layer->visible || !layer->surface.pixels || lx < 0 || ly < 0 || lx >= layer->surface.width ||
+                   ly >= layer->surface.height) {
+                    continue;
+                }
+                const size_t offset = (size_t) ly * layer->surface.stride + lx;
+                const uint16_t *src = layer->surface.pixels + offset;
+                if(layer->alpha) {
+                    blend->rgb565_a8_over(dst, src, layer->alpha + offset, 1);
+                } else if(layer->opacity == 255) {
+                    *dst = *src;
+                } else {
+                    blend->rgb565_const_over(dst, src, layer->opacity, 1);
+                }
+            }
+        }
+    }
+}
+
+// Random rect inside a w x h layer
+static esp_bsp_sdl_rect_t random_rect(int w, int h)
+{
+    esp_bsp_sdl_rect_t rect;
+    rect.x = random_range(0, w - 1);
+    rect.y = random_range(0, h - 1);
+    rect.w = random_range(1, w - rect.x);
+    rect.h = random_range(1, h - rect.y);
+    return rect;
+}
+
+// One random change, applied to the reference layers and reported to every compositor
+static void change(esp_bsp_sdl_compositor_handle_t *comps, int count)
+{
+    switch(test_random() % 6) {
+        case 0:
+        case 1: {
+            // Sprite moves, partly off the output at times
+            const int x = random_range(-SPRITE / 2, W - SPRITE / 2);
+            const int y = random_range(-SPRITE / 2, H - SPRITE / 2);
+            s_layers[3].x = x;
+            s_layers[3].y = y;
+            for(int c = 0; c < count; c++) {
+                TEST_CHECK_OK(esp_bsp_sdl_compositor_move_layer(comps[c], 3, x, y));
+            }
+            break;
+        }
+        case 2:
+        case 3: {
+            // Pixels of the background or the widgets change
+            const int index = (int) (test_random() % 2);
+            const esp_bsp_sdl_rect_t rect = random_rect(W, H);
+            uint16_t *pixels = index ? s_widgets : s_background;
+            const uint16_t color = (uint16_t) test_random();
+            for(int y = rect.y; y < rect.y + rect.h; y++) {
+                for(int x = rect.x; x < rect.x + rect.w; x++) {
+                    pixels[y * W + x] = color;
+                }
+            }
+            for(int c = 0; c < count; c++) {
+                TEST_CHECK_OK(esp_bsp_sdl_compositor_invalidate(comps[c], index, &rect));
+            }
+            break;
+        }
+        case 4: {
+            // The panel layer moves, changes opacity or hides
+            esp_bsp_sdl_layer_t *panel = &s_layers[2];
+            panel->x = random_range(-20, W - 20);
+            panel->y = random_range(-15, H - 15);
+            panel->opacity = (uint8_t) (test_random() % 2 ? 255 : test_random());
+            panel->visible = test_random() % 4 != 0;
+            for(int c = 0; c < count; c++) {
+                TEST_CHECK_OK(esp_bsp_sdl_compositor_set_layer(comps[c], 2, panel));
+            }
+            break;
+        }
+        case 5: {
+            // Panel pixels change inside the layer
+            const esp_bsp_sdl_rect_t rect = random_rect(s_layers[2].surface.width, s_layers[2].surface.height);
+            for(int y = rect.y; y < rect.y + rect.h; y++) {
+                for(int x = rect.x; x < rect.x + rect.w; x++) {
+                    s_panel[y * 48 + x] ^= 0x5A5A;
+                }
+            }
+            for(int c = 0; c < count; c++) {
+                TEST_CHECK_OK(esp_bsp_sdl_compositor_invalidate(comps[c], 2, &rect));
+            }
+            break;
+        }
+    }
+}
+
+static void test_sequence(void)
+{
+    static const int cached[3] = {0, 2, 3};
+    esp_bsp_sdl_compositor_handle_t comps[3];
+    init_layers();
+    for(int c = 0; c < 3; c++) {
+        const esp_bsp_sdl_compositor_config_t config = {
+            .width = W,
+            .height = H,
+            .layers = LAYERS,
+            .cached_layers = cached[c],
+            .clear_color = CLEAR,
+        };
+        TEST_CHECK_OK(esp_bsp_sdl_compositor_create(&config, &comps[c]));
+        for(int i = 0; i < LAYERS; i++) {
+            TEST_CHECK_OK(esp_bsp_sdl_compositor_set_layer(comps[c], i, &s_layers[i]));
+        }
+        memset(s_targets[c], 0, sizeof(s_targets[c]));
+    }
+    if(test_failures) {
+        return;
+    }
+
+    // Stop at the first mismatch, the following frames would only repeat it
+    for(int frame = 0; frame < FRAMES && !test_failures; frame++) {
+        // No change at all on some frames, several on others
+        const int changes = frame ? (int) (test_random() % 4) : 0;
+        for(int i = 0; i < changes; i++) {
+            change(comps, 3);
+        }
+        compose_reference();
+        for(int c = 0; c < 3; c++) {
+            esp_bsp_sdl_surface_t target = {s_targets[c], W, H, W};
+            TEST_CHECK_OK(esp_bsp_sdl_compositor_render(comps[c], &target));
+            if(memcmp(s_targets[c], s_expected, sizeof(s_expected)) != 0) {
+                fprintf(stderr, "frame %d: output with %d cached layers differs from the reference\n", frame,
+                        cached[c]);
+                test_failures++;
+            }
+        }
+    }
+
+    // Only the dirty tiles were composed, and the cached setups rebuilt cache tiles instead of reading every layer
+    esp_bsp_sdl_compositor_stats_t stats[3];
+    for(int c = 0; c < 3; c++) {
+        TEST_CHECK_OK(esp_bsp_sdl_compositor_get_stats(comps[c], &stats[c]));
+        TEST_CHECK(stats[c].frames == FRAMES);
+        TEST_CHECK(stats[c].read_bytes < stats[c].full_bytes);
+    }
+    TEST_CHECK(stats[0].cache_rebuilds == 0);
+    TEST_CHECK(stats[1].cache_rebuilds > 0);
+    TEST_CHECK(stats[2].cache_rebuilds > stats[1].cache_rebuilds);
+    TEST_CHECK(stats[1].read_bytes < stats[0].read_bytes);
+
+    for(int c = 0; c < 3; c++) {
+        esp_bsp_sdl_compositor_delete(comps[c]);
+    }
+}
+
+// Nothing changed: nothing is composed and the target is left alone
+static void test_clean_frame(void)
+{
+    const esp_bsp_sdl_compositor_config_t config = {.width = W, .height = H, .layers = 2, .cached_layers = 1};
+    esp_bsp_sdl_compositor_handle_t comp;
+    init_layers();
+    TEST_CHECK_OK(esp_bsp_sdl_compositor_create(&config, &comp));
+    TEST_CHECK_OK(esp_bsp_sdl_compositor_set_layer(comp, 0, &s_layers[0]));
+    TEST_CHECK_OK(esp_bsp_sdl_compositor_set_layer(comp, 1, &s_layers[1]));
+    esp_bsp_sdl_surface_t target = {s_targets[0], W, H, W};
+    TEST_CHECK_OK(esp_bsp_sdl_compositor_render(comp, &target));
+
+    esp_bsp_sdl_compositor_reset_stats(comp);
+    s_targets[0][0] ^= 0xFFFF;
+    const uint16_t untouched = s_targets[0][0];
+    TEST_CHECK_OK(esp_bsp_sdl_compositor_render(comp, &target));
+    esp_bsp_sdl_compositor_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_compositor_get_stats(comp, &stats));
+    TEST_CHECK(stats.tiles_composed == 0 && stats.cache_rebuilds == 0 && stats.read_bytes == 0);
+    TEST_CHECK(s_targets[0][0] == untouched);
+
+    // A too small target is refused
+    esp_bsp_sdl_surface_t small = {s_targets[0], W - 1, H, W};
+    TEST_CHECK(esp_bsp_sdl_compositor_render(comp, &small) == ESP_ERR_INVALID_ARG);
+    esp_bsp_sdl_compositor_delete(comp);
+}
+
+int main(void)
+{
+    test_sequence();
+    test_clean_frame();
+    return test_finish("test_compositor");
+}
@@ -0,0 +1,119 @@
+/**
+ * @file test_dma.c
+ * @brief DMA fill and copy chunking through the synchronous DMA memcpy stand-in
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_bsp_sdl_dma.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_host_port.h"
+#include "test_util.h"
+
+#define FILL_PATTERN_BYTES 4096
+
+static uint16_t s_pixels[180 * 180] __attribute__((aligned(64)));
+static uint16_t s_source[180 * 180] __attribute__((aligned(64)));
+static int s_done_calls;
+
+static void on_done(void *user_ctx)
+{
+    s_done_calls++;
+}
+
+static int count_color(const esp_bsp_sdl_surface_t *surface, const esp_bsp_sdl_rect_t *rect, uint16_t color)
+{
+    int count = 0;
+    for(int y = rect->y; y < rect->y + rect->h; y++) {
+        for(int x = rect->x; x < rect->x + rect->w; x++) {
+            count += surface->pixels[y * surface->stride + x] == color;
+        }
+    }
+    return count;
+}
+
+// A contiguous fill whose size is not a multiple of the pattern: full chunks and one remainder
+static void test_fill_remainder(void)
+{
+    esp_bsp_sdl_surface_t surface = {s_pixels, 180, 180, 180};
+    memset(s_pixels, 0, sizeof(s_pixels));
+    esp_host_port_dma_reset_stats();
+    s_done_calls = 0;
+
+    TEST_CHECK_OK(esp_bsp_sdl_fill(&surface, NULL, 0x1234, on_done, NULL));
+    TEST_CHECK_OK(esp_bsp_sdl_dma_wait(-1));
+
+    const size_t total = sizeof(s_pixels);
+    esp_host_port_dma_stats_t stats;
+    esp_host_port_dma_get_stats(&stats);
+    if(stats.transfers != total / FILL_PATTERN_BYTES + 1 || stats.min_size != total % FILL_PATTERN_BYTES ||
+       stats.max_size != FILL_PATTERN_BYTES) {
+        fprintf(stderr, "fill of %u bytes: %u transfers of %u..%u bytes\n", (unsigned) total,
+                (unsigned) stats.transfers, (unsigned) stats.min_size, (unsigned) stats.max_size);
+        test_failures++;
+    }
+    TEST_CHECK(stats.bytes == total);
+    TEST_CHECK(s_done_calls == 1);
+    const esp_bsp_sdl_rect_t whole = {0, 0, 180, 180};
+    TEST_CHECK(count_color(&surface, &whole, 0x1234) == 180 * 180);
+}
+
+// A multiple of the pattern needs no remainder chunk
+static void test_fill_exact(void)
+{
+    esp_bsp_sdl_surface_t surface = {s_pixels, 128, 64, 128};
+    esp_host_port_dma_reset_stats();
+    TEST_CHECK_OK(esp_bsp_sdl_fill(&surface, NULL, 0xF800, NULL, NULL));
+    esp_host_port_dma_stats_t stats;
+    esp_host_port_dma_get_stats(&stats);
+    TEST_CHECK(stats.transfers == 128 * 64 * 2 / FILL_PATTERN_BYTES);
+    TEST_CHECK(stats.min_size == FILL_PATTERN_BYTES);
+}
+
+// Narrower than the stride: one chunk per row, the pixels around the rectangle stay untouched
+static void test_fill_rows(void)
+{
+    esp_bsp_sdl_surface_t surface = {s_pixels, 180, 180, 180};
+    memset(s_pixels, 0, sizeof(s_pixels));
+    esp_host_port_dma_reset_stats();
+    const esp_bsp_sdl_rect_t rect = {4, 10, 100, 60};
+    TEST_CHECK_OK(esp_bsp_sdl_fill(&surface, &rect, 0x07E0, NULL, NULL));
+    esp_host_port_dma_stats_t stats;
+    esp_host_port_dma_get_stats(&stats);
+    TEST_CHECK(stats.transfers == 60);
+    TEST_CHECK(stats.min_size == 200 && stats.max_size == 200);
+    const esp_bsp_sdl_rect_t whole = {0, 0, 180, 180};
+    TEST_CHECK(count_color(&surface, &rect, 0x07E0) == 100 * 60);
+    TEST_CHECK(count_color(&surface, &whole, 0x07E0) == 100 * 60);
+}
+
+// A copy clipped at the right edge lands row by row
+static void test_copy(void)
+{
+    for(size_t i = 0; i < sizeof(s_source) / sizeof(s_source[0]); i++) {
+        s_source[i] = i * 2654435761u >> 16;
+    }
+    memset(s_pixels, 0, sizeof(s_pixels));
+    esp_bsp_sdl_surface_t dst = {s_pixels, 180, 180, 180};
+    const esp_bsp_sdl_surface_t src = {s_source, 180, 180, 180};
+    const esp_bsp_sdl_rect_t src_rect = {8, 8, 120, 100};
+    TEST_CHECK_OK(esp_bsp_sdl_copy(&dst, 100, 20, &src, &src_rect, NULL, NULL));
+    TEST_CHECK_OK(esp_bsp_sdl_dma_wait(-1));
+    int mismatched = 0;
+    for(int y = 0; y < 100; y++) {
+        for(int x = 0; x < 80; x++) {
+            mismatched += s_pixels[(20 + y) * 180 + 100 + x] != s_source[(8 + y) * 180 + 8 + x];
+        }
+    }
+    TEST_CHECK(mismatched == 0);
+}
+
+int main(void)
+{
+    test_fill_remainder();
+    test_fill_exact();
+    test_fill_rows();
+    test_copy();
+    esp_bsp_sdl_dma_deinit();
+    return test_finish("test_dma");
+}
@@ -0,0 +1,215 @@
+/**
+ * @file test_fbc.c
+ * @brief Compressed frame buffer: lossless round trip against a plain frame, read counters, flush
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_fbc.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "sdkconfig.h"
+#include "test_util.h"
+
+// Not a multiple of the tile size, so the right and bottom tiles are partial
+#define FRAME_W 100
+#define FRAME_H 70
+#define ROUNDS  400
+
+static uint16_t s_ref[FRAME_W * FRAME_H];
+static uint16_t s_out[FRAME_W * FRAME_H];
+static uint16_t s_patch[40 * 40];
+
+static int random_range(int lo, int hi)
+{
+    return lo + (int) (test_random() % (uint32_t) (hi - lo + 1));
+}
+
+// Noise, horizontal runs or a flat color, the content classes the encoder chooses between
+static void make_patch(int w, int h)
+{
+    const int kind = random_range(0, 2);
+    const uint16_t flat = (uint16_t) test_random();
+    for(int i = 0; i < w * h; i++) {
+        if(kind == 0) {
+            s_patch[i] = (uint16_t) test_random();
+        } else if(kind == 1) {
+            s_patch[i] = (uint16_t) (((i % w) / 5) * 0x0841);
+        } else {
+            s_patch[i] = flat;
+        }
+    }
+}
+
+static void ref_write(int x, int y, int w, int h)
+{
+    for(int r = 0; r < h; r++) {
+        for(int c = 0; c < w; c++) {
+            if(x + c >= 0 && x + c < FRAME_W && y + r >= 0 && y + r < FRAME_H) {
+                s_ref[(y + r) * FRAME_W + x + c] = s_patch[r * w + c];
+            }
+        }
+    }
+}
+
+static void ref_fill(const esp_bsp_sdl_rect_t *rect, uint16_t color)
+{
+    for(int y = rect->y; y < rect->y + rect->h; y++) {
+        for(int x = rect->x; x < rect->x + rect->w; x++) {
+            if(x >= 0 && x < FRAME_W && y >= 0 && y < FRAME_H) {
+                s_ref[y * FRAME_W + x] = color;
+            }
+        }
+    }
+}
+
+// Read the frame back in random linear chunks, like the RGB bounce buffer callback does
+static bool read_matches(esp_bsp_sdl_fbc_handle_t fbc)
+{
+    memset(s_out, 0xA5, sizeof(s_out));
+    size_t pos = 0;
+    while(pos < FRAME_W * FRAME_H) {
+        size_t len = (size_t) random_range(1, 3 * FRAME_W);
+        if(pos + len > FRAME_W * FRAME_H) {
+            len = FRAME_W * FRAME_H - pos;
+        }
+        TEST_CHECK_OK(esp_bsp_sdl_fbc_read(fbc, pos, len, s_out + pos));
+        pos += len;
+    }
+    return memcmp(s_out, s_ref, sizeof(s_ref)) == 0;
+}
+
+// Random writes and fills, partially covering tiles and clipped at the frame edges
+static void test_round_trip(void)
+{
+    esp_bsp_sdl_fbc_handle_t fbc;
+    TEST_CHECK_OK(esp_bsp_sdl_fbc_create(FRAME_W, FRAME_H, &fbc));
+    memset(s_ref, 0, sizeof(s_ref));
+    TEST_CHECK(read_matches(fbc));
+
+    for(int round = 0; round < ROUNDS; round++) {
+        if(test_random() & 1) {
+            const int w = random_range(1, 40);
+            const int h = random_range(1, 40);
+            const int x = random_range(-w + 1, FRAME_W - 1);
+            const int y = random_range(-h + 1, FRAME_H - 1);
+            make_patch(w, h);
+            const esp_bsp_sdl_surface_t src = {s_patch, w, h, w};
+            TEST_CHECK_OK(esp_bsp_sdl_fbc_write(fbc, &src, x, y));
+            ref_write(x, y, w, h);
+        } else {
+            const esp_bsp_sdl_rect_t rect = {
+                random_range(-20, FRAME_W - 1), random_range(-20, FRAME_H - 1), random_range(1, 60), random_range(1, 60),
+            };
+            const uint16_t color = (uint16_t) test_random();
+            TEST_CHECK_OK(esp_bsp_sdl_fbc_fill(fbc, &rect, color));
+            ref_fill(&rect, color);
+        }
+        if(round % 50 == 49 && !read_matches(fbc)) {
+            fprintf(stderr, "round trip differs after round %d\n", round);
+            test_failures++;
+            break;
+        }
+    }
+
+    esp_bsp_sdl_fbc_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_fbc_get_stats(fbc, &stats));
+    const int tiles = ((FRAME_W + 15) / 16) * ((FRAME_H + 15) / 16);
+    TEST_CHECK(stats.tiles_const + stats.tiles_rle + stats.tiles_raw == (uint32_t) tiles);
+
+    TEST_CHECK(esp_bsp_sdl_fbc_read(fbc, FRAME_W * FRAME_H - 1, 2, s_out) == ESP_ERR_INVALID_ARG);
+    esp_bsp_sdl_fbc_delete(fbc);
+}
+
+// Bytes read per frame for a flat, a striped and a noisy scene
+static void test_read_counters(void)
+{
+    esp_bsp_sdl_fbc_handle_t fbc;
+    TEST_CHECK_OK(esp_bsp_sdl_fbc_create(FRAME_W, FRAME_H, &fbc));
+    const uint64_t frame_bytes = sizeof(s_ref);
+    esp_bsp_sdl_fbc_stats_t flat;
+    esp_bsp_sdl_fbc_stats_t stripes;
+    esp_bsp_sdl_fbc_stats_t noise;
+
+    TEST_CHECK_OK(esp_bsp_sdl_fbc_fill(fbc, NULL, 0x1234));
+    ref_fill(&(esp_bsp_sdl_rect_t) {0, 0, FRAME_W, FRAME_H}, 0x1234);
+    esp_bsp_sdl_fbc_reset_stats(fbc);
+    TEST_CHECK(read_matches(fbc));
+    TEST_CHECK_OK(esp_bsp_sdl_fbc_get_stats(fbc, &flat));
+    TEST_CHECK(flat.tiles_rle == 0 && flat.tiles_raw == 0);
+    TEST_CHECK(flat.bytes_raw == frame_bytes && flat.bytes_read == 0);
+
+    // 20-pixel vertical stripes: every tile row is two runs at most
+    for(int i = 0; i < FRAME_W * FRAME_H; i++) {
+        s_ref[i] = ((i % FRAME_W) / 20) & 1 ? 0xFFFF : 0x001F;
+    }
+    const esp_bsp_sdl_surface_t whole = {s_ref, FRAME_W, FRAME_H, FRAME_W};
+    TEST_CHECK_OK(esp_bsp_sdl_fbc_write(fbc, &whole, 0, 0));
+    esp_bsp_sdl_fbc_reset_stats(fbc);
+    TEST_CHECK(read_matches(fbc));
+    TEST_CHECK_OK(esp_bsp_sdl_fbc_get_stats(fbc, &stripes));
+    TEST_CHECK(stripes.tiles_raw == 0 && stripes.tiles_rle > 0);
+    TEST_CHECK(stripes.bytes_raw == frame_bytes && stripes.bytes_read < frame_bytes / 2);
+
+    for(int i = 0; i < FRAME_W * FRAME_H; i++) {
+        s_ref[i] = (uint16_t) test_random();
+    }
+    TEST_CHECK_OK(esp_bsp_sdl_fbc_write(fbc, &whole, 0, 0));
+    esp_bsp_sdl_fbc_reset_stats(fbc);
+    TEST_CHECK(read_matches(fbc));
+    TEST_CHECK_OK(esp_bsp_sdl_fbc_get_stats(fbc, &noise));
+    TEST_CHECK(noise.tiles_const == 0 && noise.tiles_rle == 0);
+    // Raw tiles read exactly what a plain frame buffer would
+    TEST_CHECK(noise.bytes_read == frame_bytes);
+
+    printf("bytes read per %dx%d frame (plain %llu): flat %llu, stripes %llu, noise %llu\n", FRAME_W, FRAME_H,
+           (unsigned long long) frame_bytes, (unsigned long long) flat.bytes_read,
+           (unsigned long long) stripes.bytes_read, (unsigned long long) noise.bytes_read);
+    esp_bsp_sdl_fbc_delete(fbc);
+}
+
+// Presenting decodes band by band into what the panel shows
+static void test_flush(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_handle_t panel;
+    esp_lcd_panel_io_handle_t io;
+    TEST_CHECK_OK(esp_bsp_sdl_init(&config, &panel, &io));
+
+    esp_bsp_sdl_fbc_handle_t fbc;
+    TEST_CHECK_OK(esp_bsp_sdl_fbc_create(FRAME_W, FRAME_H, &fbc));
+    TEST_CHECK(esp_bsp_sdl_fbc_flush(fbc) == ESP_ERR_INVALID_SIZE);
+    esp_bsp_sdl_fbc_delete(fbc);
+
+    const int w = config.width;
+    const int h = config.height;
+    TEST_CHECK_OK(esp_bsp_sdl_fbc_create(w, h, &fbc));
+    uint16_t *expected = calloc((size_t) w * h, sizeof(uint16_t));
+    TEST_CHECK(expected != NULL);
+    if(expected) {
+        const esp_bsp_sdl_rect_t bar = {5, 3, 40, 9};
+        TEST_CHECK_OK(esp_bsp_sdl_fbc_fill(fbc, NULL, 0x4208));
+        TEST_CHECK_OK(esp_bsp_sdl_fbc_fill(fbc, &bar, 0xF800));
+        make_patch(20, 20);
+        const esp_bsp_sdl_surface_t src = {s_patch, 20, 20, 20};
+        TEST_CHECK_OK(esp_bsp_sdl_fbc_write(fbc, &src, 30, 20));
+        TEST_CHECK_OK(esp_bsp_sdl_fbc_read(fbc, 0, (size_t) w * h, expected));
+        TEST_CHECK_OK(esp_bsp_sdl_fbc_flush(fbc));
+
+        esp_bsp_sdl_surface_t frame;
+        TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(panel, &frame));
+        const esp_bsp_sdl_surface_t reference = {expected, w, h, w};
+        TEST_CHECK_OK(esp_bsp_sdl_frame_compare(&frame, &reference, 0, NULL));
+        free(expected);
+    }
+    esp_bsp_sdl_fbc_delete(fbc);
+    TEST_CHECK_OK(esp_bsp_sdl_deinit());
+}
+
+int main(void)
+{
+    test_round_trip();
+    test_read_counters();
+    test_flush();
+    return test_finish("test_fbc");
+}
@@ -0,0 +1,258 @@
+/**
+ * @file test_flush.c
+ * @brief Flush engine bookkeeping: chained transfer callbacks, statistics, auto-dirty and bounced transfers
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "esp_host_port.h"
+#include "sdkconfig.h"
+#include "test_util.h"
+
+#define NATIVE_W CONFIG_SDL_BSP_VIRTUAL_WIDTH
+#define NATIVE_H CONFIG_SDL_BSP_VIRTUAL_HEIGHT
+
+static esp_lcd_panel_handle_t s_panel;
+static uint16_t s_frame[NATIVE_W * NATIVE_H];
+static int s_chained_calls;
+static esp_bsp_sdl_rect_t s_areas[16];
+static int s_area_count;
+
+static bool on_app_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    TEST_CHECK(user_ctx == &s_chained_calls);
+    s_chained_calls++;
+    return false;
+}
+
+static esp_err_t fill_band(esp_bsp_sdl_surface_t *band, const esp_bsp_sdl_rect_t *rect, void *user_ctx)
+{
+    for(int y = 0; y < band->height; y++) {
+        for(int x = 0; x < band->width; x++) {
+            band->pixels[y * band->stride + x] = 0x07E0;
+        }
+    }
+    return ESP_OK;
+}
+
+// An application callback keeps running once the flush engine owns the panel IO callback
+static void test_chained_callback(void)
+{
+    TEST_CHECK_OK(esp_bsp_sdl_set_trans_done_callback(on_app_trans_done, &s_chained_calls));
+
+    // Before the engine takes over, the callback is installed on the panel IO directly
+    TEST_CHECK_OK(esp_lcd_panel_draw_bitmap(s_panel, 0, 0, 8, 8, s_frame));
+    esp_bsp_sdl_surface_t frame;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(s_panel, &frame));
+    TEST_CHECK(s_chained_calls == 1);
+    esp_bsp_sdl_invalidate_window();
+
+    esp_bsp_sdl_virtual_panel_reset_stats(s_panel);
+    s_chained_calls = 0;
+    for(int i = 0; i < 3; i++) {
+        memset(s_frame, i, sizeof(s_frame));
+        TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_frame));
+    }
+    esp_bsp_sdl_virtual_panel_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_stats(s_panel, &stats));
+    TEST_CHECK(stats.color_writes >= 3);
+    TEST_CHECK(s_chained_calls == (int) stats.color_writes);
+
+    TEST_CHECK_OK(esp_bsp_sdl_set_trans_done_callback(NULL, NULL));
+    s_chained_calls = 0;
+    TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_frame));
+    TEST_CHECK(s_chained_calls == 0);
+}
+
+// Overlapping areas must not wrap the skipped byte counter
+static void test_overlapping_rects(void)
+{
+    const esp_bsp_sdl_rect_t rects[] = {
+        {0, 0, NATIVE_W, 16},
+        {0, 0, NATIVE_W, 16},
+        {0, 16, NATIVE_W, 16},
+        {0, 16, NATIVE_W, 16},
+        {0, 32, NATIVE_W, 16},
+        {0, 32, NATIVE_W, 16},
+    };
+    esp_bsp_sdl_reset_flush_stats();
+    TEST_CHECK_OK(esp_bsp_sdl_flush_rects(rects, sizeof(rects) / sizeof(rects[0]), fill_band, NULL));
+    esp_bsp_sdl_flush_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_get_flush_stats(&stats));
+    TEST_CHECK(stats.frames == 1);
+    TEST_CHECK(stats.pixel_bytes == 2ULL * NATIVE_W * NATIVE_H * sizeof(uint16_t));
+    TEST_CHECK(stats.skipped_bytes == 0);
+
+    const esp_bsp_sdl_rect_t part = {4, 4, 10, 10};
+    esp_bsp_sdl_reset_flush_stats();
+    TEST_CHECK_OK(esp_bsp_sdl_flush_rects(&part, 1, fill_band, NULL));
+    TEST_CHECK_OK(esp_bsp_sdl_get_flush_stats(&stats));
+    TEST_CHECK(stats.skipped_bytes == (NATIVE_W * NATIVE_H - 100ULL) * sizeof(uint16_t));
+}
+
+static void record_area(const esp_bsp_sdl_surface_t *frame, const esp_bsp_sdl_rect_t *area, void *user_ctx)
+{
+    if(s_area_count < (int) (sizeof(s_areas) / sizeof(s_areas[0]))) {
+        s_areas[s_area_count] = *area;
+    }
+    s_area_count++;
+}
+
+// Flush s_frame in shadow mode and check the transfers against the expected rects
+static void flush_dirty(const char *step, const esp_bsp_sdl_rect_t *expected, int count)
+{
+    esp_bsp_sdl_reset_flush_stats();
+    esp_bsp_sdl_virtual_panel_reset_stats(s_panel);
+    s_area_count = 0;
+    TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_frame));
+    esp_bsp_sdl_surface_t shown;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(s_panel, &shown));
+
+    uint64_t bytes = 0;
+    bool match = s_area_count == count;
+    for(int i = 0; i < count; i++) {
+        bytes += (uint64_t) expected[i].w * expected[i].h * sizeof(uint16_t);
+        match = match && memcmp(&s_areas[i], &expected[i], sizeof(expected[i])) == 0;
+    }
+    if(!match) {
+        fprintf(stderr, "%s: %d transfers, %d expected\n", step, s_area_count, count);
+        test_failures++;
+    }
+    esp_bsp_sdl_flush_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_get_flush_stats(&stats));
+    esp_bsp_sdl_virtual_panel_stats_t panel_stats;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_stats(s_panel, &panel_stats));
+    TEST_CHECK(stats.pixel_bytes == bytes && panel_stats.color_bytes == bytes);
+    TEST_CHECK(stats.skipped_bytes == NATIVE_W * NATIVE_H * sizeof(uint16_t) - bytes);
+    TEST_CHECK(stats.tiles_checked == (NATIVE_W / 16) * (NATIVE_H / 16));
+    for(int y = 0; y < NATIVE_H; y++) {
+        TEST_CHECK(memcmp(shown.pixels + y * shown.stride, s_frame + y * NATIVE_W, NATIVE_W * sizeof(uint16_t)) == 0);
+    }
+}
+
+// Shadow mode sends only the tile rows that changed, trimmed to the changed tile columns
+static void test_shadow_dirty(void)
+{
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_set_listener(s_panel, record_area, NULL));
+    TEST_CHECK_OK(esp_bsp_sdl_set_dirty_mode(ESP_BSP_SDL_DIRTY_SHADOW));
+    for(int i = 0; i < NATIVE_W * NATIVE_H; i++) {
+        s_frame[i] = (uint16_t) (i * 3);
+    }
+
+    // No history yet: every tile row completely
+    const esp_bsp_sdl_rect_t full[] = {
+        {0, 0, NATIVE_W, 16},
+        {0, 16, NATIVE_W, 16},
+        {0, 32, NATIVE_W, 16},
+    };
+    flush_dirty("first frame", full, 3);
+
+    flush_dirty("unchanged", NULL, 0);
+
+    // One pixel in tile (1,0) and one in tile (3,2)
+    s_frame[5 * NATIVE_W + 20] ^= 0xFFFF;
+    s_frame[40 * NATIVE_W + 50] ^= 0x0001;
+    const esp_bsp_sdl_rect_t two_tiles[] = {
+        {16, 0, 16, 16},
+        {48, 32, 16, 16},
+    };
+    flush_dirty("two tiles", two_tiles, 2);
+
+    // Tiles (0,1) and (2,1): one transfer from the first to the last changed column
+    s_frame[20 * NATIVE_W + 3] ^= 0xFFFF;
+    s_frame[31 * NATIVE_W + 47] ^= 0xFFFF;
+    const esp_bsp_sdl_rect_t span[] = {{0, 16, 48, 16}};
+    flush_dirty("one tile row", span, 1);
+
+    flush_dirty("unchanged again", NULL, 0);
+
+    TEST_CHECK_OK(esp_bsp_sdl_set_dirty_mode(ESP_BSP_SDL_DIRTY_OFF));
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_set_listener(s_panel, NULL, NULL));
+}
+
+// Flush s_frame and check the transfers, the bytes staged through the band buffers and the panel
+static void flush_placed(const char *step, const esp_bsp_sdl_rect_t *expected, int count, uint64_t bounced)
+{
+    esp_bsp_sdl_reset_flush_stats();
+    s_area_count = 0;
+    TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_frame));
+    esp_bsp_sdl_surface_t shown;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(s_panel, &shown));
+
+    bool match = s_area_count == count;
+    for(int i = 0; i < count && match; i++) {
+        match = memcmp(&s_areas[i], &expected[i], sizeof(expected[i])) == 0;
+    }
+    if(!match) {
+        fprintf(stderr, "%s: %d transfers, %d expected\n", step, s_area_count, count);
+        test_failures++;
+    }
+    esp_bsp_sdl_flush_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_get_flush_stats(&stats));
+    TEST_CHECK(stats.bounced_bytes == bounced);
+    TEST_CHECK(stats.pixel_bytes == NATIVE_W * NATIVE_H * sizeof(uint16_t));
+    for(int y = 0; y < NATIVE_H; y++) {
+        TEST_CHECK(memcmp(shown.pixels + y * shown.stride, s_frame + y * NATIVE_W, NATIVE_W * sizeof(uint16_t)) == 0);
+    }
+}
+
+// PSRAM_BOUNCE sends frames in PSRAM band by band from internal buffers, everything else in one transfer
+static void test_psram_bounce(void)
+{
+    const esp_bsp_sdl_rect_t whole[] = {{0, 0, NATIVE_W, NATIVE_H}};
+    const esp_bsp_sdl_rect_t bands[] = {
+        {0, 0, NATIVE_W, ESP_BSP_SDL_FLUSH_BAND_ROWS},
+        {0, 16, NATIVE_W, ESP_BSP_SDL_FLUSH_BAND_ROWS},
+        {0, 32, NATIVE_W, ESP_BSP_SDL_FLUSH_BAND_ROWS},
+    };
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_set_listener(s_panel, record_area, NULL));
+    for(int i = 0; i < NATIVE_W * NATIVE_H; i++) {
+        s_frame[i] = (uint16_t) (i * 5 + 1);
+    }
+
+    TEST_CHECK_OK(esp_bsp_sdl_set_placement(ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE));
+    TEST_CHECK(esp_bsp_sdl_get_placement() == ESP_BSP_SDL_PLACEMENT_PSRAM_BOUNCE);
+    flush_placed("internal frame, bounce policy", whole, 1, 0);
+
+    esp_host_port_set_external_ram(s_frame, sizeof(s_frame));
+    s_frame[0] ^= 0xFFFF;
+    flush_placed("PSRAM frame, bounce policy", bands, 3, sizeof(s_frame));
+
+    // Rows in PSRAM bounce under any policy, the panel cannot read them
+    TEST_CHECK_OK(esp_bsp_sdl_set_placement(ESP_BSP_SDL_PLACEMENT_INTERNAL));
+    esp_bsp_sdl_reset_flush_stats();
+    s_area_count = 0;
+    TEST_CHECK_OK(esp_bsp_sdl_flush_rows(s_frame + 8 * NATIVE_W, 8, 40));
+    esp_bsp_sdl_surface_t shown;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(s_panel, &shown));
+    esp_bsp_sdl_flush_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_get_flush_stats(&stats));
+    TEST_CHECK(s_area_count == 2 && stats.bounced_bytes == 32 * NATIVE_W * sizeof(uint16_t));
+    TEST_CHECK(s_areas[0].y == 8 && s_areas[0].h == 16 && s_areas[1].y == 24 && s_areas[1].h == 16);
+
+    esp_host_port_set_external_ram(NULL, 0);
+    TEST_CHECK_OK(esp_bsp_sdl_set_placement(ESP_BSP_SDL_PLACEMENT_AUTO));
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_set_listener(s_panel, NULL, NULL));
+}
+
+int main(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_io_handle_t io;
+    TEST_CHECK(esp_bsp_sdl_set_trans_done_callback(on_app_trans_done, NULL) == ESP_ERR_INVALID_STATE);
+    TEST_CHECK_OK(esp_bsp_sdl_init(&config, &s_panel, &io));
+    if(test_failures) {
+        return test_finish("test_flush");
+    }
+
+    test_chained_callback();
+    test_overlapping_rects();
+    test_shadow_dirty();
+    test_psram_bounce();
+
+    TEST_CHECK_OK(esp_bsp_sdl_deinit());
+    return test_finish("test_flush");
+}
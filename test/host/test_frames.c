@@ -0,0 +1,228 @@
+/**
+ * @file test_frames.c
+ * @brief Frames through esp_bsp_sdl_init/draw/flush on the virtual board, checked against golden images
+ *
+ * The virtual panel sits off-centre in its controller RAM (see config/sdkconfig.h), so every
+ * orientation also checks that the gaps follow the rotation.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_color.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_bsp_sdl_touch_mock.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "sdkconfig.h"
+#include "test_util.h"
+
+#define NATIVE_W CONFIG_SDL_BSP_VIRTUAL_WIDTH
+#define NATIVE_H CONFIG_SDL_BSP_VIRTUAL_HEIGHT
+
+static esp_lcd_panel_handle_t s_panel;
+static uint16_t s_logical[NATIVE_W * NATIVE_H];
+static uint16_t s_expected[NATIVE_W * NATIVE_H];
+
+static uint16_t rgb565(int r, int g, int b)
+{
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+}
+
+// Asymmetric test card: gradients, a border and a marker block near the logical origin
+static void draw_card(uint16_t *frame, int w, int h, int seed)
+{
+    for(int y = 0; y < h; y++) {
+        for(int x = 0; x < w; x++) {
+            uint16_t p = rgb565(x * 255 / (w - 1), y * 255 / (h - 1), (seed * 40 + x + y) & 0xFF);
+            if(x == 0 || y == 0 || x == w - 1 || y == h - 1) {
+                p = 0xFFFF;
+            } else if(x >= 3 && x < 9 && y >= 3 && y < 7) {
+                p = rgb565(255, 0, 0);
+            }
+            frame[y * w + x] = p;
+        }
+    }
+}
+
+static void get_frame(esp_bsp_sdl_surface_t *frame)
+{
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(s_panel, frame));
+    TEST_CHECK(frame->width == NATIVE_W && frame->height == NATIVE_H);
+}
+
+static void check_no_dropped_pixels(const char *scene)
+{
+    esp_bsp_sdl_virtual_panel_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_stats(s_panel, &stats));
+    if(stats.dropped_pixels) {
+        fprintf(stderr, "%s: %u pixels outside the visible area\n", scene, (unsigned) stats.dropped_pixels);
+        test_failures++;
+    }
+}
+
+// RGB888 gradient through the identity LUT, within one RGB565 step of the golden image
+static void test_conversion(esp_bsp_sdl_display_config_t *config)
+{
+    TEST_CHECK_OK(esp_bsp_sdl_set_orientation(ESP_BSP_SDL_ORIENTATION_0, config));
+
+    static uint8_t rgb888[NATIVE_W * NATIVE_H * 3];
+    for(int y = 0; y < NATIVE_H; y++) {
+        for(int x = 0; x < NATIVE_W; x++) {
+            uint8_t *p = &rgb888[(y * NATIVE_W + x) * 3];
+            p[0] = x * 255 / (NATIVE_W - 1);
+            p[1] = y * 255 / (NATIVE_H - 1);
+            p[2] = (x * y) & 0xFF;
+        }
+    }
+    static esp_bsp_sdl_color_lut_t lut;
+    TEST_CHECK_OK(esp_bsp_sdl_color_lut_build(NULL, &lut));
+    esp_bsp_sdl_color_convert_rgb888_to_rgb565(&lut, rgb888, s_logical, NATIVE_W * NATIVE_H, false);
+
+    esp_bsp_sdl_virtual_panel_reset_stats(s_panel);
+    TEST_CHECK_OK(esp_bsp_sdl_draw_bitmap(0, 0, NATIVE_W, NATIVE_H, s_logical));
+
+    esp_bsp_sdl_surface_t frame;
+    get_frame(&frame);
+    test_golden_check("conversion", &frame, 1);
+    check_no_dropped_pixels("conversion");
+}
+
+// Full frames in every orientation, against the software rotation blit and the golden images
+static void test_rotation(esp_bsp_sdl_display_config_t *config)
+{
+    static const char *const names[] = {"rotate_0", "rotate_90", "rotate_180", "rotate_270"};
+
+    for(int o = ESP_BSP_SDL_ORIENTATION_0; o <= ESP_BSP_SDL_ORIENTATION_270; o++) {
+        TEST_CHECK_OK(esp_bsp_sdl_set_orientation(o, config));
+        const bool swapped = o == ESP_BSP_SDL_ORIENTATION_90 || o == ESP_BSP_SDL_ORIENTATION_270;
+        TEST_CHECK(config->width == (swapped ? NATIVE_H : NATIVE_W));
+        TEST_CHECK(config->height == (swapped ? NATIVE_W : NATIVE_H));
+
+        draw_card(s_logical, config->width, config->height, o);
+        esp_bsp_sdl_virtual_panel_reset_stats(s_panel);
+        TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_logical));
+
+        esp_bsp_sdl_rotate_blit_rgb565(s_expected, NATIVE_W, NATIVE_H, o, 0, 0, config->width, config->height, s_logical);
+        const esp_bsp_sdl_surface_t expected = {s_expected, NATIVE_W, NATIVE_H, NATIVE_W};
+        esp_bsp_sdl_surface_t frame;
+        get_frame(&frame);
+        esp_bsp_sdl_frame_diff_t diff;
+        if(esp_bsp_sdl_frame_compare(&frame, &expected, 0, &diff) != ESP_OK) {
+            fprintf(stderr, "%s: %u pixels differ from the rotation blit\n", names[o], (unsigned) diff.mismatched);
+            test_failures++;
+        }
+        test_golden_check(names[o], &frame, 0);
+        check_no_dropped_pixels(names[o]);
+    }
+}
+
+// Tile hash dirty mode: a small change at 90 degrees only sends the tiles it touches
+static void test_partial_flush(esp_bsp_sdl_display_config_t *config)
+{
+    TEST_CHECK_OK(esp_bsp_sdl_set_orientation(ESP_BSP_SDL_ORIENTATION_90, config));
+    TEST_CHECK_OK(esp_bsp_sdl_set_dirty_mode(ESP_BSP_SDL_DIRTY_TILE_HASH));
+
+    draw_card(s_logical, config->width, config->height, 7);
+    TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_logical));
+
+    // Change a 5x4 block inside one 16x16 tile, and draw a sub-rectangle directly
+    for(int y = 20; y < 24; y++) {
+        for(int x = 18; x < 23; x++) {
+            s_logical[y * config->width + x] = rgb565(0, 0, 255);
+        }
+    }
+    esp_bsp_sdl_reset_flush_stats();
+    TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_logical));
+
+    esp_bsp_sdl_flush_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_get_flush_stats(&stats));
+    const uint64_t frame_bytes = (uint64_t) config->width * config->height * sizeof(uint16_t);
+    TEST_CHECK(stats.frames == 1);
+    TEST_CHECK(stats.tiles_dirty == 1);
+    TEST_CHECK(stats.pixel_bytes > 0 && stats.pixel_bytes <= 16 * 16 * sizeof(uint16_t));
+    TEST_CHECK(stats.pixel_bytes + stats.skipped_bytes == frame_bytes);
+
+    uint16_t patch[6 * 3];
+    for(int i = 0; i < 6 * 3; i++) {
+        patch[i] = rgb565(0, 255, 255);
+    }
+    TEST_CHECK_OK(esp_bsp_sdl_draw_bitmap(30, 40, 36, 43, patch));
+    for(int y = 40; y < 43; y++) {
+        memcpy(&s_logical[y * config->width + 30], patch, sizeof(uint16_t) * 6);
+    }
+
+    esp_bsp_sdl_rotate_blit_rgb565(s_expected, NATIVE_W, NATIVE_H, ESP_BSP_SDL_ORIENTATION_90, 0, 0, config->width,
+                                   config->height, s_logical);
+    const esp_bsp_sdl_surface_t expected = {s_expected, NATIVE_W, NATIVE_H, NATIVE_W};
+    esp_bsp_sdl_surface_t frame;
+    get_frame(&frame);
+    TEST_CHECK(esp_bsp_sdl_frame_compare(&frame, &expected, 0, NULL) == ESP_OK);
+    test_golden_check("partial_flush", &frame, 0);
+
+    TEST_CHECK_OK(esp_bsp_sdl_set_dirty_mode(ESP_BSP_SDL_DIRTY_OFF));
+}
+
+// A native touch point maps to the logical point whose marker lands on that native pixel
+static void test_touch(esp_bsp_sdl_display_config_t *config)
+{
+    TEST_CHECK_OK(esp_bsp_sdl_touch_init());
+    esp_lcd_touch_handle_t touch = esp_bsp_sdl_virtual_get_touch();
+    TEST_CHECK(touch != NULL);
+    if(!touch) {
+        return;
+    }
+
+    const esp_bsp_sdl_touch_mock_frame_t contact = {.points = 1, .coords = {{.x = 13, .y = 37, .strength = 1}}};
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_inject(touch, &contact));
+
+    static uint16_t first[NATIVE_W * NATIVE_H];
+    for(int o = ESP_BSP_SDL_ORIENTATION_0; o <= ESP_BSP_SDL_ORIENTATION_270; o++) {
+        TEST_CHECK_OK(esp_bsp_sdl_set_orientation(o, config));
+        esp_bsp_sdl_touch_info_t info;
+        TEST_CHECK_OK(esp_bsp_sdl_touch_read(&info));
+        TEST_CHECK(info.pressed);
+        TEST_CHECK(info.x >= 0 && info.x < config->width && info.y >= 0 && info.y < config->height);
+
+        memset(s_logical, 0, sizeof(uint16_t) * config->width * config->height);
+        s_logical[info.y * config->width + info.x] = 0xFFFF;
+        TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_logical));
+
+        esp_bsp_sdl_surface_t frame;
+        get_frame(&frame);
+        TEST_CHECK(frame.pixels[contact.coords[0].y * frame.stride + contact.coords[0].x] == 0xFFFF);
+        if(o == ESP_BSP_SDL_ORIENTATION_0) {
+            for(int y = 0; y < NATIVE_H; y++) {
+                memcpy(&first[y * NATIVE_W], &frame.pixels[y * frame.stride], sizeof(uint16_t) * NATIVE_W);
+            }
+            test_golden_check("touch", &frame, 0);
+        } else {
+            const esp_bsp_sdl_surface_t reference = {first, NATIVE_W, NATIVE_H, NATIVE_W};
+            TEST_CHECK(esp_bsp_sdl_frame_compare(&frame, &reference, 0, NULL) == ESP_OK);
+        }
+    }
+
+    const esp_bsp_sdl_touch_mock_frame_t release = {.points = 0};
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_inject(touch, &release));
+    esp_bsp_sdl_touch_info_t info;
+    TEST_CHECK_OK(esp_bsp_sdl_touch_read(&info));
+    TEST_CHECK(!info.pressed);
+}
+
+int main(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_io_handle_t io;
+    TEST_CHECK_OK(esp_bsp_sdl_init(&config, &s_panel, &io));
+    if(test_failures) {
+        return test_finish("test_frames");
+    }
+    TEST_CHECK(esp_bsp_sdl_is_virtual_panel(s_panel));
+
+    test_conversion(&config);
+    test_rotation(&config);
+    test_partial_flush(&config);
+    test_touch(&config);
+
+    TEST_CHECK_OK(esp_bsp_sdl_deinit());
+    return test_finish("test_frames");
+}
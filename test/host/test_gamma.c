@@ -0,0 +1,119 @@
+/**
+ * @file test_gamma.c
+ * @brief Panel gamma curves: the command stream sent to the controller and what it keeps
+ */
+
+#include <string.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_io_recorder.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "test_util.h"
+
+static esp_lcd_panel_handle_t s_panel;
+static esp_lcd_panel_io_handle_t s_io;
+
+static bool gamma_equal(const esp_bsp_sdl_panel_gamma_t *a, const esp_bsp_sdl_panel_gamma_t *b)
+{
+    return a->length == b->length && memcmp(a->positive, b->positive, a->length) == 0 &&
+           memcmp(a->negative, b->negative, a->length) == 0;
+}
+
+// The recorded stream is PGAMCTRL then NGAMCTRL, each with exactly the curve bytes
+static void check_stream(const esp_bsp_sdl_panel_gamma_t *expected)
+{
+    esp_bsp_sdl_io_rec_summary_t summary;
+    esp_bsp_sdl_io_recorder_get_summary(&summary);
+    TEST_CHECK(summary.entries == 2);
+
+    static const int cmds[2] = {LCD_CMD_PGAMCTRL, LCD_CMD_NGAMCTRL};
+    for(size_t i = 0; i < 2 && i < summary.entries; i++) {
+        esp_bsp_sdl_io_rec_entry_t entry;
+        TEST_CHECK_OK(esp_bsp_sdl_io_recorder_get_entry(i, &entry));
+        const uint8_t *curve = i == 0 ? expected->positive : expected->negative;
+        TEST_CHECK(entry.kind == ESP_BSP_SDL_IO_REC_TX_PARAM);
+        TEST_CHECK(entry.cmd == cmds[i]);
+        TEST_CHECK(entry.size == expected->length && entry.param_len == expected->length);
+        TEST_CHECK(memcmp(entry.param, curve, expected->length) == 0);
+    }
+}
+
+// CONFIG_SDL_BSP_PANEL_GAMMA loads the board curves at init
+static void test_init_defaults(const esp_bsp_sdl_panel_gamma_t *defaults)
+{
+    esp_bsp_sdl_panel_gamma_t gamma;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_gamma(s_panel, &gamma));
+    TEST_CHECK(defaults->length == 15);
+    TEST_CHECK(gamma_equal(&gamma, defaults));
+}
+
+// Custom curves of another length replace the board ones, NULL goes back to them
+static void test_load(const esp_bsp_sdl_panel_gamma_t *defaults)
+{
+    esp_bsp_sdl_panel_gamma_t st7789 = {.length = 14};
+    for(int i = 0; i < 14; i++) {
+        st7789.positive[i] = 0xD0 + i;
+        st7789.negative[i] = 0x10 + i;
+    }
+
+    esp_bsp_sdl_io_recorder_clear();
+    TEST_CHECK_OK(esp_bsp_sdl_load_panel_gamma(&st7789));
+    check_stream(&st7789);
+    esp_bsp_sdl_panel_gamma_t gamma;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_gamma(s_panel, &gamma));
+    TEST_CHECK(gamma_equal(&gamma, &st7789));
+
+    esp_bsp_sdl_io_recorder_clear();
+    TEST_CHECK_OK(esp_bsp_sdl_load_panel_gamma(NULL));
+    check_stream(defaults);
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_gamma(s_panel, &gamma));
+    TEST_CHECK(gamma_equal(&gamma, defaults));
+}
+
+// Bad lengths are refused before anything reaches the bus
+static void test_invalid(void)
+{
+    esp_bsp_sdl_panel_gamma_t bad = {.length = 0};
+    esp_bsp_sdl_io_recorder_clear();
+    TEST_CHECK(esp_bsp_sdl_load_panel_gamma(&bad) == ESP_ERR_INVALID_ARG);
+    bad.length = 17;
+    TEST_CHECK(esp_bsp_sdl_load_panel_gamma(&bad) == ESP_ERR_INVALID_ARG);
+    esp_bsp_sdl_io_rec_summary_t summary;
+    esp_bsp_sdl_io_recorder_get_summary(&summary);
+    TEST_CHECK(summary.entries == 0);
+}
+
+// A controller reset clears the curves until they are loaded again
+static void test_reset(const esp_bsp_sdl_panel_gamma_t *defaults)
+{
+    esp_bsp_sdl_panel_gamma_t gamma;
+    TEST_CHECK_OK(esp_bsp_sdl_io_recorder_capture_init(s_panel, s_io, 16));
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_gamma(s_panel, &gamma));
+    TEST_CHECK(gamma.length == 0);
+
+    TEST_CHECK_OK(esp_bsp_sdl_load_panel_gamma(NULL));
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_gamma(s_panel, &gamma));
+    TEST_CHECK(gamma_equal(&gamma, defaults));
+}
+
+int main(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    TEST_CHECK_OK(esp_bsp_sdl_init(&config, &s_panel, &s_io));
+    const esp_bsp_sdl_board_interface_t *board = esp_bsp_sdl_priv_get_board();
+    TEST_CHECK(board && board->panel_gamma);
+    if(test_failures) {
+        return test_finish("test_gamma");
+    }
+    TEST_CHECK_OK(esp_bsp_sdl_io_recorder_start(s_io, 16, 0));
+
+    test_init_defaults(board->panel_gamma);
+    test_load(board->panel_gamma);
+    test_invalid();
+    test_reset(board->panel_gamma);
+
+    TEST_CHECK_OK(esp_bsp_sdl_io_recorder_stop());
+    esp_bsp_sdl_io_recorder_free();
+    TEST_CHECK_OK(esp_bsp_sdl_deinit());
+    return test_finish("test_gamma");
+}
@@ -0,0 +1,284 @@
+/**
+ * @file test_glyph_cache.c
+ * @brief Glyph cache: UTF-8 decoding, atlas size, drawing of stored, blended and skipped pixels, LRU
+ *        eviction, missing glyphs and glyphs larger than the scratch
+ */
+
+#include <string.h>
+#include "esp_bsp_sdl_blend.h"
+#include "esp_bsp_sdl_glyph_cache.h"
+#include "esp_bsp_sdl_mem.h"
+#include "test_util.h"
+
+#define MAX_CODEPOINTS 16
+#define SURFACE_W      16
+#define SURFACE_H      12
+
+static uint32_t s_codepoints[MAX_CODEPOINTS];
+static int s_count;
+
+// No glyph is found, so every code point decoded for the first time reaches the callback
+static esp_err_t record_codepoint(uint32_t codepoint, esp_bsp_sdl_glyph_metrics_t *metrics, uint8_t *coverage,
+                                  size_t coverage_size, void *user_ctx)
+{
+    if(s_count < MAX_CODEPOINTS) {
+        s_codepoints[s_count] = codepoint;
+    }
+    s_count++;
+    return ESP_ERR_NOT_FOUND;
+}
+
+// 'A' is a 3x2 block: full, half and no coverage in each row
+static esp_err_t block_glyph(uint32_t codepoint, esp_bsp_sdl_glyph_metrics_t *metrics, uint8_t *coverage,
+                             size_t coverage_size, void *user_ctx)
+{
+    s_count++;
+    if(codepoint != 'A') {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *metrics = (esp_bsp_sdl_glyph_metrics_t) {.width = 3, .height = 2, .bearing_x = 1, .bearing_y = 2, .advance = 5};
+    static const uint8_t block[6] = {255, 128, 0, 255, 128, 0};
+    memcpy(coverage, block, sizeof(block));
+    return ESP_OK;
+}
+
+// Repeated code points are served from the missing entries: the callback sees each one once
+static bool decodes_to(esp_bsp_sdl_glyph_cache_handle_t cache, const char *text, const uint32_t *expected, int count)
+{
+    uint32_t first[MAX_CODEPOINTS];
+    int firsts = 0;
+    for(int i = 0; i < count; i++) {
+        bool seen = false;
+        for(int j = 0; j < firsts; j++) {
+            seen = seen || first[j] == expected[i];
+        }
+        if(!seen) {
+            first[firsts++] = expected[i];
+        }
+    }
+
+    int advance;
+    esp_bsp_sdl_glyph_cache_stats_t before;
+    esp_bsp_sdl_glyph_cache_stats_t after;
+    esp_bsp_sdl_glyph_cache_clear(cache);
+    TEST_CHECK_OK(esp_bsp_sdl_glyph_cache_get_stats(cache, &before));
+    s_count = 0;
+    TEST_CHECK_OK(esp_bsp_sdl_text_measure(cache, text, &advance));
+    TEST_CHECK_OK(esp_bsp_sdl_glyph_cache_get_stats(cache, &after));
+    return s_count == firsts && memcmp(s_codepoints, first, firsts * sizeof(uint32_t)) == 0 &&
+           (int) (after.hits - before.hits) == count - firsts && advance == 0;
+}
+
+static void test_utf8(void)
+{
+    const esp_bsp_sdl_glyph_cache_config_t config = {
+        .max_glyph_width = 8,
+        .max_glyph_height = 8,
+        .capacity = 4,
+        .rasterize = record_codepoint,
+    };
+    esp_bsp_sdl_glyph_cache_handle_t cache;
+    TEST_CHECK_OK(esp_bsp_sdl_glyph_cache_create(&config, &cache));
+
+    TEST_CHECK(decodes_to(cache, "Az", (const uint32_t[]) {'A', 'z'}, 2));
+    TEST_CHECK(decodes_to(cache, "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80", (const uint32_t[]) {0xE9, 0x20AC, 0x1F600}, 3));
+    // Stray continuation bytes, each one replaced
+    TEST_CHECK(decodes_to(cache, "A\x80" "B", (const uint32_t[]) {'A', 0xFFFD, 'B'}, 3));
+    TEST_CHECK(decodes_to(cache, "\xBF\xBF", (const uint32_t[]) {0xFFFD, 0xFFFD}, 2));
+    // A lead byte whose sequence breaks off does not swallow the next character
+    TEST_CHECK(decodes_to(cache, "\xC3" "A", (const uint32_t[]) {0xFFFD, 'A'}, 2));
+    TEST_CHECK(decodes_to(cache, "\xE2\x82", (const uint32_t[]) {0xFFFD}, 1));
+    esp_bsp_sdl_glyph_cache_delete(cache);
+}
+
+// The atlas is the largest allocation and matches the documented size
+static void test_atlas_size(void)
+{
+    const esp_bsp_sdl_glyph_cache_config_t config = {
+        .max_glyph_width = 13,
+        .max_glyph_height = 20,
+        .capacity = 64,
+        .rasterize = record_codepoint,
+    };
+    esp_bsp_sdl_mem_snapshot_t before;
+    esp_bsp_sdl_mem_snapshot_t after;
+    TEST_CHECK_OK(esp_bsp_sdl_mem_get_snapshot(&before));
+    esp_bsp_sdl_glyph_cache_handle_t cache;
+    TEST_CHECK_OK(esp_bsp_sdl_glyph_cache_create(&config, &cache));
+    TEST_CHECK_OK(esp_bsp_sdl_mem_get_snapshot(&after));
+
+    const size_t atlas = (size_t) config.capacity * (2 + (config.max_glyph_width + 1) / 2) * config.max_glyph_height;
+    const size_t held = after.held - before.held;
+    // The rest is the slot table, hash buckets and rasterize scratch
+    TEST_CHECK(held >= atlas && held < atlas + atlas / 2);
+    esp_bsp_sdl_glyph_cache_delete(cache);
+}
+
+static void test_draw(void)
+{
+    const esp_bsp_sdl_glyph_cache_config_t config = {
+        .max_glyph_width = 8,
+        .max_glyph_height = 8,
+        .capacity = 4,
+        .rasterize = block_glyph,
+    };
+    esp_bsp_sdl_glyph_cache_handle_t cache;
+    TEST_CHECK_OK(esp_bsp_sdl_glyph_cache_create(&config, &cache));
+
+    const uint16_t background = 0x0841;
+    const uint16_t color = 0xF800;
+    uint16_t pixels[SURFACE_W * SURFACE_H];
+    for(int i = 0; i < SURFACE_W * SURFACE_H; i++) {
+        pixels[i] = background;
+    }
+    esp_bsp_sdl_surface_t dst = {pixels, SURFACE_W, SURFACE_H, SURFACE_W};
+    int advance;
+    s_count = 0;
+    // "A?A": the missing glyph is skipped and advances nothing
+    TEST_CHECK_OK(esp_bsp_sdl_text_draw(cache, &dst, 2, 6, "A?A", color, &advance));
+    TEST_CHECK(advance == 10);
+
+    // Half coverage is quantized to 4 bits before blending
+    uint16_t half = background;
+    const uint8_t coverage = (128 >> 4) * 17;
+    esp_bsp_sdl_blend_get_kernels(ESP_BSP_SDL_BLEND_IMPL_AUTO)->color_a8_over(&half, color, &coverage, 1);
+    for(int glyph = 0; glyph < 2; glyph++) {
+        const int left = 3 + glyph * 5;
+        for(int y = 4; y < 6; y++) {
+            TEST_CHECK(pixels[y * SURFACE_W + left] == color);
+            TEST_CHECK(pixels[y * SURFACE_W + left + 1] == half);
+            TEST_CHECK(pixels[y * SURFACE_W + left + 2] == background);
+        }
+    }
+    TEST_CHECK(pixels[3 * SURFACE_W + 3] == background && pixels[6 * SURFACE_W + 3] == background);
+
+    // '?' is cached as missing: drawing again rasterizes nothing
+    esp_bsp_sdl_glyph_cache_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_glyph_cache_get_stats(cache, &stats));
+    TEST_CHECK(stats.misses == 2 && stats.hits == 1 && s_count == 2);
+    TEST_CHECK_OK(esp_bsp_sdl_text_draw(cache, &dst, 2, 6, "A?A", color, &advance));
+    TEST_CHECK_OK(esp_bsp_sdl_glyph_cache_get_stats(cache, &stats));
+    TEST_CHECK(advance == 10 && stats.misses == 2 && stats.hits == 4 && s_count == 2);
+    esp_bsp_sdl_glyph_cache_delete(cache);
+}
+
+// Capital letters are 1x1 glyphs advancing by their index, everything else is missing
+static esp_err_t letter_glyph(uint32_t codepoint, esp_bsp_sdl_glyph_metrics_t *metrics, uint8_t *coverage,
+                              size_t coverage_size, void *user_ctx)
+{
+    if(s_count < MAX_CODEPOINTS) {
+        s_codepoints[s_count] = codepoint;
+    }
+    s_count++;
+    if(codepoint < 'A' || codepoint > 'Z') {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *metrics = (esp_bsp_sdl_glyph_metrics_t) {.width = 1, .height = 1, .advance = (int) (codepoint - 'A' + 1)};
+    coverage[0] = 255;
+    return ESP_OK;
+}
+
+// Measure text and return the code points the callback was asked for, in order
+static int rasterized(esp_bsp_sdl_glyph_cache_handle_t cache, const char *text, uint32_t *codepoints)
+{
+    int advance;
+    s_count = 0;
+    TEST_CHECK_OK(esp_bsp_sdl_text_measure(cache, text, &advance));
+    memcpy(codepoints, s_codepoints, sizeof(s_codepoints));
+    return s_count;
+}
+
+static bool stats_are(esp_bsp_sdl_glyph_cache_handle_t cache, uint32_t hits, uint32_t misses, uint32_t evictions)
+{
+    esp_bsp_sdl_glyph_cache_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_glyph_cache_get_stats(cache, &stats));
+    return stats.hits == hits && stats.misses == misses && stats.evictions == evictions;
+}
+
+// More glyphs than slots: the least recently used one goes, missing entries take slots like glyphs
+static void test_eviction(void)
+{
+    const esp_bsp_sdl_glyph_cache_config_t config = {
+        .max_glyph_width = 4,
+        .max_glyph_height = 4,
+        .capacity = 4,
+        .rasterize = letter_glyph,
+    };
+    esp_bsp_sdl_glyph_cache_handle_t cache;
+    TEST_CHECK_OK(esp_bsp_sdl_glyph_cache_create(&config, &cache));
+    uint32_t cps[MAX_CODEPOINTS];
+
+    // Fill the cache, then use A: least to most recent B C D A
+    TEST_CHECK(rasterized(cache, "ABCD", cps) == 4);
+    TEST_CHECK(rasterized(cache, "A", cps) == 0);
+    TEST_CHECK(stats_are(cache, 1, 4, 0));
+
+    // E and F take the slots of B and C
+    TEST_CHECK(rasterized(cache, "EF", cps) == 2 && cps[0] == 'E' && cps[1] == 'F');
+    TEST_CHECK(stats_are(cache, 1, 6, 2));
+    TEST_CHECK(rasterized(cache, "DAFE", cps) == 0);
+    TEST_CHECK(stats_are(cache, 5, 6, 2));
+    TEST_CHECK(rasterized(cache, "B", cps) == 1 && cps[0] == 'B');
+    TEST_CHECK(stats_are(cache, 5, 7, 3));
+
+    // Order is now A F E B: the missing '?' evicts A, C evicts F
+    TEST_CHECK(rasterized(cache, "?C", cps) == 2 && cps[0] == '?' && cps[1] == 'C');
+    TEST_CHECK(stats_are(cache, 5, 9, 5));
+    TEST_CHECK(rasterized(cache, "?EBC", cps) == 0);
+    TEST_CHECK(stats_are(cache, 9, 9, 5));
+    TEST_CHECK(rasterized(cache, "AF", cps) == 2 && cps[0] == 'A' && cps[1] == 'F');
+    TEST_CHECK(stats_are(cache, 9, 11, 7));
+
+    // The glyphs that stayed still measure right, from the atlas
+    int advance;
+    TEST_CHECK_OK(esp_bsp_sdl_text_measure(cache, "BCAF", &advance));
+    TEST_CHECK(advance == 2 + 3 + 1 + 6);
+
+    // Clearing drops everything, missing entries included
+    esp_bsp_sdl_glyph_cache_clear(cache);
+    TEST_CHECK(rasterized(cache, "?A", cps) == 2);
+    esp_bsp_sdl_glyph_cache_delete(cache);
+}
+
+// Reports a glyph larger than the scratch it is given, without writing it
+static esp_err_t oversized_glyph(uint32_t codepoint, esp_bsp_sdl_glyph_metrics_t *metrics, uint8_t *coverage,
+                                 size_t coverage_size, void *user_ctx)
+{
+    s_count++;
+    *metrics = (esp_bsp_sdl_glyph_metrics_t) {.width = 9, .height = 9, .advance = 10};
+    if((size_t) (metrics->width * metrics->height) > coverage_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memset(coverage, 255, metrics->width * metrics->height);
+    return ESP_OK;
+}
+
+// The callback is told the scratch size; a failure is returned and not cached as missing
+static void test_oversized(void)
+{
+    const esp_bsp_sdl_glyph_cache_config_t config = {
+        .max_glyph_width = 8,
+        .max_glyph_height = 8,
+        .capacity = 2,
+        .rasterize = oversized_glyph,
+    };
+    esp_bsp_sdl_glyph_cache_handle_t cache;
+    TEST_CHECK_OK(esp_bsp_sdl_glyph_cache_create(&config, &cache));
+    int advance;
+    s_count = 0;
+    TEST_CHECK(esp_bsp_sdl_text_measure(cache, "W", &advance) == ESP_ERR_INVALID_SIZE);
+    TEST_CHECK(esp_bsp_sdl_text_measure(cache, "W", &advance) == ESP_ERR_INVALID_SIZE);
+    TEST_CHECK(s_count == 2);
+    TEST_CHECK(stats_are(cache, 0, 0, 0));
+    esp_bsp_sdl_glyph_cache_delete(cache);
+}
+
+int main(void)
+{
+    test_utf8();
+    test_atlas_size();
+    test_draw();
+    test_eviction();
+    test_oversized();
+    return test_finish("test_glyph_cache");
+}
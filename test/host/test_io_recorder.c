@@ -0,0 +1,94 @@
+/**
+ * @file test_io_recorder.c
+ * @brief Recording the panel init sequence leaves the flush state in step with the controller
+ */
+
+#include <string.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_io_recorder.h"
+#include "esp_bsp_sdl_scroll.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "esp_lcd_panel_commands.h"
+#include "sdkconfig.h"
+#include "test_util.h"
+
+#define NATIVE_W CONFIG_SDL_BSP_VIRTUAL_WIDTH
+#define NATIVE_H CONFIG_SDL_BSP_VIRTUAL_HEIGHT
+
+static esp_lcd_panel_handle_t s_panel;
+static esp_lcd_panel_io_handle_t s_io;
+static uint16_t s_frame[NATIVE_W * NATIVE_H];
+static uint16_t s_exposed[NATIVE_W * 5];
+
+static void check_panel_shows_frame(const char *scene)
+{
+    esp_bsp_sdl_surface_t frame;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(s_panel, &frame));
+    const esp_bsp_sdl_surface_t expected = {s_frame, NATIVE_W, NATIVE_H, NATIVE_W};
+    esp_bsp_sdl_frame_diff_t diff;
+    if(esp_bsp_sdl_frame_compare(&frame, &expected, 0, &diff) != ESP_OK) {
+        fprintf(stderr, "%s: %u pixels differ\n", scene, (unsigned) diff.mismatched);
+        test_failures++;
+    }
+}
+
+static void capture_init(void)
+{
+    esp_bsp_sdl_io_recorder_clear();
+    TEST_CHECK_OK(esp_bsp_sdl_io_recorder_capture_init(s_panel, s_io, 256));
+    esp_bsp_sdl_io_rec_entry_t entry;
+    TEST_CHECK_OK(esp_bsp_sdl_io_recorder_get_entry(0, &entry));
+    TEST_CHECK(entry.cmd == LCD_CMD_SWRESET);
+}
+
+// The controller window and content are gone after the re-init: the next flush sends everything
+static void test_window_and_history(void)
+{
+    TEST_CHECK_OK(esp_bsp_sdl_set_dirty_mode(ESP_BSP_SDL_DIRTY_TILE_HASH));
+    TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_frame));
+    capture_init();
+
+    esp_bsp_sdl_reset_flush_stats();
+    TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_frame));
+    esp_bsp_sdl_flush_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_get_flush_stats(&stats));
+    TEST_CHECK(stats.pixel_bytes == sizeof(s_frame));
+    TEST_CHECK(stats.caset_sent > 0 && stats.raset_sent > 0);
+    check_panel_shows_frame("window");
+    TEST_CHECK_OK(esp_bsp_sdl_set_dirty_mode(ESP_BSP_SDL_DIRTY_OFF));
+}
+
+// The re-init unscrolls the controller, draws must no longer be redirected into the scroll area
+static void test_scroll(void)
+{
+    TEST_CHECK_OK(esp_bsp_sdl_scroll_set_area(4, 4));
+    TEST_CHECK_OK(esp_bsp_sdl_scroll(5, s_exposed));
+    capture_init();
+
+    TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_frame));
+    check_panel_shows_frame("scroll");
+}
+
+int main(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    TEST_CHECK_OK(esp_bsp_sdl_init(&config, &s_panel, &s_io));
+    if(test_failures) {
+        return test_finish("test_io_recorder");
+    }
+    for(int i = 0; i < NATIVE_W * NATIVE_H; i++) {
+        s_frame[i] = (uint16_t) (i * 40503u);
+    }
+    for(int i = 0; i < NATIVE_W * 5; i++) {
+        s_exposed[i] = 0xFFFF;
+    }
+    TEST_CHECK_OK(esp_bsp_sdl_io_recorder_start(s_io, 256, 0));
+
+    test_window_and_history();
+    test_scroll();
+
+    TEST_CHECK_OK(esp_bsp_sdl_io_recorder_stop());
+    esp_bsp_sdl_io_recorder_free();
+    TEST_CHECK_OK(esp_bsp_sdl_deinit());
+    return test_finish("test_io_recorder");
+}
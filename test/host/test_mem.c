@@ -0,0 +1,158 @@
+/**
+ * @file test_mem.c
+ * @brief Memory accounting: booked bytes against the heap stand-in
+ *
+ * The host heap counts every allocation, so whatever the component holds must show up in the
+ * accounting exactly once.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_blit_queue.h"
+#include "esp_bsp_sdl_capture.h"
+#include "esp_bsp_sdl_glyph_cache.h"
+#include "esp_bsp_sdl_mem.h"
+#include "esp_bsp_sdl_tiler.h"
+#include "esp_bsp_sdl_touch_mock.h"
+#include "esp_host_port.h"
+#include "sdkconfig.h"
+#include "test_util.h"
+
+#define NATIVE_W CONFIG_SDL_BSP_VIRTUAL_WIDTH
+#define NATIVE_H CONFIG_SDL_BSP_VIRTUAL_HEIGHT
+
+static uint16_t s_frame[NATIVE_W * NATIVE_H];
+
+static size_t held(esp_bsp_sdl_mem_subsys_t subsys)
+{
+    esp_bsp_sdl_mem_snapshot_t snap;
+    TEST_CHECK_OK(esp_bsp_sdl_mem_get_snapshot(&snap));
+    size_t bytes = 0;
+    for(int c = 0; c < ESP_BSP_SDL_MEM_CLASS_MAX; c++) {
+        bytes += snap.current[subsys][c];
+    }
+    return bytes;
+}
+
+static size_t held_all(void)
+{
+    esp_bsp_sdl_mem_snapshot_t snap;
+    TEST_CHECK_OK(esp_bsp_sdl_mem_get_snapshot(&snap));
+    return snap.held;
+}
+
+static esp_err_t rasterize(uint32_t codepoint, esp_bsp_sdl_glyph_metrics_t *metrics, uint8_t *coverage,
+                           size_t coverage_size, void *user_ctx)
+{
+    *metrics = (esp_bsp_sdl_glyph_metrics_t) {.width = 6, .height = 8, .bearing_y = 8, .advance = 7};
+    memset(coverage, 0xFF, 6 * 8);
+    return ESP_OK;
+}
+
+// Rendering helpers book every buffer they hold and give it all back on delete
+static void test_render_helpers(void)
+{
+    const size_t heap_before = esp_host_port_heap_used();
+    const size_t render_before = held(ESP_BSP_SDL_MEM_RENDER);
+
+    const esp_bsp_sdl_tiler_config_t tiler_config = {.width = NATIVE_W, .height = NATIVE_H};
+    esp_bsp_sdl_tiler_handle_t tiler = NULL;
+    TEST_CHECK_OK(esp_bsp_sdl_tiler_create(&tiler_config, &tiler));
+
+    const esp_bsp_sdl_glyph_cache_config_t glyph_config = {
+        .max_glyph_width = 12,
+        .max_glyph_height = 16,
+        .capacity = 32,
+        .rasterize = rasterize,
+    };
+    esp_bsp_sdl_glyph_cache_handle_t cache = NULL;
+    TEST_CHECK_OK(esp_bsp_sdl_glyph_cache_create(&glyph_config, &cache));
+
+    const esp_bsp_sdl_blit_queue_config_t queue_config = {.width = NATIVE_W, .height = NATIVE_H};
+    esp_bsp_sdl_blit_queue_handle_t queue = NULL;
+    TEST_CHECK_OK(esp_bsp_sdl_blit_queue_create(&queue_config, &queue));
+
+    const size_t heap_delta = esp_host_port_heap_used() - heap_before;
+    const size_t render_delta = held(ESP_BSP_SDL_MEM_RENDER) - render_before;
+    if(render_delta != heap_delta) {
+        fprintf(stderr, "render helpers: %u bytes booked, %u allocated\n", (unsigned) render_delta,
+                (unsigned) heap_delta);
+        test_failures++;
+    }
+
+    esp_bsp_sdl_blit_queue_delete(queue);
+    esp_bsp_sdl_glyph_cache_delete(cache);
+    esp_bsp_sdl_tiler_delete(tiler);
+    TEST_CHECK(held(ESP_BSP_SDL_MEM_RENDER) == render_before);
+    TEST_CHECK(esp_host_port_heap_used() == heap_before);
+}
+
+// Frame capture books its buffers and index, including the index growth, to the tools
+static void test_capture(void)
+{
+    FILE *out = tmpfile();
+    TEST_CHECK(out != NULL);
+    if(!out) {
+        return;
+    }
+    // The flush engine allocates its buffers on the first frame
+    TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_frame));
+    const size_t heap_before = esp_host_port_heap_used();
+    const esp_bsp_sdl_capture_config_t config = {.out = out, .delta = true};
+    TEST_CHECK_OK(esp_bsp_sdl_capture_start(&config));
+    for(int i = 0; i < 100; i++) {
+        s_frame[i] = i;
+        TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_frame));
+    }
+    TEST_CHECK(held(ESP_BSP_SDL_MEM_TOOLS) > 0);
+    TEST_CHECK(held(ESP_BSP_SDL_MEM_TOOLS) == esp_host_port_heap_used() - heap_before);
+    TEST_CHECK_OK(esp_bsp_sdl_capture_stop());
+    TEST_CHECK(held(ESP_BSP_SDL_MEM_TOOLS) == 0);
+    TEST_CHECK(esp_host_port_heap_used() == heap_before);
+    fclose(out);
+}
+
+// The touch mock books itself and its script to the touch subsystem, inside and after the measured init
+static void test_touch_mock(void)
+{
+    const size_t heap_before = esp_host_port_heap_used();
+    TEST_CHECK_OK(esp_bsp_sdl_touch_init());
+    TEST_CHECK(held(ESP_BSP_SDL_MEM_TOUCH) > 0);
+    TEST_CHECK(held(ESP_BSP_SDL_MEM_TOUCH) == esp_host_port_heap_used() - heap_before);
+
+    static const esp_bsp_sdl_touch_mock_frame_t script[] = {
+        {.time_ms = 0, .points = 1, .coords = {{.x = 10, .y = 10}}},
+        {.time_ms = 70, .points = 0},
+    };
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_load_script(esp_bsp_sdl_virtual_get_touch(), script, 2, 0));
+    TEST_CHECK(held(ESP_BSP_SDL_MEM_TOUCH) == esp_host_port_heap_used() - heap_before);
+}
+
+int main(void)
+{
+    const size_t heap_before = esp_host_port_heap_used();
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_handle_t panel;
+    esp_lcd_panel_io_handle_t io;
+    TEST_CHECK_OK(esp_bsp_sdl_init(&config, &panel, &io));
+    if(test_failures) {
+        return test_finish("test_mem");
+    }
+
+    // Measured board init and hooked allocations inside it, e.g. the panel RAM, count once
+    const size_t init_heap = esp_host_port_heap_used() - heap_before;
+    if(held_all() != init_heap) {
+        fprintf(stderr, "init: %u bytes booked, %u allocated\n", (unsigned) held_all(), (unsigned) init_heap);
+        test_failures++;
+    }
+    TEST_CHECK(held(ESP_BSP_SDL_MEM_PANEL) >= (size_t) NATIVE_W * NATIVE_H * sizeof(uint16_t));
+
+    test_render_helpers();
+    test_capture();
+    test_touch_mock();
+
+    TEST_CHECK_OK(esp_bsp_sdl_deinit());
+    TEST_CHECK(held_all() == 0);
+    return test_finish("test_mem");
+}
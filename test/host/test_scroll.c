@@ -0,0 +1,160 @@
+/**
+ * @file test_scroll.c
+ * @brief Controller scrolling on the virtual panel, which models VSCRDEF/VSCRSADD
+ *
+ * A logical model of the screen is scrolled alongside the panel: the area rows move, the exposed
+ * rows are written, the fixed rows stay. After every step the panel must show the model, at 0 and
+ * 180 degrees, over mixed step sizes in both directions and with fixed rows at top and bottom.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_priv.h"
+#include "esp_bsp_sdl_scroll.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "sdkconfig.h"
+#include "test_util.h"
+
+#define NATIVE_W CONFIG_SDL_BSP_VIRTUAL_WIDTH
+#define NATIVE_H CONFIG_SDL_BSP_VIRTUAL_HEIGHT
+
+static esp_lcd_panel_handle_t s_panel;
+static uint16_t s_model[NATIVE_W * NATIVE_H];
+static uint16_t s_expected[NATIVE_W * NATIVE_H];
+static uint16_t s_exposed[NATIVE_W * NATIVE_H];
+static uint16_t s_counter;
+
+// Rows that differ from everything drawn before, every pixel distinct within a row
+static void make_rows(uint16_t *rows, int count)
+{
+    for(int i = 0; i < count * NATIVE_W; i++) {
+        rows[i] = (uint16_t) (s_counter * 0x0101 + i);
+    }
+    s_counter++;
+}
+
+// The panel shows the model, rotated to the native orientation
+static bool panel_matches(esp_bsp_sdl_orientation_t orientation)
+{
+    esp_bsp_sdl_rotate_blit_rgb565(s_expected, NATIVE_W, NATIVE_H, orientation, 0, 0, NATIVE_W, NATIVE_H, s_model);
+    const esp_bsp_sdl_surface_t expected = {s_expected, NATIVE_W, NATIVE_H, NATIVE_W};
+    esp_bsp_sdl_surface_t frame;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(s_panel, &frame));
+    esp_bsp_sdl_frame_diff_t diff;
+    return esp_bsp_sdl_frame_compare(&frame, &expected, 0, &diff) == ESP_OK;
+}
+
+// Scroll the panel and the model, then check the bytes accounted and what the panel shows
+static void scroll_step(esp_bsp_sdl_orientation_t orientation, int top, int bottom, int lines)
+{
+    const int rows = NATIVE_H - top - bottom;
+    const int distance = lines > 0 ? lines : -lines;
+    make_rows(s_exposed, distance);
+
+    esp_bsp_sdl_flush_stats_t before;
+    TEST_CHECK_OK(esp_bsp_sdl_get_flush_stats(&before));
+    esp_bsp_sdl_virtual_panel_stats_t panel_before;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_stats(s_panel, &panel_before));
+    TEST_CHECK_OK(esp_bsp_sdl_scroll(lines, s_exposed));
+
+    uint16_t *area = s_model + top * NATIVE_W;
+    const size_t kept = (size_t) (rows - distance) * NATIVE_W;
+    const size_t exposed = (size_t) distance * NATIVE_W;
+    if(lines > 0) {
+        memmove(area, area + exposed, kept * sizeof(uint16_t));
+        memcpy(area + kept, s_exposed, exposed * sizeof(uint16_t));
+    } else {
+        memmove(area + exposed, area, kept * sizeof(uint16_t));
+        memcpy(area, s_exposed, exposed * sizeof(uint16_t));
+    }
+    if(!panel_matches(orientation)) {
+        fprintf(stderr, "orientation %d, fixed %d/%d: panel differs after scrolling %d lines\n", (int) orientation,
+                top, bottom, lines);
+        test_failures++;
+    }
+
+    // Only the exposed rows are sent, plus VSCRSADD and the address window of each span
+    esp_bsp_sdl_flush_stats_t after;
+    TEST_CHECK_OK(esp_bsp_sdl_get_flush_stats(&after));
+    esp_bsp_sdl_virtual_panel_stats_t panel_after;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_stats(s_panel, &panel_after));
+    const uint64_t pixel_bytes = exposed * sizeof(uint16_t);
+    const uint64_t panel_bytes = (panel_after.color_bytes - panel_before.color_bytes) +
+                                 (panel_after.param_bytes - panel_before.param_bytes) +
+                                 (panel_after.commands - panel_before.commands);
+    TEST_CHECK(after.scrolls == before.scrolls + 1);
+    TEST_CHECK(after.scroll_lines == before.scroll_lines + distance);
+    TEST_CHECK(panel_after.color_bytes - panel_before.color_bytes == pixel_bytes);
+    TEST_CHECK(after.scroll_bytes - before.scroll_bytes == panel_bytes);
+}
+
+static void test_orientation(esp_bsp_sdl_display_config_t *config, esp_bsp_sdl_orientation_t orientation)
+{
+    static const int fixed[][2] = {{0, 0}, {4, 0}, {0, 6}, {5, 7}};
+    static const int steps[] = {1, 3, -2, 16, -5, 7, -1, 11, -13, 2};
+
+    TEST_CHECK_OK(esp_bsp_sdl_set_orientation(orientation, config));
+    for(size_t f = 0; f < sizeof(fixed) / sizeof(fixed[0]); f++) {
+        const int top = fixed[f][0];
+        const int bottom = fixed[f][1];
+        const int rows = NATIVE_H - top - bottom;
+
+        // A new area shows its content unscrolled until it is redrawn
+        TEST_CHECK_OK(esp_bsp_sdl_scroll_set_area(top, bottom));
+        make_rows(s_model, NATIVE_H);
+        TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_model));
+        TEST_CHECK(panel_matches(orientation));
+
+        for(size_t s = 0; s < sizeof(steps) / sizeof(steps[0]); s++) {
+            scroll_step(orientation, top, bottom, steps[s]);
+        }
+        // The whole area at once, both ways
+        scroll_step(orientation, top, bottom, rows);
+        scroll_step(orientation, top, bottom, -rows);
+        scroll_step(orientation, top, bottom, 9);
+
+        // Full frames are remapped while scrolled, fixed rows included
+        make_rows(s_model, NATIVE_H);
+        TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_model));
+        if(!panel_matches(orientation)) {
+            fprintf(stderr, "orientation %d, fixed %d/%d: full frame differs while scrolled\n", (int) orientation, top,
+                    bottom);
+            test_failures++;
+        }
+    }
+}
+
+static void test_invalid(void)
+{
+    TEST_CHECK(esp_bsp_sdl_scroll_set_area(-1, 0) == ESP_ERR_INVALID_ARG);
+    TEST_CHECK(esp_bsp_sdl_scroll_set_area(20, NATIVE_H - 20) == ESP_ERR_INVALID_ARG);
+    TEST_CHECK_OK(esp_bsp_sdl_scroll_set_area(8, 8));
+    TEST_CHECK(esp_bsp_sdl_scroll(NATIVE_H - 15, s_exposed) == ESP_ERR_INVALID_ARG);
+    TEST_CHECK(esp_bsp_sdl_scroll(1, NULL) == ESP_ERR_INVALID_ARG);
+    TEST_CHECK_OK(esp_bsp_sdl_scroll(0, NULL));
+}
+
+int main(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_io_handle_t io;
+    TEST_CHECK(esp_bsp_sdl_scroll(1, s_exposed) == ESP_ERR_INVALID_STATE);
+    TEST_CHECK_OK(esp_bsp_sdl_init(&config, &s_panel, &io));
+    if(test_failures) {
+        return test_finish("test_scroll");
+    }
+
+    test_orientation(&config, ESP_BSP_SDL_ORIENTATION_0);
+    test_orientation(&config, ESP_BSP_SDL_ORIENTATION_180);
+
+    // Rotated by 90 degrees the controller scrolls along the wrong axis
+    TEST_CHECK_OK(esp_bsp_sdl_set_orientation(ESP_BSP_SDL_ORIENTATION_90, &config));
+    TEST_CHECK(esp_bsp_sdl_scroll_set_area(0, 0) == ESP_ERR_NOT_SUPPORTED);
+    TEST_CHECK(esp_bsp_sdl_scroll(1, s_exposed) == ESP_ERR_NOT_SUPPORTED);
+    TEST_CHECK_OK(esp_bsp_sdl_set_orientation(ESP_BSP_SDL_ORIENTATION_0, &config));
+    test_invalid();
+
+    TEST_CHECK_OK(esp_bsp_sdl_deinit());
+    return test_finish("test_scroll");
+}
@@ -0,0 +1,240 @@
+/**
+ * @file test_tiler.c
+ * @brief Tiler binning, rasterization and target traffic against immediate-mode drawing
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_bsp_sdl_tiler.h"
+#include "test_util.h"
+
+#define TARGET_W 256
+#define TARGET_H 160
+#define TILE_W 64
+#define TILE_H 32
+#define TILES_X (TARGET_W / TILE_W)
+#define TILES_Y (TARGET_H / TILE_H)
+
+static uint16_t s_target[TARGET_W * TARGET_H];
+static uint16_t s_expected[TARGET_W * TARGET_H];
+
+// Immediate-mode reference line, marking the tiles it plots in
+static void reference_line(int x0, int y0, int x1, int y1, uint16_t color, bool *tiles)
+{
+    const int dx = abs(x1 - x0);
+    const int dy = -abs(y1 - y0);
+    const int sx = x0 < x1 ? 1 : -1;
+    const int sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    for(;;) {
+        if(x0 >= 0 && x0 < TARGET_W && y0 >= 0 && y0 < TARGET_H) {
+            s_expected[y0 * TARGET_W + x0] = color;
+            tiles[(y0 / TILE_H) * TILES_X + x0 / TILE_W] = true;
+        }
+        if(x0 == x1 && y0 == y1) {
+            break;
+        }
+        const int e2 = 2 * err;
+        if(e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if(e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+static void fill_background(void)
+{
+    for(int i = 0; i < TARGET_W * TARGET_H; i++) {
+        s_target[i] = s_expected[i] = (uint16_t) (i * 7);
+    }
+}
+
+// Lines are binned only to the tiles they cross, not to every tile of their bounding box
+static void test_line_binning(void)
+{
+    static const int lines[][4] = {
+        {0, 0, TARGET_W - 1, TARGET_H - 1},
+        {TARGET_W - 1, 0, 0, TARGET_H - 1},
+        {-40, 100, 300, 20},
+        {10, 5, 10, 150},
+        {5, 70, 250, 70},
+        {200, -30, 260, 20},
+    };
+    const int count = sizeof(lines) / sizeof(lines[0]);
+
+    for(int i = 0; i < count; i++) {
+        const int *l = lines[i];
+        bool tiles[TILES_X * TILES_Y] = {0};
+        fill_background();
+        reference_line(l[0], l[1], l[2], l[3], 0xFFFF, tiles);
+        int crossed = 0;
+        for(int t = 0; t < TILES_X * TILES_Y; t++) {
+            crossed += tiles[t];
+        }
+
+        // Exactly enough bin entries for the tiles crossed
+        const esp_bsp_sdl_tiler_config_t config = {
+            .width = TARGET_W,
+            .height = TARGET_H,
+            .tile_width = TILE_W,
+            .tile_height = TILE_H,
+            .max_bin_entries = crossed ? crossed : 1,
+        };
+        esp_bsp_sdl_tiler_handle_t tiler = NULL;
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_create(&config, &tiler));
+        if(!tiler) {
+            return;
+        }
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_line(tiler, l[0], l[1], l[2], l[3], 0xFFFF));
+        esp_bsp_sdl_surface_t target = {s_target, TARGET_W, TARGET_H, TARGET_W};
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_render(tiler, &target));
+
+        esp_bsp_sdl_tiler_stats_t stats;
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_get_stats(tiler, &stats));
+        if((int) stats.tiles_touched != crossed) {
+            fprintf(stderr, "line %d: %u tiles touched, %d crossed\n", i, (unsigned) stats.tiles_touched, crossed);
+            test_failures++;
+        }
+        TEST_CHECK(memcmp(s_target, s_expected, sizeof(s_target)) == 0);
+        esp_bsp_sdl_tiler_delete(tiler);
+    }
+}
+
+// Fills, blits and lines in one frame keep their submission order in every tile
+static void test_mixed(void)
+{
+    static uint16_t texture_pixels[40 * 30];
+    for(int i = 0; i < 40 * 30; i++) {
+        texture_pixels[i] = (uint16_t) (0x8000 | i);
+    }
+    const esp_bsp_sdl_surface_t texture = {texture_pixels, 40, 30, 40};
+
+    fill_background();
+    const esp_bsp_sdl_tiler_config_t config = {.width = TARGET_W, .height = TARGET_H};
+    esp_bsp_sdl_tiler_handle_t tiler = NULL;
+    TEST_CHECK_OK(esp_bsp_sdl_tiler_create(&config, &tiler));
+    if(!tiler) {
+        return;
+    }
+    const esp_bsp_sdl_rect_t rect = {50, 20, 100, 80};
+    TEST_CHECK_OK(esp_bsp_sdl_tiler_fill_rect(tiler, &rect, 0x001F));
+    TEST_CHECK_OK(esp_bsp_sdl_tiler_blit(tiler, &texture, NULL, 120, 60));
+    TEST_CHECK_OK(esp_bsp_sdl_tiler_line(tiler, 0, 159, 255, 0, 0xF800));
+
+    for(int y = rect.y; y < rect.y + rect.h; y++) {
+        for(int x = rect.x; x < rect.x + rect.w; x++) {
+            s_expected[y * TARGET_W + x] = 0x001F;
+        }
+    }
+    for(int y = 0; y < 30; y++) {
+        memcpy(&s_expected[(60 + y) * TARGET_W + 120], &texture_pixels[y * 40], 40 * sizeof(uint16_t));
+    }
+    bool tiles[TILES_X * TILES_Y] = {0};
+    reference_line(0, 159, 255, 0, 0xF800, tiles);
+
+    esp_bsp_sdl_surface_t target = {s_target, TARGET_W, TARGET_H, TARGET_W};
+    TEST_CHECK_OK(esp_bsp_sdl_tiler_render(tiler, &target));
+    TEST_CHECK(memcmp(s_target, s_expected, sizeof(s_target)) == 0);
+    esp_bsp_sdl_tiler_delete(tiler);
+}
+
+// Random lines over odd-sized tiles, many of them leaving the target, match the reference pixel for pixel
+static void test_line_clipping(void)
+{
+    const esp_bsp_sdl_tiler_config_t config = {
+        .width = TARGET_W,
+        .height = TARGET_H,
+        .tile_width = 13,
+        .tile_height = 7,
+        .max_commands = 200,
+        .max_bin_entries = 200 * 64,
+    };
+    esp_bsp_sdl_tiler_handle_t tiler = NULL;
+    TEST_CHECK_OK(esp_bsp_sdl_tiler_create(&config, &tiler));
+    if(!tiler) {
+        return;
+    }
+    bool tiles[TILES_X * TILES_Y];
+    fill_background();
+    for(int i = 0; i < 200; i++) {
+        const int x0 = (int) (test_random() % (TARGET_W + 160)) - 80;
+        const int y0 = (int) (test_random() % (TARGET_H + 160)) - 80;
+        // Every fourth line is short, down to a single pixel
+        const int reach = i % 4 ? TARGET_W + 160 : 5;
+        const int x1 = i % 4 ? (int) (test_random() % reach) - 80 : x0 + (int) (test_random() % reach) - 2;
+        const int y1 = i % 4 ? (int) (test_random() % reach) - 80 : y0 + (int) (test_random() % reach) - 2;
+        const uint16_t color = (uint16_t) (0x8000 | i);
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_line(tiler, x0, y0, x1, y1, color));
+        reference_line(x0, y0, x1, y1, color, tiles);
+    }
+    esp_bsp_sdl_surface_t target = {s_target, TARGET_W, TARGET_H, TARGET_W};
+    TEST_CHECK_OK(esp_bsp_sdl_tiler_render(tiler, &target));
+    TEST_CHECK(memcmp(s_target, s_expected, sizeof(s_target)) == 0);
+    esp_bsp_sdl_tiler_delete(tiler);
+}
+
+// Every touched tile is read (unless cleared) and written once, whatever the overdraw inside it
+static void test_traffic(void)
+{
+    static uint16_t texture_pixels[40 * 30];
+    const esp_bsp_sdl_surface_t texture = {texture_pixels, 40, 30, 40};
+    const uint64_t tile_bytes = TILE_W * TILE_H * sizeof(uint16_t);
+
+    for(int clear = 0; clear <= 1; clear++) {
+        const esp_bsp_sdl_tiler_config_t config = {
+            .width = TARGET_W,
+            .height = TARGET_H,
+            .tile_width = TILE_W,
+            .tile_height = TILE_H,
+            .clear = clear,
+        };
+        esp_bsp_sdl_tiler_handle_t tiler = NULL;
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_create(&config, &tiler));
+        if(!tiler) {
+            return;
+        }
+        // Tile (0,0) drawn three times, (1,1), (2,2) and (0,4) once each
+        const esp_bsp_sdl_rect_t full_tile = {0, 0, TILE_W, TILE_H};
+        const esp_bsp_sdl_rect_t clipped = {-10, -10, 20, 20};
+        const esp_bsp_sdl_rect_t small = {100, 40, 20, 10};
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_fill_rect(tiler, &full_tile, 0x001F));
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_fill_rect(tiler, &full_tile, 0x07E0));
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_fill_rect(tiler, &clipped, 0xF800));
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_fill_rect(tiler, &small, 0xFFFF));
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_blit(tiler, &texture, NULL, 140, 64));
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_line(tiler, 0, 150, 10, 155, 0xFFE0));
+        esp_bsp_sdl_surface_t target = {s_target, TARGET_W, TARGET_H, TARGET_W};
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_render(tiler, &target));
+
+        esp_bsp_sdl_tiler_stats_t stats;
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_get_stats(tiler, &stats));
+        TEST_CHECK(stats.commands == 6);
+        TEST_CHECK(stats.tiles_touched == 4);
+        TEST_CHECK(stats.target_written == 4 * tile_bytes);
+        TEST_CHECK(stats.target_read == (clear ? 0 : 4 * tile_bytes));
+        const uint64_t direct_pixels = 2 * TILE_W * TILE_H + 10 * 10 + 20 * 10 + 40 * 30 + 11;
+        TEST_CHECK(stats.direct_written == direct_pixels * sizeof(uint16_t));
+
+        // Nothing recorded, nothing touched
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_render(tiler, &target));
+        TEST_CHECK_OK(esp_bsp_sdl_tiler_get_stats(tiler, &stats));
+        TEST_CHECK(stats.tiles_touched == 0 && stats.target_read == 0 && stats.target_written == 0);
+        TEST_CHECK(stats.direct_written == 0);
+        esp_bsp_sdl_tiler_delete(tiler);
+    }
+}
+
+int main(void)
+{
+    test_line_binning();
+    test_mixed();
+    test_line_clipping();
+    test_traffic();
+    return test_finish("test_tiler");
+}
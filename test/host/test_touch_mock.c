@@ -0,0 +1,224 @@
+/**
+ * @file test_touch_mock.c
+ * @brief Touch mock: gesture replay, software swap/mirror, injection and the latency counters
+ */
+
+#include "esp_bsp_sdl_touch_mock.h"
+#include "esp_lcd_touch.h"
+#include "esp_timer.h"
+#include "test_util.h"
+
+#define LATENCY_US 400
+#define POLL_US    4000
+
+// Press with one finger at 0 ms, second finger at 10 ms, release at 30 ms
+static const esp_bsp_sdl_touch_mock_frame_t s_pinch[] = {
+    {.time_ms = 0, .points = 1, .coords = {{10, 20, 50, 0}}},
+    {.time_ms = 10, .points = 2, .coords = {{12, 22, 60, 0}, {100, 80, 40, 1}}},
+    {.time_ms = 30, .points = 0},
+};
+
+static esp_lcd_touch_handle_t new_mock(const esp_bsp_sdl_touch_mock_frame_t *script,
+                                       size_t script_len,
+                                       uint32_t loop_period_ms,
+                                       bool manual_clock)
+{
+    const esp_bsp_sdl_touch_mock_config_t config = {
+        .x_max = 320,
+        .y_max = 240,
+        .script = script,
+        .script_len = script_len,
+        .loop_period_ms = loop_period_ms,
+        .i2c_latency_us = LATENCY_US,
+        .manual_clock = manual_clock,
+    };
+    esp_lcd_touch_handle_t touch = NULL;
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_new(&config, &touch));
+    return touch;
+}
+
+// One poll of the LVGL indev read: read_data() + get_coordinates(), then wait for the next period
+static uint8_t poll(esp_lcd_touch_handle_t touch, uint16_t *x, uint16_t *y)
+{
+    uint16_t strength[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
+    uint8_t points = 0;
+    TEST_CHECK_OK(esp_lcd_touch_read_data(touch));
+    const bool touched = esp_lcd_touch_get_coordinates(touch, x, y, strength, &points, CONFIG_ESP_LCD_TOUCH_MAX_POINTS);
+    TEST_CHECK(touched == (points > 0));
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_advance(touch, POLL_US - LATENCY_US));
+    return points;
+}
+
+// Reads every 4 ms see each frame once, 400 us bus time after the frame time or on the next poll
+static void test_replay(void)
+{
+    esp_lcd_touch_handle_t touch = new_mock(s_pinch, 3, 0, true);
+    uint16_t x[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
+    uint16_t y[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
+
+    // Reads complete at 0.4, 4.4, 8.4, ... ms
+    for(int i = 0; i < 12; i++) {
+        const int64_t t_us = (int64_t) i * POLL_US + LATENCY_US;
+        const uint8_t points = poll(touch, x, y);
+        if(t_us < 10000) {
+            TEST_CHECK(points == 1 && x[0] == 10 && y[0] == 20);
+        } else if(t_us < 30000) {
+            TEST_CHECK(points == 2 && x[0] == 12 && y[0] == 22 && x[1] == 100 && y[1] == 80);
+        } else {
+            TEST_CHECK(points == 0);
+        }
+    }
+
+    esp_bsp_sdl_touch_mock_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_get_stats(touch, &stats));
+    TEST_CHECK(stats.reads == 12);
+    TEST_CHECK(stats.read_time_us == 12 * LATENCY_US);
+    TEST_CHECK(stats.events == 3);
+    TEST_CHECK(stats.missed_events == 0);
+    // Frame 0 read at 0.4 ms, frame 1 (10 ms) at 12.4 ms, frame 2 (30 ms) at 32.4 ms
+    TEST_CHECK(stats.latency_us == 400 + 2400 + 2400);
+    TEST_CHECK(stats.max_latency_us == 2400);
+
+    // Coordinates are consumed by get_coordinates() like with the real drivers
+    uint8_t points = 0;
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_restart(touch));
+    TEST_CHECK_OK(esp_lcd_touch_read_data(touch));
+    TEST_CHECK(esp_lcd_touch_get_coordinates(touch, x, y, NULL, &points, 1) && points == 1);
+    TEST_CHECK(!esp_lcd_touch_get_coordinates(touch, x, y, NULL, &points, 1) && points == 0);
+
+    TEST_CHECK_OK(esp_lcd_touch_del(touch));
+}
+
+// Polling slower than the script drops frames, a looped script replays with increasing event numbers
+static void test_missed_and_loop(void)
+{
+    esp_lcd_touch_handle_t touch = new_mock(s_pinch, 3, 50, true);
+    uint16_t x[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
+    uint16_t y[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
+
+    // Reads at 35.4 ms (release, frames 0 and 1 missed) and 55.4 ms (frame 0 of the second loop)
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_advance(touch, 35000));
+    TEST_CHECK(poll(touch, x, y) == 0);
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_advance(touch, 20000 - POLL_US));
+    TEST_CHECK(poll(touch, x, y) == 1 && x[0] == 10 && y[0] == 20);
+
+    esp_bsp_sdl_touch_mock_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_get_stats(touch, &stats));
+    TEST_CHECK(stats.events == 2);
+    TEST_CHECK(stats.missed_events == 2);
+    TEST_CHECK(stats.latency_us == 5400 + 5400);
+
+    // Reading again within the same frame is no new event
+    TEST_CHECK(poll(touch, x, y) == 1);
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_get_stats(touch, &stats));
+    TEST_CHECK(stats.events == 2 && stats.reads == 3);
+
+    TEST_CHECK_OK(esp_lcd_touch_del(touch));
+}
+
+// Swap and mirror are applied in software by esp_lcd_touch_get_coordinates()
+static void test_swap_mirror(void)
+{
+    const esp_bsp_sdl_touch_mock_frame_t press = {.points = 1, .coords = {{30, 40, 10, 0}}};
+    const esp_bsp_sdl_touch_mock_config_t config = {
+        .x_max = 320,
+        .y_max = 240,
+        .swap_xy = true,
+        .mirror_x = true,
+        .script = &press,
+        .script_len = 1,
+        .manual_clock = true,
+    };
+    esp_lcd_touch_handle_t touch = NULL;
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_new(&config, &touch));
+
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint8_t points = 0;
+    TEST_CHECK_OK(esp_lcd_touch_read_data(touch));
+    TEST_CHECK(esp_lcd_touch_get_coordinates(touch, &x, &y, NULL, &points, 1));
+    TEST_CHECK(points == 1 && x == 40 && y == 320 - 30);
+
+    TEST_CHECK_OK(esp_lcd_touch_del(touch));
+}
+
+// Injected contacts override the script until handed back, with their own latency and missed counts
+static void test_inject(void)
+{
+    esp_lcd_touch_handle_t touch = new_mock(s_pinch, 3, 0, true);
+    uint16_t x[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
+    uint16_t y[CONFIG_ESP_LCD_TOUCH_MAX_POINTS];
+    const esp_bsp_sdl_touch_mock_frame_t drag[2] = {
+        {.points = 1, .coords = {{200, 100, 30, 3}}},
+        {.points = 1, .coords = {{210, 105, 30, 3}}},
+    };
+
+    // Replaced before any read: one missed, the second is read 1 ms + bus time later
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_inject(touch, &drag[0]));
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_inject(touch, &drag[1]));
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_advance(touch, 1000));
+    TEST_CHECK(poll(touch, x, y) == 1 && x[0] == 210 && y[0] == 105);
+    // Script frame 1 passes under the injection and is not reported
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_advance(touch, 10000));
+    TEST_CHECK(poll(touch, x, y) == 1 && x[0] == 210);
+
+    esp_bsp_sdl_touch_mock_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_get_stats(touch, &stats));
+    TEST_CHECK(stats.events == 1);
+    TEST_CHECK(stats.missed_events == 1);
+    TEST_CHECK(stats.latency_us == 1000 + LATENCY_US);
+
+    // Back to the script, which is at frame 1 by now
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_inject(touch, NULL));
+    TEST_CHECK(poll(touch, x, y) == 2 && x[1] == 100);
+
+    TEST_CHECK_OK(esp_lcd_touch_del(touch));
+}
+
+// Without the manual clock the bus latency is spent on the esp_timer clock
+static void test_timer_clock(void)
+{
+    esp_lcd_touch_handle_t touch = new_mock(s_pinch, 3, 0, false);
+    const int64_t start = esp_timer_get_time();
+    for(int i = 0; i < 5; i++) {
+        TEST_CHECK_OK(esp_lcd_touch_read_data(touch));
+    }
+    TEST_CHECK(esp_timer_get_time() - start == 5 * LATENCY_US);
+    TEST_CHECK(esp_bsp_sdl_touch_mock_advance(touch, 1) == ESP_ERR_INVALID_STATE);
+
+    esp_bsp_sdl_touch_mock_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_get_stats(touch, &stats));
+    TEST_CHECK(stats.reads == 5 && stats.read_time_us == 5 * LATENCY_US);
+    TEST_CHECK(stats.events == 1 && stats.latency_us == LATENCY_US);
+
+    TEST_CHECK_OK(esp_lcd_touch_del(touch));
+}
+
+static void test_invalid_scripts(void)
+{
+    esp_lcd_touch_handle_t touch = new_mock(NULL, 0, 0, true);
+    const esp_bsp_sdl_touch_mock_frame_t unsorted[2] = {{.time_ms = 20}, {.time_ms = 10}};
+    TEST_CHECK(esp_bsp_sdl_touch_mock_load_script(touch, unsorted, 2, 0) == ESP_ERR_INVALID_ARG);
+    TEST_CHECK(esp_bsp_sdl_touch_mock_load_script(touch, s_pinch, 3, 30) == ESP_ERR_INVALID_ARG);
+    TEST_CHECK(esp_bsp_sdl_touch_mock_load_script(touch, NULL, 3, 0) == ESP_ERR_INVALID_ARG);
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_load_script(touch, s_pinch, 3, 31));
+
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint8_t points = 0;
+    TEST_CHECK_OK(esp_lcd_touch_read_data(touch));
+    TEST_CHECK(esp_lcd_touch_get_coordinates(touch, &x, &y, NULL, &points, 1) && x == 10);
+    TEST_CHECK_OK(esp_lcd_touch_del(touch));
+    TEST_CHECK(!esp_bsp_sdl_is_touch_mock(NULL));
+}
+
+int main(void)
+{
+    test_replay();
+    test_missed_and_loop();
+    test_swap_mirror();
+    test_inject();
+    test_timer_clock();
+    test_invalid_scripts();
+    return test_finish("test_touch_mock");
+}
@@ -0,0 +1,137 @@
+/**
+ * @file test_util.c
+ * @brief Golden images are binary PPM files, RGB565 expanded to 8 bits per channel
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "test_util.h"
+
+int test_failures = 0;
+
+static bool write_ppm(const char *path, const esp_bsp_sdl_surface_t *surface)
+{
+    FILE *f = fopen(path, "wb");
+    if(!f) {
+        return false;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", surface->width, surface->height);
+    for(int y = 0; y < surface->height; y++) {
+        for(int x = 0; x < surface->width; x++) {
+            const uint16_t p = surface->pixels[y * surface->stride + x];
+            const uint8_t r = p >> 11;
+            const uint8_t g = (p >> 5) & 0x3F;
+            const uint8_t b = p & 0x1F;
+            const uint8_t rgb[3] = {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+            fwrite(rgb, 1, sizeof(rgb), f);
+        }
+    }
+    return fclose(f) == 0;
+}
+
+// Returns the pixels of a PPM written by write_ppm(), NULL if it cannot be read
+static uint16_t *read_ppm(const char *path, int *width, int *height)
+{
+    FILE *f = fopen(path, "rb");
+    if(!f) {
+        return NULL;
+    }
+    int max = 0;
+    uint16_t *pixels = NULL;
+    if(fscanf(f, "P6 %d %d %d", width, height, &max) == 3 && max == 255 && fgetc(f) == '\n' && *width > 0 &&
+       *height > 0) {
+        pixels = malloc((size_t) *width * *height * sizeof(uint16_t));
+        for(int i = 0; pixels && i < *width * *height; i++) {
+            uint8_t rgb[3];
+            if(fread(rgb, 1, sizeof(rgb), f) != sizeof(rgb)) {
+                free(pixels);
+                pixels = NULL;
+                break;
+            }
+            pixels[i] = ((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3);
+        }
+    }
+    fclose(f);
+    return pixels;
+}
+
+bool test_golden_check(const char *name, const esp_bsp_sdl_surface_t *surface, int tolerance)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.ppm", GOLDEN_DIR, name);
+
+    if(getenv("ESP_BSP_SDL_UPDATE_GOLDEN")) {
+        if(!write_ppm(path, surface)) {
+            fprintf(stderr, "%s: cannot write %s\n", name, path);
+            test_failures++;
+            return false;
+        }
+        printf("%s: golden image updated\n", name);
+        return true;
+    }
+
+    int width;
+    int height;
+    uint16_t *golden = read_ppm(path, &width, &height);
+    if(!golden) {
+        fprintf(stderr, "%s: cannot read %s\n", name, path);
+        test_failures++;
+        return false;
+    }
+
+    const esp_bsp_sdl_surface_t reference = {golden, width, height, width};
+    esp_bsp_sdl_frame_diff_t diff;
+    const esp_err_t ret = esp_bsp_sdl_frame_compare(surface, &reference, tolerance, &diff);
+    free(golden);
+    if(ret == ESP_OK) {
+        return true;
+    }
+
+    char actual[512];
+    snprintf(actual, sizeof(actual), "%s.actual.ppm", name);
+    write_ppm(actual, surface);
+    if(ret == ESP_ERR_INVALID_SIZE) {
+        fprintf(stderr, "%s: %dx%d, golden image is %dx%d\n", name, surface->width, surface->height, width, height);
+    } else {
+        fprintf(stderr,
+                "%s: %u pixels off by up to %d in %d,%d %dx%d, output written to %s\n",
+                name,
+                (unsigned) diff.mismatched,
+                diff.max_delta,
+                diff.bounds.x,
+                diff.bounds.y,
+                diff.bounds.w,
+                diff.bounds.h,
+                actual);
+    }
+    test_failures++;
+    return false;
+}
+
+uint32_t test_random(void)
+{
+    static uint32_t state = 2463534242u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+int64_t test_wall_time_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+int test_finish(const char *test_name)
+{
+    if(test_failures) {
+        printf("%s: %d check(s) failed\n", test_name, test_failures);
+        return EXIT_FAILURE;
+    }
+    printf("%s: all checks passed\n", test_name);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file test_util.h
+ * @brief Assertions and golden image checks shared by the host tests
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_bsp_sdl_surface.h"
+
+/**
+ * @brief Failed checks of the running test program
+ */
+extern int test_failures;
+
+/**
+ * @brief Check a condition, report and count a failure without stopping the test
+ */
+#define TEST_CHECK(cond)                                                                                               \
+    do {                                                                                                               \
+        if(!(cond)) {                                                                                                  \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                                   \
+            test_failures++;                                                                                           \
+        }                                                                                                              \
+    } while(0)
+
+/**
+ * @brief Check that an esp_err_t expression returns ESP_OK
+ */
+#define TEST_CHECK_OK(expr)                                                                                            \
+    do {                                                                                                               \
+        const int ret_ = (expr);                                                                                       \
+        if(ret_ != 0) {                                                                                                \
+            fprintf(stderr, "%s:%d: %s returned 0x%x\n", __FILE__, __LINE__, #expr, ret_);                             \
+            test_failures++;                                                                                           \
+        }                                                                                                              \
+    } while(0)
+
+/**
+ * @brief Compare an RGB565 surface against golden/<name>.ppm
+ *
+ * On a mismatch the surface is written to <name>.actual.ppm in the working directory. With
+ * ESP_BSP_SDL_UPDATE_GOLDEN set in the environment the golden image is written instead.
+ *
+ * @param name Golden image name
+ * @param surface Surface to check
+ * @param tolerance Allowed difference per channel in RGB565 steps
+ * @return true if the surface matches
+ */
+bool test_golden_check(const char *name, const esp_bsp_sdl_surface_t *surface, int tolerance);
+
+/**
+ * @brief Deterministic pseudo-random numbers (xorshift32), the same sequence on every run
+ */
+uint32_t test_random(void);
+
+/**
+ * @brief Monotonic wall clock for benchmarks, unlike esp_timer which runs on the simulated clock
+ */
+int64_t test_wall_time_us(void);
+
+/**
+ * @brief Exit status of the test program, prints a summary
+ */
+int test_finish(const char *test_name);
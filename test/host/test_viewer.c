@@ -0,0 +1,133 @@
+/**
+ * @file test_viewer.c
+ * @brief Shared-memory export: frames reach the segment, mouse input comes back as touch
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "esp_bsp_sdl.h"
+#include "esp_bsp_sdl_touch_mock.h"
+#include "esp_bsp_sdl_virtual_panel.h"
+#include "esp_host_viewer.h"
+#include "sdkconfig.h"
+#include "test_util.h"
+
+#define NATIVE_W CONFIG_SDL_BSP_VIRTUAL_WIDTH
+#define NATIVE_H CONFIG_SDL_BSP_VIRTUAL_HEIGHT
+
+static uint16_t s_frame[NATIVE_W * NATIVE_H];
+
+// Map the segment the way a viewer process does
+static esp_host_viewer_shm_t *map_viewer(const char *name, size_t size)
+{
+    const int fd = shm_open(name, O_RDWR, 0);
+    if(fd < 0) {
+        return NULL;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+static bool segment_matches_panel(const esp_host_viewer_shm_t *shm, esp_lcd_panel_handle_t panel)
+{
+    esp_bsp_sdl_surface_t frame;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(panel, &frame));
+    for(int y = 0; y < NATIVE_H; y++) {
+        if(memcmp(&shm->pixels[y * NATIVE_W], &frame.pixels[y * frame.stride], NATIVE_W * sizeof(uint16_t)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void send_mouse(esp_host_viewer_shm_t *shm, int x, int y, bool pressed)
+{
+    shm->touch_x = x;
+    shm->touch_y = y;
+    shm->touch_pressed = pressed;
+    __atomic_add_fetch(&shm->touch_seq, 1, __ATOMIC_RELEASE);
+}
+
+int main(void)
+{
+    esp_bsp_sdl_display_config_t config;
+    esp_lcd_panel_handle_t panel;
+    esp_lcd_panel_io_handle_t io;
+    TEST_CHECK_OK(esp_bsp_sdl_init(&config, &panel, &io));
+    TEST_CHECK_OK(esp_bsp_sdl_touch_init());
+    esp_lcd_touch_handle_t touch = esp_bsp_sdl_virtual_get_touch();
+
+    char name[64];
+    snprintf(name, sizeof(name), "/esp_bsp_sdl_test_viewer_%d", (int) getpid());
+    TEST_CHECK(esp_host_viewer_start("no_slash", panel, touch) == ESP_ERR_INVALID_ARG);
+    TEST_CHECK(esp_host_viewer_poll() == ESP_ERR_INVALID_STATE);
+    TEST_CHECK_OK(esp_host_viewer_start(name, panel, touch));
+    TEST_CHECK(esp_host_viewer_start(name, panel, touch) == ESP_ERR_INVALID_STATE);
+
+    const size_t size = sizeof(esp_host_viewer_shm_t) + sizeof(s_frame);
+    esp_host_viewer_shm_t *shm = map_viewer(name, size);
+    TEST_CHECK(shm != NULL);
+    if(!shm) {
+        esp_host_viewer_stop();
+        return test_finish("test_viewer");
+    }
+    TEST_CHECK(shm->magic == ESP_HOST_VIEWER_MAGIC);
+    TEST_CHECK(shm->width == NATIVE_W && shm->height == NATIVE_H);
+    TEST_CHECK(!(shm->frame_seq & 1));
+    TEST_CHECK(segment_matches_panel(shm, panel));
+
+    // A full frame and a partial draw both land in the segment
+    for(int i = 0; i < NATIVE_W * NATIVE_H; i++) {
+        s_frame[i] = (uint16_t) test_random();
+    }
+    uint32_t seq = shm->frame_seq;
+    TEST_CHECK_OK(esp_bsp_sdl_flush_frame(s_frame));
+    TEST_CHECK(shm->frame_seq > seq && !(shm->frame_seq & 1));
+    TEST_CHECK(segment_matches_panel(shm, panel));
+
+    const uint16_t patch[4 * 3] = {0xF800, 0xF800, 0xF800, 0xF800, 0x07E0, 0x07E0,
+                                   0x07E0, 0x07E0, 0x001F, 0x001F, 0x001F, 0x001F};
+    seq = shm->frame_seq;
+    TEST_CHECK_OK(esp_bsp_sdl_draw_bitmap(10, 20, 14, 23, patch));
+    // Reading the panel frame waits for the transfer on the simulated bus
+    TEST_CHECK(segment_matches_panel(shm, panel));
+    TEST_CHECK(shm->frame_seq == seq + 2);
+    TEST_CHECK(shm->dirty_x == 10 && shm->dirty_y == 20 && shm->dirty_w == 4 && shm->dirty_h == 3);
+
+    // Mouse press, drag and release reach esp_bsp_sdl_touch_read()
+    esp_bsp_sdl_touch_info_t info;
+    send_mouse(shm, 13, 37, true);
+    TEST_CHECK_OK(esp_host_viewer_poll());
+    TEST_CHECK_OK(esp_bsp_sdl_touch_read(&info));
+    TEST_CHECK(info.pressed && info.x == 13 && info.y == 37);
+    send_mouse(shm, 20, 30, true);
+    TEST_CHECK_OK(esp_host_viewer_poll());
+    TEST_CHECK_OK(esp_bsp_sdl_touch_read(&info));
+    TEST_CHECK(info.pressed && info.x == 20 && info.y == 30);
+    send_mouse(shm, 20, 30, false);
+    TEST_CHECK_OK(esp_host_viewer_poll());
+    TEST_CHECK_OK(esp_bsp_sdl_touch_read(&info));
+    TEST_CHECK(!info.pressed);
+
+    // Every mouse change was read once
+    esp_bsp_sdl_touch_mock_stats_t stats;
+    TEST_CHECK_OK(esp_bsp_sdl_touch_mock_get_stats(touch, &stats));
+    TEST_CHECK(stats.events == 3 && stats.missed_events == 0);
+
+    // Stopping detaches the listener and removes the segment
+    esp_host_viewer_stop();
+    seq = shm->frame_seq;
+    TEST_CHECK_OK(esp_bsp_sdl_draw_bitmap(0, 0, 4, 3, patch));
+    esp_bsp_sdl_surface_t frame;
+    TEST_CHECK_OK(esp_bsp_sdl_virtual_panel_get_frame(panel, &frame));
+    TEST_CHECK(shm->frame_seq == seq);
+    munmap(shm, size);
+    TEST_CHECK(map_viewer(name, size) == NULL);
+
+    TEST_CHECK_OK(esp_bsp_sdl_deinit());
+    return test_finish("test_viewer");
+}
@@ -0,0 +1,163 @@
+/**
+ * @file viewer_sdl.c
+ * @brief Live preview of a virtual panel exported with esp_host_viewer_start()
+ *
+ * Maps the shared memory segment, shows the frame at board resolution (scaled by an integer
+ * factor) and writes the mouse state back for the mock touch controller. Frame pixels are
+ * uploaded straight from the segment into the texture.
+ *
+ * Usage: viewer_sdl <name> [scale] [--swap], --swap for frames sent in big-endian byte order
+ */
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <SDL.h>
+#include "esp_host_viewer.h"
+
+static esp_host_viewer_shm_t *map_segment(const char *name, size_t *size)
+{
+    const int fd = shm_open(name, O_RDWR, 0);
+    if(fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if(fstat(fd, &st) == 0 && (size_t) st.st_size > sizeof(esp_host_viewer_shm_t)) {
+        map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        *size = st.st_size;
+    }
+    close(fd);
+    if(map == MAP_FAILED) {
+        return NULL;
+    }
+    esp_host_viewer_shm_t *shm = map;
+    if(__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != ESP_HOST_VIEWER_MAGIC) {
+        munmap(map, *size);
+        return NULL;
+    }
+    return shm;
+}
+
+// Upload a consistent frame, false if the exporter was writing
+static bool upload(SDL_Texture *texture, const esp_host_viewer_shm_t *shm, uint32_t seq, bool swap)
+{
+    void *dst;
+    int pitch;
+    if(SDL_LockTexture(texture, NULL, &dst, &pitch) != 0) {
+        return false;
+    }
+    for(int y = 0; y < shm->height; y++) {
+        const uint16_t *src = &shm->pixels[y * shm->width];
+        uint16_t *row = (uint16_t *) ((uint8_t *) dst + y * pitch);
+        if(swap) {
+            for(int x = 0; x < shm->width; x++) {
+                row[x] = (uint16_t) (src[x] << 8 | src[x] >> 8);
+            }
+        } else {
+            memcpy(row, src, shm->width * sizeof(uint16_t));
+        }
+    }
+    SDL_UnlockTexture(texture);
+    return __atomic_load_n(&shm->frame_seq, __ATOMIC_ACQUIRE) == seq;
+}
+
+static void send_touch(esp_host_viewer_shm_t *shm, int x, int y, bool pressed, int scale)
+{
+    x /= scale;
+    y /= scale;
+    shm->touch_x = x < 0 ? 0 : x >= shm->width ? shm->width - 1 : x;
+    shm->touch_y = y < 0 ? 0 : y >= shm->height ? shm->height - 1 : y;
+    shm->touch_pressed = pressed;
+    __atomic_add_fetch(&shm->touch_seq, 1, __ATOMIC_RELEASE);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = NULL;
+    int scale = 2;
+    bool swap = false;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--swap") == 0) {
+            swap = true;
+        } else if(!name) {
+            name = argv[i];
+        } else {
+            scale = atoi(argv[i]);
+        }
+    }
+    if(!name || scale < 1) {
+        fprintf(stderr, "usage: %s <name> [scale] [--swap]\n", argv[0]);
+        return 1;
+    }
+
+    size_t size = 0;
+    esp_host_viewer_shm_t *shm = NULL;
+    while(!(shm = map_segment(name, &size))) {
+        // Wait for the exporter
+        usleep(100000);
+    }
+
+    if(SDL_Init(SDL_INIT_VIDEO) != 0) {
+        fprintf(stderr, "SDL_Init: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_Window *window = SDL_CreateWindow(name, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                                          shm->width * scale, shm->height * scale, 0);
+    SDL_Renderer *renderer = window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC) : NULL;
+    SDL_Texture *texture = renderer ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB565, SDL_TEXTUREACCESS_STREAMING,
+                                                        shm->width, shm->height)
+                                    : NULL;
+    if(!texture) {
+        fprintf(stderr, "SDL: %s\n", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    uint32_t shown = UINT32_MAX;
+    bool pressed = false;
+    bool running = true;
+    while(running) {
+        SDL_Event event;
+        while(SDL_PollEvent(&event)) {
+            switch(event.type) {
+                case SDL_QUIT:
+                    running = false;
+                    break;
+                case SDL_MOUSEBUTTONDOWN:
+                case SDL_MOUSEBUTTONUP:
+                    if(event.button.button == SDL_BUTTON_LEFT) {
+                        pressed = event.type == SDL_MOUSEBUTTONDOWN;
+                        send_touch(shm, event.button.x, event.button.y, pressed, scale);
+                    }
+                    break;
+                case SDL_MOUSEMOTION:
+                    if(pressed) {
+                        send_touch(shm, event.motion.x, event.motion.y, true, scale);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        const uint32_t seq = __atomic_load_n(&shm->frame_seq, __ATOMIC_ACQUIRE);
+        if(seq != shown && !(seq & 1) && upload(texture, shm, seq, swap)) {
+            shown = seq;
+        }
+        SDL_RenderCopy(renderer, texture, NULL, NULL);
+        SDL_RenderPresent(renderer);
+    }
+
+    SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    munmap(shm, size);
+    return 0;
+}